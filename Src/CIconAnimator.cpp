@@ -0,0 +1,865 @@
+/*! \file    CIconAnimator.cpp
+    \brief   Play the animated icons of an icon view lazily, within a frame rate and a memory budget.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "CIconAnimator.h"
+
+/*! \struct ICON_ANIM_ENTRY
+    \brief The animation of one icon file.
+*/
+typedef struct _ICON_ANIM_ENTRY
+{
+  GtkTreeRowReference *row;          /*!< The row of the icon, it follows the row when the rows are sorted. */
+  GdkPixbufAnimation *anim;          /*!< The decoded animation. */
+  GdkPixbufAnimationIter *iter;      /*!< The position in the animation, NULL while it is not shown. */
+  GdkPixbuf *staticIcon;             /*!< The thumbnail of the row before it was animated. */
+  gboolean bFresh;                   /*!< To indicate if it just became active and its frame must be shown. */
+  gsize nBytes;                      /*!< The memory of all its frames decoded. */
+  guint lastUsed;                    /*!< The tick it was shown last. */
+} ICON_ANIM_ENTRY;
+
+/*! \struct ICON_ANIM_LOAD
+    \brief A GIF file queued to the loading thread, and its result.
+*/
+typedef struct _ICON_ANIM_LOAD
+{
+  gchar *fullName;                   /*!< The icon's full file name. */
+  GtkTreeRowReference *row;          /*!< The row of the icon. Only used by the main thread. */
+  gsize nMaxBytes;                   /*!< The memory budget, a GIF whose frames take more is not decoded. */
+  gint nGeneration;                  /*!< The generation of the animator it was queued in. */
+  GdkPixbufAnimation *anim;          /*!< The decoded animation, NULL if it failed or was refused. */
+  gsize nBytes;                      /*!< The memory of all its frames. */
+} ICON_ANIM_LOAD;
+
+/*! \fn static gboolean skip_sub_blocks(const guchar *data, gsize length, gsize *pPos)
+    \brief To skip the data sub-blocks of a GIF block, up to the empty one ending them.
+
+    \param[in] data. The GIF file.
+    \param[in] length. The bytes of the file.
+    \param[in,out] pPos. The offset of the first sub-block, then the offset after the empty one.
+    \return FALSE if the file ends inside the sub-blocks.
+*/
+static gboolean skip_sub_blocks(const guchar *data, gsize length, gsize *pPos)
+{
+  while(*pPos < length)
+  {
+     gsize nSize = data[(*pPos)++];
+
+     if(nSize == 0)
+       return true;
+
+     if(length - *pPos < nSize)
+       return false;
+
+     *pPos += nSize;
+  }
+
+  return false;
+}
+
+/*! \fn static gboolean measure_gif(const guchar *data, gsize length, gsize nMaxBytes, gsize *pBytes)
+    \brief To walk the blocks of a GIF file without decoding it, and get the memory of all its decoded frames.
+    \n Every frame is kept composited at the size of the logical screen, or of the frame if it is larger.
+
+    \param[in] data. The GIF file.
+    \param[in] length. The bytes of the file.
+    \param[in] nMaxBytes. The memory budget, the walk stops as soon as the frames take more.
+    \param[out] pBytes. The memory of all frames.
+    \return FALSE if the file is not a well-formed GIF, or its frames take more than the budget.
+*/
+static gboolean measure_gif(const guchar *data, gsize length, gsize nMaxBytes, gsize *pBytes)
+{
+  guint64 nBytes = 0;
+  guint width = 0, height = 0;
+  gsize pos = 13;
+
+  if( (length < 13) || ((memcmp(data, "GIF87a", 6) != 0) && (memcmp(data, "GIF89a", 6) != 0)) )
+    return false;
+
+  width = data[6] | (data[7] << 8);
+  height = data[8] | (data[9] << 8);
+
+  /* The global color table. */
+  if(data[10] & 0x80)
+    pos += (gsize)3 << ((data[10] & 0x07) + 1);
+
+  while(pos < length)
+  {
+     guchar block = data[pos++];
+     guint frameWidth = 0, frameHeight = 0;
+     guchar packed = 0;
+
+     /* The trailer. */
+     if(block == 0x3B)
+       break;
+
+     /* An extension: its label, then its sub-blocks. */
+     if(block == 0x21)
+     {
+        if( (++pos > length) || !skip_sub_blocks(data, length, &pos) )
+          return false;
+
+        continue;
+     }
+
+     /* Anything else than an image descriptor is a broken file. */
+     if( (block != 0x2C) || (length - pos < 9) )
+       return false;
+
+     frameWidth = data[pos + 4] | (data[pos + 5] << 8);
+     frameHeight = data[pos + 6] | (data[pos + 7] << 8);
+     packed = data[pos + 8];
+     pos += 9;
+
+     /* The local color table. */
+     if(packed & 0x80)
+       pos += (gsize)3 << ((packed & 0x07) + 1);
+
+     /* The LZW minimum code size, then the image data. */
+     if( (++pos > length) || !skip_sub_blocks(data, length, &pos) )
+       return false;
+
+     nBytes += (guint64)MAX(width, frameWidth) * MAX(height, frameHeight) * 4;
+
+     if(nBytes > nMaxBytes)
+       return false;
+  }
+
+  *pBytes = (gsize)nBytes;
+
+  return (nBytes > 0);
+}
+
+/*! \fn static GdkPixbuf* scale_frame(GdkPixbuf *frame, gint size)
+    \brief To shrink a frame into the thumbnail size, keeping its aspect ratio.
+
+    \param[in] frame. The frame of the animation.
+    \param[in] size. The thumbnail size.
+    \return The thumbnail, it must be unreferenced.
+*/
+static GdkPixbuf* scale_frame(GdkPixbuf *frame, gint size)
+{
+  gint width = gdk_pixbuf_get_width(frame);
+  gint height = gdk_pixbuf_get_height(frame);
+
+  if( (width <= size) && (height <= size) )
+    return (GdkPixbuf*)g_object_ref(frame);
+
+  if(width > height)
+  {
+     height = MAX(1, height * size / width);
+     width = size;
+  }
+  else
+  {
+     width = MAX(1, width * size / height);
+     height = size;
+  }
+
+  return gdk_pixbuf_scale_simple(frame, width, height, GDK_INTERP_BILINEAR);
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconAnimator::CIconAnimator(gint iconColumn, gint pathColumn, gint size)
+    \brief CIconAnimator constructor
+
+    \param[in] iconColumn. The model column of the thumbnail.
+    \param[in] pathColumn. The model column of the icon's full file name.
+    \param[in] size. The thumbnail size.
+*/
+CIconAnimator::CIconAnimator(gint iconColumn, gint pathColumn, gint size)
+{
+  m_pIconView = NULL;
+  m_nIconColumn = iconColumn;
+  m_nPathColumn = pathColumn;
+  m_nSize = size;
+  m_bEnabled = false;
+  m_nFps = ICON_ANIM_MAX_FPS;
+  m_nMaxBytes = ICON_ANIM_MAX_BYTES;
+  m_nBytes = 0;
+  m_nTimer = 0;
+  m_nTick = 0;
+  m_nNextAdvance = 0;
+  m_pHoverPath = NULL;
+  m_pAnimations = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, m_FreeEntry);
+  m_pStaticNames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  m_pLoading = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  m_pLoaded = g_async_queue_new();
+  m_nGeneration = 0;
+
+  /* One loading thread, the GIF files are decoded one at a time off the main loop. */
+  m_pLoadPool = g_thread_pool_new(cb_load_thread, this, 1, FALSE, NULL);
+}
+
+/*! \fn CIconAnimator::~CIconAnimator()
+    \brief CIconAnimator destructor
+*/
+CIconAnimator::~CIconAnimator()
+{
+  /* The thumbnails of a view still shown get their static images back. */
+  m_SetEnabled(false);
+  m_Attach(NULL);
+
+  /* The loads still queued are cancelled, they end without reading their files. */
+  if(m_pLoadPool)
+    g_thread_pool_free(m_pLoadPool, FALSE, TRUE);
+
+  m_pLoadPool = NULL;
+  m_CancelLoads();
+
+  if(m_pLoaded)
+    g_async_queue_unref(m_pLoaded);
+
+  if(m_pAnimations)
+    g_hash_table_destroy(m_pAnimations);
+
+  if(m_pStaticNames)
+    g_hash_table_destroy(m_pStaticNames);
+
+  if(m_pLoading)
+    g_hash_table_destroy(m_pLoading);
+
+  m_pLoaded = NULL;
+  m_pAnimations = NULL;
+  m_pStaticNames = NULL;
+  m_pLoading = NULL;
+}
+
+/*! \fn void CIconAnimator::m_FreeEntry(gpointer data)
+    \brief To free an ICON_ANIM_ENTRY, without restoring its thumbnail.
+*/
+void CIconAnimator::m_FreeEntry(gpointer data)
+{
+  ICON_ANIM_ENTRY *entry = (ICON_ANIM_ENTRY*)data;
+
+  if(entry->iter)
+    g_object_unref(entry->iter);
+
+  if(entry->anim)
+    g_object_unref(entry->anim);
+
+  if(entry->staticIcon)
+    g_object_unref(entry->staticIcon);
+
+  if(entry->row)
+    gtk_tree_row_reference_free(entry->row);
+
+  g_free(entry);
+}
+
+/*! \fn void CIconAnimator::m_FreeLoad(gpointer data)
+    \brief To free an ICON_ANIM_LOAD, by the main thread since it holds a row reference.
+*/
+void CIconAnimator::m_FreeLoad(gpointer data)
+{
+  ICON_ANIM_LOAD *load = (ICON_ANIM_LOAD*)data;
+
+  if(load->anim)
+    g_object_unref(load->anim);
+
+  if(load->row)
+    gtk_tree_row_reference_free(load->row);
+
+  g_free(load->fullName);
+  g_free(load);
+}
+
+/*! \fn void CIconAnimator::cb_load_thread(gpointer data, gpointer thisObject)
+    \brief The thread function decoding a GIF file, fed to the loader chunk by chunk.
+    \n The blocks are walked first, a broken file or one whose frames exceed the budget is not decoded at all.
+
+    \param[in] data. The ICON_ANIM_LOAD, it is passed back to the main thread through m_pLoaded.
+    \param[in] thisObject. The instance of class CIconAnimator.
+    \return NONE
+*/
+void CIconAnimator::cb_load_thread(gpointer data, gpointer thisObject)
+{
+  CIconAnimator *animator = (CIconAnimator*)thisObject;
+  ICON_ANIM_LOAD *load = (ICON_ANIM_LOAD*)data;
+  gchar *contents = NULL;
+  gsize length = 0;
+  struct stat st;
+
+  /* A cancelled load, or a file too large, is not read. */
+  if( (g_atomic_int_get(&animator->m_nGeneration) == load->nGeneration) &&
+      (stat(load->fullName, &st) == 0) && (st.st_size <= ICON_ANIM_MAX_FILE_BYTES) &&
+      g_file_get_contents(load->fullName, &contents, &length, NULL) )
+  {
+     if( (length <= ICON_ANIM_MAX_FILE_BYTES) && measure_gif((const guchar*)contents, length, load->nMaxBytes, &load->nBytes) )
+     {
+        /* Only the GIF loader, whatever the file looks like to the others. */
+        GdkPixbufLoader *loader = gdk_pixbuf_loader_new_with_type("gif", NULL);
+        gboolean bLoaded = (loader != NULL);
+
+        for(gsize pos=0; bLoaded && (pos < length); pos += ICON_ANIM_LOAD_CHUNK)
+        {
+           if( g_atomic_int_get(&animator->m_nGeneration) != load->nGeneration )
+             bLoaded = false;
+           else
+             bLoaded = gdk_pixbuf_loader_write(loader, (const guchar*)contents + pos, MIN((gsize)ICON_ANIM_LOAD_CHUNK, length - pos), NULL);
+        }
+
+        if(loader)
+        {
+           /* The loader must be closed even when the writing failed. */
+           if( gdk_pixbuf_loader_close(loader, NULL) && bLoaded && gdk_pixbuf_loader_get_animation(loader) )
+             load->anim = (GdkPixbufAnimation*)g_object_ref(gdk_pixbuf_loader_get_animation(loader));
+
+           g_object_unref(loader);
+        }
+     }
+
+     g_free(contents);
+  }
+
+  g_async_queue_push(animator->m_pLoaded, load);
+}
+
+/*! \fn gboolean CIconAnimator::m_TakeLoaded(void)
+    \brief To take the animations decoded by the loading thread, charging all their frames to the memory budget.
+
+    \param[in] NONE
+    \return TRUE if an animation was added.
+*/
+gboolean CIconAnimator::m_TakeLoaded(void)
+{
+  ICON_ANIM_LOAD *load = NULL;
+  gboolean bAdded = false;
+
+  while( (load = (ICON_ANIM_LOAD*)g_async_queue_try_pop(m_pLoaded)) != NULL )
+  {
+     ICON_ANIM_ENTRY *entry = NULL;
+     GtkTreeModel *model = NULL;
+     GtkTreePath *path = NULL;
+     GtkTreeIter iter;
+
+     /* Queued before the model was replaced or the animations were stopped. */
+     if(load->nGeneration != m_nGeneration)
+     {
+        m_FreeLoad(load);
+        continue;
+     }
+
+     g_hash_table_remove(m_pLoading, load->fullName);
+
+     if( !gtk_tree_row_reference_valid(load->row) )
+     {
+        m_FreeLoad(load);
+        continue;
+     }
+
+     if( load->anim && !gdk_pixbuf_animation_is_static_image(load->anim) )
+       m_Evict(load->nBytes);
+
+     if( !load->anim || gdk_pixbuf_animation_is_static_image(load->anim) || (m_nBytes + load->nBytes > m_nMaxBytes) )
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        if(load->anim && (m_nBytes + load->nBytes > m_nMaxBytes))
+          printf("%s(%d) - %s is not animated, the memory budget is full \n", __FUNCTION__, __LINE__, load->fullName);
+        #endif
+
+        g_hash_table_insert(m_pStaticNames, load->fullName, GINT_TO_POINTER(1));
+        load->fullName = NULL;
+        m_FreeLoad(load);
+        continue;
+     }
+
+     entry = g_new0(ICON_ANIM_ENTRY, 1);
+     entry->row = load->row;
+     entry->anim = load->anim;
+     entry->nBytes = load->nBytes;
+
+     model = gtk_tree_row_reference_get_model(entry->row);
+     path = gtk_tree_row_reference_get_path(entry->row);
+     if( gtk_tree_model_get_iter(model, &iter, path) )
+       gtk_tree_model_get(model, &iter, m_nIconColumn, &entry->staticIcon, -1);
+
+     gtk_tree_path_free(path);
+
+     m_nBytes += entry->nBytes;
+     g_hash_table_insert(m_pAnimations, load->fullName, entry);
+     bAdded = true;
+
+     load->row = NULL;
+     load->anim = NULL;
+     load->fullName = NULL;
+     m_FreeLoad(load);
+  }
+
+  return bAdded;
+}
+
+/*! \fn void CIconAnimator::m_CancelLoads(void)
+    \brief To drop the loads queued or in progress, their results are freed when they come back.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconAnimator::m_CancelLoads(void)
+{
+  ICON_ANIM_LOAD *load = NULL;
+
+  g_atomic_int_inc(&m_nGeneration);
+  g_hash_table_remove_all(m_pLoading);
+
+  while( (load = (ICON_ANIM_LOAD*)g_async_queue_try_pop(m_pLoaded)) != NULL )
+    m_FreeLoad(load);
+}
+
+/*! \fn void CIconAnimator::m_Attach(GtkIconView *iconView)
+    \brief To animate the items of an icon view. The animations of the previous view are dropped.
+
+    \param[in] iconView. The icon view, NULL to detach.
+    \return NONE
+*/
+void CIconAnimator::m_Attach(GtkIconView *iconView)
+{
+  if(m_pIconView)
+  {
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_motion_notify, this);
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_leave_notify, this);
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_expose, this);
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_destroy, this);
+  }
+
+  m_Reset();
+  m_pIconView = iconView;
+
+  if(!m_pIconView)
+    return;
+
+  gtk_widget_add_events(GTK_WIDGET(m_pIconView), GDK_POINTER_MOTION_MASK | GDK_LEAVE_NOTIFY_MASK);
+
+  g_signal_connect(m_pIconView, "motion-notify-event", G_CALLBACK(cb_motion_notify), this);
+  g_signal_connect(m_pIconView, "leave-notify-event", G_CALLBACK(cb_leave_notify), this);
+  g_signal_connect_after(m_pIconView, "expose-event", G_CALLBACK(cb_expose), this);
+  g_signal_connect(m_pIconView, "destroy", G_CALLBACK(cb_destroy), this);
+}
+
+/*! \fn void CIconAnimator::m_Reset(void)
+    \brief To drop all animations without restoring the thumbnails, because the model they were in is replaced.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconAnimator::m_Reset(void)
+{
+  m_CancelLoads();
+  g_hash_table_remove_all(m_pAnimations);
+  g_hash_table_remove_all(m_pStaticNames);
+  m_nBytes = 0;
+  m_nNextAdvance = 0;
+
+  if(m_pHoverPath)
+    gtk_tree_path_free(m_pHoverPath);
+
+  m_pHoverPath = NULL;
+}
+
+/*! \fn void CIconAnimator::m_Kick(void)
+    \brief To start the timer if it is not running. It stops by itself when there is nothing to animate.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconAnimator::m_Kick(void)
+{
+  if( !m_bEnabled || !m_pIconView || m_nTimer )
+    return;
+
+  m_nTimer = g_timeout_add(1000 / m_nFps, cb_tick, this);
+}
+
+/*! \fn void CIconAnimator::m_SetEnabled(gboolean enabled)
+    \brief To play or stop the animations. Stopping restores the static thumbnails and frees all frames.
+
+    \param[in] enabled. TRUE to play the animations.
+    \return NONE
+*/
+void CIconAnimator::m_SetEnabled(gboolean enabled)
+{
+  m_bEnabled = enabled;
+
+  if(m_bEnabled)
+  {
+     m_Kick();
+     return;
+  }
+
+  if(m_nTimer)
+    g_source_remove(m_nTimer);
+
+  m_nTimer = 0;
+
+  /* Nothing is active after a tick without anything to collect, so it restores all thumbnails. */
+  m_CancelLoads();
+  m_nTick++;
+  m_Evict(m_nMaxBytes + 1);
+  g_hash_table_remove_all(m_pStaticNames);
+}
+
+/*! \fn void CIconAnimator::m_SetBudget(guint fps, gsize maxBytes)
+    \brief To set the budgets of all animations together.
+
+    \param[in] fps. The frames per second at most, 0 keeps the current value.
+    \param[in] maxBytes. The memory of the decoded frames at most, 0 keeps the current value.
+    \return NONE
+*/
+void CIconAnimator::m_SetBudget(guint fps, gsize maxBytes)
+{
+  if(fps > 0)
+    m_nFps = MIN(fps, 100);
+
+  if(maxBytes > 0)
+    m_nMaxBytes = maxBytes;
+
+  /* The timer is started again with the new interval. */
+  if(m_nTimer)
+  {
+     g_source_remove(m_nTimer);
+     m_nTimer = 0;
+     m_Kick();
+  }
+}
+
+/*! \fn void CIconAnimator::m_SetThumbnail(gpointer entry, GdkPixbuf *pixbuf)
+    \brief To set the thumbnail of the row of an animation.
+
+    \param[in] entry. The ICON_ANIM_ENTRY.
+    \param[in] pixbuf. The thumbnail.
+    \return NONE
+*/
+void CIconAnimator::m_SetThumbnail(gpointer entry, GdkPixbuf *pixbuf)
+{
+  GtkTreeRowReference *row = ((ICON_ANIM_ENTRY*)entry)->row;
+  GtkTreeModel *model = NULL;
+  GtkTreePath *path = NULL;
+  GtkTreeIter iter;
+
+  if( !gtk_tree_row_reference_valid(row) )
+    return;
+
+  model = gtk_tree_row_reference_get_model(row);
+  path = gtk_tree_row_reference_get_path(row);
+
+  if( gtk_tree_model_get_iter(model, &iter, path) )
+    gtk_list_store_set(GTK_LIST_STORE(model), &iter, m_nIconColumn, pixbuf, -1);
+
+  gtk_tree_path_free(path);
+}
+
+/*! \fn void CIconAnimator::m_Evict(gsize nNeeded)
+    \brief To drop the animations not shown in the current tick, least recently shown first, until the memory budget has room.
+
+    \param[in] nNeeded. The memory wanted for a new animation.
+    \return NONE
+*/
+void CIconAnimator::m_Evict(gsize nNeeded)
+{
+  while( m_nBytes + nNeeded > m_nMaxBytes )
+  {
+     ICON_ANIM_ENTRY *oldest = NULL;
+     gchar *oldestName = NULL;
+     GHashTableIter iter;
+     gpointer key = NULL, value = NULL;
+
+     g_hash_table_iter_init(&iter, m_pAnimations);
+     while( g_hash_table_iter_next(&iter, &key, &value) )
+     {
+        ICON_ANIM_ENTRY *entry = (ICON_ANIM_ENTRY*)value;
+
+        if( (entry->lastUsed != m_nTick) && (!oldest || (entry->lastUsed < oldest->lastUsed)) )
+        {
+           oldest = entry;
+           oldestName = (gchar*)key;
+        }
+     }
+
+     if(!oldest)
+       break;
+
+     if(oldest->iter)
+       m_SetThumbnail(oldest, oldest->staticIcon);
+
+     m_nBytes -= MIN(m_nBytes, oldest->nBytes);
+     g_hash_table_remove(m_pAnimations, oldestName);
+  }
+}
+
+/*! \fn gboolean CIconAnimator::m_CollectPath(GtkTreeModel *model, GtkTreePath *path, GPtrArray *active, guint *pLoads)
+    \brief To make the animation of an item active in this tick, queueing it to the loading thread if it was not yet.
+
+    \param[in] model. The model of the icon view.
+    \param[in] path. The item.
+    \param[in,out] active. The active ICON_ANIM_ENTRY of this tick.
+    \param[in,out] pLoads. The number of animations queued in this tick.
+    \return FALSE if the item could be an animation but was not queued, because of the loading limit of a tick.
+*/
+gboolean CIconAnimator::m_CollectPath(GtkTreeModel *model, GtkTreePath *path, GPtrArray *active, guint *pLoads)
+{
+  ICON_ANIM_ENTRY *entry = NULL;
+  ICON_ANIM_LOAD *load = NULL;
+  GtkTreeIter iter;
+  gchar *fullName = NULL;
+  const gchar *ext = NULL;
+
+  if( !gtk_tree_model_get_iter(model, &iter, path) )
+    return true;
+
+  gtk_tree_model_get(model, &iter, m_nPathColumn, &fullName, -1);
+
+  /* Only GIF files are animated, the others are not even looked at. */
+  ext = fullName ? strrchr(fullName, '.') : NULL;
+  if( !ext || (g_ascii_strcasecmp(ext, ".gif") != 0) || g_hash_table_lookup(m_pStaticNames, fullName) ||
+      g_hash_table_contains(m_pLoading, fullName) )
+  {
+     g_free(fullName);
+     return true;
+  }
+
+  entry = (ICON_ANIM_ENTRY*)g_hash_table_lookup(m_pAnimations, fullName);
+  if(entry)
+  {
+     /* An item could be selected and visible at once. */
+     if(entry->lastUsed != m_nTick)
+     {
+        entry->lastUsed = m_nTick;
+        g_ptr_array_add(active, entry);
+     }
+
+     g_free(fullName);
+     return true;
+  }
+
+  if(*pLoads >= ICON_ANIM_LOADS_PER_TICK)
+  {
+     g_free(fullName);
+     return false;
+  }
+
+  (*pLoads)++;
+
+  load = g_new0(ICON_ANIM_LOAD, 1);
+  load->fullName = fullName;
+  load->row = gtk_tree_row_reference_new(model, path);
+  load->nMaxBytes = m_nMaxBytes;
+  load->nGeneration = m_nGeneration;
+
+  g_hash_table_add(m_pLoading, g_strdup(fullName));
+  g_thread_pool_push(m_pLoadPool, load, NULL);
+
+  return true;
+}
+
+/*! \fn void CIconAnimator::m_Advance(GPtrArray *active)
+    \brief To show the current frames of the active animations, at most ICON_ANIM_FRAMES_PER_TICK of them.
+
+    \param[in] active. The active ICON_ANIM_ENTRY of this tick.
+    \return NONE
+*/
+void CIconAnimator::m_Advance(GPtrArray *active)
+{
+  guint nCount = MIN(active->len, (guint)ICON_ANIM_FRAMES_PER_TICK);
+
+  if(active->len == 0)
+    return;
+
+  for(guint n=0; n<nCount; n++)
+  {
+     ICON_ANIM_ENTRY *entry = (ICON_ANIM_ENTRY*)g_ptr_array_index(active, (m_nNextAdvance + n) % active->len);
+     GdkPixbuf *frame = NULL, *thumbnail = NULL;
+
+     /* A NULL time is the current time, GTimeVal is deprecated. */
+     if( !gdk_pixbuf_animation_iter_advance(entry->iter, NULL) && !entry->bFresh )
+       continue;
+
+     entry->bFresh = false;
+     frame = gdk_pixbuf_animation_iter_get_pixbuf(entry->iter);
+     if(!frame)
+       continue;
+
+     thumbnail = scale_frame(frame, m_nSize);
+     m_SetThumbnail(entry, thumbnail);
+     g_object_unref(thumbnail);
+  }
+
+  /* The animations not advanced in this tick are advanced first in the next one. */
+  m_nNextAdvance = (m_nNextAdvance + nCount) % active->len;
+}
+
+/*! \fn gboolean CIconAnimator::m_Tick(void)
+    \brief To find the items to animate, the selected ones first, then the one under the pointer, then the visible ones,
+           and to show their current frames.
+
+    \param[in] NONE
+    \return FALSE to stop the timer, when nothing is animated.
+*/
+gboolean CIconAnimator::m_Tick(void)
+{
+  GtkTreeModel *model = NULL;
+  GtkTreePath *start = NULL, *end = NULL;
+  GPtrArray *active = NULL;
+  GList *selected = NULL;
+  GHashTableIter hashIter;
+  gpointer value = NULL;
+  guint nLoads = 0;
+  gboolean bPending = false;
+
+  model = m_pIconView ? gtk_icon_view_get_model(m_pIconView) : NULL;
+
+  if( !m_bEnabled || !model )
+  {
+     m_nTimer = 0;
+     return false;
+  }
+
+  m_nTick++;
+  active = g_ptr_array_new();
+
+  selected = gtk_icon_view_get_selected_items(m_pIconView);
+  for(GList *node=selected; node; node=node->next)
+  {
+     bPending |= !m_CollectPath(model, (GtkTreePath*)node->data, active, &nLoads);
+     gtk_tree_path_free((GtkTreePath*)node->data);
+  }
+
+  g_list_free(selected);
+
+  if(m_pHoverPath)
+    bPending |= !m_CollectPath(model, m_pHoverPath, active, &nLoads);
+
+  if( gtk_icon_view_get_visible_range(m_pIconView, &start, &end) )
+  {
+     for(GtkTreePath *path=start; gtk_tree_path_compare(path, end) <= 0; gtk_tree_path_next(path))
+       bPending |= !m_CollectPath(model, path, active, &nLoads);
+
+     gtk_tree_path_free(start);
+     gtk_tree_path_free(end);
+  }
+
+  /* The animations loaded meanwhile are shown from the next tick, if their items are still shown. */
+  bPending |= m_TakeLoaded();
+  bPending |= (g_hash_table_size(m_pLoading) > 0);
+
+  /* The animations not shown any more get their static thumbnails back, their frames are kept while the budget allows. */
+  g_hash_table_iter_init(&hashIter, m_pAnimations);
+  while( g_hash_table_iter_next(&hashIter, NULL, &value) )
+  {
+     ICON_ANIM_ENTRY *entry = (ICON_ANIM_ENTRY*)value;
+
+     if( (entry->lastUsed != m_nTick) && entry->iter )
+     {
+        m_SetThumbnail(entry, entry->staticIcon);
+        g_object_unref(entry->iter);
+        entry->iter = NULL;
+     }
+     else if( (entry->lastUsed == m_nTick) && !entry->iter )
+     {
+        entry->iter = gdk_pixbuf_animation_get_iter(entry->anim, NULL);
+        entry->bFresh = true;
+     }
+  }
+
+  m_Advance(active);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if( (m_nTick % (m_nFps * 10)) == 0 )
+    printf("%s(%d) - %u animations, %u active, %lu bytes \n", __FUNCTION__, __LINE__,
+           g_hash_table_size(m_pAnimations), active->len, (gulong)m_nBytes);
+  #endif
+
+  if( (active->len == 0) && !bPending )
+  {
+     g_ptr_array_free(active, TRUE);
+     m_nTimer = 0;
+     return false;
+  }
+
+  g_ptr_array_free(active, TRUE);
+
+  return true;
+}
+
+/*! \fn gboolean CIconAnimator::cb_tick(gpointer data)
+    \brief The timer callback function of the animations.
+*/
+gboolean CIconAnimator::cb_tick(gpointer data)
+{
+  return ((CIconAnimator*)data)->m_Tick();
+}
+
+/*! \fn gboolean CIconAnimator::cb_motion_notify(GtkWidget *widget, GdkEventMotion *event, gpointer data)
+    \brief The callback function to follow the item under the pointer.
+*/
+gboolean CIconAnimator::cb_motion_notify(GtkWidget *widget, GdkEventMotion *event, gpointer data)
+{
+  CIconAnimator *thisObject = (CIconAnimator*)data;
+  GtkTreePath *path = gtk_icon_view_get_path_at_pos(GTK_ICON_VIEW(widget), (gint)event->x, (gint)event->y);
+
+  if( (path == NULL) && (thisObject->m_pHoverPath == NULL) )
+    return false;
+
+  if( path && thisObject->m_pHoverPath && (gtk_tree_path_compare(path, thisObject->m_pHoverPath) == 0) )
+  {
+     gtk_tree_path_free(path);
+     return false;
+  }
+
+  if(thisObject->m_pHoverPath)
+    gtk_tree_path_free(thisObject->m_pHoverPath);
+
+  thisObject->m_pHoverPath = path;
+  thisObject->m_Kick();
+
+  return false;
+}
+
+/*! \fn gboolean CIconAnimator::cb_leave_notify(GtkWidget *widget, GdkEventCrossing *event, gpointer data)
+    \brief The callback function to forget the item under the pointer when it leaves the view.
+*/
+gboolean CIconAnimator::cb_leave_notify(GtkWidget *widget, GdkEventCrossing *event, gpointer data)
+{
+  CIconAnimator *thisObject = (CIconAnimator*)data;
+
+  if(thisObject->m_pHoverPath)
+    gtk_tree_path_free(thisObject->m_pHoverPath);
+
+  thisObject->m_pHoverPath = NULL;
+
+  return false;
+}
+
+/*! \fn gboolean CIconAnimator::cb_expose(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    \brief The callback function to look for animations when other items are shown, e.g. after scrolling.
+*/
+gboolean CIconAnimator::cb_expose(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+{
+  ((CIconAnimator*)data)->m_Kick();
+
+  return false;
+}
+
+/*! \fn void CIconAnimator::cb_destroy(GtkWidget *widget, gpointer data)
+    \brief The callback function to detach from an icon view being destroyed.
+*/
+void CIconAnimator::cb_destroy(GtkWidget *widget, gpointer data)
+{
+  CIconAnimator *thisObject = (CIconAnimator*)data;
+
+  if(thisObject->m_nTimer)
+    g_source_remove(thisObject->m_nTimer);
+
+  thisObject->m_nTimer = 0;
+  thisObject->m_Reset();
+  thisObject->m_pIconView = NULL;
+}
@@ -0,0 +1,104 @@
+/*! \file    CIconAnimator.h
+    \brief   Declaration of class CIconAnimator.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONANIMATOR
+#define __CICONANIMATOR
+
+#include <gtk/gtk.h>
+
+/* The frames shown per second by all animations together at most. */
+#define ICON_ANIM_MAX_FPS          15
+
+/* The memory the decoded frames of all animations could take, in bytes. */
+#define ICON_ANIM_MAX_BYTES        (16 * 1024 * 1024)
+
+/* The animations queued to the loading thread in one tick at most. */
+#define ICON_ANIM_LOADS_PER_TICK   2
+
+/* The largest GIF file animated, the larger ones keep their static thumbnails without being read. */
+#define ICON_ANIM_MAX_FILE_BYTES   (4 * 1024 * 1024)
+
+/* The bytes fed to the loader at once, the loading stops between two chunks when it is cancelled. */
+#define ICON_ANIM_LOAD_CHUNK       (64 * 1024)
+
+/* The thumbnails updated in one tick at most, the others wait for the next tick. */
+#define ICON_ANIM_FRAMES_PER_TICK  64
+
+/*! \class CIconAnimator
+    \brief Plays the animated GIF icons of an icon view in their thumbnails.
+
+    Only the items selected, under the pointer or visible are animated, their GdkPixbufAnimation is decoded by a loading
+    thread the first time they become one of those. The blocks of the GIF are walked before decoding, so the size of all
+    its frames is known and charged to the memory budget at once; an animation which could never fit is not decoded.
+    A single timer at ICON_ANIM_MAX_FPS advances the animations, at most ICON_ANIM_FRAMES_PER_TICK thumbnails per tick,
+    and takes the loaded ones. The animations not shown for the longest time are dropped when the budget is exceeded.
+    A thumbnail which stops animating gets its static image back.
+*/
+class CIconAnimator
+{
+  private:
+    GtkIconView *m_pIconView;     /*!< The icon view animated, NULL if it is not attached. */
+    gint m_nIconColumn;           /*!< The model column of the thumbnail. */
+    gint m_nPathColumn;           /*!< The model column of the icon's full file name. */
+    gint m_nSize;                 /*!< The thumbnail size the frames are scaled to. */
+    gboolean m_bEnabled;          /*!< To indicate if the animations are played. */
+    guint m_nFps;                 /*!< The frame rate budget. */
+    gsize m_nMaxBytes;            /*!< The memory budget. */
+    gsize m_nBytes;               /*!< The memory taken by the decoded frames of all animations. */
+    guint m_nTimer;               /*!< The source ID of the timer, 0 if it is not running. */
+    guint m_nTick;                /*!< The number of ticks, to know which animations were shown last. */
+    guint m_nNextAdvance;         /*!< The first active animation advanced in the next tick, so all of them take turns. */
+    GtkTreePath *m_pHoverPath;    /*!< The item under the pointer, NULL if none. */
+    GHashTable *m_pAnimations;    /*!< The full file name to its ICON_ANIM_ENTRY. */
+    GHashTable *m_pStaticNames;   /*!< The full file names known not to be animations, or refused by the memory budget. */
+    GHashTable *m_pLoading;       /*!< The full file names queued to the loading thread. */
+    GThreadPool *m_pLoadPool;     /*!< The loading thread, one GIF at a time. */
+    GAsyncQueue *m_pLoaded;       /*!< The ICON_ANIM_LOAD finished by the loading thread, taken by the timer. */
+    gint m_nGeneration;           /*!< Increased when the loads in progress are cancelled, their results are dropped. */
+
+    gboolean m_Tick(void);
+    gboolean m_CollectPath(GtkTreeModel *model, GtkTreePath *path, GPtrArray *active, guint *pLoads);
+    void m_Advance(GPtrArray *active);
+    void m_Evict(gsize nNeeded);
+    void m_SetThumbnail(gpointer entry, GdkPixbuf *pixbuf);
+    gboolean m_TakeLoaded(void);
+    void m_CancelLoads(void);
+
+    static gboolean cb_tick(gpointer data);
+    static void cb_load_thread(gpointer data, gpointer thisObject);
+    static void m_FreeLoad(gpointer data);
+    static gboolean cb_motion_notify(GtkWidget *widget, GdkEventMotion *event, gpointer data);
+    static gboolean cb_leave_notify(GtkWidget *widget, GdkEventCrossing *event, gpointer data);
+    static gboolean cb_expose(GtkWidget *widget, GdkEventExpose *event, gpointer data);
+    static void cb_destroy(GtkWidget *widget, gpointer data);
+    static void m_FreeEntry(gpointer data);
+
+  public:
+    CIconAnimator(gint iconColumn, gint pathColumn, gint size);
+    ~CIconAnimator();
+
+    /* To animate the items of an icon view, NULL to detach from it. */
+    void m_Attach(GtkIconView *iconView);
+
+    /* To drop all animations without restoring the thumbnails, when the model is replaced. */
+    void m_Reset(void);
+
+    /* To start the timer if there could be something to animate, e.g. the selection changed. */
+    void m_Kick(void);
+
+    void m_SetEnabled(gboolean enabled);
+    gboolean m_GetEnabled(void) { return m_bEnabled; }
+
+    void m_SetSize(gint size) { m_nSize = size; }
+    void m_SetBudget(guint fps, gsize maxBytes);
+    gsize m_GetBytes(void) { return m_nBytes; }
+    guint m_GetCount(void) { return g_hash_table_size(m_pAnimations); }
+};
+#endif   /* CICONANIMATOR.H	*/
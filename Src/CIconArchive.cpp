@@ -0,0 +1,829 @@
+/*! \file    CIconArchive.cpp
+    \brief   List and stream the icon files inside zip and tar archives, without extracting them.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "CIconArchive.h"
+#include "CIconContentCache.h"
+#include "CIconStreamDecoder.h"
+
+/* The signatures and fixed sizes of the zip records. */
+#define ZIP_END_SIGNATURE     0x06054b50
+#define ZIP_END_SIZE          22
+#define ZIP_ENTRY_SIGNATURE   0x02014b50
+#define ZIP_ENTRY_SIZE        46
+#define ZIP_LOCAL_SIGNATURE   0x04034b50
+#define ZIP_LOCAL_SIZE        30
+#define ZIP_MAX_COMMENT       65535
+
+/* The zip compression methods read. */
+#define ZIP_METHOD_STORED     0
+#define ZIP_METHOD_DEFLATED   8
+
+/* The tar record size, and the longest long name or extended header read. */
+#define TAR_BLOCK_SIZE        512
+#define TAR_MAX_EXTENDED      (64 * 1024)
+
+/*! \fn static guint16 get_le16(const guchar *p)
+    \brief To read a little-endian 16-bit number of a zip record.
+*/
+static guint16 get_le16(const guchar *p)
+{
+  return (guint16)(p[0] | (p[1] << 8));
+}
+
+/*! \fn static guint32 get_le32(const guchar *p)
+    \brief To read a little-endian 32-bit number of a zip record.
+*/
+static guint32 get_le32(const guchar *p)
+{
+  return (guint32)p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+}
+
+/*! \fn static gboolean pread_all(gint fd, void *buf, gsize len, guint64 offset)
+    \brief To read exactly "len" bytes of a file at an offset, without moving the shared file position.
+
+    \param[in] fd. The file.
+    \param[out] buf. The buffer.
+    \param[in] len. The number of bytes.
+    \param[in] offset. The offset in the file.
+    \return TRUE or FALSE
+*/
+static gboolean pread_all(gint fd, void *buf, gsize len, guint64 offset)
+{
+  guchar *p = (guchar*)buf;
+
+  while(len > 0)
+  {
+     ssize_t n = pread(fd, p, len, (off_t)offset);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+       return false;
+
+     p += n;
+     len -= n;
+     offset += n;
+  }
+
+  return true;
+}
+
+/*! \fn static guint64 tar_number(const guchar *field, gsize length)
+    \brief To read a number field of a tar header, in octal or in the base-256 of GNU tar for large sizes.
+
+    \param[in] field. The field.
+    \param[in] length. The length of the field.
+    \return The number.
+*/
+static guint64 tar_number(const guchar *field, gsize length)
+{
+  guint64 value = 0;
+  gsize i = 0;
+
+  if(field[0] & 0x80)
+  {
+     value = field[0] & 0x3f;
+     for(i=1; i<length; i++)
+       value = (value << 8) | field[i];
+
+     return value;
+  }
+
+  while( (i < length) && ((field[i] == ' ') || (field[i] == '\0')) )
+    i++;
+
+  for(; (i < length) && (field[i] >= '0') && (field[i] <= '7'); i++)
+    value = (value << 3) | (field[i] - '0');
+
+  return value;
+}
+
+/*! \fn static gboolean tar_checksum_ok(const guchar *header)
+    \brief To check the checksum of a tar header, so a file which is not a tar is refused at its first block.
+
+    \param[in] header. The header block.
+    \return TRUE or FALSE
+*/
+static gboolean tar_checksum_ok(const guchar *header)
+{
+  guint64 sum = 0;
+
+  /* The checksum field is summed as spaces. */
+  for(gint i=0; i<TAR_BLOCK_SIZE; i++)
+    sum += ((i >= 148) && (i < 156)) ? ' ' : header[i];
+
+  return sum == tar_number(header + 148, 8);
+}
+
+/*! \fn static gchar* tar_header_name(const guchar *header)
+    \brief To get the name of a tar header, with the prefix of a POSIX ustar header.
+
+    \param[in] header. The header block.
+    \return The name, it must be freed.
+*/
+static gchar* tar_header_name(const guchar *header)
+{
+  gchar *name = g_strndup((const gchar*)header, 100);
+
+  if( (memcmp(header + 257, "ustar", 5) == 0) && header[345] )
+  {
+     gchar *prefix = g_strndup((const gchar*)header + 345, 155);
+     gchar *fullName = g_strdup_printf("%s/%s", prefix, name);
+
+     g_free(prefix);
+     g_free(name);
+     name = fullName;
+  }
+
+  return name;
+}
+
+/*! \fn static gchar* tar_pax_path(const gchar *data, gsize length)
+    \brief To get the "path" record of a POSIX extended header, "<length> path=<name>\n".
+
+    \param[in] data. The extended header.
+    \param[in] length. The number of bytes.
+    \return The path, it must be freed. NULL if there is none.
+*/
+static gchar* tar_pax_path(const gchar *data, gsize length)
+{
+  gchar *path = NULL;
+  gsize pos = 0;
+
+  while(pos < length)
+  {
+     gchar *end = NULL;
+     gulong recordLength = strtoul(data + pos, &end, 10);
+     const gchar *key = end + 1;
+
+     if( (end == data + pos) || (*end != ' ') || (recordLength == 0) || (pos + recordLength > length) )
+       break;
+
+     if( (strncmp(key, "path=", 5) == 0) && (data[pos + recordLength - 1] == '\n') )
+     {
+        g_free(path);
+        path = g_strndup(key + 5, data + pos + recordLength - 1 - (key + 5));
+     }
+
+     pos += recordLength;
+  }
+
+  return path;
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconArchive::CIconArchive(const gchar *fileName)
+    \brief CIconArchive constructor, with a reference.
+
+    \param[in] fileName. The archive file.
+*/
+CIconArchive::CIconArchive(const gchar *fileName)
+{
+  m_FileName = g_strdup(fileName);
+  m_nFormat = m_GetFormat(fileName);
+  m_nFd = -1;
+  m_nMtime = 0;
+  m_nSize = 0;
+  m_pMembers = g_array_new(FALSE, TRUE, sizeof(ICON_ARCHIVE_MEMBER));
+  m_pIndex = g_hash_table_new(g_str_hash, g_str_equal);
+  m_pInflated = NULL;
+  m_nRef = 1;
+}
+
+/*! \fn CIconArchive::~CIconArchive()
+    \brief CIconArchive destructor, when the last reference is dropped.
+*/
+CIconArchive::~CIconArchive()
+{
+  if(m_nFd >= 0)
+    close(m_nFd);
+
+  /* The index shares the names of the members. */
+  g_hash_table_destroy(m_pIndex);
+
+  for(guint i=0; i<m_pMembers->len; i++)
+    g_free(g_array_index(m_pMembers, ICON_ARCHIVE_MEMBER, i).name);
+
+  g_array_free(m_pMembers, TRUE);
+
+  if(m_pInflated)
+    g_byte_array_free(m_pInflated, TRUE);
+
+  g_free(m_FileName);
+
+  m_nFd = -1;
+  m_pIndex = NULL;
+  m_pMembers = NULL;
+  m_pInflated = NULL;
+  m_FileName = NULL;
+}
+
+/*! \fn gboolean CIconArchive::m_Open(ICON_NAME_FILTER filter)
+    \brief To open the archive and read its directory once.
+
+    \param[in] filter. The function the base names of the members must pass, NULL keeps all files.
+    \return TRUE or FALSE
+*/
+gboolean CIconArchive::m_Open(ICON_NAME_FILTER filter)
+{
+  struct stat st;
+  gboolean bRet = false;
+
+  if( (m_nFd >= 0) || (m_nFormat == ICON_ARCHIVE_None) )
+    return false;
+
+  m_nFd = open(m_FileName, O_RDONLY | O_CLOEXEC);
+  if(m_nFd < 0)
+    return false;
+
+  if( (fstat(m_nFd, &st) != 0) || !S_ISREG(st.st_mode) )
+    return false;
+
+  m_nMtime = (gint64)st.st_mtime;
+  m_nSize = (guint64)st.st_size;
+
+  if(m_nFormat == ICON_ARCHIVE_Zip)
+    bRet = m_ReadZipDirectory(filter);
+  else
+    bRet = m_ReadTarHeaders(filter);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("\n %s(%d) %s: %s, %u icon members. \n", __FUNCTION__, __LINE__, m_FileName, bRet ? "opened" : "not readable", m_pMembers->len);
+  #endif
+
+  return bRet;
+}
+
+/*! \fn gboolean CIconArchive::m_IsCurrent(void)
+    \brief To check if the archive file was not replaced or changed since it was opened.
+
+    \param[in] NONE
+    \return TRUE or FALSE
+*/
+gboolean CIconArchive::m_IsCurrent(void)
+{
+  struct stat st;
+
+  if( (m_nFd < 0) || (stat(m_FileName, &st) != 0) )
+    return false;
+
+  return ((gint64)st.st_mtime == m_nMtime) && ((guint64)st.st_size == m_nSize);
+}
+
+/*! \fn gchar* CIconArchive::m_TakeName(gchar *name, ICON_NAME_FILTER filter)
+    \brief To check the name of a member before it is listed.
+
+    \param[in] name. The name read from the archive, it is taken.
+    \param[in] filter. The function the base name must pass, NULL keeps all files.
+    \return The name without a leading "./", NULL(and freed) for a directory, a filtered out file, a member listed
+            already or when the archive has ICON_ARCHIVE_MAX_MEMBERS.
+*/
+gchar* CIconArchive::m_TakeName(gchar *name, ICON_NAME_FILTER filter)
+{
+  gchar *baseName = NULL;
+  gboolean bKeep = false;
+
+  while( g_str_has_prefix(name, "./") )
+    memmove(name, name + 2, strlen(name + 2) + 1);
+
+  baseName = strrchr(name, '/');
+  baseName = baseName ? baseName + 1 : name;
+
+  /* The later copy of a member appended to a tar replaces the former, the former is kept here. It rarely matters. */
+  bKeep = (*baseName != '\0') && (!filter || filter(baseName)) &&
+          (m_pMembers->len < ICON_ARCHIVE_MAX_MEMBERS) && !g_hash_table_lookup(m_pIndex, name);
+
+  if(!bKeep)
+  {
+     g_free(name);
+     return NULL;
+  }
+
+  return name;
+}
+
+/*! \fn void CIconArchive::m_AddMember(gchar *name, ICON_ARCHIVE_MEMBER *pMember)
+    \brief To list a member.
+
+    \param[in] name. The name from m_TakeName(), it is taken.
+    \param[in] pMember. The member, copied.
+    \return NONE
+*/
+void CIconArchive::m_AddMember(gchar *name, ICON_ARCHIVE_MEMBER *pMember)
+{
+  pMember->name = name;
+  g_array_append_val(m_pMembers, *pMember);
+  g_hash_table_insert(m_pIndex, name, GUINT_TO_POINTER(m_pMembers->len));
+}
+
+/*! \fn gboolean CIconArchive::m_ReadZipDirectory(ICON_NAME_FILTER filter)
+    \brief To read the central directory of a zip archive, from the end of central directory record.
+    \n A zip64 archive, an encrypted member or a compression method other than stored and deflated is not read.
+
+    \param[in] filter. The function the base names of the members must pass.
+    \return TRUE or FALSE
+*/
+gboolean CIconArchive::m_ReadZipDirectory(ICON_NAME_FILTER filter)
+{
+  gsize tailLength = (gsize)MIN(m_nSize, (guint64)(ZIP_END_SIZE + ZIP_MAX_COMMENT));
+  guchar *tail = NULL;
+  guchar *directory = NULL;
+  const guchar *end = NULL;
+  guint32 dirSize = 0;
+  guint32 dirOffset = 0;
+  guint32 pos = 0;
+  guint nEntries = 0;
+
+  if(tailLength < ZIP_END_SIZE)
+    return false;
+
+  tail = (guchar*)g_malloc(tailLength);
+  if( !pread_all(m_nFd, tail, tailLength, m_nSize - tailLength) )
+  {
+     g_free(tail);
+     return false;
+  }
+
+  /* The record is the last one, followed only by the archive comment. */
+  for(gsize i=tailLength-ZIP_END_SIZE+1; (i > 0) && !end; i--)
+  {
+     if( get_le32(tail + i - 1) == ZIP_END_SIGNATURE )
+       end = tail + i - 1;
+  }
+
+  if(end)
+  {
+     nEntries = get_le16(end + 10);
+     dirSize = get_le32(end + 12);
+     dirOffset = get_le32(end + 16);
+  }
+
+  g_free(tail);
+
+  if( !end || (dirOffset == 0xffffffff) || (dirSize > ICON_ARCHIVE_MAX_DIRECTORY) || ((guint64)dirOffset + dirSize > m_nSize) )
+    return false;
+
+  directory = (guchar*)g_malloc(dirSize + 1);
+  if( !pread_all(m_nFd, directory, dirSize, dirOffset) )
+  {
+     g_free(directory);
+     return false;
+  }
+
+  for(guint i=0; (i < nEntries) && (pos + ZIP_ENTRY_SIZE <= dirSize); i++)
+  {
+     const guchar *entry = directory + pos;
+     guint16 flags = get_le16(entry + 8);
+     guint16 method = get_le16(entry + 10);
+     guint16 nameLength = get_le16(entry + 28);
+     guint32 entryLength = ZIP_ENTRY_SIZE + nameLength + get_le16(entry + 30) + get_le16(entry + 32);
+
+     if( (get_le32(entry) != ZIP_ENTRY_SIGNATURE) || (pos + entryLength > dirSize) )
+       break;
+
+     /* Bit 0 is encryption. A directory is named with a trailing slash. */
+     if( !(flags & 0x0001) && ((method == ZIP_METHOD_STORED) || (method == ZIP_METHOD_DEFLATED)) &&
+         (nameLength > 0) && (entry[ZIP_ENTRY_SIZE + nameLength - 1] != '/') )
+     {
+        gchar *name = m_TakeName(g_strndup((const gchar*)entry + ZIP_ENTRY_SIZE, nameLength), filter);
+
+        if(name)
+        {
+           ICON_ARCHIVE_MEMBER member;
+
+           memset(&member, 0x00, sizeof(member));
+           member.crc = get_le32(entry + 16);
+           member.packedSize = get_le32(entry + 20);
+           member.size = get_le32(entry + 24);
+           member.offset = get_le32(entry + 42);
+           member.method = method;
+
+           m_AddMember(name, &member);
+        }
+     }
+
+     pos += entryLength;
+  }
+
+  g_free(directory);
+
+  return true;
+}
+
+/*! \fn gboolean CIconArchive::m_ReadTarHeaders(ICON_NAME_FILTER filter)
+    \brief To read the member headers of a tar archive, compressed by gzip or not.
+    \n zlib reads a file which is not compressed as it is, so both are read by one pass here. The data of the other
+    members is skipped, by seeking in a plain tar. In a compressed tar it must be inflated to be skipped, and the
+    icon members are kept in m_pInflated then, since reading one later would inflate the archive from its start.
+
+    \param[in] filter. The function the base names of the members must pass.
+    \return TRUE or FALSE
+*/
+gboolean CIconArchive::m_ReadTarHeaders(ICON_NAME_FILTER filter)
+{
+  guchar header[TAR_BLOCK_SIZE];
+  gchar *longName = NULL;
+  gint fd = dup(m_nFd);
+  gzFile gz = (fd >= 0) ? gzdopen(fd, "rb") : NULL;
+  gboolean bRet = true;
+  gboolean bFirst = true;
+
+  if(gz == NULL)
+  {
+     if(fd >= 0)
+       close(fd);
+
+     return false;
+  }
+
+  while( bRet && (gzread(gz, header, TAR_BLOCK_SIZE) == TAR_BLOCK_SIZE) )
+  {
+     guint64 size = 0;
+     guint64 padded = 0;
+     gchar type = 0;
+     gchar *name = NULL;
+
+     /* The end of the archive is a zeroed block. */
+     if(header[0] == '\0')
+       break;
+
+     /* A file which is not a tar, compressed or not, is refused at its first block. */
+     if( !tar_checksum_ok(header) )
+     {
+        bRet = !bFirst;
+        break;
+     }
+
+     if(bFirst)
+     {
+        bFirst = false;
+        if( !gzdirect(gz) )
+        {
+           m_nFormat = ICON_ARCHIVE_TarGz;
+           m_pInflated = g_byte_array_new();
+        }
+     }
+
+     size = tar_number(header + 124, 12);
+     padded = (size + TAR_BLOCK_SIZE - 1) & ~((guint64)TAR_BLOCK_SIZE - 1);
+     type = (gchar)header[156];
+
+     /* The name of the next member, from a GNU long name or a POSIX extended header. */
+     if( ((type == 'L') || (type == 'x')) && (size <= TAR_MAX_EXTENDED) )
+     {
+        gchar *data = (gchar*)g_malloc0(padded + 1);
+
+        bRet = (gzread(gz, data, (unsigned)padded) == (int)padded);
+        if(bRet)
+        {
+           gchar *extendedName = (type == 'L') ? g_strndup(data, size) : tar_pax_path(data, size);
+
+           if(extendedName)
+           {
+              g_free(longName);
+              longName = extendedName;
+           }
+        }
+
+        g_free(data);
+        continue;
+     }
+
+     name = longName ? longName : tar_header_name(header);
+     longName = NULL;
+
+     /* Only the regular files, '7' is a contiguous file. */
+     if( (type == '0') || (type == '\0') || (type == '7') )
+       name = m_TakeName(name, filter);
+     else
+     {
+        g_free(name);
+        name = NULL;
+     }
+
+     if( name && m_pInflated && ((guint64)m_pInflated->len + size > ICON_ARCHIVE_MAX_INFLATED) )
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        printf("\n %s(%d) %s: the icons over %d bytes are not listed. \n", __FUNCTION__, __LINE__, m_FileName, ICON_ARCHIVE_MAX_INFLATED);
+        #endif
+
+        g_free(name);
+        name = NULL;
+     }
+
+     if(name)
+     {
+        ICON_ARCHIVE_MEMBER member;
+
+        memset(&member, 0x00, sizeof(member));
+        member.size = size;
+        member.packedSize = size;
+
+        if(m_pInflated)
+        {
+           member.offset = m_pInflated->len;
+           g_byte_array_set_size(m_pInflated, m_pInflated->len + size);
+
+           bRet = (gzread(gz, m_pInflated->data + member.offset, (unsigned)size) == (int)size);
+           padded -= size;
+        }
+        else
+          member.offset = (guint64)gztell(gz);
+
+        if(bRet)
+          m_AddMember(name, &member);
+        else
+          g_free(name);
+     }
+
+     if( bRet && (padded > 0) && (gzseek(gz, (z_off_t)padded, SEEK_CUR) < 0) )
+       bRet = false;
+  }
+
+  g_free(longName);
+  gzclose(gz);
+
+  /* A truncated archive keeps the members read completely. */
+  return bRet || (m_pMembers->len > 0);
+}
+
+/*! \fn const ICON_ARCHIVE_MEMBER* CIconArchive::m_Lookup(const gchar *memberName)
+    \brief To find a member by its path inside the archive.
+
+    \param[in] memberName. The path of the member.
+    \return The member, NULL if it is not listed.
+*/
+const ICON_ARCHIVE_MEMBER* CIconArchive::m_Lookup(const gchar *memberName)
+{
+  guint nPosition = memberName ? GPOINTER_TO_UINT(g_hash_table_lookup(m_pIndex, memberName)) : 0;
+
+  return nPosition ? m_GetMember(nPosition - 1) : NULL;
+}
+
+/*! \fn gboolean CIconArchive::m_ReadMember(const ICON_ARCHIVE_MEMBER *pMember, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData)
+    \brief To feed the uncompressed bytes of a member to a function, ICON_STREAM_CHUNK_BYTES at a time.
+
+    \param[in] pMember. The member, from this archive.
+    \param[in] func. The function fed.
+    \param[in] userData. The user data passed to func.
+    \return TRUE if the whole member was fed and, for a zip, its CRC-32 matched.
+*/
+gboolean CIconArchive::m_ReadMember(const ICON_ARCHIVE_MEMBER *pMember, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData)
+{
+  guchar local[ZIP_LOCAL_SIZE];
+  guint64 offset = 0;
+
+  /* The decoding limits hold for the members as for the files. */
+  if( !pMember || !func || (m_nFd < 0) || (pMember->size > CIconStreamDecoder::m_GetMaxBytes()) )
+    return false;
+
+  if(m_pInflated)
+  {
+     for(offset=0; offset<pMember->size; offset+=ICON_STREAM_CHUNK_BYTES)
+     {
+        if( !func(m_pInflated->data + pMember->offset + offset, (gsize)MIN(pMember->size - offset, (guint64)ICON_STREAM_CHUNK_BYTES), userData) )
+          return false;
+     }
+
+     return true;
+  }
+
+  if(m_nFormat != ICON_ARCHIVE_Zip)
+    return m_ReadStored(pMember, pMember->offset, func, userData);
+
+  /* The local header has its own name and extra field lengths, they could differ from the central directory's. */
+  if( !pread_all(m_nFd, local, ZIP_LOCAL_SIZE, pMember->offset) || (get_le32(local) != ZIP_LOCAL_SIGNATURE) )
+    return false;
+
+  offset = pMember->offset + ZIP_LOCAL_SIZE + get_le16(local + 26) + get_le16(local + 28);
+
+  if(pMember->method == ZIP_METHOD_DEFLATED)
+    return m_ReadDeflated(pMember, offset, func, userData);
+
+  return m_ReadStored(pMember, offset, func, userData);
+}
+
+/*! \fn gboolean CIconArchive::m_ReadStored(const ICON_ARCHIVE_MEMBER *pMember, guint64 offset, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData)
+    \brief To feed a member stored without compression.
+
+    \param[in] pMember. The member.
+    \param[in] offset. The offset of its data in the archive.
+    \param[in] func. The function fed.
+    \param[in] userData. The user data passed to func.
+    \return TRUE or FALSE
+*/
+gboolean CIconArchive::m_ReadStored(const ICON_ARCHIVE_MEMBER *pMember, guint64 offset, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData)
+{
+  guchar *chunk = (guchar*)g_malloc(ICON_STREAM_CHUNK_BYTES);
+  guint64 left = pMember->size;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  gboolean bRet = true;
+
+  while( bRet && (left > 0) )
+  {
+     gsize n = (gsize)MIN(left, (guint64)ICON_STREAM_CHUNK_BYTES);
+
+     bRet = pread_all(m_nFd, chunk, n, offset);
+     if(bRet)
+     {
+        if(m_nFormat == ICON_ARCHIVE_Zip)
+          crc = crc32(crc, chunk, n);
+
+        bRet = func(chunk, n, userData);
+     }
+
+     offset += n;
+     left -= n;
+  }
+
+  g_free(chunk);
+
+  return bRet && ((m_nFormat != ICON_ARCHIVE_Zip) || (crc == pMember->crc));
+}
+
+/*! \fn gboolean CIconArchive::m_ReadDeflated(const ICON_ARCHIVE_MEMBER *pMember, guint64 offset, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData)
+    \brief To inflate a deflated zip member chunk by chunk.
+    \n A member inflating to more than the directory says is stopped there, it is corrupt or made to exhaust memory.
+
+    \param[in] pMember. The member.
+    \param[in] offset. The offset of its compressed data in the archive.
+    \param[in] func. The function fed.
+    \param[in] userData. The user data passed to func.
+    \return TRUE if it inflated to its size and CRC-32.
+*/
+gboolean CIconArchive::m_ReadDeflated(const ICON_ARCHIVE_MEMBER *pMember, guint64 offset, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData)
+{
+  z_stream stream;
+  guchar *input = NULL;
+  guchar *output = NULL;
+  guint64 packedLeft = pMember->packedSize;
+  guint64 total = 0;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  gint zret = Z_OK;
+  gboolean bRet = true;
+
+  memset(&stream, 0x00, sizeof(stream));
+
+  /* Raw deflate data, a zip member has no zlib header. */
+  if( inflateInit2(&stream, -MAX_WBITS) != Z_OK )
+    return false;
+
+  input = (guchar*)g_malloc(ICON_STREAM_CHUNK_BYTES);
+  output = (guchar*)g_malloc(ICON_STREAM_CHUNK_BYTES);
+
+  while( bRet && (zret != Z_STREAM_END) )
+  {
+     gsize produced = 0;
+
+     if(stream.avail_in == 0)
+     {
+        gsize n = (gsize)MIN(packedLeft, (guint64)ICON_STREAM_CHUNK_BYTES);
+
+        bRet = (n > 0) && pread_all(m_nFd, input, n, offset);
+        if(!bRet)
+          break;
+
+        offset += n;
+        packedLeft -= n;
+        stream.next_in = input;
+        stream.avail_in = (uInt)n;
+     }
+
+     stream.next_out = output;
+     stream.avail_out = ICON_STREAM_CHUNK_BYTES;
+
+     zret = inflate(&stream, Z_NO_FLUSH);
+     produced = ICON_STREAM_CHUNK_BYTES - stream.avail_out;
+     total += produced;
+
+     bRet = ((zret == Z_OK) || (zret == Z_STREAM_END)) && (total <= pMember->size);
+
+     if( bRet && (produced > 0) )
+     {
+        crc = crc32(crc, output, (uInt)produced);
+        bRet = func(output, produced, userData);
+     }
+  }
+
+  inflateEnd(&stream);
+  g_free(input);
+  g_free(output);
+
+  return bRet && (total == pMember->size) && (crc == pMember->crc);
+}
+
+/*! \fn guint64 CIconArchive::m_GetMemberHash(const ICON_ARCHIVE_MEMBER *pMember)
+    \brief To get the content hash of a member without reading it.
+    \n The members of a compressed tar are in memory, they hash as the same file on disk would. A zip member is
+    known by its CRC-32 and size, so identical members share a thumbnail. A plain tar member is known by its place.
+
+    \param[in] pMember. The member.
+    \return The content hash, never 0.
+*/
+guint64 CIconArchive::m_GetMemberHash(const ICON_ARCHIVE_MEMBER *pMember)
+{
+  guint64 hash = 0;
+
+  if(m_pInflated)
+    hash = CIconContentCache::m_HashBytes(m_pInflated->data + pMember->offset, (gsize)pMember->size);
+  else if(m_nFormat == ICON_ARCHIVE_Zip)
+  {
+     guint64 key[3] = { pMember->crc, pMember->size, 0x70697a };   /* "zip" */
+
+     hash = CIconContentCache::m_HashBytes((const guchar*)key, sizeof(key));
+  }
+  else
+  {
+     gchar *key = g_strdup_printf("%s|%" G_GINT64_FORMAT "|%" G_GUINT64_FORMAT, m_FileName, m_nMtime, pMember->offset);
+
+     hash = CIconContentCache::m_HashBytes((const guchar*)key, strlen(key));
+     g_free(key);
+  }
+
+  return hash;
+}
+
+/*! \fn gint CIconArchive::m_GetFormat(const gchar *fileName)
+    \brief To get the archive format of a file name by its suffix.
+
+    \param[in] fileName. The file name.
+    \return The ICON_ARCHIVE_FORMAT, ICON_ARCHIVE_None if it is not an archive.
+*/
+gint CIconArchive::m_GetFormat(const gchar *fileName)
+{
+  gint nFormat = ICON_ARCHIVE_None;
+  gchar *pStr = NULL;
+
+  if(!fileName)
+    return ICON_ARCHIVE_None;
+
+  pStr = g_ascii_strdown(fileName, -1);
+
+  if( g_str_has_suffix(pStr, ".zip") )
+    nFormat = ICON_ARCHIVE_Zip;
+  else if( g_str_has_suffix(pStr, ".tar") )
+    nFormat = ICON_ARCHIVE_Tar;
+  else if( g_str_has_suffix(pStr, ".tar.gz") || g_str_has_suffix(pStr, ".tgz") )
+    nFormat = ICON_ARCHIVE_TarGz;
+
+  g_free(pStr);
+
+  return nFormat;
+}
+
+/*! \fn gboolean CIconArchive::m_SplitMemberName(const gchar *fullName, gchar **pArchiveName, const gchar **pMemberName)
+    \brief To split the full name of an archive member, "archive!/member".
+
+    \param[in] fullName. The full name.
+    \param[out] pArchiveName. The archive file, it must be freed. Could be NULL.
+    \param[out] pMemberName. The member, pointing into fullName. Could be NULL.
+    \return TRUE if it is the name of a member, FALSE if it is a plain file name.
+*/
+gboolean CIconArchive::m_SplitMemberName(const gchar *fullName, gchar **pArchiveName, const gchar **pMemberName)
+{
+  const gchar *pSeparator = fullName;
+
+  if(!fullName)
+    return false;
+
+  /* An archive could be in a directory whose name has the separator as well. */
+  while( (pSeparator = strstr(pSeparator, ICON_ARCHIVE_SEPARATOR)) != NULL )
+  {
+     gchar *archiveName = g_strndup(fullName, pSeparator - fullName);
+
+     if( m_IsArchive(archiveName) && pSeparator[strlen(ICON_ARCHIVE_SEPARATOR)] )
+     {
+        if(pArchiveName)
+          *pArchiveName = archiveName;
+        else
+          g_free(archiveName);
+
+        if(pMemberName)
+          *pMemberName = pSeparator + strlen(ICON_ARCHIVE_SEPARATOR);
+
+        return true;
+     }
+
+     g_free(archiveName);
+     pSeparator += strlen(ICON_ARCHIVE_SEPARATOR);
+  }
+
+  return false;
+}
@@ -0,0 +1,125 @@
+/*! \file    CIconArchive.h
+    \brief   Declaration of class CIconArchive.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONARCHIVE
+#define __CICONARCHIVE
+
+#include <glib.h>
+
+#include "CIconSearchRoots.h"
+
+/* The separator between the archive file and a member in the full name of an icon, "pack.zip!/apps/a.png". */
+#define ICON_ARCHIVE_SEPARATOR  "!/"
+
+/* The icon members listed from one archive at most. */
+#define ICON_ARCHIVE_MAX_MEMBERS  65536
+
+/* The largest central directory of a zip archive read. */
+#define ICON_ARCHIVE_MAX_DIRECTORY  (16 * 1024 * 1024)
+
+/* A compressed tar has no directory, its icon members are inflated in one pass and kept, up to these bytes in total. */
+#define ICON_ARCHIVE_MAX_INFLATED  (64 * 1024 * 1024)
+
+/*! \enum ICON_ARCHIVE_FORMAT
+    \brief The archive formats, known by the file name suffix.
+*/
+enum ICON_ARCHIVE_FORMAT {
+  ICON_ARCHIVE_None = 0,
+  ICON_ARCHIVE_Zip,       /* ".zip", stored or deflated members. */
+  ICON_ARCHIVE_Tar,       /* ".tar" */
+  ICON_ARCHIVE_TarGz      /* ".tar.gz", ".tgz" */
+};
+
+/*! \struct ICON_ARCHIVE_MEMBER
+    \brief One icon file inside an archive.
+*/
+typedef struct _ICON_ARCHIVE_MEMBER
+{
+  gchar   *name;        /*!< The path of the member inside the archive, without a leading "./". */
+  guint64 offset;       /*!< Zip: the local header. Tar: the data. Compressed tar: the data in the inflated members. */
+  guint64 size;         /*!< The uncompressed size. */
+  guint64 packedSize;   /*!< The compressed size of a zip member, the size otherwise. */
+  guint32 crc;          /*!< The CRC-32 of a zip member, 0 otherwise. */
+  guint16 method;       /*!< The zip compression method, 0(stored) or 8(deflated). */
+} ICON_ARCHIVE_MEMBER;
+
+/*! \typedef ICON_ARCHIVE_CHUNK_FUNC
+    \brief The callback function type fed with the uncompressed bytes of a member, FALSE to stop reading.
+*/
+typedef gboolean (*ICON_ARCHIVE_CHUNK_FUNC)(const guchar *data, gsize length, gpointer userData);
+
+/*! \class CIconArchive
+    \brief Lists the icon files of a zip or tar archive and streams them out, without extracting anything to disk.
+
+    The directory is read once when it is opened: the central directory of a zip, the member headers of a tar,
+    and only the members which pass the name filter are kept. A member is then read by its offset chunk by chunk,
+    inflated on the fly for a deflated zip member, so it is never held in memory as a whole. A compressed tar could
+    only be read from its start, its icon members are inflated once and kept in memory instead.
+    After m_Open() all members may be called from several threads at once. It is shared by reference counting.
+*/
+class CIconArchive
+{
+  private:
+    gchar *m_FileName;         /*!< The archive file. */
+    gint m_nFormat;            /*!< The ICON_ARCHIVE_FORMAT. */
+    gint m_nFd;                /*!< The opened archive, -1 if it is not open. */
+    gint64 m_nMtime;           /*!< The modification time of the archive when it was opened. */
+    guint64 m_nSize;           /*!< The size of the archive when it was opened. */
+    GArray *m_pMembers;        /*!< The icon members(ICON_ARCHIVE_MEMBER). */
+    GHashTable *m_pIndex;      /*!< The member name to its position in m_pMembers plus 1. */
+    GByteArray *m_pInflated;   /*!< The icon members of a compressed tar, NULL for the other formats. */
+    gint m_nRef;               /*!< The reference count. */
+
+    gboolean m_ReadZipDirectory(ICON_NAME_FILTER filter);
+    gboolean m_ReadTarHeaders(ICON_NAME_FILTER filter);
+    gchar* m_TakeName(gchar *name, ICON_NAME_FILTER filter);
+    void m_AddMember(gchar *name, ICON_ARCHIVE_MEMBER *pMember);
+    gboolean m_ReadStored(const ICON_ARCHIVE_MEMBER *pMember, guint64 offset, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData);
+    gboolean m_ReadDeflated(const ICON_ARCHIVE_MEMBER *pMember, guint64 offset, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData);
+
+    ~CIconArchive();
+
+  public:
+    CIconArchive(const gchar *fileName);
+
+    void m_Ref(void) { g_atomic_int_inc(&m_nRef); }
+    void m_Unref(void) { if( g_atomic_int_dec_and_test(&m_nRef) ) delete this; }
+
+    /* To open the archive and read its directory, keeping the members whose base name passes the filter. */
+    gboolean m_Open(ICON_NAME_FILTER filter);
+
+    /* To check if the archive file is still the one opened, by its modification time and size. */
+    gboolean m_IsCurrent(void);
+
+    /* To find a member by its path inside the archive, NULL if it is not an icon member. */
+    const ICON_ARCHIVE_MEMBER* m_Lookup(const gchar *memberName);
+
+    /* To feed the uncompressed bytes of a member to a function chunk by chunk. FALSE if it could not be read
+       completely, was corrupt, or the function stopped it. */
+    gboolean m_ReadMember(const ICON_ARCHIVE_MEMBER *pMember, ICON_ARCHIVE_CHUNK_FUNC func, gpointer userData);
+
+    /* The content hash of a member, in the space of CIconContentCache where the contents are known. */
+    guint64 m_GetMemberHash(const ICON_ARCHIVE_MEMBER *pMember);
+
+    guint m_GetMemberCount(void) { return m_pMembers->len; }
+    const ICON_ARCHIVE_MEMBER* m_GetMember(guint i) { return &g_array_index(m_pMembers, ICON_ARCHIVE_MEMBER, i); }
+    const gchar* m_GetFileName(void) { return m_FileName; }
+    gint64 m_GetMtime(void) { return m_nMtime; }
+
+    /* To get the ICON_ARCHIVE_FORMAT of a file name by its suffix. */
+    static gint m_GetFormat(const gchar *fileName);
+    static gboolean m_IsArchive(const gchar *fileName) { return m_GetFormat(fileName) != ICON_ARCHIVE_None; }
+
+    /* To split "archive!/member" into the archive file, which must be freed, and the member. FALSE if it is not
+       the name of an archive member. */
+    static gboolean m_SplitMemberName(const gchar *fullName, gchar **pArchiveName, const gchar **pMemberName);
+    static gboolean m_IsMemberName(const gchar *fullName) { return m_SplitMemberName(fullName, NULL, NULL); }
+};
+#endif   /* CICONARCHIVE.H	*/
@@ -0,0 +1,1338 @@
+/*! \file    CIconCatalog.cpp
+    \brief   The icon catalog engine shared by the dialog, the index daemon and programs without a display.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "CIconCatalog.h"
+
+/* The extensions tried for an icon name without one, in the preference order of the Icon Theme Specification. */
+static const gchar *g_ProbeExtensions[] = { ".png", ".svg", ".xpm", NULL };
+
+/* The image formats of icons, in lower case. */
+static const gchar *g_IconSuffixes[] = { ".jpg", ".jpeg", ".jpe", ".png", ".gif", ".tif", ".tiff", ".bmp", ".svg", ".xpm", NULL };
+
+CIconCatalog *CIconCatalog::m_pShared = NULL;
+
+/*! \struct ICON_RESOLVED
+    \brief A remembered resolution of an icon name.
+*/
+typedef struct _ICON_RESOLVED
+{
+  gchar *fullName;   /*!< The full file name, "" if it was not found. */
+  GList *link;       /*!< Its key's link in m_pResolvedOrder, moved to the head when it is used. */
+} ICON_RESOLVED;
+
+/* The levels of subdirectories of a theme taken into its generation, e.g. "48x48/apps". */
+#define ICON_GENERATION_DEPTH  2
+
+/*! \fn static guint32 add_dir_mtimes(const gchar *dirName, gint depth, guint32 generation)
+    \brief To add the modification times of a directory, of its icon-theme.cache and of its subdirectories down to
+           a depth into a generation.
+
+    \param[in] dirName. The directory.
+    \param[in] depth. The levels of subdirectories to take, 0 for the directory only.
+    \param[in] generation. The generation so far.
+    \return The generation, the same if the directory does not exist.
+*/
+static guint32 add_dir_mtimes(const gchar *dirName, gint depth, guint32 generation)
+{
+  GDir *dir = NULL;
+  const gchar *name = NULL;
+  gchar *cacheName = NULL;
+  guint32 subDirs = 0;
+  struct stat st;
+
+  if( stat(dirName, &st) != 0 )
+    return generation;
+
+  generation = generation * 31 + (guint32)st.st_mtime;
+
+  /* gtk-update-icon-cache rewrites it when an icon is installed, even in a directory already there. */
+  cacheName = g_build_filename(dirName, ICON_THEME_CACHE_NAME, NULL);
+  if( stat(cacheName, &st) == 0 )
+    generation = generation * 31 + (guint32)st.st_mtime;
+  g_free(cacheName);
+
+  if( (depth <= 0) || !(dir = g_dir_open(dirName, 0, NULL)) )
+    return generation;
+
+  /* An icon added to an existing "48x48/apps" only changes that directory.
+     The subdirectories are summed, so the order they are read in does not matter. */
+  while( (name = g_dir_read_name(dir)) )
+  {
+     gchar *subDir = g_build_filename(dirName, name, NULL);
+
+     if( g_file_test(subDir, G_FILE_TEST_IS_DIR) )
+       subDirs += add_dir_mtimes(subDir, depth - 1, 0);
+
+     g_free(subDir);
+  }
+
+  g_dir_close(dir);
+
+  return generation * 31 + subDirs;
+}
+
+//------------------------ Callback Functions
+/*! \fn static void cb_loader_size_prepared(GdkPixbufLoader *loader, gint width, gint height, gpointer size)
+    \brief The callback function to let the image loader decode the icon at the wanted size directly.
+
+    \param[in] loader. The GdkPixbufLoader object this callback function connects to.
+    \param[in] width. The original width of the image.
+    \param[in] height. The original height of the image.
+    \param[in] size. The wanted size of the icon, stored with GINT_TO_POINTER().
+    \return NONE
+*/
+static void cb_loader_size_prepared(GdkPixbufLoader *loader, gint width, gint height, gpointer size)
+{
+  gint nSize = GPOINTER_TO_INT(size);
+
+  if( (width <= 0) || (height <= 0) )
+    return;
+
+  /* The original dimensions are kept for sorting, the thumbnail does not tell them any more. */
+  g_object_set_data(G_OBJECT(loader), ICON_DATA_WIDTH, GINT_TO_POINTER(width));
+  g_object_set_data(G_OBJECT(loader), ICON_DATA_HEIGHT, GINT_TO_POINTER(height));
+
+  /* A huge image of a format decoded at full size is refused before its pixels are allocated. */
+  if( !CIconStreamDecoder::m_CheckSize(loader, width, height) )
+    return;
+
+  /* Keep the aspect ratio, as gdk_pixbuf_new_from_file_at_size() does. */
+  CIconStreamDecoder::m_FitSize(&width, &height, nSize);
+  gdk_pixbuf_loader_set_size(loader, width, height);
+}
+
+/*! \fn static gboolean cb_loader_write_chunk(const guchar *data, gsize length, gpointer loader)
+    \brief The callback function to feed the chunks of an archive member to the image loader.
+
+    \param[in] data. The uncompressed bytes.
+    \param[in] length. The number of bytes.
+    \param[in] loader. The GdkPixbufLoader object.
+    \return FALSE to stop reading the member, when the loader failed or refused the image.
+*/
+static gboolean cb_loader_write_chunk(const guchar *data, gsize length, gpointer loader)
+{
+  return gdk_pixbuf_loader_write((GdkPixbufLoader*)loader, data, length, NULL);
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconCatalog::CIconCatalog()
+    \brief CIconCatalog constructor
+*/
+CIconCatalog::CIconCatalog()
+{
+  g_mutex_init(&m_CacheLock);
+  m_pContentCache = new CIconContentCache();
+
+  g_mutex_init(&m_ThemeLock);
+  m_pThemes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, m_FreeTheme);
+  m_pGenerations = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+  g_mutex_init(&m_RootsLock);
+  m_pSearchRoots = new CIconSearchRoots();
+  m_pSearchRoots->m_SetDefaultRoots(ICON_THUMBNAIL_SIZE);
+
+  g_mutex_init(&m_ResolveLock);
+  m_pResolved = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, m_FreeResolved);
+  m_pResolvedOrder = g_queue_new();
+  m_pNegativeCache = new CIconNegativeCache(NULL);
+
+  g_mutex_init(&m_PoolLock);
+  m_pDecoderPool = NULL;
+
+  g_mutex_init(&m_ArchiveLock);
+  m_pArchives = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, m_FreeArchive);
+}
+
+/*! \fn CIconCatalog::~CIconCatalog()
+    \brief CIconCatalog destructor
+*/
+CIconCatalog::~CIconCatalog()
+{
+  if(m_pContentCache)
+    delete m_pContentCache;
+
+  if(m_pSearchRoots)
+    delete m_pSearchRoots;
+
+  if(m_pThemes)
+    g_hash_table_destroy(m_pThemes);
+
+  if(m_pGenerations)
+    g_hash_table_destroy(m_pGenerations);
+
+  /* The failures are written when it is deleted. */
+  if(m_pNegativeCache)
+    delete m_pNegativeCache;
+
+  if(m_pResolved)
+    g_hash_table_destroy(m_pResolved);
+
+  if(m_pResolvedOrder)
+    g_queue_free(m_pResolvedOrder);
+
+  if(m_pDecoderPool)
+    m_pDecoderPool->m_Unref();
+
+  if(m_pArchives)
+    g_hash_table_destroy(m_pArchives);
+
+  g_mutex_clear(&m_CacheLock);
+  g_mutex_clear(&m_ThemeLock);
+  g_mutex_clear(&m_RootsLock);
+  g_mutex_clear(&m_ResolveLock);
+  g_mutex_clear(&m_PoolLock);
+  g_mutex_clear(&m_ArchiveLock);
+
+  m_pContentCache = NULL;
+  m_pSearchRoots = NULL;
+  m_pThemes = NULL;
+  m_pGenerations = NULL;
+  m_pResolved = NULL;
+  m_pResolvedOrder = NULL;
+  m_pNegativeCache = NULL;
+  m_pDecoderPool = NULL;
+  m_pArchives = NULL;
+
+  if(m_pShared == this)
+    m_pShared = NULL;
+}
+
+/*! \fn CIconCatalog* CIconCatalog::m_GetShared(void)
+    \brief To get the catalog shared in the process, it is created at the first call.
+
+    \param[in] NONE
+    \return The shared catalog, it must not be deleted.
+*/
+CIconCatalog* CIconCatalog::m_GetShared(void)
+{
+  static gsize initialized = 0;
+
+  if( g_once_init_enter(&initialized) )
+  {
+     m_pShared = new CIconCatalog();
+     g_once_init_leave(&initialized, 1);
+  }
+
+  return m_pShared;
+}
+
+/*! \fn void CIconCatalog::m_FreeTheme(gpointer data)
+    \brief To delete a theme of the theme table.
+*/
+void CIconCatalog::m_FreeTheme(gpointer data)
+{
+  if(data)
+    delete (CIconTheme*)data;
+}
+
+/*! \fn void CIconCatalog::m_FreeResolved(gpointer data)
+    \brief To free an ICON_RESOLVED of the resolved table. Its link is removed from m_pResolvedOrder by the caller.
+*/
+void CIconCatalog::m_FreeResolved(gpointer data)
+{
+  ICON_RESOLVED *resolved = (ICON_RESOLVED*)data;
+
+  if(!resolved)
+    return;
+
+  g_free(resolved->fullName);
+  g_free(resolved);
+}
+
+/*! \fn void CIconCatalog::m_FreeArchive(gpointer data)
+    \brief To drop the reference of the archive table, the callers reading a member keep theirs.
+*/
+void CIconCatalog::m_FreeArchive(gpointer data)
+{
+  if(data)
+    ((CIconArchive*)data)->m_Unref();
+}
+
+/*! \fn CIconArchive* CIconCatalog::m_GetArchive(const gchar *archiveName)
+    \brief To get an opened archive, it is opened and its directory read at the first call and when it changed.
+    \n It is opened under the lock, so two callers do not read the same directory at once.
+
+    \param[in] archiveName. The archive file.
+    \return The archive with a new reference to be dropped by m_Unref(), NULL if it could not be read.
+*/
+CIconArchive* CIconCatalog::m_GetArchive(const gchar *archiveName)
+{
+  CIconArchive *pArchive = NULL;
+
+  g_mutex_lock(&m_ArchiveLock);
+
+  pArchive = (CIconArchive*)g_hash_table_lookup(m_pArchives, archiveName);
+  if( pArchive && !pArchive->m_IsCurrent() )
+  {
+     g_hash_table_remove(m_pArchives, archiveName);
+     pArchive = NULL;
+  }
+
+  if(pArchive == NULL)
+  {
+     pArchive = new CIconArchive(archiveName);
+
+     if( pArchive->m_Open(m_IsIconFile) )
+       g_hash_table_insert(m_pArchives, g_strdup(archiveName), pArchive);
+     else
+     {
+        pArchive->m_Unref();
+        pArchive = NULL;
+     }
+  }
+
+  if(pArchive)
+    pArchive->m_Ref();
+
+  g_mutex_unlock(&m_ArchiveLock);
+
+  return pArchive;
+}
+
+/*! \fn CIconArchive* CIconCatalog::m_OpenMember(const gchar *fullName, const ICON_ARCHIVE_MEMBER **ppMember)
+    \brief To find the archive and the member of a full name "archive!/member".
+
+    \param[in] fullName. The full name of the member.
+    \param[out] ppMember. The member, it belongs to the archive.
+    \return The archive with a new reference to be dropped by m_Unref(), NULL if the member is not found.
+*/
+CIconArchive* CIconCatalog::m_OpenMember(const gchar *fullName, const ICON_ARCHIVE_MEMBER **ppMember)
+{
+  gchar *archiveName = NULL;
+  const gchar *memberName = NULL;
+  CIconArchive *pArchive = NULL;
+
+  *ppMember = NULL;
+
+  if( !CIconArchive::m_SplitMemberName(fullName, &archiveName, &memberName) )
+    return NULL;
+
+  pArchive = m_GetArchive(archiveName);
+  g_free(archiveName);
+
+  if(pArchive)
+    *ppMember = pArchive->m_Lookup(memberName);
+
+  if( pArchive && (*ppMember == NULL) )
+  {
+     pArchive->m_Unref();
+     pArchive = NULL;
+  }
+
+  return pArchive;
+}
+
+/*! \fn CIconTheme* CIconCatalog::m_GetTheme(const gchar *themeName)
+    \brief To get the tables of a theme, they are loaded at the first call.
+
+    \param[in] themeName. The theme name, NULL for ICON_THEME_FALLBACK.
+    \return The theme, NULL if it could not be loaded. It belongs to the catalog.
+*/
+CIconTheme* CIconCatalog::m_GetTheme(const gchar *themeName)
+{
+  CIconTheme *pTheme = NULL;
+  gpointer value = NULL;
+
+  if( !themeName || (strlen(themeName) == 0) )
+    themeName = ICON_THEME_FALLBACK;
+
+  /* The lock is held while a theme loads, so a theme asked for by several threads at once is loaded once. */
+  g_mutex_lock(&m_ThemeLock);
+
+  if( g_hash_table_lookup_extended(m_pThemes, themeName, NULL, &value) )
+    pTheme = (CIconTheme*)value;
+  else
+  {
+     pTheme = new CIconTheme();
+
+     if( !pTheme->m_Load(themeName) )
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        printf("%s(%d) - The theme %s could not be loaded \n", __FUNCTION__, __LINE__, themeName);
+        #endif
+
+        delete pTheme;
+        pTheme = NULL;
+     }
+
+     g_hash_table_insert(m_pThemes, g_strdup(themeName), pTheme);
+  }
+
+  g_mutex_unlock(&m_ThemeLock);
+
+  return pTheme;
+}
+
+/*! \fn guint32 CIconCatalog::m_GetThemeGeneration(const gchar *themeName)
+    \brief To get the generation of a theme, which changes when an icon is installed in it.
+    \n It is made of the modification times of the directories of every theme of the chain the names are resolved
+       through(the theme, the themes it inherits and ICON_THEME_FALLBACK) in every base directory, of their
+       icon-theme.cache and of their subdirectories down to ICON_GENERATION_DEPTH, and of the "pixmaps" directories.
+       Installing an icon changes one of them, with or without updating the cache.
+       It is taken once, until m_ClearCaches().
+
+    \param[in] themeName. The theme name, NULL for ICON_THEME_FALLBACK.
+    \return The generation.
+*/
+guint32 CIconCatalog::m_GetThemeGeneration(const gchar *themeName)
+{
+  const gchar * const *dataDirs = NULL;
+  const gchar *fallback[] = { NULL, ICON_THEME_FALLBACK };
+  GPtrArray *baseDirs = NULL;
+  const GPtrArray *chain = NULL;
+  CIconTheme *pTheme = NULL;
+  gpointer value = NULL;
+  guint32 generation = 0;
+  guint nThemes = 0;
+
+  if( !themeName || (strlen(themeName) == 0) )
+    themeName = ICON_THEME_FALLBACK;
+
+  g_mutex_lock(&m_ThemeLock);
+  if( g_hash_table_lookup_extended(m_pGenerations, themeName, NULL, &value) )
+  {
+     g_mutex_unlock(&m_ThemeLock);
+     return GPOINTER_TO_UINT(value);
+  }
+  g_mutex_unlock(&m_ThemeLock);
+
+  /* The inherited themes are known once the theme is loaded, a theme without index.theme has only the fallback. */
+  pTheme = m_GetTheme(themeName);
+  chain = pTheme ? pTheme->m_GetChain() : NULL;
+  nThemes = chain ? chain->len : G_N_ELEMENTS(fallback);
+  fallback[0] = themeName;
+
+  baseDirs = CIconTheme::m_GetBaseDirs();
+
+  for(guint i=0; i<baseDirs->len; i++)
+  {
+     for(guint j=0; j<nThemes; j++)
+     {
+        const gchar *name = chain ? (const gchar*)g_ptr_array_index(chain, j) : fallback[j];
+        gchar *dirName = g_build_filename((const gchar*)g_ptr_array_index(baseDirs, i), name, NULL);
+
+        generation = add_dir_mtimes(dirName, ICON_GENERATION_DEPTH, generation);
+
+        g_free(dirName);
+     }
+
+     g_free(g_ptr_array_index(baseDirs, i));
+  }
+
+  g_ptr_array_free(baseDirs, TRUE);
+
+  dataDirs = g_get_system_data_dirs();
+  for(gint i=0; dataDirs[i]; i++)
+  {
+     gchar *dirName = g_build_filename(dataDirs[i], ICON_SEARCH_PATH_PIXMAPS, NULL);
+
+     generation = add_dir_mtimes(dirName, 0, generation);
+
+     g_free(dirName);
+  }
+
+  g_mutex_lock(&m_ThemeLock);
+  g_hash_table_replace(m_pGenerations, g_strdup(themeName), GUINT_TO_POINTER(generation));
+  g_mutex_unlock(&m_ThemeLock);
+
+  return generation;
+}
+
+/*! \fn void CIconCatalog::m_SetSearchRoots(const gchar **roots)
+    \brief To set the roots of the union view.
+
+    \param[in] roots. The NULL-terminated list of directories in precedence order, NULL for the default roots.
+    \return NONE
+*/
+void CIconCatalog::m_SetSearchRoots(const gchar **roots)
+{
+  g_mutex_lock(&m_RootsLock);
+
+  if(roots)
+    m_pSearchRoots->m_SetRoots(roots);
+  else
+    m_pSearchRoots->m_SetDefaultRoots(ICON_THUMBNAIL_SIZE);
+
+  g_mutex_unlock(&m_RootsLock);
+}
+
+/*! \fn GPtrArray* CIconCatalog::m_Scan(const gchar *location, gint scale, gint *pShadowed)
+    \brief To list the icon files of a location.
+
+    \param[in] location. A directory, a zip or tar archive, ICON_LOCATION_UNION, or "theme:<theme name>/<context>" where
+               an empty theme name is ICON_THEME_FALLBACK and an empty context is all contexts.
+    \param[in] scale. The scale a theme is listed for.
+    \param[out] pShadowed. The number of icon files hidden in the union view, could be NULL.
+    \return The full names of the icon files, the array and its strings must be freed. NULL if the location could not be read.
+*/
+GPtrArray* CIconCatalog::m_Scan(const gchar *location, gint scale, gint *pShadowed)
+{
+  GPtrArray *pList = NULL;
+
+  if(pShadowed)
+    *pShadowed = 0;
+
+  if(!location)
+    return NULL;
+
+  if( strcmp(location, ICON_LOCATION_UNION) == 0 )
+  {
+     g_mutex_lock(&m_RootsLock);
+     pList = m_pSearchRoots->m_Scan(m_IsIconFile, pShadowed);
+     g_mutex_unlock(&m_RootsLock);
+  }
+  else if( g_str_has_prefix(location, ICON_LOCATION_THEME) )
+  {
+     gchar **parts = g_strsplit(location + strlen(ICON_LOCATION_THEME), "/", 2);
+     const gchar *context = (parts[0] && parts[1] && strlen(parts[1])) ? parts[1] : NULL;
+     CIconTheme *pTheme = m_GetTheme(parts[0]);
+
+     if(pTheme)
+       pList = pTheme->m_ListIcons(context, ICON_THUMBNAIL_SIZE, MAX(scale, 1));
+
+     g_strfreev(parts);
+  }
+  else if( CIconArchive::m_IsArchive(location) && !g_file_test(location, G_FILE_TEST_IS_DIR) )
+  {
+     CIconArchive *pArchive = m_GetArchive(location);
+
+     if(!pArchive)
+       return NULL;
+
+     /* The directory was read once when the archive was opened, only the icon members were kept. */
+     pList = g_ptr_array_sized_new(pArchive->m_GetMemberCount());
+
+     for(guint i=0; i<pArchive->m_GetMemberCount(); i++)
+       g_ptr_array_add(pList, g_strconcat(location, ICON_ARCHIVE_SEPARATOR, pArchive->m_GetMember(i)->name, NULL));
+
+     pArchive->m_Unref();
+  }
+  else
+  {
+     GDir *dir = g_dir_open(location, 0, NULL);
+     const gchar *baseName = NULL;
+
+     if(!dir)
+       return NULL;
+
+     pList = g_ptr_array_new();
+
+     while( (baseName = g_dir_read_name(dir)) != NULL )
+     {
+        if( m_IsIconFile((gchar*)baseName) )
+          g_ptr_array_add(pList, g_build_filename(location, baseName, NULL));
+     }
+
+     g_dir_close(dir);
+  }
+
+  return pList;
+}
+
+/*! \fn GPtrArray* CIconCatalog::m_Query(const gchar *location, const gchar *pattern, gint scale)
+    \brief To list the icon files of a location whose file name matches a pattern.
+
+    \param[in] location. The location, as m_Scan() takes.
+    \param[in] pattern. The glob pattern of g_pattern_match_simple(), NULL matches all files.
+    \param[in] scale. The scale a theme is listed for.
+    \return The full names of the icon files, the array and its strings must be freed. NULL if the location could not be read.
+*/
+GPtrArray* CIconCatalog::m_Query(const gchar *location, const gchar *pattern, gint scale)
+{
+  GPtrArray *pList = m_Scan(location, scale, NULL);
+  GPtrArray *pMatches = NULL;
+  GPatternSpec *spec = NULL;
+
+  if( !pList || !pattern )
+    return pList;
+
+  spec = g_pattern_spec_new(pattern);
+  pMatches = g_ptr_array_sized_new(pList->len);
+
+  for(guint i=0; i<pList->len; i++)
+  {
+     gchar *fullName = (gchar*)g_ptr_array_index(pList, i);
+     const gchar *baseName = strrchr(fullName, '/');
+
+     baseName = baseName ? baseName + 1 : fullName;
+
+     if( g_pattern_match_string(spec, baseName) )
+       g_ptr_array_add(pMatches, fullName);
+     else
+       g_free(fullName);
+  }
+
+  g_pattern_spec_free(spec);
+  g_ptr_array_free(pList, TRUE);
+
+  return pMatches;
+}
+
+/*! \fn gchar* CIconCatalog::m_LookupThemeFile(const gchar *themeName, const gchar *fileName, gint size, gint scale)
+    \brief To find an icon file in the tables of a theme, which are built at its first lookup.
+
+    \param[in] themeName. The theme name, NULL for ICON_THEME_FALLBACK.
+    \param[in] fileName. The icon name, with or without extension.
+    \param[in] size. The wanted logical size.
+    \param[in] scale. The wanted scale.
+    \return The full file name, NULL if it is not in the theme. It must be freed.
+*/
+gchar* CIconCatalog::m_LookupThemeFile(const gchar *themeName, const gchar *fileName, gint size, gint scale)
+{
+  CIconTheme *pTheme = NULL;
+  gchar *iconName = NULL, *fullName = NULL;
+
+  if( !fileName || g_path_is_absolute(fileName) )
+    return NULL;
+
+  pTheme = m_GetTheme(themeName);
+  if(!pTheme)
+    return NULL;
+
+  iconName = CIconSearchRoots::m_GetIconName(fileName);
+  fullName = pTheme->m_LookupIcon(iconName, size, MAX(scale, 1));
+  g_free(iconName);
+
+  return fullName;
+}
+
+/*! \fn gchar* CIconCatalog::m_ProbeFile(const gchar *fileName, gint size)
+    \brief To find an icon file in the legacy icon directories of the user's data directory, then of the XDG data directories:
+    \n "pixmaps", "icons/hicolor/SizexSize/apps", "icons/hicolor/scalable/apps", "icons/gnome/scalable",
+       "icons/gnome/scalable/apps" and "icons/gnome/SizexSize/apps". A name without extension is tried with each of
+       g_ProbeExtensions.
+
+    \param[in] fileName. The icon name, with or without extension.
+    \param[in] size. The wanted size in device pixels.
+    \return The full file name, NULL if it is not found. It must be freed.
+*/
+gchar* CIconCatalog::m_ProbeFile(const gchar *fileName, gint size)
+{
+  const gchar * const *systemDirs = g_get_system_data_dirs();  /* To read the setting of the environment variable : "XDG_DATA_DIRS"*/
+  gchar *hicolorSize = g_strdup_printf("%s/%dx%d/apps", ICON_SEARCH_PATH_HICOLOR, size, size);
+  gchar *gnomeSize = g_strdup_printf("%s/%dx%d/apps", ICON_SEARCH_PATH_GNOME, size, size);
+  const gchar *subDirs[] = { ICON_SEARCH_PATH_PIXMAPS, hicolorSize, ICON_SEARCH_PATH_HICOLOR_SCALABLE,
+                             ICON_SEARCH_PATH_GNOME_SCALABLE, ICON_SEARCH_PATH_GNOME_SCALABLE_APPS, gnomeSize, NULL };
+  const gchar *noExtension[] = { "", NULL };
+  const gchar **extensions = strchr(fileName, '.') ? noExtension : g_ProbeExtensions;
+  gchar *file_path = NULL;
+  GPtrArray *dirs = g_ptr_array_new();
+
+  /* $XDG_DATA_HOME, e.g. "~/.local/share", comes first as in the Icon Theme Specification. */
+  g_ptr_array_add(dirs, (gpointer)g_get_user_data_dir());
+  for(const gchar * const *dir = systemDirs; *dir; ++dir)
+    g_ptr_array_add(dirs, (gpointer)*dir);
+
+  for(guint d=0; (d < dirs->len) && !file_path; d++)
+  {
+     const gchar *dataDir = (const gchar*)g_ptr_array_index(dirs, d);
+
+     for(gint i=0; subDirs[i] && !file_path; i++)
+     {
+        for(gint j=0; extensions[j] && !file_path; j++)
+        {
+           gchar *baseName = g_strconcat(fileName, extensions[j], NULL);
+
+           /* The file is only checked to exist, it is decoded by the caller when it is shown. */
+           file_path = g_build_filename(dataDir, subDirs[i], baseName, NULL);
+           if( !g_file_test(file_path, G_FILE_TEST_IS_REGULAR) )
+           {
+              g_free(file_path);
+              file_path = NULL;
+           }
+
+           g_free(baseName);
+        }
+     }
+  }
+
+  g_ptr_array_free(dirs, TRUE);
+  g_free(hicolorSize);
+  g_free(gnomeSize);
+
+  return file_path;
+}
+
+/*! \fn gchar* CIconCatalog::m_Resolve(const gchar *iconName, gint size, gint scale, const gchar *themeName)
+    \brief To find the file of an icon: an absolute file name as it is, otherwise the theme, then the legacy icon directories.
+    \n The results, found or not, are remembered until m_ClearCaches(). Beyond ICON_CATALOG_MAX_RESOLVED of them, the least
+    recently used ones are forgotten one by one.
+
+    \param[in] iconName. The icon name or file name.
+    \param[in] size. The wanted logical size.
+    \param[in] scale. The wanted scale.
+    \param[in] themeName. The theme name, NULL for ICON_THEME_FALLBACK.
+    \return The full file name, NULL if it is not found. It must be freed.
+*/
+gchar* CIconCatalog::m_Resolve(const gchar *iconName, gint size, gint scale, const gchar *themeName)
+{
+  gchar *key = NULL, *fullName = NULL;
+  ICON_RESOLVED *resolved = NULL;
+  gboolean bFound = false;
+  guint32 generation = 0;
+
+  if( !iconName || (strlen(iconName) == 0) )
+    return NULL;
+
+  if( g_path_is_absolute(iconName) )
+    return g_file_test(iconName, G_FILE_TEST_IS_REGULAR) ? g_strdup(iconName) : NULL;
+
+  scale = MAX(scale, 1);
+  key = g_strdup_printf("%s|%s|%d|%d", themeName ? themeName : "", iconName, size, scale);
+
+  g_mutex_lock(&m_ResolveLock);
+  resolved = (ICON_RESOLVED*)g_hash_table_lookup(m_pResolved, key);
+  if(resolved)
+  {
+     bFound = true;
+     if( strlen(resolved->fullName) )
+       fullName = g_strdup(resolved->fullName);
+
+     g_queue_unlink(m_pResolvedOrder, resolved->link);
+     g_queue_push_head_link(m_pResolvedOrder, resolved->link);
+  }
+  g_mutex_unlock(&m_ResolveLock);
+
+  if(bFound)
+  {
+     g_free(key);
+     return fullName;
+  }
+
+  /* A name which failed in an earlier run is not looked up again, until the theme changes. */
+  generation = m_GetThemeGeneration(themeName);
+  if( !m_pNegativeCache->m_IsUnresolvable(themeName, iconName, size * scale, generation) )
+  {
+     fullName = m_LookupThemeFile(themeName, iconName, size, scale);
+     if(!fullName)
+       fullName = m_ProbeFile(iconName, size * scale);
+
+     if(!fullName)
+       m_pNegativeCache->m_AddUnresolvable(themeName, iconName, size * scale, generation);
+  }
+
+  g_mutex_lock(&m_ResolveLock);
+
+  /* Another thread could have resolved the same name meanwhile, its result is kept. */
+  if( g_hash_table_contains(m_pResolved, key) )
+    g_free(key);
+  else
+  {
+     while( g_hash_table_size(m_pResolved) >= ICON_CATALOG_MAX_RESOLVED )
+       g_hash_table_remove(m_pResolved, g_queue_pop_tail(m_pResolvedOrder));
+
+     resolved = g_new0(ICON_RESOLVED, 1);
+     resolved->fullName = g_strdup(fullName ? fullName : "");
+     g_queue_push_head(m_pResolvedOrder, key);
+     resolved->link = g_queue_peek_head_link(m_pResolvedOrder);
+     g_hash_table_insert(m_pResolved, key, resolved);
+  }
+
+  g_mutex_unlock(&m_ResolveLock);
+
+  return fullName;
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_Thumbnail(const gchar *fullName, gint size, guint64 *pContentHash)
+    \brief To make the thumbnail of an icon file. Byte-identical files share one thumbnail in the cache.
+
+    \param[in] fullName. The icon file, or an archive member "archive!/member".
+    \param[in] size. The thumbnail size in device pixels.
+    \param[out] pContentHash. The content hash of the file, 0 if it is unknown. Could be NULL.
+    \return The thumbnail, it must be unreferenced. NULL if the file could not be read or decoded.
+*/
+GdkPixbuf* CIconCatalog::m_Thumbnail(const gchar *fullName, gint size, guint64 *pContentHash)
+{
+  ICON_FILE_BUFFER buffer;
+  GdkPixbuf *pixbuf = NULL;
+  guint64 contentHash = 0;
+  gint nStatus = ICON_DECODER_Failed;
+
+  if( CIconArchive::m_IsMemberName(fullName) )
+    return m_ThumbnailMember(fullName, size, pContentHash);
+
+  memset(&buffer, 0x00, sizeof(buffer));
+  buffer.fullName = (gchar*)fullName;
+
+  /* Only the identity is needed to find the thumbnail of an unchanged file, the contents are read on a miss. */
+  CIconFileReader::m_StatOne(&buffer);
+
+  /* A file which failed before is not decoded again, until it changes. */
+  if( (buffer.error == 0) && !m_pNegativeCache->m_IsBadFile(fullName, buffer.mtime, buffer.fileSize) )
+  {
+     contentHash = m_LookupContentHash(&buffer);
+     pixbuf = contentHash ? m_LookupThumbnail(contentHash, size) : NULL;
+
+     if(pixbuf == NULL)
+       CIconFileReader::m_ReadOne(&buffer);
+
+     if( (pixbuf == NULL) && (buffer.error == 0) )
+     {
+        contentHash = m_GetContentHash(&buffer);
+        pixbuf = m_LookupThumbnail(contentHash, size);
+     }
+
+     if( (pixbuf == NULL) && (buffer.error == 0) )
+     {
+        ICONPROF_MARK(nDecodeStart);
+
+        /* Two callers could decode the same file at once, the later thumbnail simply replaces the other. */
+        pixbuf = m_DecodeIconFile(&buffer, size, &nStatus);
+
+        ICONPROF_DECODE(fullName, nDecodeStart, pixbuf != NULL);
+
+        /* A file a worker timed out or crashed on is tried again the next time, the worker could have been starved. */
+        if(pixbuf)
+          m_InsertThumbnail(contentHash, size, pixbuf);
+        else if(nStatus == ICON_DECODER_Failed)
+          m_pNegativeCache->m_AddBadFile(fullName, buffer.mtime, buffer.fileSize);
+     }
+  }
+
+  CIconFileReader::m_FreeBuffer(&buffer);
+
+  if(pContentHash)
+    *pContentHash = contentHash;
+
+  return pixbuf;
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_ThumbnailMember(const gchar *fullName, gint size, guint64 *pContentHash)
+    \brief To make the thumbnail of an archive member, streamed from the archive into the decoder.
+    \n A failed member is remembered by its full name, the modification time of the archive and its size.
+
+    \param[in] fullName. The full name of the member, "archive!/member".
+    \param[in] size. The thumbnail size in device pixels.
+    \param[out] pContentHash. The content hash of the member, 0 if it is not found. Could be NULL.
+    \return The thumbnail, it must be unreferenced. NULL if the member could not be read or decoded.
+*/
+GdkPixbuf* CIconCatalog::m_ThumbnailMember(const gchar *fullName, gint size, guint64 *pContentHash)
+{
+  const ICON_ARCHIVE_MEMBER *pMember = NULL;
+  CIconArchive *pArchive = m_OpenMember(fullName, &pMember);
+  GdkPixbuf *pixbuf = NULL;
+  guint64 contentHash = 0;
+
+  if( pArchive && !m_pNegativeCache->m_IsBadFile(fullName, pArchive->m_GetMtime(), pMember->size) )
+  {
+     contentHash = pArchive->m_GetMemberHash(pMember);
+     pixbuf = m_LookupThumbnail(contentHash, size);
+
+     if(pixbuf == NULL)
+     {
+        CIconDecoderPool *pPool = m_GetDecoderPool();
+        gint nStatus = ICON_DECODER_Unavailable;
+        ICONPROF_MARK(nDecodeStart);
+
+        /* A worker opens the archive by itself, only the name is sent. */
+        if(pPool)
+        {
+           pixbuf = pPool->m_Decode(fullName, NULL, 0, size, &nStatus);
+           pPool->m_Unref();
+        }
+
+        if(nStatus == ICON_DECODER_Unavailable)
+        {
+           pixbuf = m_DecodeMember(pArchive, pMember, size);
+           nStatus = pixbuf ? ICON_DECODER_Done : ICON_DECODER_Failed;
+        }
+
+        ICONPROF_DECODE(fullName, nDecodeStart, pixbuf != NULL);
+
+        if(pixbuf)
+          m_InsertThumbnail(contentHash, size, pixbuf);
+        else if(nStatus == ICON_DECODER_Failed)
+          m_pNegativeCache->m_AddBadFile(fullName, pArchive->m_GetMtime(), pMember->size);
+     }
+  }
+
+  if(pArchive)
+    pArchive->m_Unref();
+
+  if(pContentHash)
+    *pContentHash = contentHash;
+
+  return pixbuf;
+}
+
+/*! \fn gboolean CIconCatalog::m_StatArchiveMember(const gchar *fullName, gsize *pSize, gint64 *pMtime, guint64 *pContentHash)
+    \brief To get what a caller reading a file would know of an archive member, without reading it.
+
+    \param[in] fullName. The full name of the member, "archive!/member".
+    \param[out] pSize. The uncompressed size of the member.
+    \param[out] pMtime. The modification time of the archive.
+    \param[out] pContentHash. The content hash of the member.
+    \return TRUE or FALSE
+*/
+gboolean CIconCatalog::m_StatArchiveMember(const gchar *fullName, gsize *pSize, gint64 *pMtime, guint64 *pContentHash)
+{
+  const ICON_ARCHIVE_MEMBER *pMember = NULL;
+  CIconArchive *pArchive = m_OpenMember(fullName, &pMember);
+
+  if(!pArchive)
+    return false;
+
+  if(pSize)
+    *pSize = (gsize)pMember->size;
+
+  if(pMtime)
+    *pMtime = pArchive->m_GetMtime();
+
+  if(pContentHash)
+    *pContentHash = pArchive->m_GetMemberHash(pMember);
+
+  pArchive->m_Unref();
+
+  return true;
+}
+
+/*! \fn gboolean CIconCatalog::m_IsKnownBadFile(const gchar *fullName)
+    \brief To check if an icon file or archive member failed to decode before, before it is read.
+
+    \param[in] fullName. The full name.
+    \return TRUE if it is known to fail.
+*/
+gboolean CIconCatalog::m_IsKnownBadFile(const gchar *fullName)
+{
+  gsize size = 0;
+  gint64 mtime = 0;
+
+  if( !CIconArchive::m_IsMemberName(fullName) )
+    return m_pNegativeCache->m_IsKnownBadFile(fullName);
+
+  return m_StatArchiveMember(fullName, &size, &mtime, NULL) && m_pNegativeCache->m_IsBadFile(fullName, mtime, size);
+}
+
+/*! \fn guint64 CIconCatalog::m_GetContentHash(const ICON_FILE_BUFFER *pBuffer)
+    \brief To get the content hash of an icon file read into memory, or known from its identity without being read.
+
+    \param[in] pBuffer. The file read.
+    \return The content hash, 0 if the file was not read completely.
+*/
+guint64 CIconCatalog::m_GetContentHash(const ICON_FILE_BUFFER *pBuffer)
+{
+  guint64 contentHash = 0;
+
+  if( pBuffer && pBuffer->knownHash && !pBuffer->data )
+    return pBuffer->knownHash;
+
+  g_mutex_lock(&m_CacheLock);
+  contentHash = m_pContentCache->m_GetContentHash(pBuffer);
+  g_mutex_unlock(&m_CacheLock);
+
+  return contentHash;
+}
+
+/*! \fn guint64 CIconCatalog::m_LookupContentHash(const ICON_FILE_BUFFER *pBuffer)
+    \brief To get the content hash of an icon file by its identity only, see CIconFileReader::m_StatOne().
+
+    \param[in] pBuffer. The file.
+    \return The content hash, 0 if the file was not hashed since it last changed.
+*/
+guint64 CIconCatalog::m_LookupContentHash(const ICON_FILE_BUFFER *pBuffer)
+{
+  guint64 contentHash = 0;
+
+  g_mutex_lock(&m_CacheLock);
+  contentHash = m_pContentCache->m_LookupContentHash(pBuffer);
+  g_mutex_unlock(&m_CacheLock);
+
+  return contentHash;
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_LookupThumbnail(guint64 contentHash, gint size)
+    \brief To get the cached thumbnail of a content hash.
+
+    \param[in] contentHash. The content hash.
+    \param[in] size. The thumbnail size in device pixels.
+    \return The thumbnail, it must be unreferenced. NULL if it is not cached.
+*/
+GdkPixbuf* CIconCatalog::m_LookupThumbnail(guint64 contentHash, gint size)
+{
+  GdkPixbuf *pixbuf = NULL;
+
+  g_mutex_lock(&m_CacheLock);
+  pixbuf = m_pContentCache->m_LookupPixbuf(contentHash, size);
+  g_mutex_unlock(&m_CacheLock);
+
+  return pixbuf;
+}
+
+/*! \fn void CIconCatalog::m_InsertThumbnail(guint64 contentHash, gint size, GdkPixbuf *pixbuf)
+    \brief To cache the thumbnail of a content hash.
+
+    \param[in] contentHash. The content hash, 0 is not cached.
+    \param[in] size. The thumbnail size in device pixels.
+    \param[in] pixbuf. The thumbnail, the cache takes its own reference.
+    \return NONE
+*/
+void CIconCatalog::m_InsertThumbnail(guint64 contentHash, gint size, GdkPixbuf *pixbuf)
+{
+  g_mutex_lock(&m_CacheLock);
+  m_pContentCache->m_InsertPixbuf(contentHash, size, pixbuf);
+  g_mutex_unlock(&m_CacheLock);
+}
+
+/*! \fn void CIconCatalog::m_PruneThumbnails(void)
+    \brief To keep the cached thumbnails nobody else holds in the bounded idle list, the least recently used beyond
+           its bound are dropped.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconCatalog::m_PruneThumbnails(void)
+{
+  g_mutex_lock(&m_CacheLock);
+  m_pContentCache->m_Prune();
+  g_mutex_unlock(&m_CacheLock);
+}
+
+/*! \fn guint CIconCatalog::m_GetThumbnailCount(void)
+    \brief To get the number of cached thumbnails.
+
+    \param[in] NONE
+    \return The number of thumbnails.
+*/
+guint CIconCatalog::m_GetThumbnailCount(void)
+{
+  guint nCount = 0;
+
+  g_mutex_lock(&m_CacheLock);
+  nCount = m_pContentCache->m_GetPixbufCount();
+  g_mutex_unlock(&m_CacheLock);
+
+  return nCount;
+}
+
+/*! \fn void CIconCatalog::m_ClearCaches(void)
+    \brief To forget the cached thumbnails, the resolved names, the theme generations and the opened archives.
+    \n The theme tables are kept.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconCatalog::m_ClearCaches(void)
+{
+  g_mutex_lock(&m_CacheLock);
+  m_pContentCache->m_Clear();
+  g_mutex_unlock(&m_CacheLock);
+
+  g_mutex_lock(&m_ResolveLock);
+  g_queue_clear(m_pResolvedOrder);
+  g_hash_table_remove_all(m_pResolved);
+  g_mutex_unlock(&m_ResolveLock);
+
+  /* The generations are taken again, so the names which failed are looked up again if a theme changed. */
+  g_mutex_lock(&m_ThemeLock);
+  g_hash_table_remove_all(m_pGenerations);
+  g_mutex_unlock(&m_ThemeLock);
+
+  /* The archives are opened again at their next member. */
+  g_mutex_lock(&m_ArchiveLock);
+  g_hash_table_remove_all(m_pArchives);
+  g_mutex_unlock(&m_ArchiveLock);
+}
+
+/*! \fn	gboolean CIconCatalog::m_IsIconFile(gchar *fileName)
+    \brief To determine if the file name is an image format of icons.
+
+    \param[in] fileName. The icon file name.
+    \return TRUE or FALSE
+*/
+gboolean CIconCatalog::m_IsIconFile(gchar *fileName)
+{
+  gboolean bRet = FALSE;
+  gchar *pStr = NULL;
+  ICONPROF_SCOPE(Filter);
+
+  pStr = g_ascii_strdown(fileName, -1);
+
+  for(gint i=0; g_IconSuffixes[i] && !bRet; i++)
+    bRet = g_str_has_suffix(pStr, g_IconSuffixes[i]);
+
+  g_free(pStr);
+
+  return bRet;
+}
+
+/*! \fn void CIconCatalog::m_SetSandboxed(gboolean sandboxed, const gchar *program, gint nWorkers)
+    \brief To decode the icon files in worker processes, so a bad image costs one timeout instead of the process.
+
+    \param[in] sandboxed. TRUE to start using the workers, FALSE to kill them and decode in the process.
+    \param[in] program. The program the workers run with ICON_DECODER_WORKER_ARG, NULL for ICON_DECODER_DEFAULT_PROGRAM.
+    \param[in] nWorkers. The number of workers.
+    \return NONE
+*/
+void CIconCatalog::m_SetSandboxed(gboolean sandboxed, const gchar *program, gint nWorkers)
+{
+  CIconDecoderPool *pNewPool = sandboxed ? new CIconDecoderPool(program, nWorkers) : NULL;
+  CIconDecoderPool *pOldPool = NULL;
+
+  g_mutex_lock(&m_PoolLock);
+  pOldPool = m_pDecoderPool;
+  m_pDecoderPool = pNewPool;
+  g_mutex_unlock(&m_PoolLock);
+
+  /* The workers are killed when the decodings still using them are done. */
+  if(pOldPool)
+    pOldPool->m_Unref();
+}
+
+/*! \fn CIconDecoderPool* CIconCatalog::m_GetDecoderPool(void)
+    \brief To get the sandboxed decoder workers, kept while the caller uses them even if m_SetSandboxed() replaces them.
+
+    \param[in] NONE
+    \return The pool with a reference to be dropped by CIconDecoderPool::m_Unref(), NULL if the catalog is not sandboxed.
+*/
+CIconDecoderPool* CIconCatalog::m_GetDecoderPool(void)
+{
+  CIconDecoderPool *pPool = NULL;
+
+  g_mutex_lock(&m_PoolLock);
+  pPool = m_pDecoderPool;
+  if(pPool)
+    pPool->m_Ref();
+  g_mutex_unlock(&m_PoolLock);
+
+  return pPool;
+}
+
+/*! \fn gboolean CIconCatalog::m_IsSandboxed(void)
+    \brief To check if the icon files are decoded by sandboxed workers.
+
+    \param[in] NONE
+    \return TRUE or FALSE
+*/
+gboolean CIconCatalog::m_IsSandboxed(void)
+{
+  gboolean sandboxed = false;
+
+  g_mutex_lock(&m_PoolLock);
+  sandboxed = (m_pDecoderPool != NULL);
+  g_mutex_unlock(&m_PoolLock);
+
+  return sandboxed;
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_DecodeIconFile(const ICON_FILE_BUFFER *pBuffer, gint size, gint *pStatus)
+    \brief To decode an icon file, by a sandboxed worker if there are workers.
+    \n The contents read into memory are passed to the worker in a memfd, a file too large to be read is read by
+    the worker chunk by chunk. The file is decoded in the process only if no worker could be started.
+
+    \param[in] pBuffer. The icon file read by CIconFileReader, its data is NULL if it was too large to be read.
+    \param[in] size. The wanted size of the icon.
+    \param[out] pStatus. The ICON_DECODER_STATUS, ICON_DECODER_Done or ICON_DECODER_Failed when it was decoded in the
+                process. Could be NULL.
+    \return GdkPixbuf object for the icon, NULL if it could not be decoded. It must be unreferenced.
+*/
+GdkPixbuf* CIconCatalog::m_DecodeIconFile(const ICON_FILE_BUFFER *pBuffer, gint size, gint *pStatus)
+{
+  CIconDecoderPool *pPool = m_GetDecoderPool();
+  GdkPixbuf *pixbuf = NULL;
+  gint nStatus = ICON_DECODER_Unavailable;
+
+  if(pPool)
+  {
+     pixbuf = pPool->m_Decode(pBuffer->fullName, pBuffer->data, pBuffer->length, size, &nStatus);
+     pPool->m_Unref();
+  }
+
+  if(nStatus == ICON_DECODER_Unavailable)
+  {
+     if(pBuffer->data)
+       pixbuf = m_DecodeBuffer(pBuffer->data, pBuffer->length, size);
+     else
+       pixbuf = m_DecodeFile(pBuffer->fullName, pBuffer->fileSize, size);
+
+     nStatus = pixbuf ? ICON_DECODER_Done : ICON_DECODER_Failed;
+  }
+
+  if(pStatus)
+    *pStatus = nStatus;
+
+  return pixbuf;
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_DecodeBuffer(const guchar *data, gsize length, gint size)
+    \brief To decode an icon file which had been read into memory.
+
+    \param[in] data. The file contents.
+    \param[in] length. The number of bytes of the contents.
+    \param[in] size. The wanted size of the icon.
+    \return GdkPixbuf object for the icon, NULL if it could not be decoded. It must be unreferenced.
+*/
+GdkPixbuf* CIconCatalog::m_DecodeBuffer(const guchar *data, gsize length, gint size)
+{
+  GdkPixbufLoader *loader = NULL;
+  gboolean bWritten = false;
+
+  if( !data || (length == 0) )
+    return NULL;
+
+#ifdef USE_NATIVE_XPM
+  /* Most XPM icons are parsed in one pass here, the loader takes the others. */
+  if( CIconXpmDecoder::m_GetEnabled() && CIconXpmDecoder::m_IsXpm(data, length) )
+  {
+     CIconXpmDecoder decoder(data, length);
+     GdkPixbuf *icon = decoder.m_Decode(size);
+
+     if(icon)
+     {
+        g_object_set_data(G_OBJECT(icon), ICON_DATA_WIDTH, GINT_TO_POINTER(decoder.m_GetWidth()));
+        g_object_set_data(G_OBJECT(icon), ICON_DATA_HEIGHT, GINT_TO_POINTER(decoder.m_GetHeight()));
+        return icon;
+     }
+  }
+#endif
+
+  loader = gdk_pixbuf_loader_new();
+
+  /* To decode the image at the wanted size, e.g. SVG is rendered at that size instead of being scaled later. */
+  g_signal_connect(loader, "size-prepared", G_CALLBACK(cb_loader_size_prepared), GINT_TO_POINTER(size));
+
+  bWritten = gdk_pixbuf_loader_write(loader, data, length, NULL);
+
+  return m_TakeLoaderPixbuf(loader, bWritten);
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_TakeLoaderPixbuf(GdkPixbufLoader *loader, gboolean bWritten)
+    \brief To close a loader fed with a whole image and take its pixbuf, with the original dimensions attached.
+
+    \param[in] loader. The loader, it is released here.
+    \param[in] bWritten. To indicate if all bytes were written successfully.
+    \return GdkPixbuf object for the icon, NULL if it could not be decoded. It must be unreferenced.
+*/
+GdkPixbuf* CIconCatalog::m_TakeLoaderPixbuf(GdkPixbufLoader *loader, gboolean bWritten)
+{
+  GdkPixbuf *icon = NULL;
+
+  /* The loader must always be closed, even if writing failed. */
+  if( gdk_pixbuf_loader_close(loader, NULL) && bWritten )
+  {
+     icon = gdk_pixbuf_loader_get_pixbuf(loader);
+
+     /* The pixbuf belongs to the loader, take our own reference before the loader is released. */
+     if(icon)
+     {
+        g_object_ref(icon);
+
+        g_object_set_data(G_OBJECT(icon), ICON_DATA_WIDTH, g_object_get_data(G_OBJECT(loader), ICON_DATA_WIDTH));
+        g_object_set_data(G_OBJECT(icon), ICON_DATA_HEIGHT, g_object_get_data(G_OBJECT(loader), ICON_DATA_HEIGHT));
+     }
+  }
+
+  g_object_unref(loader);
+
+  return icon;
+}
+
+/*! \fn GdkPixbuf* CIconCatalog::m_DecodeFile(const gchar *fullName, guint64 fileSize, gint size)
+    \brief To decode an icon file too large to be read into memory, chunk by chunk within the decoding limits.
+
+    \param[in] fullName. The icon file.
+    \param[in] fileSize. The size of the file.
+    \param[in] size. The wanted size of the icon.
+    \return GdkPixbuf object for the icon, NULL if it could not be decoded or is over the limits. It must be unreferenced.
+*/
+GdkPixbuf* CIconCatalog::m_DecodeFile(const gchar *fullName, guint64 fileSize, gint size)
+{
+  CIconStreamDecoder decoder(fullName, size);
+  GdkPixbuf *pixbuf = NULL;
+  gint status = ICON_STREAM_Running;
+
+#ifdef USE_NATIVE_XPM
+  /* A large XPM is parsed in place over a read-only mapping, it is never copied into a buffer or the loader. */
+  if( (pixbuf = m_DecodeMappedXpm(fullName, fileSize, size)) != NULL )
+    return pixbuf;
+#endif
+
+  if( !decoder.m_Open(fileSize) )
+    return NULL;
+
+  while(status == ICON_STREAM_Running)
+    status = decoder.m_Feed(16);
+
+  pixbuf = decoder.m_TakePixbuf();
+  if(pixbuf)
+  {
+     g_object_set_data(G_OBJECT(pixbuf), ICON_DATA_WIDTH, GINT_TO_POINTER(decoder.m_GetWidth()));
+     g_object_set_data(G_OBJECT(pixbuf), ICON_DATA_HEIGHT, GINT_TO_POINTER(decoder.m_GetHeight()));
+  }
+
+  return pixbuf;
+}
+
+#ifdef USE_NATIVE_XPM
+/*! \fn GdkPixbuf* CIconCatalog::m_DecodeMappedXpm(const gchar *fullName, guint64 fileSize, gint size)
+    \brief To decode an XPM file too large to be read into memory by the XPM parser, over a mapping of the file.
+
+    \param[in] fullName. The icon file, only a ".xpm" file is mapped.
+    \param[in] fileSize. The size of the file.
+    \param[in] size. The wanted size of the icon.
+    \return GdkPixbuf object for the icon, NULL if it is not an XPM the parser handles. It must be unreferenced.
+*/
+GdkPixbuf* CIconCatalog::m_DecodeMappedXpm(const gchar *fullName, guint64 fileSize, gint size)
+{
+  GMappedFile *mapped = NULL;
+  GdkPixbuf *pixbuf = NULL;
+
+  if( !CIconXpmDecoder::m_GetEnabled() || !g_str_has_suffix(fullName, ".xpm") ||
+      (fileSize > CIconStreamDecoder::m_GetMaxBytes()) )
+    return NULL;
+
+  if( (mapped = g_mapped_file_new(fullName, FALSE, NULL)) == NULL )
+    return NULL;
+
+  if( CIconXpmDecoder::m_IsXpm((const guchar*)g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped)) )
+  {
+     CIconXpmDecoder decoder((const guchar*)g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped));
+
+     if( (pixbuf = decoder.m_Decode(size)) != NULL )
+     {
+        g_object_set_data(G_OBJECT(pixbuf), ICON_DATA_WIDTH, GINT_TO_POINTER(decoder.m_GetWidth()));
+        g_object_set_data(G_OBJECT(pixbuf), ICON_DATA_HEIGHT, GINT_TO_POINTER(decoder.m_GetHeight()));
+     }
+  }
+
+  /* The decoder is gone before the mapping, it parses the file in place. */
+  g_mapped_file_unref(mapped);
+
+  return pixbuf;
+}
+#endif
+
+/*! \fn GdkPixbuf* CIconCatalog::m_DecodeMember(CIconArchive *pArchive, const ICON_ARCHIVE_MEMBER *pMember, gint size)
+    \brief To decode an archive member, fed from the archive into the loader chunk by chunk. It is never extracted.
+
+    \param[in] pArchive. The opened archive.
+    \param[in] pMember. The member of the archive.
+    \param[in] size. The wanted size of the icon.
+    \return GdkPixbuf object for the icon, NULL if it could not be read or decoded. It must be unreferenced.
+*/
+GdkPixbuf* CIconCatalog::m_DecodeMember(CIconArchive *pArchive, const ICON_ARCHIVE_MEMBER *pMember, gint size)
+{
+  GdkPixbufLoader *loader = NULL;
+  gboolean bWritten = false;
+
+  if( !pArchive || !pMember || (pMember->size == 0) )
+    return NULL;
+
+  loader = gdk_pixbuf_loader_new();
+  g_signal_connect(loader, "size-prepared", G_CALLBACK(cb_loader_size_prepared), GINT_TO_POINTER(size));
+
+  /* The reading stops at the first chunk the loader refuses, e.g. an image over the pixel limit. */
+  bWritten = pArchive->m_ReadMember(pMember, cb_loader_write_chunk, loader);
+
+  return m_TakeLoaderPixbuf(loader, bWritten);
+}
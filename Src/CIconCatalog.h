@@ -0,0 +1,178 @@
+/*! \file    CIconCatalog.h
+    \brief   Declaration of class CIconCatalog.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONCATALOG
+#define __CICONCATALOG
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "CIconFileReader.h"
+#include "CIconContentCache.h"
+#include "CIconSearchRoots.h"
+#include "CIconTheme.h"
+#include "CIconStreamDecoder.h"
+#include "CIconNegativeCache.h"
+#include "CIconDecoderPool.h"
+#include "CIconArchive.h"
+#include "CIconXpmDecoder.h"
+#include "CIconProfiler.h"
+
+/* Default icon path. This is used for file chooser, also */
+#define DEFAULT_ICON_PATH  "/usr/share/pixmaps/"
+#define DEFAULT_ICON_PATH_2  "/usr/share/app-install/icons/"
+
+/* Icons searching paths, under each XDG data directory. */
+#define ICON_SEARCH_PATH_PIXMAPS             "pixmaps"
+#define ICON_SEARCH_PATH_HICOLOR             "icons/hicolor"
+#define ICON_SEARCH_PATH_HICOLOR_SCALABLE    "icons/hicolor/scalable/apps"
+#define ICON_SEARCH_PATH_GNOME               "icons/gnome"
+#define ICON_SEARCH_PATH_GNOME_SCALABLE      "icons/gnome/scalable"
+#define ICON_SEARCH_PATH_GNOME_SCALABLE_APPS "icons/gnome/scalable/apps"
+
+/* The logical size of the thumbnails. */
+#define ICON_THUMBNAIL_SIZE  48
+
+/* The keys of the original image dimensions attached to the decoded thumbnails. */
+#define ICON_DATA_WIDTH   "iconchooser-original-width"
+#define ICON_DATA_HEIGHT  "iconchooser-original-height"
+
+/* The resolutions remembered at most, the least recently used ones are forgotten beyond it. */
+#define ICON_CATALOG_MAX_RESOLVED  65536
+
+/*! \class CIconCatalog
+    \brief The icon catalog engine: scanning locations, resolving icon names, making thumbnails and querying,
+           without any display.
+
+    It needs GLib and gdk-pixbuf only, and is built as the library libiconcatalog. All members may be called
+    from several threads at once, the caches are shared by all callers: the thumbnails of byte-identical files,
+    the loaded theme tables, the directories of the opened archives, the resolved names, and the decoding and resolving failures which are kept across runs
+    by CIconNegativeCache. A theme is loaded once and kept for the life of the
+    catalog, its tables are only read afterwards, so the lookups in it run without a lock.
+    The dialog is one caller of the process-wide catalog from m_GetShared().
+*/
+class CIconCatalog
+{
+  private:
+    GMutex m_CacheLock;                  /*!< Protect m_pContentCache. */
+    CIconContentCache *m_pContentCache;  /*!< The thumbnails of byte-identical icon files. */
+    GMutex m_ThemeLock;                  /*!< Protect m_pThemes. */
+    GHashTable *m_pThemes;               /*!< The theme name to its CIconTheme, NULL for a theme which failed to load. */
+    GHashTable *m_pGenerations;          /*!< The theme name to its generation, protected by m_ThemeLock as well. */
+    GMutex m_RootsLock;                  /*!< Protect m_pSearchRoots. */
+    CIconSearchRoots *m_pSearchRoots;    /*!< The directories of the union view, ICON_LOCATION_UNION. */
+    GMutex m_ResolveLock;                /*!< Protect m_pResolved and m_pResolvedOrder. */
+    GHashTable *m_pResolved;             /*!< "theme|name|size|scale" to its ICON_RESOLVED. */
+    GQueue *m_pResolvedOrder;            /*!< The keys of m_pResolved, the most recently used first. */
+    CIconNegativeCache *m_pNegativeCache;  /*!< The files which failed to decode and names which failed to resolve, across runs. */
+    GMutex m_PoolLock;                     /*!< Protect m_pDecoderPool, the pointer only. */
+    CIconDecoderPool *m_pDecoderPool;      /*!< The sandboxed decoder workers, NULL to decode in the process. */
+    GMutex m_ArchiveLock;                /*!< Protect m_pArchives. */
+    GHashTable *m_pArchives;             /*!< The archive file to its opened CIconArchive, read again when it changes. */
+
+    static CIconCatalog *m_pShared;
+
+    CIconTheme* m_GetTheme(const gchar *themeName);
+    gchar* m_ProbeFile(const gchar *fileName, gint size);
+    guint32 m_GetThemeGeneration(const gchar *themeName);
+    CIconArchive* m_GetArchive(const gchar *archiveName);
+    CIconArchive* m_OpenMember(const gchar *fullName, const ICON_ARCHIVE_MEMBER **ppMember);
+    GdkPixbuf* m_ThumbnailMember(const gchar *fullName, gint size, guint64 *pContentHash);
+
+    static void m_FreeTheme(gpointer data);
+    static void m_FreeResolved(gpointer data);
+    static void m_FreeArchive(gpointer data);
+    static GdkPixbuf* m_TakeLoaderPixbuf(GdkPixbufLoader *loader, gboolean bWritten);
+#ifdef USE_NATIVE_XPM
+    static GdkPixbuf* m_DecodeMappedXpm(const gchar *fullName, guint64 fileSize, gint size);
+#endif
+
+  public:
+    CIconCatalog();
+    ~CIconCatalog();
+
+    /* The catalog shared in the process, created at the first call. */
+    static CIconCatalog* m_GetShared(void);
+
+    /* To set the roots of the union view from a NULL-terminated list, NULL sets the default roots. */
+    void m_SetSearchRoots(const gchar **roots);
+
+    /* To list the icon files of a location: a directory, a zip or tar archive, ICON_LOCATION_UNION or
+       "theme:<theme name>/<context>". The icons in an archive are named "archive!/member".
+       The array and its strings must be freed, NULL if the location could not be read. */
+    GPtrArray* m_Scan(const gchar *location, gint scale, gint *pShadowed);
+
+    /* To list the icon files of a location whose file name matches a glob pattern, e.g. "*folder*". */
+    GPtrArray* m_Query(const gchar *location, const gchar *pattern, gint scale);
+
+    /* To find the file of an icon name in a theme, with or without extension. The returned string must be freed. */
+    gchar* m_LookupThemeFile(const gchar *themeName, const gchar *fileName, gint size, gint scale);
+
+    /* To find the file of an icon name or file name: in the theme, then in the legacy icon directories.
+       The results are remembered. The returned string must be freed, NULL if it is not found. */
+    gchar* m_Resolve(const gchar *iconName, gint size, gint scale, const gchar *themeName);
+
+    /* To make the thumbnail of an icon file or archive member at a size in device pixels, shared with identical files.
+       It must be unreferenced, NULL if the file could not be decoded. */
+    GdkPixbuf* m_Thumbnail(const gchar *fullName, gint size, guint64 *pContentHash);
+
+    /* The shared thumbnail cache, for callers which read the files themselves. */
+    guint64 m_GetContentHash(const ICON_FILE_BUFFER *pBuffer);
+    guint64 m_LookupContentHash(const ICON_FILE_BUFFER *pBuffer);
+    GdkPixbuf* m_LookupThumbnail(guint64 contentHash, gint size);
+    void m_InsertThumbnail(guint64 contentHash, gint size, GdkPixbuf *pixbuf);
+    void m_PruneThumbnails(void);
+    guint m_GetThumbnailCount(void);
+
+    /* To forget the thumbnails and the resolved names, e.g. after icons were installed. The failures remembered
+       across runs are kept, they are checked against the files and the themes. */
+    void m_ClearCaches(void);
+
+    /* The files which failed to decode, remembered across runs. m_IsKnownBadFile() only stat()s the files which failed. */
+    gboolean m_IsKnownBadFile(const gchar *fullName);
+    void m_AddBadFile(const gchar *fullName, gint64 mtime, guint64 size) { m_pNegativeCache->m_AddBadFile(fullName, mtime, size); }
+    CIconNegativeCache* m_GetNegativeCache(void) { return m_pNegativeCache; }
+
+    /* To write the failures remembered if they changed, e.g. when a loading finished. */
+    gboolean m_SaveNegativeCache(void) { return m_pNegativeCache->m_Save(); }
+
+    /* To decode the icon files in sandboxed worker processes running "program ICON_DECODER_WORKER_ARG", NULL for
+       ICON_DECODER_DEFAULT_PROGRAM. FALSE decodes in the process again. It could be changed while other threads
+       decode, their files are finished by the workers they started with. */
+    void m_SetSandboxed(gboolean sandboxed, const gchar *program, gint nWorkers);
+
+    /* The sandboxed decoder workers with a reference to be dropped by CIconDecoderPool::m_Unref(), NULL if there are none. */
+    CIconDecoderPool* m_GetDecoderPool(void);
+
+    gboolean m_IsSandboxed(void);
+
+    /* To decode an icon file read by CIconFileReader, in a worker if the catalog is sandboxed, even if it was too
+       large to be read into memory. It must be unreferenced. pStatus gets the ICON_DECODER_STATUS, only
+       ICON_DECODER_Failed is a file which could not be decoded, a worker which timed out or crashed says nothing of
+       the file. Could be NULL. */
+    GdkPixbuf* m_DecodeIconFile(const ICON_FILE_BUFFER *pBuffer, gint size, gint *pStatus);
+
+    /* To get the size, the archive's modification time and the content hash of an archive member without reading it.
+       FALSE if it is not a member of a readable archive. */
+    gboolean m_StatArchiveMember(const gchar *fullName, gsize *pSize, gint64 *pMtime, guint64 *pContentHash);
+
+    /* To check if a file name is an image format of icons. */
+    static gboolean m_IsIconFile(gchar *fileName);
+
+    /* To decode an icon file read into memory at a size in device pixels. It must be unreferenced. */
+    static GdkPixbuf* m_DecodeBuffer(const guchar *data, gsize length, gint size);
+
+    /* To decode an icon file too large to be read into memory, chunk by chunk. It must be unreferenced. */
+    static GdkPixbuf* m_DecodeFile(const gchar *fullName, guint64 fileSize, gint size);
+
+    /* To decode an archive member streamed from the archive, chunk by chunk. It must be unreferenced. */
+    static GdkPixbuf* m_DecodeMember(CIconArchive *pArchive, const ICON_ARCHIVE_MEMBER *pMember, gint size);
+};
+#endif   /* CICONCATALOG.H	*/
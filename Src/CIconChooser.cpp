@@ -12,9 +12,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <glib/gi18n.h>  /* For multi-language. */
 
 #include "CIconChooser.h"
+#include "CIconScoped.h"
+#ifdef USE_INDEX_DAEMON
+#include "CIconIndexDaemon.h"
+#endif
 
 /* The title of the frame widget. The tile string is enclosed with GNU gettext hint for multi-language. */
 #define WINDOW_TITLE  _("Icon Chooser")
@@ -23,15 +28,18 @@
 #define  DEFAULT_APP_ICON        "application-x-executable"
 #define  DEFAULT_APP_MIME_ICON  "gnome-mime-application-x-executable"
 
-/* The size of the icon shown in the icon view. The unit is "pixel" */
-#define IMG_SIZE 48
+/* The theme icon shown in the rows listed before decoding whose files could not be decoded. */
+#define  ICON_MISSING_IMAGE  "image-missing"
+
+/* The longest time of one icon loading slice on the main loop. The unit is "microsecond". */
+#define ICON_LOAD_SLICE_USEC  4000
 
 /* The maximum number of characters of one menu item's name and comment. */
 #define  MAX_ICON_PATH 2048
 
 /* The dimension of main window. */
 #define MAIN_WIN_WIDTH  540
-#define MAIN_WIN_HEIGHT 400
+#define MAIN_WIN_HEIGHT 470
 
 /* The dimension of scroll window. */
 #define SCROLL_WIDTH  520
@@ -41,6 +49,10 @@
 #define TEXT_ENTRY_WIDTH  430
 #define TEXT_ENTRY_HEIGHT 25
 
+/* The dimension of the loading progress bar. */
+#define PROGRESS_BAR_WIDTH  430
+#define PROGRESS_BAR_HEIGHT 25
+
 /* The dimension of the file chooser/dialog. */
 #define FILE_DIALOG_WIDTH  450 
 #define FILE_DIALOG_HEIGHT 400
@@ -66,6 +78,10 @@ enum ICON_ITEM_IDX
   COLUMN_ICON = 0,
   COLUMN_ICONNAME,
   COLUMN_ICONPATH,
+  COLUMN_CONTENTHASH,   /* The content hash of the icon file, 0 if it is unknown. */
+  COLUMN_DUPLICATES,    /* The number of identical icon files hidden behind this row. */
+  COLUMN_PERCEPTUALHASH,  /* The difference hash of the thumbnail, for finding similar icons. */
+  COLUMN_SOURCEROOT,    /* The directory the icon file was found in. */
   NUM_COLS
 };
 
@@ -97,16 +113,10 @@ static void on_browse_icon_path(GtkButton *button, CIconChooser *thisObject)
   {
      /* To get the current entered text. */
 	 gchar *text = (gchar*)gtk_entry_get_text((GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName));
-	 gchar *dirName = NULL;			
-			
-     if(text)
-       dirName = g_path_get_dirname(text);
-				
+	 CIconScopedString dirName(text ? g_path_get_dirname(text) : NULL);
+
      if(dirName)
-     {
         gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(dialog), dirName);
-        g_free(dirName);
-     }
      else
      {   
         /* To use the default icons searching path. */
@@ -126,17 +136,16 @@ static void on_browse_icon_path(GtkButton *button, CIconChooser *thisObject)
   /* To run the file dialog. And to store the selected files/directory. */
   if( gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT )
   {
-     /* To retrieve the selected command executable. */
-     GSList *selectCmd = gtk_file_chooser_get_filenames(GTK_FILE_CHOOSER (dialog));
-     gchar *chosenDir = g_strdup_printf("%s%s", (gchar*)(selectCmd->data), "/");
-
-     /* To refrsh/update the icon list store(model). */
-     gtk_entry_set_text( (GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName), chosenDir);
+     /* To retrieve the selected directory. The list and its file names are freed when they go out of scope. */
+     CIconScopedList<GSList> selectCmd(gtk_file_chooser_get_filenames(GTK_FILE_CHOOSER (dialog)), g_free);
 
-     if(chosenDir)
-       g_free(chosenDir);
+     if( selectCmd.m_GetFirst() )
+     {
+        CIconScopedString chosenDir(g_strdup_printf("%s%s", (gchar*)selectCmd.m_GetFirst(), "/"));
 
-     chosenDir = NULL;
+        /* To refrsh/update the icon list store(model). */
+        gtk_entry_set_text( (GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName), chosenDir);
+     }
   }
 
   /* Destroy the file dialog widget. */
@@ -161,8 +170,8 @@ static gboolean on_file_apply(GtkButton *button, CIconChooser *thisObject)
   /* To get the current entered text. */
   text = (gchar*)gtk_entry_get_text((GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName));
 
-  /* To store the current selected icon's full name. */
-  if( g_file_test(text, (GFileTest)(G_FILE_TEST_EXISTS|G_FILE_TEST_IS_REGULAR)) )
+  /* To store the current selected icon's full name, a file or a member of the archive browsed. */
+  if( g_file_test(text, (GFileTest)(G_FILE_TEST_EXISTS|G_FILE_TEST_IS_REGULAR)) || CIconArchive::m_IsMemberName(text) )
   {
     thisObject->m_SetCurrentIcon(text);
   }
@@ -170,11 +179,8 @@ static gboolean on_file_apply(GtkButton *button, CIconChooser *thisObject)
   /* To set the flag to indicate the user had chosen a icon. */
   thisObject->m_SetIsChosen(true);
 
-  /* To deinitialize all member variables and release allocated memory. */
-  thisObject->m_DeinitValue();
-
-  /* To destroy dialog window. */
-  gtk_widget_destroy( thisObject->m_GetWidget(ICONCHOOSER_GtkWindow_Main) );
+  /* To hide or destroy the dialog window and leave m_DoModal(). */
+  thisObject->m_EndModal();
 
   return true;
 }
@@ -191,15 +197,147 @@ static gboolean on_close(GtkButton *button, CIconChooser *thisObject)
   if(!button || !thisObject)
     return false;
 		
-  /* To de-initialize all member variables and release allocated memory. */
-  thisObject->m_DeinitValue();
+  /* To hide or destroy the dialog window and leave m_DoModal(). */
+  thisObject->m_EndModal();
+
+  return true;
+}
+
+/*!	\fn static gboolean cb_delete_event(GtkWidget *widget, GdkEvent *event, CIconChooser *thisObject)
+    \brief The callback function for the window manager closing the window. It acts as the "Close" button.
 
-  /* To destroy dialog window. */
-  gtk_widget_destroy( thisObject->m_GetWidget(ICONCHOOSER_GtkWindow_Main) );	
+    \param[in] widget. The main window.
+    \param[in] event. The delete event.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return TRUE to stop GTK from destroying the window, m_EndModal() takes care of it.
+*/
+static gboolean cb_delete_event(GtkWidget *widget, GdkEvent *event, CIconChooser *thisObject)
+{
+  if(!widget || !thisObject)
+    return false;
+
+  thisObject->m_EndModal();
 
   return true;
 }
 
+/*!	\fn static void cb_window_destroy(GtkWidget *widget, CIconChooser *thisObject)
+    \brief The callback function for the main window being destroyed.
+
+    \param[in] widget. The main window.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void cb_window_destroy(GtkWidget *widget, CIconChooser *thisObject)
+{
+  if(!widget || !thisObject)
+    return;
+
+  thisObject->m_OnWindowDestroyed();
+}
+
+/*!	\fn static void on_stop_loading(GtkButton *button, CIconChooser *thisObject)
+    \brief The callback function to cancel the icon loading in progress.
+
+    \param[in] button. The GtkButton object this callback function connects to.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void on_stop_loading(GtkButton *button, CIconChooser *thisObject)
+{
+  if(!button || !thisObject)
+    return;
+
+  thisObject->m_CancelIconList();
+}
+
+/*!	\fn static void cb_hide_duplicates_toggled(GtkToggleButton *button, CIconChooser *thisObject)
+    \brief The callback function to show or hide the duplicates of identical icons.
+
+    \param[in] button. The GtkCheckButton object this callback function connects to.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void cb_hide_duplicates_toggled(GtkToggleButton *button, CIconChooser *thisObject)
+{
+  if(!button || !thisObject)
+    return;
+
+  thisObject->m_SetHideDuplicates( gtk_toggle_button_get_active(button) );
+
+  /* The thumbnails are shared by the content cache, so only the rows are built again. */
+  thisObject->m_ReloadIconList(NULL);
+}
+
+/*!	\fn static void cb_all_folders_toggled(GtkToggleButton *button, CIconChooser *thisObject)
+    \brief The callback function to switch between the union view over all search roots and the default icon path.
+
+    \param[in] button. The GtkCheckButton object this callback function connects to.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void cb_all_folders_toggled(GtkToggleButton *button, CIconChooser *thisObject)
+{
+  GtkEntry *entry = NULL;
+
+  if(!button || !thisObject)
+    return;
+
+  /* The entry reloads the icon list as if the location was typed. */
+  entry = (GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName);
+
+  if( gtk_toggle_button_get_active(button) )
+    gtk_entry_set_text(entry, ICON_LOCATION_UNION);
+  else
+    gtk_entry_set_text(entry, thisObject->m_GetDefaultIconPath());
+}
+
+/*!	\fn static void cb_animate_toggled(GtkToggleButton *button, CIconChooser *thisObject)
+    \brief The callback function to play or stop the animated icons.
+
+    \param[in] button. The GtkCheckButton object this callback function connects to.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void cb_animate_toggled(GtkToggleButton *button, CIconChooser *thisObject)
+{
+  if(!button || !thisObject)
+    return;
+
+  thisObject->m_SetAnimate( gtk_toggle_button_get_active(button) );
+}
+
+/*!	\fn static void on_find_similar(GtkButton *button, CIconChooser *thisObject)
+    \brief The callback function to move the icons looking like the selected one to the top.
+
+    \param[in] button. The GtkButton object this callback function connects to.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void on_find_similar(GtkButton *button, CIconChooser *thisObject)
+{
+  if(!button || !thisObject)
+    return;
+
+  thisObject->m_FindSimilar();
+}
+
+/*!	\fn static void cb_sort_changed(GtkComboBox *combo, CIconChooser *thisObject)
+    \brief The callback function for choosing the sort mode or the group mode.
+
+    \param[in] combo. The GtkComboBox object this callback function connects to.
+    \param[in] thisObject. The instance of class CIconChooser.
+    \return NONE
+*/
+static void cb_sort_changed(GtkComboBox *combo, CIconChooser *thisObject)
+{
+  if(!combo || !thisObject)
+    return;
+
+  thisObject->m_SetSortMode( gtk_combo_box_get_active(GTK_COMBO_BOX(thisObject->m_GetWidget(ICONCHOOSER_GtkComboBox_Sort))),
+                             gtk_combo_box_get_active(GTK_COMBO_BOX(thisObject->m_GetWidget(ICONCHOOSER_GtkComboBox_Group))) );
+}
+
 /*!	\fn static void cb_selection_changed (GtkIconView *iconView, CIconChooser *thisObject)
     \brief The callback function for processing icon view item selected events.
 
@@ -209,12 +347,10 @@ static gboolean on_close(GtkButton *button, CIconChooser *thisObject)
 */
 static void cb_selection_changed(GtkIconView *iconView, CIconChooser *thisObject)
 {
-  GList *selected = NULL;
   GtkTreeIter iter;
   GtkTreeModel *model = NULL;
   GtkTreePath *path = NULL;
   GtkIconView *iconview = NULL;
-  gchar *iconFullName = NULL;
 
 #ifdef DEBUG_MENU_ICONCHOOSER
   g_print ("Selection changed!\n");
@@ -226,28 +362,30 @@ static void cb_selection_changed(GtkIconView *iconView, CIconChooser *thisObject
   /* To get the icon view object. */
   iconview = (GtkIconView*)thisObject->m_GetWidget(ICONCHOOSER_GtkIconView);
 
-  /* To get the path to the currently selected icon object in the icon view. */
-  selected = gtk_icon_view_get_selected_items(iconview);
+  /* To get the paths to the currently selected icon objects in the icon view, they are freed with the list. */
+  CIconScopedList<GList> selected(gtk_icon_view_get_selected_items(iconview), (GDestroyNotify)gtk_tree_path_free);
 
   /* To get the model of the icon view. */
   model = gtk_icon_view_get_model(iconview);
 
   /* Convert the path data from the "data" field in the GList node. */
-  if(selected && selected->data)
-     path = (GtkTreePath*)selected->data;
+  path = (GtkTreePath*)selected.m_GetFirst();
 
   /* To get the iterate from the path to the selected icon object. */
   if( (path != NULL) && (gtk_tree_model_get_iter(model, &iter, path) == true)  )
   {
-     /* To retrieve the full name of the selected icon object. */
-     gtk_tree_model_get(model, &iter, COLUMN_ICONPATH, &iconFullName,  -1);
+     /* To retrieve the full name of the selected icon object, the model returns a copy. */
+     CIconScopedString iconFullName(NULL);
+     gtk_tree_model_get(model, &iter, COLUMN_ICONPATH, iconFullName.m_Out(),  -1);
 
      /* To set the selected icon's full name to the text entry. */
-     gtk_entry_set_text((GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName), iconFullName);
+     if(iconFullName)
+       gtk_entry_set_text((GtkEntry*)thisObject->m_GetWidget(ICONCHOOSER_GtkEntry_IconPathName), iconFullName);
   }
 
-  if(selected)
-    g_list_free(selected);
+  /* Similar icons could only be found for a selected one. */
+  if( thisObject->m_GetWidget(ICONCHOOSER_GtkButton_FindSimilar) )
+    gtk_widget_set_sensitive(thisObject->m_GetWidget(ICONCHOOSER_GtkButton_FindSimilar), path != NULL);
 }
 
 /*!	\fn static void cb_text_changed(GtkEditable *iconView, CIconChooser *thisObject)
@@ -267,6 +405,20 @@ static void cb_text_changed(GtkEditable *textentry, CIconChooser *thisObject)
   /* To get the current entered text. */
   text = (gchar*)gtk_entry_get_text((GtkEntry*)textentry);
 
+  /* The union view over all search roots, or an icon theme. */
+  if( (strcmp(text, ICON_LOCATION_UNION) == 0) || g_str_has_prefix(text, ICON_LOCATION_THEME) )
+  {
+     thisObject->m_ReloadIconList(text);
+     return;
+  }
+
+  /* An icon pack could be browsed inside its zip or tar archive, without extracting it. */
+  if( CIconArchive::m_IsArchive(text) && (g_file_test(text, (GFileTest) (G_FILE_TEST_IS_REGULAR)) == true) )
+  {
+     thisObject->m_ReloadIconList(text);
+     return;
+  }
+
   /* To update the icon list contents if the entered text is a directory. */
   if( (g_file_test(text, (GFileTest) (G_FILE_TEST_EXISTS | G_FILE_TEST_IS_REGULAR)) == true) &&
       (g_file_test(text, (GFileTest) (G_FILE_TEST_IS_DIR)) == false)  )
@@ -278,15 +430,10 @@ static void cb_text_changed(GtkEditable *textentry, CIconChooser *thisObject)
   }
   else if( g_file_test(text, (GFileTest)(G_FILE_TEST_EXISTS | G_FILE_TEST_IS_DIR)) == true )
   {
-     gchar *pathName = NULL;
-
      if(g_str_has_suffix(text, "/") == false)
      {
-        pathName = g_strdup_printf("%s%s", text, "/");
+        CIconScopedString pathName(g_strdup_printf("%s%s", text, "/"));
         thisObject->m_ReloadIconList(pathName);
-
-        if(pathName)
-          g_free(pathName);
      }
      else
      {
@@ -296,6 +443,60 @@ static void cb_text_changed(GtkEditable *textentry, CIconChooser *thisObject)
    }
 }
 
+/*!	\fn static gboolean cb_idle_load_icons(CIconChooser *thisObject)
+    \brief The idle callback function to load icons in time slices.
+
+    \param[in] thisObject. The Icon Chooser window instance.
+    \return TRUE to be called again, FALSE when the loading finished.
+*/
+static gboolean cb_idle_load_icons(CIconChooser *thisObject)
+{
+  if(!thisObject)
+    return false;
+
+  /* Do a bounded amount of work, then yield to let GTK process input and redraw. */
+  if( thisObject->m_LoadIconListStep(g_get_monotonic_time() + ICON_LOAD_SLICE_USEC) )
+  {
+     thisObject->m_UpdateIconTotal();
+     thisObject->m_ReportProgress();
+
+     /* The loading waiting for the sandboxed workers is not polled, their thumbnails resume it. */
+     return !thisObject->m_SuspendLoad();
+  }
+
+  thisObject->m_FinishIconList();
+
+  return false;
+}
+
+/*!	\fn static gboolean cb_idle_decode_pending(CIconChooser *thisObject)
+    \brief The idle callback function to decode the rows scrolled near after the loading, in time slices.
+
+    \param[in] thisObject. The Icon Chooser window instance.
+    \return TRUE to be called again, FALSE when the rows near the visible ones are decoded.
+*/
+static gboolean cb_idle_decode_pending(CIconChooser *thisObject)
+{
+  if(!thisObject)
+    return false;
+
+  return thisObject->m_DecodePendingStep(g_get_monotonic_time() + ICON_LOAD_SLICE_USEC);
+}
+
+/*!	\fn static void cb_wake_pending(gpointer data)
+    \brief The callback function of the decode scheduler, other rows are shown after a scroll.
+
+    \param[in] data. The Icon Chooser window instance.
+    \return NONE
+*/
+static void cb_wake_pending(gpointer data)
+{
+  CIconChooser *thisObject = (CIconChooser*)data;
+
+  if(thisObject)
+    thisObject->m_WakePendingRows();
+}
+
 //--------------- Class Member Function Implementation.
 /*! \fn CIconChooser::CIconChooser(gchar *currentIconFullName, GtkWidget *pwGtkParent)
     \brief CIconChooser constructor
@@ -318,16 +519,61 @@ CIconChooser::CIconChooser(gchar *currentIconFullName, GtkWidget *pwGtkParent)
   m_DefaultIcon = g_strdup( DEFAULT_ICON );
 
   m_bIsChosen = false;
+  m_bPersistent = false;
+  m_bInModal = false;
+  m_LoadedLocation = NULL;
 
   m_nIconWidth = (gint)ICON_SHOW_WIDTH;
   m_nIconHeight = (gint)ICON_SHOW_HEIGHT;
 
   m_nButtonWidth = (gint)ICON_BUTTON_WIDTH;
   m_nButtonHeight = (gint)ICON_BUTTON_HEIGHT;
+  m_nScale = m_GetDefaultScale();
 
   m_icon_total = 0;
   m_icon_visible_total = 0;
 
+  m_pFileReader = new CIconFileReader();
+  m_pCatalog = CIconCatalog::m_GetShared();
+  m_pShownHashes = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)gtk_tree_iter_free);
+  m_bHideDuplicates = false;
+  m_pPerceptualHashes = g_array_new(false, false, sizeof(guint64));
+  m_pRowKeys = g_array_new(false, false, sizeof(ICONCHOOSER_ROW_KEYS));
+  m_nSortMode = ICONCHOOSER_SORT_None;
+  m_nGroupMode = ICONCHOOSER_GROUP_None;
+
+  m_pAnimator = new CIconAnimator(COLUMN_ICON, COLUMN_ICONPATH, m_GetThumbnailSize());
+  m_pBudget = new CIconThumbnailBudget(m_pCatalog, COLUMN_ICON, COLUMN_ICONPATH, COLUMN_CONTENTHASH, m_GetThumbnailSize());
+  m_pScheduler = new CIconDecodeScheduler();
+  m_pScheduler->m_SetWakeCallback(cb_wake_pending, this);
+
+  m_pLoadDir = NULL;
+  m_pLoadQueue = NULL;
+  m_nLoadQueueNext = 0;
+  m_pStreamJobs = g_queue_new();
+  m_pSandboxJobs = g_queue_new();
+  m_bWaitingWorkers = false;
+  m_bLoadSuspended = false;
+  m_nLoadBuffers = 0;
+  m_nLoadNext = 0;
+  m_nLoadSource = 0;
+  m_bIdleLoad = true;
+  m_bPrioritize = true;
+  m_bPrioritizedRun = false;
+  m_bArchiveRun = false;
+  m_nFarPriority = ICON_DECODE_Rest;
+  m_nPendingSource = 0;
+#ifdef USE_INDEX_DAEMON
+  m_pDaemonEntries = NULL;
+  m_nDaemonNext = 0;
+#endif
+  m_pPendingIcon = NULL;
+
+  memset(&m_LoadProgress, 0x00, sizeof(m_LoadProgress));
+  m_nLoadStartTime = 0;
+  m_pfnProgress = NULL;
+  m_pProgressData = NULL;
+
   for(int i=0; i<N_ICONCHOOSER_WIDGET_IDX ;i++)
     m_pWidgets[i] = NULL;  
 
@@ -352,23 +598,102 @@ CIconChooser::CIconChooser(gchar *currentIconFullName, GtkWidget *pwGtkParent)
 CIconChooser::~CIconChooser()
 {
   m_pwParent = NULL;
-  m_CurrentIcon = NULL;
-  m_IconBrowseLocation = NULL;	
-  m_DefaultIconPath = NULL;  
-  m_DefaultIcon = NULL;  	
   m_bIsChosen = false;
 
+  /* The strings are freed before they are cleared, clearing them first leaked them at every dialog. */
   if(m_CurrentIcon)
     g_free(m_CurrentIcon);
 
   if(m_IconBrowseLocation)
-		g_free(m_IconBrowseLocation);	
+    g_free(m_IconBrowseLocation);
 
   if (m_DefaultIconPath)
-		g_free(m_DefaultIconPath);  
+    g_free(m_DefaultIconPath);
 
   if (m_DefaultIcon)
-		g_free(m_DefaultIcon);  
+    g_free(m_DefaultIcon);
+
+  m_CurrentIcon = NULL;
+  m_IconBrowseLocation = NULL;
+  m_DefaultIconPath = NULL;
+  m_DefaultIcon = NULL;
+
+  /* The loading may still be in progress if the window was closed by the window manager. */
+  m_StopIconList();
+
+  /* A persistent instance keeps its window until it is deleted. */
+  if( m_pWidgets[ICONCHOOSER_GtkWindow_Main] )
+  {
+     m_DeinitValue();
+     gtk_widget_destroy( m_pWidgets[ICONCHOOSER_GtkWindow_Main] );
+  }
+
+  if (m_LoadedLocation)
+    g_free(m_LoadedLocation);
+
+  m_LoadedLocation = NULL;
+
+  if (m_pFileReader)
+    delete m_pFileReader;
+
+  m_pFileReader = NULL;
+
+  if (m_pShownHashes)
+    g_hash_table_destroy(m_pShownHashes);
+
+  m_pShownHashes = NULL;
+
+  if (m_pPerceptualHashes)
+    g_array_free(m_pPerceptualHashes, TRUE);
+
+  m_pPerceptualHashes = NULL;
+
+  if (m_pRowKeys)
+  {
+     m_ClearRowKeys();
+     g_array_free(m_pRowKeys, TRUE);
+  }
+
+  m_pRowKeys = NULL;
+
+  /* The catalog is shared in the process, it outlives the dialog. */
+  m_pCatalog = NULL;
+
+  if (m_pAnimator)
+    delete m_pAnimator;
+
+  m_pAnimator = NULL;
+
+  if (m_pBudget)
+    delete m_pBudget;
+
+  m_pBudget = NULL;
+
+  if (m_pScheduler)
+    delete m_pScheduler;
+
+  m_pScheduler = NULL;
+
+  if (m_pPendingIcon)
+    g_object_unref(m_pPendingIcon);
+
+  m_pPendingIcon = NULL;
+
+  if (m_pStreamJobs)
+  {
+     m_FreeStreamJobs();
+     g_queue_free(m_pStreamJobs);
+  }
+
+  m_pStreamJobs = NULL;
+
+  if (m_pSandboxJobs)
+  {
+     m_FreeSandboxJobs();
+     g_queue_free(m_pSandboxJobs);
+  }
+
+  m_pSandboxJobs = NULL;
 }
 
 /*! \fn void CIconChooser::m_GetWindowSize(int &nWidth, int &nHeight)
@@ -419,7 +744,7 @@ void CIconChooser::m_CreateInitValue(gchar *currentIconFullName)
         { Pixel-Buffer, String, String } .
   */
   if(m_ListStore == NULL)
-    m_ListStore = gtk_list_store_new(NUM_COLS, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_STRING);
+    m_ListStore = gtk_list_store_new(NUM_COLS, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT64, G_TYPE_INT, G_TYPE_UINT64, G_TYPE_STRING);
 }
 
 /*! \fn gboolean CIconChooser::m_InitLayoutUI(GtkWidget *pwGtkParent)
@@ -430,8 +755,6 @@ void CIconChooser::m_CreateInitValue(gchar *currentIconFullName)
 */
 gboolean CIconChooser::m_InitLayoutUI(GtkWidget *pwGtkParent)
 {
-  char totalIcon[6] = {0}, totalIconVisible[6] = {0};  // Currently, it could only show 5-digit number.
-
   /* To store the top-level GTK dialog window. */
   if(pwGtkParent != NULL)
     m_pwParent = pwGtkParent;
@@ -447,17 +770,9 @@ gboolean CIconChooser::m_InitLayoutUI(GtkWidget *pwGtkParent)
   /* To invoke the icon browsing dialog. */
   InitIconChooserDlg( (MAX_WIDTH/5), (MAX_HEIGHT/5) );
 
-  /* Set the total number of icons. */
-  #ifdef DEBUG_MENU_ICONCHOOSER
-  printf("%s(%d) - Total number of icon = %d \n", __FUNCTION__, __LINE__, m_icon_total);
-  printf("%s(%d) - Total number of Visible icon = %d \n\n", __FUNCTION__, __LINE__, m_icon_visible_total);
-  #endif
-
-  sprintf(totalIcon, "%d", m_icon_total);
-  sprintf(totalIconVisible, "%d", m_icon_visible_total);
-  
-  gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_IconTotal], (gchar*)totalIcon);
-  gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_VisibleIconTotal], (gchar*)totalIconVisible);
+  /* Set the total number of icons. It is updated again by every loading slice. */
+  m_UpdateIconTotal();
+  m_ReportProgress();
 
   return true;
 }
@@ -478,6 +793,11 @@ void CIconChooser::InitIconChooserDlg(int nPosX, int nPosY)
   GtkWidget *textEntry = NULL;
   GtkWidget *textentry_iconTotal = NULL, *textentry_iconVisibleTotal = NULL;
   GtkWidget *label_iconTotal = NULL, *label_iconVisibleTotal = NULL;
+  GtkWidget *progressLoad = NULL, *buttonStopLoad = NULL;
+  GtkWidget *checkHideDuplicates = NULL, *buttonFindSimilar = NULL;
+  GtkWidget *comboSort = NULL, *comboGroup = NULL;
+  GtkWidget *checkAllFolders = NULL;
+  GtkWidget *checkAnimate = NULL;
 #ifdef USE_FILECHOOSER
   GtkWidget *buttonIconPathBrowse = NULL;
 #endif
@@ -508,9 +828,13 @@ void CIconChooser::InitIconChooserDlg(int nPosX, int nPosY)
 
   /* Connect the "destroy" event to a signal handler.
      This event occurs when we call gtk_widget_destroy() on the window,
-     or if we return 'FALSE' in the "delete_event" callback. */
+     or if we return 'FALSE' in the "delete_event" callback.
+     It leaves the nested main loop of m_DoModal(), not the application's one. */
   gtk_signal_connect(GTK_OBJECT (window), "destroy",
-                     GTK_SIGNAL_FUNC (gtk_main_quit), NULL);	
+                     GTK_SIGNAL_FUNC (cb_window_destroy), this);	
+
+  /* Closing by the window manager is handled as the "Close" button, so a persistent window is only hidden. */
+  g_signal_connect(GTK_OBJECT (window), "delete-event", G_CALLBACK(cb_delete_event), this);
 
   /* Store the required widgets ... */
   m_pWidgets[ICONCHOOSER_GtkWindow_Main] = window;
@@ -554,6 +878,15 @@ void CIconChooser::InitIconChooserDlg(int nPosX, int nPosY)
   /* Set the signal connection for GtkIconView object. */
   g_signal_connect(iconView, "selection_changed", G_CALLBACK(cb_selection_changed), this);
 
+  /* The animated icons of this view are played by the animator, only the selected, hovered and visible ones. */
+  m_pAnimator->m_Attach(GTK_ICON_VIEW(iconView));
+
+  /* The thumbnails of the rows far from the visible ones are dropped while they take more than the memory budget. */
+  m_pBudget->m_Attach(GTK_ICON_VIEW(iconView));
+
+  /* The rows listed before they are decoded get their thumbnails in the order the user looks at them. */
+  m_pScheduler->m_Attach(GTK_ICON_VIEW(iconView), gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(scrollWin)));
+
 //-------------- Create button widget instances
 #ifdef USE_FILECHOOSER
   /* The button to invoke a file dialog(FileChooser) for user to choose a folder containing icons. */
@@ -677,6 +1010,135 @@ void CIconChooser::InitIconChooserDlg(int nPosX, int nPosY)
 
   /* Store the required widgets. */
   m_pWidgets[ICONCHOOSER_GtkEntry_VisibleIconTotal] = textentry_iconVisibleTotal;	
+
+//-------------- Create a progress bar and a button widget instances for the icon loading.
+  /* Create the progress bar widget instance. */
+  progressLoad = gtk_progress_bar_new();
+
+  /* Set the widget's size. */
+  gtk_widget_set_size_request(progressLoad, PROGRESS_BAR_WIDTH, PROGRESS_BAR_HEIGHT);
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), progressLoad, 10, 405);   /* set coordinate. */
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkProgressBar_Load] = progressLoad;
+
+  /* The button to cancel the icon loading in progress. */
+  buttonStopLoad = gtk_button_new_from_stock(GTK_STOCK_STOP);
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), buttonStopLoad, 450, 405);   /* set coordinate. */
+
+  /* Set the widget's size. */
+  gtk_widget_set_size_request(buttonStopLoad, 70, PROGRESS_BAR_HEIGHT);
+
+  /* It is only sensitive while the icons are loading. */
+  gtk_widget_set_sensitive(buttonStopLoad, m_IsLoading());
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkButton_StopLoad] = buttonStopLoad;
+
+  /* Set the signal connection for the "Stop" button */
+  g_signal_connect(GTK_OBJECT(buttonStopLoad), "clicked", G_CALLBACK(on_stop_loading), this);
+
+//-------------- Create a check button widget instance for hiding the duplicates of identical icons.
+  checkHideDuplicates = gtk_check_button_new_with_label(_("Hide duplicates"));
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), checkHideDuplicates, 10, 437);   /* set coordinate. */
+
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(checkHideDuplicates), m_bHideDuplicates);
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkCheckButton_HideDuplicates] = checkHideDuplicates;
+
+  /* Set the signal connection for the "Hide duplicates" check button. */
+  g_signal_connect(GTK_OBJECT(checkHideDuplicates), "toggled", G_CALLBACK(cb_hide_duplicates_toggled), this);
+
+//-------------- Create combo box widget instances for the order and the grouping of the icons.
+  /* The items are in the order of ICONCHOOSER_SORT_MODE. */
+  comboSort = gtk_combo_box_new_text();
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboSort), _("Unsorted"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboSort), _("By name"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboSort), _("By size"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboSort), _("By date"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboSort), _("By format"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboSort), _("By dimensions"));
+  gtk_combo_box_set_active(GTK_COMBO_BOX(comboSort), m_nSortMode);
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), comboSort, 150, 435);   /* set coordinate. */
+
+  /* Set the widget's size. */
+  gtk_widget_set_size_request(comboSort, 125, PROGRESS_BAR_HEIGHT);
+
+  /* The items are in the order of ICONCHOOSER_GROUP_MODE. */
+  comboGroup = gtk_combo_box_new_text();
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboGroup), _("No groups"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboGroup), _("Group by format"));
+  gtk_combo_box_append_text(GTK_COMBO_BOX(comboGroup), _("Group by folder"));
+  gtk_combo_box_set_active(GTK_COMBO_BOX(comboGroup), m_nGroupMode);
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), comboGroup, 285, 435);   /* set coordinate. */
+
+  /* Set the widget's size. */
+  gtk_widget_set_size_request(comboGroup, 125, PROGRESS_BAR_HEIGHT);
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkComboBox_Sort] = comboSort;
+  m_pWidgets[ICONCHOOSER_GtkComboBox_Group] = comboGroup;
+
+  /* Set the signal connection for the combo boxes. */
+  g_signal_connect(GTK_OBJECT(comboSort), "changed", G_CALLBACK(cb_sort_changed), this);
+  g_signal_connect(GTK_OBJECT(comboGroup), "changed", G_CALLBACK(cb_sort_changed), this);
+
+//-------------- Create a check button widget instance for the union view over all search roots.
+  checkAllFolders = gtk_check_button_new_with_label(_("All folders"));
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), checkAllFolders, 220, 348);   /* set coordinate. */
+
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(checkAllFolders), g_strcmp0(m_IconBrowseLocation, ICON_LOCATION_UNION) == 0);
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkCheckButton_AllFolders] = checkAllFolders;
+
+  /* Set the signal connection for the "All folders" check button. */
+  g_signal_connect(GTK_OBJECT(checkAllFolders), "toggled", G_CALLBACK(cb_all_folders_toggled), this);
+
+//-------------- Create a check button widget instance for playing the animated icons.
+  checkAnimate = gtk_check_button_new_with_label(_("Animate"));
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), checkAnimate, 220, 373);   /* set coordinate. */
+
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(checkAnimate), m_pAnimator->m_GetEnabled());
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkCheckButton_Animate] = checkAnimate;
+
+  /* Set the signal connection for the "Animate" check button. */
+  g_signal_connect(GTK_OBJECT(checkAnimate), "toggled", G_CALLBACK(cb_animate_toggled), this);
+
+//-------------- Create a button widget instance for finding the icons looking like the selected one.
+  buttonFindSimilar = gtk_button_new_with_label(_("Find similar"));
+
+  /* Set the location in the fixed container. */
+  gtk_fixed_put(GTK_FIXED(pFixedContainer), buttonFindSimilar, 420, 435);   /* set coordinate. */
+
+  /* Set the widget's size. */
+  gtk_widget_set_size_request(buttonFindSimilar, 100, PROGRESS_BAR_HEIGHT);
+
+  /* It is only sensitive while an icon is selected. */
+  gtk_widget_set_sensitive(buttonFindSimilar, false);
+
+  /* Store the required widgets. */
+  m_pWidgets[ICONCHOOSER_GtkButton_FindSimilar] = buttonFindSimilar;
+
+  /* Set the signal connection for the "Find similar" button. */
+  g_signal_connect(GTK_OBJECT(buttonFindSimilar), "clicked", G_CALLBACK(on_find_similar), this);
 }
 
 /*! \fn void CIconChooser::m_DeinitValue(void)
@@ -687,6 +1149,9 @@ void CIconChooser::InitIconChooserDlg(int nPosX, int nPosY)
 */
 void CIconChooser::m_DeinitValue(void)
 {
+  /* The loading slices must not touch the list-store any more. */
+  m_StopIconList();
+
   if( m_pWidgets[ICONCHOOSER_GtkIconView] )
     m_RemoveOldTreeModel(true);
 }
@@ -699,12 +1164,36 @@ void CIconChooser::m_DeinitValue(void)
 */
 gboolean CIconChooser::m_DoModal(void)
 {
-  /* Sets a window modal or non-modal. */
-  gtk_window_set_modal(GTK_WINDOW(m_pWidgets[ICONCHOOSER_GtkWindow_Main]), TRUE);
+  /* The window of a non-persistent instance was destroyed when it was closed last time, to create it again. */
+  if( m_pWidgets[ICONCHOOSER_GtkWindow_Main] == NULL )
+  {
+     m_CreateInitValue(NULL);
+     m_InitLayoutUI(m_pwParent);
+  }
+  else
+  {
+     /* To reuse the loaded icons unless the current icon was moved to another directory meanwhile. */
+     m_bIsChosen = false;
+     m_UpdateIconLocation();
 
-  if( m_pwParent != NULL )
-  {	
-     /* Dialog windows should be set transient for the main application window they were */
+     if( m_IconBrowseLocation && (g_strcmp0(m_IconBrowseLocation, m_LoadedLocation) != 0) )
+       m_ReloadIconList(NULL);
+
+     /* Show the current icon without letting the entry reload the list. */
+     if( m_CurrentIcon )
+     {
+        g_signal_handlers_block_by_func(m_pWidgets[ICONCHOOSER_GtkEntry_IconPathName], (gpointer)cb_text_changed, this);
+        gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_IconPathName], m_CurrentIcon);
+        g_signal_handlers_unblock_by_func(m_pWidgets[ICONCHOOSER_GtkEntry_IconPathName], (gpointer)cb_text_changed, this);
+     }
+  }
+
+  /* Sets a window modal or non-modal. */
+  gtk_window_set_modal(GTK_WINDOW(m_pWidgets[ICONCHOOSER_GtkWindow_Main]), TRUE);
+
+  if( m_pwParent != NULL )
+  {	
+     /* Dialog windows should be set transient for the main application window they were */
      /* spawned from. This allows window managers to e.g. keep the dialog on top of the  */
      /* main window, or center the dialog over the main window.                          */
      gtk_window_set_transient_for(GTK_WINDOW(m_pWidgets[ICONCHOOSER_GtkWindow_Main]), GTK_WINDOW(m_pwParent));
@@ -718,13 +1207,73 @@ gboolean CIconChooser::m_DoModal(void)
 
   /* Show all widgets */
   gtk_widget_show_all(m_pWidgets[ICONCHOOSER_GtkWindow_Main]);
+  gtk_window_present(GTK_WINDOW(m_pWidgets[ICONCHOOSER_GtkWindow_Main]));
 
-  /* Start to run. */
+  /* Start to run. This is a nested main loop if the application is running its own one already. */
+  m_bInModal = true;
   gtk_main();
 
   return TRUE;
 }
 
+/*! \fn void CIconChooser::m_EndModal(void)
+    \brief To close the dialog window and leave the main loop of m_DoModal().
+    \n A persistent instance only hides the window, keeping the loaded icons for the next m_DoModal().
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconChooser::m_EndModal(void)
+{
+  GtkWidget *window = m_pWidgets[ICONCHOOSER_GtkWindow_Main];
+
+  if(!window)
+    return;
+
+  if(m_bPersistent)
+  {
+     gtk_widget_hide(window);
+
+     if(m_bInModal)
+     {
+        m_bInModal = false;
+        gtk_main_quit();
+     }
+
+     return;
+  }
+
+  /* To deinitialize all member variables and release allocated memory. */
+  m_DeinitValue();
+
+  /* To destroy dialog window. The "destroy" handler leaves the main loop. */
+  gtk_widget_destroy(window);
+}
+
+/*! \fn void CIconChooser::m_OnWindowDestroyed(void)
+    \brief To forget the destroyed widgets and leave the main loop of m_DoModal().
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconChooser::m_OnWindowDestroyed(void)
+{
+  /* The loading slices must not touch the destroyed widgets. */
+  m_StopIconList();
+
+  for(int i=0; i<N_ICONCHOOSER_WIDGET_IDX ;i++)
+    m_pWidgets[i] = NULL;
+
+  m_IconView = NULL;
+  m_TreeSelection = NULL;
+
+  if(m_bInModal)
+  {
+     m_bInModal = false;
+     gtk_main_quit();
+  }
+}
+
 //-------------------------- GtkIconView
 /*! \fn GtkTreeModel* CIconChooser::m_CreateAndFillModel(void)
     \brief To create and fill tree model contents.
@@ -792,10 +1341,13 @@ GdkPixbuf* CIconChooser::m_LoadIcon(const gchar* name, gint size, gboolean use_f
   GtkIconTheme *theme = NULL;
   gchar *icon_name = NULL, *suffix = NULL;
   GdkPixbuf *icon = NULL;
+  ICONPROF_SCOPE(LoadIcon);
 
   if( name )
   {
-     if( g_path_is_absolute(name) )
+     if( CIconArchive::m_IsMemberName(name) )
+        icon = m_pCatalog->m_Thumbnail(name, size, NULL);
+     else if( g_path_is_absolute(name) )
         icon = gdk_pixbuf_new_from_file_at_size(name, size, size, NULL);
      else
      {
@@ -834,7 +1386,7 @@ GdkPixbuf* CIconChooser::m_LoadIcon(const gchar* name, gint size, gboolean use_f
 }
 
 /*! \fn GdkPixbuf* CIconChooser::m_LoadIconFile(const char* file_name, int size)
-    \brief Try to find it in "pixmaps", "icons/hicolor", "icons/hicolor/scalable/apps" directories.
+    \brief Try to find it in the current theme, then in "pixmaps", "icons/hicolor", "icons/hicolor/scalable/apps" directories.
 
     \param[in] file_name.
     \param[in] size.
@@ -843,99 +1395,12 @@ GdkPixbuf* CIconChooser::m_LoadIcon(const gchar* name, gint size, gboolean use_f
 GdkPixbuf* CIconChooser::m_LoadIconFile(const char* file_name, int size)
 {
   GdkPixbuf *icon = NULL;
-  char *file_path = NULL;
-  const gchar **dirs = (const gchar**)g_get_system_data_dirs();
-  const gchar **dir = NULL;
-  gchar *sizeName = NULL; 
-
-  for( dir = dirs; *dir; ++dir )
-  {
-     /* Searching in "/usr/share/pixmaps" directory. */
-     file_path = g_build_filename( *dir, ICON_SEARCH_PATH_PIXMAPS, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
-
-     if(file_path)
-       g_free(file_path);
-
-     file_path = NULL;
-		
-     if( icon )
-       break;
-
-     /* Searching icon in "/usr/share/icons/hicolor/SizexSize/apps", 
-        "/usr/local/share/icons/hicolor/SizexSize/apps" directories.
-        These are needed to assign the directory name formed in size. */
-     sizeName = g_strdup_printf( "%s/%dx%d/apps", ICON_SEARCH_PATH_HICOLOR, size, size );
-     file_path = g_build_filename( *dir, sizeName, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
-
-     if(file_path)
-       g_free( file_path );
-
-     if(sizeName)
-       g_free(sizeName);
-
-     file_path = NULL;
-     sizeName = NULL;
-
-     if( icon )
-       break;
-
-     /* Searching in "/usr/share/icons/hicolor/scalable/apps",  "/usr/local/share/icons/hicolor/scalable/apps". */
-     file_path = g_build_filename( *dir, ICON_SEARCH_PATH_HICOLOR_SCALABLE, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
-
-     if(file_path)
-       g_free( file_path );
-
-     file_path = NULL;
-
-     if( icon )
-       break;
-
-     /* Searching in "/usr/share/icons/gnome/scalable". */
-     file_path = g_build_filename( *dir, ICON_SEARCH_PATH_GNOME_SCALABLE, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+  ICONPROF_SCOPE(LoadIconFile);
 
-     if(file_path)
-       g_free( file_path );
-
-     file_path = NULL;	
-
-     if( icon )
-       break;
-
-     /* Searching in "/usr/share/icons/gnome/scalable/apps". */
-     file_path = g_build_filename( *dir, ICON_SEARCH_PATH_GNOME_SCALABLE_APPS, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
-
-     if(file_path)
-       g_free( file_path );
-
-     file_path = NULL;
-
-     if( icon )
-       break;
-
-     /* Searching in "/usr/share/icons/gnome/SizexSize/apps".
-        These are needed to assign the directory name formed in size. */
-     sizeName = g_strdup_printf( "%s/%dx%d/apps", ICON_SEARCH_PATH_GNOME, size, size );
-     file_path = g_build_filename( *dir,  sizeName, file_name, NULL );
+  CIconScopedString file_path(m_GetIconFullName(file_name, size));
+  if( file_path )
      icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
 
-     if(file_path)
-       g_free(file_path);
-
-     if(sizeName)
-       g_free(sizeName);
-
-     file_path = NULL;
-     sizeName = NULL;
-
-     if( icon )
-       break;
-  }
-
   return icon;
 }
 
@@ -951,6 +1416,7 @@ GdkPixbuf* CIconChooser::m_LoadThemeIcon(GtkIconTheme* theme, const char* icon_n
 {
   GdkPixbuf *icon = NULL;
   const char *file = NULL;
+  ICONPROF_SCOPE(ThemeLookup);
   GtkIconInfo *info = gtk_icon_theme_lookup_icon( theme, icon_name, size,  GTK_ICON_LOOKUP_USE_BUILTIN );
 
   if( G_UNLIKELY( !info ) )
@@ -996,294 +1462,1794 @@ GdkPixbuf* CIconChooser::m_LoadThemeIcon(GtkIconTheme* theme, const char* icon_n
   return icon;
 }
 
-/*! \fn gboolean CIconChooser::m_LoadIconList(void)
-    \brief To load a icons' content and append contents to the list-store.
+/*! \fn void CIconChooser::m_QueueLoadFile(gchar *fullName)
+    \brief To add an icon file to the batch being filled, unless it had failed to decode and not changed since.
 
-    \param[in] NONE.
-    \return TRUE or FALSE
+    \param[in] fullName. The icon file's full name, it is owned by the batch or freed.
+    \return NONE
 */
-gboolean CIconChooser::m_LoadIconList(void)
+void CIconChooser::m_QueueLoadFile(gchar *fullName)
 {
-  GDir *pDir = NULL;
-  GError *errOpen = NULL;
-  gchar *baseName = NULL, *fullName = NULL;   /* To store the icon file's basename, e.g. filename.extension, and full name, e.g. path/filename.extension. */
-  GtkTreeIter iter;
-
-  /* To check if it had been assigned a directory name. */
-  if( m_IconBrowseLocation == NULL )
+  /* A broken file costs one lookup, and a stat() as it had failed, instead of reading and decoding it. */
+  if( m_pCatalog->m_IsKnownBadFile(fullName) )
   {
-     #ifdef DEBUG_MENU_ICONCHOOSER
-     printf ("\n\n %s(%d) Error! The icons browsing location path is NULL! \n\n", __FUNCTION__, __LINE__);
-     #endif
-
-     return false;
+     m_LoadProgress.nFailed++;
+     m_LoadProgress.nKnownBad++;
+     g_free(fullName);
+     return;
   }
 
-  /* To set the if the the current file name is a directory. */
-  if( g_file_test(m_IconBrowseLocation,(GFileTest) G_FILE_TEST_IS_DIR) == false )
+  /* The row is shown at once with a placeholder, its file is read when the scheduler takes it. */
+  if(m_bPrioritizedRun)
   {
-     #ifdef DEBUG_MENU_ICONCHOOSER
-     printf ("\n\n %s(%d) Error! The icons browsing location path is not a directory! \n\n", __FUNCTION__, __LINE__);
-     #endif
-
-     return false;
+     m_AppendPendingRow(fullName);
+     g_free(fullName);
+     return;
   }
 
-  /* To open the icon browsing directory. */
-  pDir = g_dir_open(m_IconBrowseLocation, 0, &errOpen);
-  if(pDir == NULL)
-  {
-     if(errOpen)
-     {
-        #ifdef DEBUG_MENU_ICONCHOOSER
-        printf ("\n\n %s(%d) Error! %s! \n\n", __FUNCTION__, __LINE__, errOpen->message);
-        #endif
+  m_LoadBuffers[m_nLoadBuffers].knownHash = 0;
+  m_LoadBuffers[m_nLoadBuffers++].fullName = fullName;
+}
 
-        g_error_free(errOpen);
-     }
+/*! \fn void CIconChooser::m_AppendIcon(ICON_FILE_BUFFER *pBuffer)
+    \brief To decode an icon file of the current batch and append it to the list-store.
 
-     return false;
-  }		
+    \param[in] pBuffer. The icon file, its contents are released here.
+    \return NONE
+*/
+void CIconChooser::m_AppendIcon(ICON_FILE_BUFFER *pBuffer)
+{
+  GtkTreeIter *pShownIter = NULL;
+  GdkPixbuf *pixbuf = NULL;
+  guint64 contentHash = 0;
 
-  /* To retrieve the file name of icons in the chosen directory irrecusively. */
-  while( (baseName = (gchar*)g_dir_read_name(pDir)) != NULL )
-  {	
-     GdkPixbuf *pixbuf = NULL;
+  /* A member of an archive is known from the archive's directory, it is not read here. */
+  if(m_bArchiveRun)
+    m_pCatalog->m_StatArchiveMember(pBuffer->fullName, &pBuffer->fileSize, &pBuffer->mtime, &contentHash);
 
-     fullName = g_strdup_printf("%s%s", m_IconBrowseLocation, baseName);
+  m_LoadProgress.nBytesRead += pBuffer->data ? pBuffer->length : pBuffer->fileSize;
 
-     /* To check if the the currently read icon file name is valid. */
-     if( m_IsPhotoFile((gchar *)baseName) == FALSE )
-       continue;
+  /* A file too large to be read into memory is decoded chunk by chunk between the other icons.
+     The sandboxed workers read it by themselves. */
+  if( !m_bArchiveRun && !pBuffer->data && !pBuffer->knownHash && (pBuffer->error == 0) && !m_pCatalog->m_IsSandboxed() &&
+      m_StreamIcon(pBuffer, -1) )
+    return;
 
-     /* Increae the counter for read icon with valid file name. */
-     m_icon_total++;
+  /* Identical files under other names or in other directories share one thumbnail. */
+  if(!m_bArchiveRun)
+    contentHash = m_pCatalog->m_GetContentHash(pBuffer);
 
-     /* To retrieve the basename of the icon file. */
-     baseName = g_path_get_basename(fullName);
+  /* The same image is shown already, only the number of its copies is increased. */
+  if( m_bHideDuplicates && contentHash &&
+      (pShownIter = (GtkTreeIter*)g_hash_table_lookup(m_pShownHashes, &contentHash)) != NULL )
+  {
+     CIconFileReader::m_FreeBuffer(pBuffer);
+     m_AddDuplicate(pShownIter);
+     m_LoadProgress.nDuplicates++;
 
-     /* To create the icon for the currently read node. */
-     pixbuf = m_LoadIcon(fullName, IMG_SIZE, NULL);			
+     g_free(pBuffer->fullName);
+     pBuffer->fullName = NULL;
+     return;
+  }
 
-     /* To check if it had load image successfully. */
-     if( pixbuf )
-     {
-        /* Append a row and fill in some data */
-        /* Step 1) To request a new node memory to be add new data. */
-        gtk_list_store_append(m_ListStore, &iter);
-
-        /* Step 2) To put the text into the allocated memory .The list is terminated by a -1.  */
-        gtk_list_store_set(m_ListStore, &iter,
-                           COLUMN_ICON, pixbuf,
-                           COLUMN_ICONNAME, baseName,
-                           COLUMN_ICONPATH, fullName,
-                           -1);	
-			
-        /* The PixBuf has a refcount of 1st now, as the list store has added its own reference */
-        g_object_unref(pixbuf);
+  /* The sandboxed workers decode in parallel, the row is appended when the thumbnail comes back. */
+  if( m_SandboxIcon(pBuffer, contentHash, -1) )
+    return;
 
-        /* Increae the counter for visible icon(e.g. could be shown in icon view). */
-        m_icon_visible_total++;
-     }
+  pixbuf = m_DecodeLoadBuffer(pBuffer, contentHash);
 
-     /* To free the allocated memory for storing the icon full name. */
-     if(fullName)
-       g_free(fullName);
+  CIconFileReader::m_FreeBuffer(pBuffer);
 
-     if(baseName)
-       g_free(baseName);
-  }	
+  m_AppendRow(pBuffer->fullName, pixbuf, contentHash, pBuffer->fileSize, pBuffer->mtime);
 
-  return true;
+  if(pixbuf)
+    g_object_unref(pixbuf);
+
+  /* To free the allocated memory for storing the icon full name. */
+  g_free(pBuffer->fullName);
+  pBuffer->fullName = NULL;
 }
 
-/*! \fn gboolean CIconChooser::m_ReloadIconList(gchar *iconpath)
-    \brief To reload a icon contents and append contents to the list-store.
+/*! \fn GdkPixbuf* CIconChooser::m_DecodeLoadBuffer(ICON_FILE_BUFFER *pBuffer, guint64 contentHash)
+    \brief To get the thumbnail of an icon file read by the batch, from the catalog or decoded.
 
-    \param[in] iconpath.
-    \return TRUE or FALSE
+    \param[in] pBuffer. The icon file, its contents are not released here.
+    \param[in] contentHash. The content hash of the file, 0 if it is unknown.
+    \return The thumbnail to be unreferenced, NULL if the file could not be decoded.
 */
-gboolean CIconChooser::m_ReloadIconList(gchar *iconpath)
-{ 
-  /* First, to clear out the list-store's contents. */
-  GtkTreeModel *model = NULL;
-  char totalIcon[6] = {0}, totalIconVisible[6] = {0};  // Currently, it could only show 5-digit number.
+GdkPixbuf* CIconChooser::m_DecodeLoadBuffer(ICON_FILE_BUFFER *pBuffer, guint64 contentHash)
+{
+  GdkPixbuf *pixbuf = NULL;
 
-  m_bIsChosen = false;
-  m_RemoveOldTreeModel(false);
+  /* To create the icon for the currently read node, decoded at the device pixel size so it is sharp on HiDPI displays.
+     The cache is keyed by the size as well, the thumbnails of every scale are kept apart. */
+  pixbuf = m_pCatalog->m_LookupThumbnail(contentHash, m_GetThumbnailSize());
 
-  /* Second, to load icons' content into the list-store. */
-  if(iconpath)
-    m_SetIconBrowseLocation(iconpath);  /* To set the icon browsing path. */
+  /* The file skipped by the batch because its thumbnail was cached is read now, the thumbnail was dropped since. */
+  if( (pixbuf == NULL) && !m_bArchiveRun && pBuffer->knownHash && !pBuffer->data )
+    CIconFileReader::m_ReadOne(pBuffer);
 
-  /* To call the funciton to build the list-store contents.
-     The path to icons may be changed when it is set current icon full name. */
-  m_LoadIconList();
+  /* The catalog streams an archive member into the decoder, and remembers it if it failed. */
+  if( (pixbuf == NULL) && m_bArchiveRun )
+    pixbuf = m_pCatalog->m_Thumbnail(pBuffer->fullName, m_GetThumbnailSize(), NULL);
+  else if( (pixbuf == NULL) && (pBuffer->error == 0) && (pBuffer->data || m_pCatalog->m_IsSandboxed()) )
+  {
+     gint nStatus = ICON_DECODER_Failed;
+     ICONPROF_MARK(nDecodeStart);
 
-  /* Finally, to set the tree model to the icon view. */
-  model = m_CreateAndFillModel();
-  gtk_icon_view_set_model(GTK_ICON_VIEW(m_pWidgets[ICONCHOOSER_GtkIconView]), model);
-  g_object_unref(model);
+     /* A large file is read by a sandboxed worker, it is never streamed in the process while sandboxed. */
+     pixbuf = m_pCatalog->m_DecodeIconFile(pBuffer, m_GetThumbnailSize(), &nStatus);
 
-  /* Set the total number of icons. */
-  #ifdef DEBUG_MENU_ICONCHOOSER
-  printf("%s(%d)  Total number of icon = %d \n", __FUNCTION__, __LINE__, m_icon_total);
-  printf("%s(%d)  Total number of Visible icon = %d \n\n", __FUNCTION__, __LINE__, m_icon_visible_total);
-  #endif
+     ICONPROF_DECODE(pBuffer->fullName, nDecodeStart, pixbuf != NULL);
 
-  sprintf(totalIcon, "%d", m_icon_total);
-  sprintf(totalIconVisible, "%d", m_icon_visible_total);
-  
-  gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_IconTotal], (gchar*)totalIcon);
-  gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_VisibleIconTotal], (gchar*)totalIconVisible);
+     /* Only a file which could not be decoded is remembered, not one a worker timed out or crashed on. */
+     if(pixbuf)
+       m_pCatalog->m_InsertThumbnail(contentHash, m_GetThumbnailSize(), pixbuf);
+     else if(nStatus == ICON_DECODER_Failed)
+       m_pCatalog->m_AddBadFile(pBuffer->fullName, pBuffer->mtime, pBuffer->fileSize);
+  }
 
-  return true;
+  return pixbuf;
 }
 
-/*! \fn	gboolean CIconChooser::m_IsPhotoFile(gchar *pFile)
-    \brief To determine if the current read image format is valid.
+/*! \fn void CIconChooser::m_ReadLoadBatch(void)
+    \brief To read the files of the batch into memory, except those whose contents are not needed.
+    \n Each file is stat()ed first. An unchanged file whose content hash is known by its identity is not read when
+    its thumbnail is cached or an identical image is shown already, its "knownHash" is set instead.
 
-    \param[in] pFile. The icon file name.
-    \return TRUE or FALSE
+    \return NONE
 */
-gboolean CIconChooser::m_IsPhotoFile(gchar *pFile)
+void CIconChooser::m_ReadLoadBatch(void)
 {
-  gboolean bRet = FALSE;
-  gchar *pStr;
+  ICON_FILE_BUFFER toRead[ICON_READ_BATCH];
+  gint slots[ICON_READ_BATCH];
+  gint nToRead = 0;
 
-  pStr = g_ascii_strdown(pFile, -1);
-
-  bRet = g_str_has_suffix (pStr,".jpg");
-  if(bRet == TRUE)
+  for(gint i=0; i<m_nLoadBuffers; i++)
   {
-    g_free(pStr);
-    return TRUE;
-  }
+     ICON_FILE_BUFFER *pBuffer = &m_LoadBuffers[i];
+     GdkPixbuf *pixbuf = NULL;
+     guint64 contentHash = 0;
 
-  bRet = g_str_has_suffix(pStr,".jpeg");
-  if(bRet==TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+     CIconFileReader::m_StatOne(pBuffer);
 
-  bRet = g_str_has_suffix(pStr,".jpe");
-  if(bRet==TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+     if( (pBuffer->error == 0) && ((contentHash = m_pCatalog->m_LookupContentHash(pBuffer)) != 0) )
+     {
+        if( m_bHideDuplicates && g_hash_table_contains(m_pShownHashes, &contentHash) )
+          pBuffer->knownHash = contentHash;
+        else if( (pixbuf = m_pCatalog->m_LookupThumbnail(contentHash, m_GetThumbnailSize())) != NULL )
+        {
+           pBuffer->knownHash = contentHash;
+           g_object_unref(pixbuf);
+        }
+     }
 
-  bRet = g_str_has_suffix(pStr,".png");
-  if(bRet == TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+     if( (pBuffer->error != 0) || pBuffer->knownHash )
+       continue;
 
-  bRet = g_str_has_suffix(pStr,".gif");
-  if(bRet == TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
+     toRead[nToRead] = *pBuffer;
+     slots[nToRead++] = i;
   }
 
-  bRet = g_str_has_suffix(pStr,".tif");
-  if(bRet == TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+  if(nToRead == 0)
+    return;
 
-  bRet = g_str_has_suffix(pStr,".tiff");
-  if(bRet == TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+  /* The buffers keep their places in the batch, the rows of a prioritized run are matched by position. */
+  m_pFileReader->m_ReadBatch(toRead, nToRead);
 
-  bRet = g_str_has_suffix(pStr,".bmp");
-  if(bRet == TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+  for(gint i=0; i<nToRead; i++)
+    m_LoadBuffers[ slots[i] ] = toRead[i];
+}
 
-  bRet = g_str_has_suffix(pStr,".svg");
-  if(bRet == TRUE)
-  {
-     g_free(pStr);
-     return TRUE;
-  }
+/*! \fn void CIconChooser::m_AppendRow(const gchar *fullName, GdkPixbuf *pixbuf, guint64 contentHash, gsize fileSize, gint64 mtime)
+    \brief To append the row of a decoded icon to the list-store.
+
+    \param[in] fullName. The icon file's full name.
+    \param[in] pixbuf. The thumbnail, NULL if the decoding failed. The list-store takes its own reference.
+    \param[in] contentHash. The content hash of the file, 0 if it is unknown.
+    \param[in] fileSize. The size of the file on disk.
+    \param[in] mtime. The modification time of the file.
+    \return NONE
+*/
+void CIconChooser::m_AppendRow(const gchar *fullName, GdkPixbuf *pixbuf, guint64 contentHash, gsize fileSize, gint64 mtime)
+{
+  GtkTreeIter iter;
+  gchar *baseName = NULL;
+  gchar *sourceRoot = NULL;
+  guint64 perceptualHash = 0;
 
-  bRet = g_str_has_suffix(pStr,".xpm");
-  if (bRet == TRUE)
+  /* To check if it had load image successfully. */
+  if( pixbuf == NULL )
   {
-     g_free(pStr);
-     return TRUE;
+     m_LoadProgress.nFailed++;
+     return;
   }
 
-  g_free(pStr);
+  ICONPROF_SCOPE(ModelInsert);
+
+  /* The shrunk thumbnail is tiny, so this costs far less than the decoding. */
+  perceptualHash = CIconPerceptualHash::m_Compute(pixbuf);
+
+  /* To retrieve the basename of the icon file, and the directory it was found in for the union view. */
+  baseName = g_path_get_basename(fullName);
+  sourceRoot = g_path_get_dirname(fullName);
+
+  /* Append a row and fill in some data */
+  /* Step 1) To request a new node memory to be add new data. */
+  gtk_list_store_append(m_ListStore, &iter);
+
+  /* Step 2) To put the text into the allocated memory .The list is terminated by a -1.  */
+  gtk_list_store_set(m_ListStore, &iter,
+                     COLUMN_ICON, pixbuf,
+                     COLUMN_ICONNAME, baseName,
+                     COLUMN_ICONPATH, fullName,
+                     COLUMN_CONTENTHASH, contentHash,
+                     COLUMN_DUPLICATES, 0,
+                     COLUMN_PERCEPTUALHASH, perceptualHash,
+                     COLUMN_SOURCEROOT, sourceRoot,
+                     -1);	
+
+  /* Kept contiguous as well, so the whole set could be ranked in one pass. */
+  g_array_append_val(m_pPerceptualHashes, perceptualHash);
 
-  return FALSE;
+  m_AppendRowKeys(fullName, fileSize, mtime, pixbuf);
+  m_pBudget->m_AddRow(pixbuf);
+
+  /* The iterators of a list-store persist, so the row could be found for the later duplicates. */
+  if(contentHash)
+    g_hash_table_insert(m_pShownHashes, g_memdup2(&contentHash, sizeof(contentHash)), gtk_tree_iter_copy(&iter));
+
+  /* Increae the counter for visible icon(e.g. could be shown in icon view). */
+  m_icon_visible_total++;
+
+  g_free(baseName);
+  g_free(sourceRoot);
 }
 
-/*! \fn	void CIconChooser::m_SetCurrentIcon(gchar *icon)
-    \brief To set the current chosen icon's full name string.
+/*! \fn void CIconChooser::m_AppendPendingRow(const gchar *fullName)
+    \brief To append the row of an icon file not decoded yet, with a placeholder. The scheduler decodes it later.
 
-    \param[in] icon. The current chosen icon's full path.
+    \param[in] fullName. The icon file's full name.
     \return NONE
 */
-void CIconChooser::m_SetCurrentIcon(gchar *icon)
+void CIconChooser::m_AppendPendingRow(const gchar *fullName)
 {
-  if( (icon == NULL) || (strlen(icon) == 0) )
-  {
-     #ifdef DEBUG_MENU_ICONCHOOSER
-     printf("\n\n %s(%d)  Error! The passed-in icons full name is NULL! \n\n", __FUNCTION__, __LINE__);
-     #endif
+  GtkTreeIter iter;
+  guint64 perceptualHash = 0;
+  CIconScopedString baseName(g_path_get_basename(fullName));
+  CIconScopedString sourceRoot(g_path_get_dirname(fullName));
+
+  ICONPROF_SCOPE(ModelInsert);
+
+  gtk_list_store_append(m_ListStore, &iter);
+  gtk_list_store_set(m_ListStore, &iter,
+                     COLUMN_ICON, m_pPendingIcon,
+                     COLUMN_ICONNAME, baseName.m_Get(),
+                     COLUMN_ICONPATH, fullName,
+                     COLUMN_CONTENTHASH, (guint64)0,
+                     COLUMN_DUPLICATES, 0,
+                     COLUMN_PERCEPTUALHASH, perceptualHash,
+                     COLUMN_SOURCEROOT, sourceRoot.m_Get(),
+                     -1);
+
+  /* The keys known from the name are set now, the size, the time and the dimensions when it is decoded. */
+  g_array_append_val(m_pPerceptualHashes, perceptualHash);
+  m_AppendRowKeys(fullName, 0, 0, NULL);
+  m_pBudget->m_AddRow(NULL);
+  m_pScheduler->m_AddPending();
+}
 
-     return;
-  }
-	
-  if(m_CurrentIcon)
-  {
-     g_free(m_CurrentIcon);
-     m_CurrentIcon = NULL;
-  }	
+/*! \fn void CIconChooser::m_FillPendingRow(ICON_FILE_BUFFER *pBuffer, gint nRow)
+    \brief To decode an icon file of the current batch into the row waiting for it.
 
-  m_CurrentIcon = g_strdup(icon);
+    \param[in] pBuffer. The icon file, its contents are released here.
+    \param[in] nRow. The position of the row.
+    \return NONE
+*/
+void CIconChooser::m_FillPendingRow(ICON_FILE_BUFFER *pBuffer, gint nRow)
+{
+  GdkPixbuf *pixbuf = NULL;
+  guint64 contentHash = 0;
 
-  /* To update the icon browing location. */
-  m_UpdateIconLocation();
-} 
+  if(m_bArchiveRun)
+    m_pCatalog->m_StatArchiveMember(pBuffer->fullName, &pBuffer->fileSize, &pBuffer->mtime, &contentHash);
 
-/*! \fn	void CIconChooser::m_SetCurrentIcon(gchar *iconlocation)
-    \brief To set the current chosen icons locating path string.
+  m_LoadProgress.nBytesRead += pBuffer->data ? pBuffer->length : pBuffer->fileSize;
 
-    \param[in] iconlocation. The current chosen icon's full path name.
+  if( !m_bArchiveRun && !pBuffer->data && !pBuffer->knownHash && (pBuffer->error == 0) && !m_pCatalog->m_IsSandboxed() &&
+      m_StreamIcon(pBuffer, nRow) )
+    return;
+
+  if(!m_bArchiveRun)
+    contentHash = m_pCatalog->m_GetContentHash(pBuffer);
+
+  if( m_SandboxIcon(pBuffer, contentHash, nRow) )
+    return;
+
+  pixbuf = m_DecodeLoadBuffer(pBuffer, contentHash);
+
+  CIconFileReader::m_FreeBuffer(pBuffer);
+
+  if( pixbuf == NULL )
+    m_LoadProgress.nFailed++;
+
+  m_SetRowThumbnail(nRow, pixbuf, contentHash, pBuffer->fileSize, pBuffer->mtime);
+
+  if(pixbuf)
+    g_object_unref(pixbuf);
+
+  g_free(pBuffer->fullName);
+  pBuffer->fullName = NULL;
+}
+
+/*! \fn void CIconChooser::m_SetRowThumbnail(gint nRow, GdkPixbuf *pixbuf, guint64 contentHash, gsize fileSize, gint64 mtime)
+    \brief To put the thumbnail into a row listed before it was decoded, and mark the row done.
+
+    \param[in] nRow. The position of the row.
+    \param[in] pixbuf. The thumbnail, NULL if the file could not be decoded. The list-store takes its own reference.
+    \param[in] contentHash. The content hash of the file, 0 if it is unknown.
+    \param[in] fileSize. The size of the file on disk.
+    \param[in] mtime. The modification time of the file.
     \return NONE
 */
-void CIconChooser::m_SetIconBrowseLocation(gchar *iconlocation) 
+void CIconChooser::m_SetRowThumbnail(gint nRow, GdkPixbuf *pixbuf, guint64 contentHash, gsize fileSize, gint64 mtime)
 {
-  if( (iconlocation == NULL) || (strlen(iconlocation) == 0) )
+  GtkTreeIter iter;
+  guint64 perceptualHash = 0;
+
+  m_pScheduler->m_Done(nRow);
+
+  if( !gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(m_ListStore), &iter, NULL, nRow) )
+    return;
+
+  /* The row is shown already, removing it would move the rows under the user's pointer. It shows the missing image. */
+  if( pixbuf == NULL )
   {
-     #ifdef DEBUG_MENU_ICONCHOOSER
-     printf("\n\n %s(%d)  Error! The passed-in icons locating path is NULL! \n\n", __FUNCTION__, __LINE__);
-     #endif
+     CIconScopedObject<GdkPixbuf> missing(m_LoadThemeIcon(gtk_icon_theme_get_default(), ICON_MISSING_IMAGE, m_GetThumbnailSize()));
+
+     if(missing)
+       gtk_list_store_set(m_ListStore, &iter, COLUMN_ICON, missing.m_Get(), -1);
 
      return;
   }
 
-  if(m_IconBrowseLocation)
-  {
-     g_free(m_IconBrowseLocation);
-     m_IconBrowseLocation = NULL;
-  }
+  ICONPROF_SCOPE(ModelInsert);
 
-  m_IconBrowseLocation = g_strdup(iconlocation);
-} 
+  perceptualHash = CIconPerceptualHash::m_Compute(pixbuf);
 
-/*! \fn	void CIconChooser::m_SetDefaultIconPath(gchar *defaultIconPath)
+  /* The budget counts the thumbnail before the row holds it, the placeholder held nothing. */
+  m_pBudget->m_SetRow(nRow, pixbuf);
+
+  gtk_list_store_set(m_ListStore, &iter,
+                     COLUMN_ICON, pixbuf,
+                     COLUMN_CONTENTHASH, contentHash,
+                     COLUMN_PERCEPTUALHASH, perceptualHash,
+                     -1);
+
+  if( (guint)nRow < m_pPerceptualHashes->len )
+    g_array_index(m_pPerceptualHashes, guint64, nRow) = perceptualHash;
+
+  m_UpdateRowKeys(nRow, fileSize, mtime, pixbuf);
+
+  m_icon_visible_total++;
+}
+
+/*! \fn gboolean CIconChooser::m_StreamIcon(ICON_FILE_BUFFER *pBuffer, gint nRow)
+    \brief To queue a file too large to be read into memory for the decoding chunk by chunk.
+
+    \param[in] pBuffer. The icon file, its full name is moved into the queue.
+    \param[in] nRow. The row waiting for the thumbnail, -1 to append a row for it.
+    \return TRUE if the file was queued or refused by the limits, FALSE if it could not be opened.
+*/
+gboolean CIconChooser::m_StreamIcon(ICON_FILE_BUFFER *pBuffer, gint nRow)
+{
+  ICONCHOOSER_STREAM_JOB *job = NULL;
+  CIconStreamDecoder *decoder = new CIconStreamDecoder(pBuffer->fullName, m_GetThumbnailSize());
+
+  if( !decoder->m_Open(pBuffer->fileSize) )
+  {
+     gboolean bRejected = decoder->m_GetRejected();
+
+     delete decoder;
+
+     if(!bRejected)
+       return false;
+
+     m_LoadProgress.nOversized++;
+
+     if(nRow >= 0)
+       m_SetRowThumbnail(nRow, NULL, 0, pBuffer->fileSize, pBuffer->mtime);
+
+     g_free(pBuffer->fullName);
+     pBuffer->fullName = NULL;
+     return true;
+  }
+
+  job = g_new0(ICONCHOOSER_STREAM_JOB, 1);
+  job->decoder = decoder;
+  job->fileSize = pBuffer->fileSize;
+  job->mtime = pBuffer->mtime;
+  job->nRow = nRow;
+  g_queue_push_tail(m_pStreamJobs, job);
+
+  g_free(pBuffer->fullName);
+  pBuffer->fullName = NULL;
+
+  return true;
+}
+
+/*! \fn void CIconChooser::m_StepStreamJob(void)
+    \brief To feed one chunk of the first large file to its decoder, and append its row when it is done.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconChooser::m_StepStreamJob(void)
+{
+  ICONCHOOSER_STREAM_JOB *job = (ICONCHOOSER_STREAM_JOB*)g_queue_peek_head(m_pStreamJobs);
+  GdkPixbuf *pixbuf = NULL;
+  gint status = ICON_STREAM_Running;
+
+  if(!job)
+    return;
+
+  status = job->decoder->m_Feed(1);
+
+  if(status == ICON_STREAM_Running)
+    return;
+
+  g_queue_pop_head(m_pStreamJobs);
+
+  pixbuf = job->decoder->m_TakePixbuf();
+
+  if(job->decoder->m_GetRejected())
+  {
+     m_LoadProgress.nOversized++;
+
+     if(job->nRow >= 0)
+       m_SetRowThumbnail(job->nRow, NULL, 0, job->fileSize, job->mtime);
+  }
+  else
+  {
+     if(pixbuf)
+     {
+        g_object_set_data(G_OBJECT(pixbuf), ICON_DATA_WIDTH, GINT_TO_POINTER(job->decoder->m_GetWidth()));
+        g_object_set_data(G_OBJECT(pixbuf), ICON_DATA_HEIGHT, GINT_TO_POINTER(job->decoder->m_GetHeight()));
+     }
+
+     if(!pixbuf)
+       m_pCatalog->m_AddBadFile(job->decoder->m_GetFullName(), job->mtime, job->fileSize);
+
+     if(job->nRow < 0)
+       m_AppendRow(job->decoder->m_GetFullName(), pixbuf, 0, job->fileSize, job->mtime);
+     else
+     {
+        if(!pixbuf)
+          m_LoadProgress.nFailed++;
+
+        m_SetRowThumbnail(job->nRow, pixbuf, 0, job->fileSize, job->mtime);
+     }
+  }
+
+  if(pixbuf)
+    g_object_unref(pixbuf);
+
+  delete job->decoder;
+  g_free(job);
+}
+
+/*! \fn void CIconChooser::m_FreeStreamJobs(void)
+    \brief To drop the large files not decoded yet.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconChooser::m_FreeStreamJobs(void)
+{
+  ICONCHOOSER_STREAM_JOB *job = NULL;
+
+  if(!m_pStreamJobs)
+    return;
+
+  while( (job = (ICONCHOOSER_STREAM_JOB*)g_queue_pop_head(m_pStreamJobs)) != NULL )
+  {
+     /* The row waits again, it is decoded when it is scrolled near. */
+     if( (job->nRow >= 0) && m_pScheduler )
+       m_pScheduler->m_Requeue(job->nRow);
+
+     delete job->decoder;
+     g_free(job);
+  }
+}
+
+/*! \fn gboolean CIconChooser::m_SandboxIcon(ICON_FILE_BUFFER *pBuffer, guint64 contentHash, gint nRow)
+    \brief To send an icon file of the batch to the sandboxed workers without waiting for it, when loading in time
+           slices. The contents read go along, a file too large to be read or an archive member is read by the worker.
+
+    \param[in] pBuffer. The icon file, its contents are released and its full name is moved into the job if it is sent.
+    \param[in] contentHash. The content hash of the file, 0 if it is unknown.
+    \param[in] nRow. The row waiting for the thumbnail, -1 to append a row for it.
+    \return TRUE if the file was sent, FALSE to decode it here.
+*/
+gboolean CIconChooser::m_SandboxIcon(ICON_FILE_BUFFER *pBuffer, guint64 contentHash, gint nRow)
+{
+  ICONCHOOSER_SANDBOX_JOB *job = NULL;
+  CIconDecoderPool *pPool = NULL;
+  GdkPixbuf *pixbuf = NULL;
+
+  /* The blocking loading has no main loop to read the replies by. */
+  if( !m_bIdleLoad || (pBuffer->error != 0) )
+    return false;
+
+  if( (pPool = m_pCatalog->m_GetDecoderPool()) == NULL )
+    return false;
+
+  /* The thumbnail of the same contents may be known already. */
+  if( contentHash && ((pixbuf = m_pCatalog->m_LookupThumbnail(contentHash, m_GetThumbnailSize())) != NULL) )
+  {
+     g_object_unref(pixbuf);
+     pPool->m_Unref();
+     return false;
+  }
+
+  job = g_new0(ICONCHOOSER_SANDBOX_JOB, 1);
+  job->pChooser = this;
+  job->pPool = pPool;
+  job->contentHash = contentHash;
+  job->fileSize = pBuffer->fileSize;
+  job->mtime = pBuffer->mtime;
+  job->nRow = nRow;
+  job->pJob = pPool->m_DecodeAsync(pBuffer->fullName, pBuffer->data, pBuffer->length, m_GetThumbnailSize(),
+                                   cb_sandbox_done, job);
+
+  if(job->pJob == NULL)
+  {
+     pPool->m_Unref();
+     g_free(job);
+     return false;
+  }
+
+  g_queue_push_tail(m_pSandboxJobs, job);
+
+  CIconFileReader::m_FreeBuffer(pBuffer);
+  job->fullName = pBuffer->fullName;
+  pBuffer->fullName = NULL;
+
+  return true;
+}
+
+/*! \fn void CIconChooser::cb_sandbox_done(GdkPixbuf *pixbuf, gint nStatus, gpointer data)
+    \brief The callback function of the sandboxed workers, called on the main loop when a thumbnail comes back.
+
+    \param[in] pixbuf. The thumbnail, NULL if it could not be decoded. It is unreferenced here.
+    \param[in] nStatus. The ICON_DECODER_STATUS.
+    \param[in] data. The ICONCHOOSER_SANDBOX_JOB.
+    \return NONE
+*/
+void CIconChooser::cb_sandbox_done(GdkPixbuf *pixbuf, gint nStatus, gpointer data)
+{
+  ICONCHOOSER_SANDBOX_JOB *job = (ICONCHOOSER_SANDBOX_JOB*)data;
+
+  job->pChooser->m_FinishSandboxJob(job, pixbuf, nStatus);
+}
+
+/*! \fn void CIconChooser::m_FinishSandboxJob(ICONCHOOSER_SANDBOX_JOB *job, GdkPixbuf *pixbuf, gint nStatus)
+    \brief To put the thumbnail of a sandboxed worker into its row, and resume the loading waiting for it.
+
+    \param[in] job. The job, it is freed.
+    \param[in] pixbuf. The thumbnail, NULL if it could not be decoded. It is unreferenced here.
+    \param[in] nStatus. The ICON_DECODER_STATUS.
+    \return NONE
+*/
+void CIconChooser::m_FinishSandboxJob(ICONCHOOSER_SANDBOX_JOB *job, GdkPixbuf *pixbuf, gint nStatus)
+{
+  g_queue_remove(m_pSandboxJobs, job);
+
+  /* No worker could be started, the file is decoded here as without the sandbox. */
+  if(nStatus == ICON_DECODER_Unavailable)
+  {
+     pixbuf = m_pCatalog->m_Thumbnail(job->fullName, m_GetThumbnailSize(), NULL);
+     nStatus = pixbuf ? ICON_DECODER_Done : ICON_DECODER_Failed;
+  }
+  else if(pixbuf)
+    m_pCatalog->m_InsertThumbnail(job->contentHash, m_GetThumbnailSize(), pixbuf);
+  else if(nStatus == ICON_DECODER_Failed)
+    m_pCatalog->m_AddBadFile(job->fullName, job->mtime, job->fileSize);
+
+  if(job->nRow < 0)
+    m_AppendRow(job->fullName, pixbuf, job->contentHash, job->fileSize, job->mtime);
+  else
+  {
+     if(!pixbuf)
+       m_LoadProgress.nFailed++;
+
+     m_SetRowThumbnail(job->nRow, pixbuf, job->contentHash, job->fileSize, job->mtime);
+  }
+
+  if(pixbuf)
+    g_object_unref(pixbuf);
+
+  job->pPool->m_Unref();
+  g_free(job->fullName);
+  g_free(job);
+
+  /* The loading step which waited for the workers goes on. */
+  if(m_bWaitingWorkers)
+  {
+     m_bWaitingWorkers = false;
+
+     if(m_bLoadSuspended)
+     {
+        m_bLoadSuspended = false;
+        m_nLoadSource = g_idle_add( (GSourceFunc)cb_idle_load_icons, this );
+     }
+     else
+       m_WakePendingRows();
+  }
+}
+
+/*! \fn void CIconChooser::m_FreeSandboxJobs(void)
+    \brief To drop the files the sandboxed workers are decoding, their thumbnails are not waited for.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconChooser::m_FreeSandboxJobs(void)
+{
+  ICONCHOOSER_SANDBOX_JOB *job = NULL;
+
+  if(!m_pSandboxJobs)
+    return;
+
+  while( (job = (ICONCHOOSER_SANDBOX_JOB*)g_queue_pop_head(m_pSandboxJobs)) != NULL )
+  {
+     /* The row waits again, it is decoded when it is scrolled near. */
+     if( (job->nRow >= 0) && m_pScheduler )
+       m_pScheduler->m_Requeue(job->nRow);
+
+     job->pPool->m_Cancel(job->pJob);
+     job->pPool->m_Unref();
+     g_free(job->fullName);
+     g_free(job);
+  }
+}
+
+/*! \fn gboolean CIconChooser::m_SuspendLoad(void)
+    \brief To remove the loading's idle source while the last step waits for the sandboxed workers.
+    \n The idle callback returns FALSE then, the first thumbnail coming back adds the source again.
+
+    \param[in] NONE
+    \return TRUE if the source is to be removed.
+*/
+gboolean CIconChooser::m_SuspendLoad(void)
+{
+  if(!m_bWaitingWorkers)
+    return false;
+
+  m_nLoadSource = 0;
+  m_bLoadSuspended = true;
+
+  return true;
+}
+
+/*! \fn void CIconChooser::m_AddDuplicate(GtkTreeIter *pIter)
+    \brief To count one more hidden copy of the icon in a row, the number is shown after its name.
+
+    \param[in] pIter. The row showing the icon.
+    \return NONE
+*/
+void CIconChooser::m_AddDuplicate(GtkTreeIter *pIter)
+{
+  CIconScopedString fullName(NULL);
+  gint nDuplicates = 0;
+
+  gtk_tree_model_get(GTK_TREE_MODEL(m_ListStore), pIter,
+                     COLUMN_ICONPATH, fullName.m_Out(),
+                     COLUMN_DUPLICATES, &nDuplicates,
+                     -1);
+
+  nDuplicates++;
+
+  CIconScopedString baseName(g_path_get_basename(fullName));
+  CIconScopedString text(g_strdup_printf("%s (+%d)", baseName.m_Get(), nDuplicates));
+
+  gtk_list_store_set(m_ListStore, pIter,
+                     COLUMN_ICONNAME, text.m_Get(),
+                     COLUMN_DUPLICATES, nDuplicates,
+                     -1);
+}
+
+/*! \fn void CIconChooser::m_ReorderRows(gint *newOrder)
+    \brief To reorder the rows of the list-store, and the row-ordered arrays beside it.
+
+    \param[in] newOrder. newOrder[newPosition] is the old position of a row, as gtk_list_store_reorder() takes it.
+    \return NONE
+*/
+void CIconChooser::m_ReorderRows(gint *newOrder)
+{
+  guint64 *oldHashes = NULL;
+  guint nRows = m_pPerceptualHashes->len;
+
+  gtk_list_store_reorder(m_ListStore, newOrder);
+  m_pBudget->m_Reorder(newOrder, nRows);
+  m_pScheduler->m_Reorder(newOrder, nRows);
+
+  /* The rows being read or streamed are known by their positions as well. */
+  if( m_bPrioritizedRun && nRows )
+  {
+     gint *newPositions = g_new(gint, nRows);
+
+     for(guint i=0; i<nRows; i++)
+       newPositions[ newOrder[i] ] = i;
+
+     for(gint i=m_nLoadNext; i<m_nLoadBuffers; i++)
+     {
+        if( (m_LoadRows[i] >= 0) && ((guint)m_LoadRows[i] < nRows) )
+          m_LoadRows[i] = newPositions[ m_LoadRows[i] ];
+     }
+
+     for(GList *node=m_pStreamJobs->head; node; node=node->next)
+     {
+        ICONCHOOSER_STREAM_JOB *job = (ICONCHOOSER_STREAM_JOB*)node->data;
+
+        if( (job->nRow >= 0) && ((guint)job->nRow < nRows) )
+          job->nRow = newPositions[ job->nRow ];
+     }
+
+     for(GList *node=m_pSandboxJobs->head; node; node=node->next)
+     {
+        ICONCHOOSER_SANDBOX_JOB *job = (ICONCHOOSER_SANDBOX_JOB*)node->data;
+
+        if( (job->nRow >= 0) && ((guint)job->nRow < nRows) )
+          job->nRow = newPositions[ job->nRow ];
+     }
+
+     g_free(newPositions);
+  }
+
+  oldHashes = (guint64*)g_memdup2(m_pPerceptualHashes->data, nRows * sizeof(guint64));
+
+  for(guint i=0; i<nRows; i++)
+    g_array_index(m_pPerceptualHashes, guint64, i) = oldHashes[ newOrder[i] ];
+
+  g_free(oldHashes);
+
+  if(m_pRowKeys->len == nRows)
+  {
+     ICONCHOOSER_ROW_KEYS *oldKeys = (ICONCHOOSER_ROW_KEYS*)g_memdup2(m_pRowKeys->data, nRows * sizeof(ICONCHOOSER_ROW_KEYS));
+
+     for(guint i=0; i<nRows; i++)
+       g_array_index(m_pRowKeys, ICONCHOOSER_ROW_KEYS, i) = oldKeys[ newOrder[i] ];
+
+     g_free(oldKeys);
+  }
+}
+
+/*! \fn void CIconChooser::m_AppendRowKeys(const gchar *fullName, guint64 fileSize, gint64 mtime, GdkPixbuf *pixbuf)
+    \brief To compute the sort keys of the row just appended.
+
+    \param[in] fullName. The icon file name including path.
+    \param[in] fileSize. The size of the icon file.
+    \param[in] mtime. The modification time of the icon file.
+    \param[in] pixbuf. The thumbnail carrying the original dimensions, or NULL.
+    \return NONE
+*/
+void CIconChooser::m_AppendRowKeys(const gchar *fullName, guint64 fileSize, gint64 mtime, GdkPixbuf *pixbuf)
+{
+  ICONCHOOSER_ROW_KEYS keys;
+  gchar *baseName = g_path_get_basename(fullName);
+  gchar *dirName = g_path_get_dirname(fullName);
+  const gchar *ext = strrchr(baseName, '.');
+
+  keys.nLoadIndex = m_pRowKeys->len;
+  keys.nameKey = g_utf8_collate_key_for_filename(baseName, -1);
+  keys.formatKey = g_ascii_strdown(ext ? ext + 1 : "", -1);
+  keys.dirKey = g_utf8_collate_key_for_filename(dirName, -1);
+  keys.fileSize = fileSize;
+  keys.mtime = mtime;
+  keys.nPixels = 0;
+
+  if(pixbuf)
+    keys.nPixels = (gint64)GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pixbuf), ICON_DATA_WIDTH)) *
+                   GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pixbuf), ICON_DATA_HEIGHT));
+
+  g_array_append_val(m_pRowKeys, keys);
+
+  g_free(baseName);
+  g_free(dirName);
+}
+
+/*! \fn void CIconChooser::m_UpdateRowKeys(gint nRow, guint64 fileSize, gint64 mtime, GdkPixbuf *pixbuf)
+    \brief To set the sort keys known once the row listed before decoding is decoded.
+
+    \param[in] nRow. The position of the row.
+    \param[in] fileSize. The size of the icon file.
+    \param[in] mtime. The modification time of the icon file.
+    \param[in] pixbuf. The thumbnail carrying the original dimensions, or NULL.
+    \return NONE
+*/
+void CIconChooser::m_UpdateRowKeys(gint nRow, guint64 fileSize, gint64 mtime, GdkPixbuf *pixbuf)
+{
+  ICONCHOOSER_ROW_KEYS *keys = NULL;
+
+  if( (nRow < 0) || ((guint)nRow >= m_pRowKeys->len) )
+    return;
+
+  keys = &g_array_index(m_pRowKeys, ICONCHOOSER_ROW_KEYS, nRow);
+  keys->fileSize = fileSize;
+  keys->mtime = mtime;
+
+  if(pixbuf)
+    keys->nPixels = (gint64)GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pixbuf), ICON_DATA_WIDTH)) *
+                    GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pixbuf), ICON_DATA_HEIGHT));
+}
+
+/*! \fn void CIconChooser::m_ClearRowKeys(void)
+    \brief To free the sort keys of all rows.
+
+    \param[in] NONE.
+    \return NONE
+*/
+void CIconChooser::m_ClearRowKeys(void)
+{
+  for(guint i=0; i<m_pRowKeys->len; i++)
+  {
+     ICONCHOOSER_ROW_KEYS *keys = &g_array_index(m_pRowKeys, ICONCHOOSER_ROW_KEYS, i);
+
+     g_free(keys->nameKey);
+     g_free(keys->formatKey);
+     g_free(keys->dirKey);
+  }
+
+  g_array_set_size(m_pRowKeys, 0);
+}
+
+/*! \struct ICONCHOOSER_SORT_CONTEXT
+    \brief The data compare_rows() sorts with.
+*/
+typedef struct _ICONCHOOSER_SORT_CONTEXT
+{
+  const ICONCHOOSER_ROW_KEYS *keys;
+  gint sortMode;
+  gint groupMode;
+} ICONCHOOSER_SORT_CONTEXT;
+
+/* To compare two numbers without overflowing. */
+#define COMPARE_NUMBERS(a, b)  ( ((a) > (b)) - ((a) < (b)) )
+
+/*! \fn static gint compare_rows(gconstpointer a, gconstpointer b, gpointer data)
+    \brief To compare two rows by their precomputed keys, for g_qsort_with_data().
+
+    \param[in] a. The position of one row.
+    \param[in] b. The position of the other row.
+    \param[in] data. The ICONCHOOSER_SORT_CONTEXT.
+    \return Less than, equal to or greater than 0.
+*/
+static gint compare_rows(gconstpointer a, gconstpointer b, gpointer data)
+{
+  const ICONCHOOSER_SORT_CONTEXT *context = (const ICONCHOOSER_SORT_CONTEXT*)data;
+  const ICONCHOOSER_ROW_KEYS *ka = &context->keys[ *(const gint*)a ];
+  const ICONCHOOSER_ROW_KEYS *kb = &context->keys[ *(const gint*)b ];
+  gint result = 0;
+
+  /* The group comes first. */
+  if(context->groupMode == ICONCHOOSER_GROUP_Format)
+    result = strcmp(ka->formatKey, kb->formatKey);
+  else if(context->groupMode == ICONCHOOSER_GROUP_Directory)
+    result = strcmp(ka->dirKey, kb->dirKey);
+
+  if(result)
+    return result;
+
+  switch(context->sortMode)
+  {
+    case ICONCHOOSER_SORT_Name:
+      result = strcmp(ka->nameKey, kb->nameKey);
+      break;
+
+    case ICONCHOOSER_SORT_Size:
+      result = COMPARE_NUMBERS(ka->fileSize, kb->fileSize);
+      break;
+
+    case ICONCHOOSER_SORT_Mtime:
+      result = COMPARE_NUMBERS(kb->mtime, ka->mtime);   /* The newest first. */
+      break;
+
+    case ICONCHOOSER_SORT_Format:
+      result = strcmp(ka->formatKey, kb->formatKey);
+      break;
+
+    case ICONCHOOSER_SORT_Dimensions:
+      result = COMPARE_NUMBERS(ka->nPixels, kb->nPixels);
+      break;
+
+    default:
+      break;
+  }
+
+  /* The ties keep the order the directory was read in. */
+  if(result == 0)
+    result = COMPARE_NUMBERS(ka->nLoadIndex, kb->nLoadIndex);
+
+  return result;
+}
+
+/*! \fn void CIconChooser::m_SetSortMode(gint sortMode, gint groupMode)
+    \brief To set the order and the grouping of the icons, and to reorder the loaded ones.
+
+    \param[in] sortMode. One of ICONCHOOSER_SORT_MODE.
+    \param[in] groupMode. One of ICONCHOOSER_GROUP_MODE.
+    \return NONE
+*/
+void CIconChooser::m_SetSortMode(gint sortMode, gint groupMode)
+{
+  if( (sortMode >= 0) && (sortMode < N_ICONCHOOSER_SORT_MODE) )
+    m_nSortMode = sortMode;
+
+  if( (groupMode >= 0) && (groupMode < N_ICONCHOOSER_GROUP_MODE) )
+    m_nGroupMode = groupMode;
+
+  m_SortRows();
+}
+
+/*! \fn gboolean CIconChooser::m_SortRows(void)
+    \brief To reorder the rows by the current sort mode and group mode.
+    \n Only an array of row positions is sorted by the keys computed at loading, the list-store is reordered in place.
+
+    \param[in] NONE.
+    \return FALSE if the rows could not be sorted.
+*/
+gboolean CIconChooser::m_SortRows(void)
+{
+  ICONCHOOSER_SORT_CONTEXT context;
+  guint nRows = m_pRowKeys->len;
+  gint *newOrder = NULL;
+
+  if( !m_ListStore || (nRows == 0) ||
+      (gtk_tree_model_iter_n_children(GTK_TREE_MODEL(m_ListStore), NULL) != (gint)nRows) )
+    return false;
+
+  context.keys = (const ICONCHOOSER_ROW_KEYS*)m_pRowKeys->data;
+  context.sortMode = m_nSortMode;
+  context.groupMode = m_nGroupMode;
+
+  newOrder = g_new(gint, nRows);
+  for(guint i=0; i<nRows; i++)
+    newOrder[i] = (gint)i;
+
+  g_qsort_with_data(newOrder, nRows, sizeof(gint), compare_rows, &context);
+
+  m_ReorderRows(newOrder);
+  g_free(newOrder);
+
+  return true;
+}
+
+/*! \fn gboolean CIconChooser::m_FindSimilar(void)
+    \brief To move the icons looking like the selected one to the top of the icon view, the most similar first.
+
+    \param[in] NONE.
+    \return FALSE if no icon is selected.
+*/
+gboolean CIconChooser::m_FindSimilar(void)
+{
+  GtkIconView *iconView = (GtkIconView*)m_pWidgets[ICONCHOOSER_GtkIconView];
+  GtkTreePath *path = NULL;
+  gint *newOrder = NULL;
+  gint nRow = -1;
+  guint nRows = m_pPerceptualHashes->len;
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  gint64 nStart = g_get_monotonic_time();
+  #endif
+
+  if(!iconView)
+    return false;
+
+  {
+     CIconScopedList<GList> selected(gtk_icon_view_get_selected_items(iconView), (GDestroyNotify)gtk_tree_path_free);
+
+     if( selected.m_GetFirst() )
+       nRow = gtk_tree_path_get_indices((GtkTreePath*)selected.m_GetFirst())[0];
+  }
+
+  /* Every row has its hash, unless the list-store was changed behind the chooser. */
+  if( (nRow < 0) || ((guint)nRow >= nRows) ||
+      (gtk_tree_model_iter_n_children(GTK_TREE_MODEL(m_ListStore), NULL) != (gint)nRows) )
+    return false;
+
+  newOrder = g_new(gint, nRows);
+  CIconPerceptualHash::m_Rank((guint64*)m_pPerceptualHashes->data, nRows,
+                              g_array_index(m_pPerceptualHashes, guint64, nRow), newOrder);
+
+  m_ReorderRows(newOrder);
+  g_free(newOrder);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - Ranked %u icons in %.3f ms \n", __FUNCTION__, __LINE__, nRows,
+         (g_get_monotonic_time() - nStart) / 1000.0);
+  #endif
+
+  /* The selected icon itself is the nearest, so it comes first. */
+  path = gtk_tree_path_new_first();
+  gtk_icon_view_scroll_to_path(iconView, path, true, 0, 0);
+  gtk_tree_path_free(path);
+
+  return true;
+}
+
+/*! \fn gboolean CIconChooser::m_LoadIconList(void)
+    \brief To load a icons' content and append contents to the list-store.
+    \n If m_bIdleLoad is set, this only starts the loading, which goes on in time slices on the main loop.
+
+    \param[in] NONE.
+    \return TRUE or FALSE
+*/
+gboolean CIconChooser::m_LoadIconList(void)
+{
+  CIconScopedError errOpen;
+
+  /* Only one loading could be in progress. */
+  m_StopIconList();
+
+  if(m_LoadedLocation)
+    g_free(m_LoadedLocation);
+
+  m_LoadedLocation = m_IconBrowseLocation ? g_strdup(m_IconBrowseLocation) : NULL;
+
+  memset(&m_LoadProgress, 0x00, sizeof(m_LoadProgress));
+  m_LoadProgress.fEta = -1;
+  m_nLoadStartTime = g_get_monotonic_time();
+
+  /* The rows of the previous loading are gone. */
+  g_hash_table_remove_all(m_pShownHashes);
+  g_array_set_size(m_pPerceptualHashes, 0);
+  m_ClearRowKeys();
+
+  /* The rows are listed first and decoded by what is shown, unless a duplicate must be decoded before its row is
+     known to be hidden, or the loading blocks anyway. */
+  m_bPrioritizedRun = m_bPrioritize && m_bIdleLoad && !m_bHideDuplicates && (m_pWidgets[ICONCHOOSER_GtkIconView] != NULL);
+  m_nFarPriority = ICON_DECODE_Rest;
+  m_bArchiveRun = false;
+
+  if( m_bPrioritizedRun &&
+      (!m_pPendingIcon || (gdk_pixbuf_get_width(m_pPendingIcon) != m_GetThumbnailSize())) )
+  {
+     if(m_pPendingIcon)
+       g_object_unref(m_pPendingIcon);
+
+     m_pPendingIcon = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, m_GetThumbnailSize(), m_GetThumbnailSize());
+     gdk_pixbuf_fill(m_pPendingIcon, 0x00000000);
+  }
+
+  /* To check if it had been assigned a directory name. */
+  if( m_IconBrowseLocation == NULL )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf ("\n\n %s(%d) Error! The icons browsing location path is NULL! \n\n", __FUNCTION__, __LINE__);
+     #endif
+
+     return false;
+  }
+
+  if( strcmp(m_IconBrowseLocation, ICON_LOCATION_UNION) == 0 )
+  {
+     ICONPROF_MARK(nScanStart);
+
+     /* The union view lists all search roots before decoding, the roots are read in parallel. */
+     m_pLoadQueue = m_pCatalog->m_Scan(ICON_LOCATION_UNION, m_nScale, &m_LoadProgress.nShadowed);
+     m_nLoadQueueNext = 0;
+     m_icon_total = m_pLoadQueue->len;
+
+     ICONPROF_RECORD(Enumerate, nScanStart);
+  }
+  else if( g_str_has_prefix(m_IconBrowseLocation, ICON_LOCATION_THEME) )
+  {
+     /* "theme:<theme name>/<context>", the current theme if the name is empty. The catalog keeps the tables of
+        every theme loaded, so browsing another theme does not drop those of the current theme. */
+     CIconScoped<gchar*> parts(g_strsplit(m_IconBrowseLocation + strlen(ICON_LOCATION_THEME), "/", 2), (GDestroyNotify)g_strfreev);
+     CIconScopedString currentName(m_GetCurrentThemeName());
+     const gchar *themeName = (parts[0] && strlen(parts[0])) ? parts[0] : currentName.m_Get();
+     CIconScopedString location(g_strdup_printf("%s%s/%s", ICON_LOCATION_THEME, themeName, (parts[0] && parts[1]) ? parts[1] : ""));
+     gboolean bLoaded = false;
+     ICONPROF_MARK(nScanStart);
+
+     m_pLoadQueue = m_pCatalog->m_Scan(location, m_nScale, NULL);
+     bLoaded = (m_pLoadQueue != NULL);
+     if(bLoaded)
+     {
+        m_nLoadQueueNext = 0;
+        m_icon_total = m_pLoadQueue->len;
+     }
+
+     ICONPROF_RECORD(Enumerate, nScanStart);
+
+     if(!bLoaded)
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        printf ("\n\n %s(%d) Error! The icon theme of %s is not found! \n\n", __FUNCTION__, __LINE__, m_IconBrowseLocation);
+        #endif
+
+        return false;
+     }
+  }
+  else if( CIconArchive::m_IsArchive(m_IconBrowseLocation) &&
+           (g_file_test(m_IconBrowseLocation, (GFileTest) G_FILE_TEST_IS_DIR) == false) )
+  {
+     ICONPROF_MARK(nScanStart);
+
+     /* The catalog reads the directory of the archive once, the members are streamed out of it by their names. */
+     m_pLoadQueue = m_pCatalog->m_Scan(m_IconBrowseLocation, m_nScale, NULL);
+     m_bArchiveRun = (m_pLoadQueue != NULL);
+
+     ICONPROF_RECORD(Enumerate, nScanStart);
+
+     if(!m_bArchiveRun)
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        printf ("\n\n %s(%d) Error! The archive %s could not be read! \n\n", __FUNCTION__, __LINE__, m_IconBrowseLocation);
+        #endif
+
+        return false;
+     }
+
+     m_nLoadQueueNext = 0;
+     m_icon_total = m_pLoadQueue->len;
+  }
+  else
+  {
+     /* To set the if the the current file name is a directory. */
+     if( g_file_test(m_IconBrowseLocation,(GFileTest) G_FILE_TEST_IS_DIR) == false )
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        printf ("\n\n %s(%d) Error! The icons browsing location path is not a directory! \n\n", __FUNCTION__, __LINE__);
+        #endif
+
+        return false;
+     }
+
+     /* To open the icon browsing directory. */
+     m_pLoadDir = g_dir_open(m_IconBrowseLocation, 0, errOpen.m_Out());
+     if(m_pLoadDir == NULL)
+     {
+        #ifdef DEBUG_MENU_ICONCHOOSER
+        if(errOpen)
+          printf ("\n\n %s(%d) Error! %s! \n\n", __FUNCTION__, __LINE__, errOpen->message);
+        #endif
+
+        return false;
+     }
+  }		
+
+#ifdef USE_INDEX_DAEMON
+  /* A running index daemon already has the thumbnails of this directory, though only at scale 1.
+     They are appended in the same time slices as the decoded ones. */
+  if( m_pLoadDir && (m_nScale == 1) && m_LoadIconListFromDaemon() )
+  {
+     g_dir_close(m_pLoadDir);
+     m_pLoadDir = NULL;
+  }
+#endif
+
+  if(m_bIdleLoad)
+  {
+     /* The idle priority is lower than input and redrawing, so the dialog keeps responsive. */
+     m_nLoadSource = g_idle_add( (GSourceFunc)cb_idle_load_icons, this );
+     return true;
+  }
+
+  /* To load all icons at once, the embedding application still gets the progress of every batch. */
+  while( m_LoadIconListStep(0) )
+    m_ReportProgress();
+
+  m_FinishIconList();
+
+  return true;
+}
+
+#ifdef USE_INDEX_DAEMON
+/*! \fn gboolean CIconChooser::m_LoadIconListFromDaemon(void)
+    \brief To get the thumbnails kept by the index daemon, they are appended by m_LoadIconListStep().
+
+    \param[in] NONE.
+    \return FALSE if there is no daemon running or it has not indexed the directory, the icons must be loaded by the dialog then.
+*/
+gboolean CIconChooser::m_LoadIconListFromDaemon(void)
+{
+  gint nTotal = 0;
+
+  m_pDaemonEntries = CIconIndexDaemon::m_QueryDirectory(m_IconBrowseLocation, &nTotal);
+  if(!m_pDaemonEntries)
+    return false;
+
+  m_nDaemonNext = 0;
+  m_icon_total = nTotal;
+  m_LoadProgress.nFailed = nTotal - m_pDaemonEntries->len;
+
+  /* Every row has its thumbnail already, there is nothing to list ahead of decoding. */
+  m_bPrioritizedRun = false;
+
+  return true;
+}
+
+/*! \fn void CIconChooser::m_AppendDaemonEntries(gint nMax)
+    \brief To append the rows of the next entries of the index daemon, hiding the duplicates like the decoded icons.
+
+    \param[in] nMax. The number of entries to append at most.
+    \return NONE.
+*/
+void CIconChooser::m_AppendDaemonEntries(gint nMax)
+{
+  while( (nMax-- > 0) && (m_nDaemonNext < m_pDaemonEntries->len) )
+  {
+     ICON_INDEX_ENTRY *entry = (ICON_INDEX_ENTRY*)g_ptr_array_index(m_pDaemonEntries, m_nDaemonNext);
+     GtkTreeIter *pShownIter = NULL;
+     CIconScopedString fullName(g_strdup_printf("%s%s", m_IconBrowseLocation, entry->baseName));
+
+     g_ptr_array_index(m_pDaemonEntries, m_nDaemonNext++) = NULL;
+
+     if( m_bHideDuplicates && entry->contentHash &&
+         (pShownIter = (GtkTreeIter*)g_hash_table_lookup(m_pShownHashes, &entry->contentHash)) != NULL )
+     {
+        m_AddDuplicate(pShownIter);
+        m_LoadProgress.nDuplicates++;
+     }
+     else
+       m_AppendRow(fullName, entry->pixbuf, entry->contentHash, entry->fileSize, entry->mtime);
+
+     CIconIndexDaemon::m_FreeEntry(entry);
+  }
+
+  if(m_nDaemonNext >= m_pDaemonEntries->len)
+    m_FreeDaemonEntries();
+}
+
+/*! \fn void CIconChooser::m_FreeDaemonEntries(void)
+    \brief To release the entries of the index daemon not appended yet.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_FreeDaemonEntries(void)
+{
+  if(!m_pDaemonEntries)
+    return;
+
+  for(guint i=m_nDaemonNext; i<m_pDaemonEntries->len; i++)
+    CIconIndexDaemon::m_FreeEntry(g_ptr_array_index(m_pDaemonEntries, i));
+
+  g_ptr_array_free(m_pDaemonEntries, TRUE);
+  m_pDaemonEntries = NULL;
+  m_nDaemonNext = 0;
+}
+#endif
+
+/*! \fn gboolean CIconChooser::m_LoadIconListStep(gint64 nDeadline)
+    \brief To scan the icon browsing directory and decode icons until the deadline.
+
+    \param[in] nDeadline. The monotonic time(in microsecond) to stop at, 0 means no limit.
+    \return TRUE if there are icons left to load, FALSE when the loading finished.
+*/
+gboolean CIconChooser::m_LoadIconListStep(gint64 nDeadline)
+{
+  const gchar *baseName = NULL;   /* To store the icon file's basename, e.g. filename.extension. */
+  gint nListed = 0;
+
+  m_bWaitingWorkers = false;
+
+  do
+  {
+     ICONPROF_MARK(nStageStart);
+
+     /* The files sent to the sandboxed workers are bounded, the loading waits for their thumbnails beyond. */
+     if( g_queue_get_length(m_pSandboxJobs) >= ICONCHOOSER_MAX_SANDBOX_JOBS )
+     {
+        m_bWaitingWorkers = true;
+        return true;
+     }
+
+     /* A chunk of the first large file goes between the icons, so the large files never hold the others up. */
+     if( !g_queue_is_empty(m_pStreamJobs) )
+       m_StepStreamJob();
+
+     /* Decode one icon of the current batch. */
+     if(m_nLoadNext < m_nLoadBuffers)
+     {
+        if(m_bPrioritizedRun)
+        {
+           m_FillPendingRow(&m_LoadBuffers[m_nLoadNext], m_LoadRows[m_nLoadNext]);
+           m_nLoadNext++;
+        }
+        else
+          m_AppendIcon(&m_LoadBuffers[m_nLoadNext++]);
+
+        continue;
+     }
+
+     /* The batch is done, to fill the next one. */
+     m_nLoadBuffers = 0;
+     m_nLoadNext = 0;
+     nListed = 0;
+
+#ifdef USE_INDEX_DAEMON
+     /* The thumbnails of the index daemon are appended a batch at a time, so the loading could be cancelled. */
+     if(m_pDaemonEntries)
+     {
+        m_AppendDaemonEntries(ICON_READ_BATCH);
+        continue;
+     }
+#endif
+
+     /* The rows the user looks at, or is scrolling to, are decoded before more rows are listed. */
+     if( !m_bPrioritizedRun || !m_TakePendingRows(ICON_DECODE_Prefetch) )
+     {
+        if(m_pLoadQueue)
+        {
+           /* The union view and the theme browser had listed all their icons beforehand, the names are moved into the batch. */
+           while( (nListed < ICON_READ_BATCH) && (m_nLoadQueueNext < m_pLoadQueue->len) )
+           {
+              nListed++;
+              m_QueueLoadFile((gchar*)g_ptr_array_index(m_pLoadQueue, m_nLoadQueueNext));
+              g_ptr_array_index(m_pLoadQueue, m_nLoadQueueNext++) = NULL;
+           }
+
+           if(m_nLoadQueueNext >= m_pLoadQueue->len)
+           {
+              g_ptr_array_free(m_pLoadQueue, TRUE);
+              m_pLoadQueue = NULL;
+           }
+        }
+        else if(m_pLoadDir)
+        {
+           /* To retrieve the file name of icons in the chosen directory irrecusively. */
+           while( (nListed < ICON_READ_BATCH) && ((baseName = g_dir_read_name(m_pLoadDir)) != NULL) )
+           {
+              /* To check if the the currently read icon file name is valid. */
+              if( m_IsPhotoFile((gchar *)baseName) == FALSE )
+                continue;
+
+              /* Increae the counter for read icon with valid file name. */
+              m_icon_total++;
+              nListed++;
+
+              m_QueueLoadFile(g_strdup_printf("%s%s", m_IconBrowseLocation, baseName));
+           }
+
+           ICONPROF_RECORD(Enumerate, nStageStart);
+
+           /* The whole directory had been scanned. */
+           if(baseName == NULL)
+           {
+              g_dir_close(m_pLoadDir);
+              m_pLoadDir = NULL;
+           }
+        }
+        else if(m_bPrioritizedRun)
+        {
+           /* All rows are listed, the far ones are decoded while their thumbnails fit in the memory budget.
+              Beyond it they would only be evicted again, they are left for the scrolling to bring near. */
+           if( !m_pBudget->m_IsNearFull() )
+             m_TakePendingRows(m_nFarPriority);
+        }
+     }
+
+     /* The whole batch was known to fail, or only the large files are left, which are fed until they are done. */
+     if(m_nLoadBuffers == 0)
+     {
+        if( !m_pLoadQueue && !m_pLoadDir && g_queue_is_empty(m_pStreamJobs) )
+        {
+           if( g_queue_is_empty(m_pSandboxJobs) )
+             return false;
+
+           /* Only the thumbnails of the sandboxed workers are left. */
+           m_bWaitingWorkers = true;
+           return true;
+        }
+
+        continue;
+     }
+
+     /* To read all files of the batch at once, so the decoder does not wait for the disk file by file.
+        The members of an archive are streamed out of it when they are decoded. */
+     if(!m_bArchiveRun)
+     {
+        ICONPROF_SCOPE(Read);
+        m_ReadLoadBatch();
+     }
+  } while( (nDeadline == 0) || (g_get_monotonic_time() < nDeadline) );
+
+  return true;
+}
+
+/*! \fn gboolean CIconChooser::m_TakePendingRows(gint nMaxPriority)
+    \brief To fill the batch with the rows listed before decoding, in the order of the decode scheduler.
+
+    \param[in] nMaxPriority. The lowest ICON_DECODE_PRIORITY to take.
+    \return TRUE if the batch has rows to read.
+*/
+gboolean CIconChooser::m_TakePendingRows(gint nMaxPriority)
+{
+  gint nRow = -1;
+
+  m_pScheduler->m_Plan();
+
+  while( (m_nLoadBuffers < ICON_READ_BATCH) && m_pScheduler->m_Next(nMaxPriority, &nRow, NULL) )
+  {
+     GtkTreeIter iter;
+     gchar *fullName = NULL;
+
+     if( gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(m_ListStore), &iter, NULL, nRow) )
+       gtk_tree_model_get(GTK_TREE_MODEL(m_ListStore), &iter, COLUMN_ICONPATH, &fullName, -1);
+
+     if(fullName == NULL)
+     {
+        m_pScheduler->m_Done(nRow);
+        continue;
+     }
+
+     m_LoadRows[m_nLoadBuffers] = nRow;
+     m_LoadBuffers[m_nLoadBuffers].knownHash = 0;
+     m_LoadBuffers[m_nLoadBuffers++].fullName = fullName;
+  }
+
+  return (m_nLoadBuffers > 0);
+}
+
+/*! \fn void CIconChooser::m_WakePendingRows(void)
+    \brief To decode the rows left pending which the user scrolled near, after the loading finished or was cancelled.
+    \n While the loading runs, it takes those rows first by itself.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_WakePendingRows(void)
+{
+  if( !m_bPrioritizedRun || m_nLoadSource || m_nPendingSource || (m_pScheduler->m_GetPendingCount() == 0) )
+    return;
+
+  m_nPendingSource = g_idle_add( (GSourceFunc)cb_idle_decode_pending, this );
+}
+
+/*! \fn gboolean CIconChooser::m_DecodePendingStep(gint64 nDeadline)
+    \brief To decode the pending rows near the visible ones until the deadline. The far rows are left pending.
+
+    \param[in] nDeadline. The monotonic time(in microsecond) to stop at, 0 means no limit.
+    \return TRUE if there are rows near the visible ones left to decode.
+*/
+gboolean CIconChooser::m_DecodePendingStep(gint64 nDeadline)
+{
+  /* Nothing is left to list, so the step only decodes the rows the scheduler gives. The rows are not sorted again,
+     they would move under the user's pointer. */
+  if( m_LoadIconListStep(nDeadline) && !m_bWaitingWorkers )
+  {
+     m_UpdateIconTotal();
+     return true;
+  }
+
+  /* The idle source is removed by returning FALSE from its callback. While it waits for the sandboxed workers,
+     their thumbnails wake the pending rows again. */
+  m_nPendingSource = 0;
+
+  m_UpdateIconTotal();
+  m_ReportProgress();
+
+  return false;
+}
+
+/*! \fn void CIconChooser::m_FinishIconList(void)
+    \brief To end the loading and show the final number of icons.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_FinishIconList(void)
+{
+  /* The idle source is removed by returning FALSE from its callback. */
+  m_nLoadSource = 0;
+
+  m_StopIconList();
+
+  m_LoadProgress.bFinished = true;
+  ICONPROF_RECORD(LoadIconList, m_nLoadStartTime);
+
+  /* The thumbnails of the previous directory are kept if they are shown in this one, the others only as far as the
+     idle list of the content cache holds them. */
+  m_pCatalog->m_PruneThumbnails();
+
+  /* The files which failed to decode are not read again at the next loading, nor in the next run. */
+  m_pCatalog->m_SaveNegativeCache();
+
+  /* The rows were appended in the order the directory was read in. */
+  if( (m_nSortMode != ICONCHOOSER_SORT_None) || (m_nGroupMode != ICONCHOOSER_GROUP_None) )
+    m_SortRows();
+
+  m_UpdateIconTotal();
+  m_ReportProgress();
+}
+
+/*! \fn void CIconChooser::m_CancelIconList(void)
+    \brief To cancel the loading in progress. The icons loaded so far are kept.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_CancelIconList(void)
+{
+  if( (m_nLoadSource == 0) && !m_bLoadSuspended && (m_pLoadDir == NULL) )
+    return;
+
+  m_StopIconList();
+
+  m_LoadProgress.bFinished = true;
+  m_LoadProgress.bCancelled = true;
+  ICONPROF_RECORD(LoadIconList, m_nLoadStartTime);
+
+  /* The rows listed but not decoded keep their placeholders, those shown or scrolled to are still decoded. */
+  m_nFarPriority = ICON_DECODE_Prefetch;
+
+  m_UpdateIconTotal();
+  m_ReportProgress();
+
+  m_WakePendingRows();
+}
+
+/*! \fn void CIconChooser::m_ReportProgress(void)
+    \brief To update the loading statistics, show them on the progress bar and notify the embedding application.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_ReportProgress(void)
+{
+  ICONCHOOSER_LOAD_PROGRESS *p = &m_LoadProgress;
+  gint nDone = 0;
+
+  p->nEnumerated = m_icon_total;
+  p->nDecoded = m_icon_visible_total;
+  p->bScanDone = (m_pLoadDir == NULL);
+  p->nDeferred = m_bPrioritizedRun ? (gint)m_pScheduler->m_GetPendingCount() : 0;
+  p->fElapsed = (m_nLoadStartTime > 0) ? (gdouble)(g_get_monotonic_time() - m_nLoadStartTime) / G_USEC_PER_SEC : 0;
+
+  nDone = p->nDecoded + p->nFailed + p->nDuplicates;
+  p->fThroughput = (p->fElapsed > 0) ? nDone / p->fElapsed : 0;
+
+  /* The number of files left is only known after the whole directory had been scanned. */
+  if(p->bFinished)
+    p->fEta = 0;
+  else if( p->bScanDone && (p->fThroughput > 0) )
+    p->fEta = (p->nEnumerated - nDone) / p->fThroughput;
+  else
+    p->fEta = -1;
+
+  if( m_pWidgets[ICONCHOOSER_GtkProgressBar_Load] )
+  {
+     GtkProgressBar *bar = GTK_PROGRESS_BAR(m_pWidgets[ICONCHOOSER_GtkProgressBar_Load]);
+     gchar *text = NULL;
+
+     if(p->bFinished)
+     {
+        gtk_progress_bar_set_fraction(bar, 1.0);
+        if(p->bCancelled)
+          text = g_strdup_printf(_("Cancelled: %d of %d icons, %d failed"), p->nDecoded, p->nEnumerated, p->nFailed);
+        else if(p->nDeferred > 0)
+          text = g_strdup_printf(_("%d icons, %d failed, %d when scrolled to, %.1f s"), p->nDecoded, p->nFailed,
+                                 p->nDeferred, p->fElapsed);
+        else
+          text = g_strdup_printf(_("%d icons, %d failed, %.1f s"), p->nDecoded, p->nFailed, p->fElapsed);
+     }
+     else
+     {
+        if( p->bScanDone && (p->nEnumerated > 0) )
+          gtk_progress_bar_set_fraction(bar, (gdouble)nDone / p->nEnumerated);
+        else
+          gtk_progress_bar_pulse(bar);
+
+        if(p->fEta >= 0)
+          text = g_strdup_printf(_("%d/%d, %.1f MB, %.0f/s, %.0f s left"), nDone, p->nEnumerated,
+                                 p->nBytesRead / (1024.0 * 1024.0), p->fThroughput, p->fEta);
+        else
+          text = g_strdup_printf(_("%d/%d, %.1f MB, %.0f/s"), nDone, p->nEnumerated,
+                                 p->nBytesRead / (1024.0 * 1024.0), p->fThroughput);
+     }
+
+     gtk_progress_bar_set_text(bar, text);
+     g_free(text);
+  }
+
+  if( m_pWidgets[ICONCHOOSER_GtkButton_StopLoad] )
+    gtk_widget_set_sensitive(m_pWidgets[ICONCHOOSER_GtkButton_StopLoad], !p->bFinished);
+
+  if(m_pfnProgress)
+    m_pfnProgress(this, p, m_pProgressData);
+}
+
+/*! \fn void CIconChooser::m_StopIconList(void)
+    \brief To stop the loading in progress and release the unfinished batch.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_StopIconList(void)
+{
+  if(m_nLoadSource)
+    g_source_remove(m_nLoadSource);
+
+  m_nLoadSource = 0;
+
+  if(m_nPendingSource)
+    g_source_remove(m_nPendingSource);
+
+  m_nPendingSource = 0;
+
+  for(gint i=m_nLoadNext; i<m_nLoadBuffers; i++)
+  {
+     /* The rows taken but not decoded wait again. */
+     if(m_bPrioritizedRun && m_pScheduler)
+       m_pScheduler->m_Requeue(m_LoadRows[i]);
+
+     CIconFileReader::m_FreeBuffer(&m_LoadBuffers[i]);
+     g_free(m_LoadBuffers[i].fullName);
+     m_LoadBuffers[i].fullName = NULL;
+  }
+
+  m_nLoadBuffers = 0;
+  m_nLoadNext = 0;
+
+  if(m_pLoadDir)
+    g_dir_close(m_pLoadDir);
+
+  m_pLoadDir = NULL;
+
+  if(m_pLoadQueue)
+  {
+     for(guint i=m_nLoadQueueNext; i<m_pLoadQueue->len; i++)
+       g_free(g_ptr_array_index(m_pLoadQueue, i));
+
+     g_ptr_array_free(m_pLoadQueue, TRUE);
+  }
+
+  m_pLoadQueue = NULL;
+  m_nLoadQueueNext = 0;
+
+#ifdef USE_INDEX_DAEMON
+  m_FreeDaemonEntries();
+#endif
+
+  m_FreeStreamJobs();
+  m_FreeSandboxJobs();
+
+  m_bWaitingWorkers = false;
+  m_bLoadSuspended = false;
+}
+
+/*! \fn void CIconChooser::m_UpdateIconTotal(void)
+    \brief To show the number of icons on the text entries.
+
+    \param[in] NONE.
+    \return NONE.
+*/
+void CIconChooser::m_UpdateIconTotal(void)
+{
+  char totalIcon[12] = {0}, totalIconVisible[12] = {0};
+
+  /* The widgets are not created yet when the icons are loaded before the dialog. */
+  if( !m_pWidgets[ICONCHOOSER_GtkEntry_IconTotal] || !m_pWidgets[ICONCHOOSER_GtkEntry_VisibleIconTotal] )
+    return;
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - Total number of icon = %d \n", __FUNCTION__, __LINE__, m_icon_total);
+  printf("%s(%d) - Total number of Visible icon = %d \n\n", __FUNCTION__, __LINE__, m_icon_visible_total);
+  #endif
+
+  sprintf(totalIcon, "%d", m_icon_total);
+  sprintf(totalIconVisible, "%d", m_icon_visible_total);
+  
+  gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_IconTotal], (gchar*)totalIcon);
+  gtk_entry_set_text((GtkEntry*)m_pWidgets[ICONCHOOSER_GtkEntry_VisibleIconTotal], (gchar*)totalIconVisible);
+}
+
+/*! \fn gboolean CIconChooser::m_ReloadIconList(gchar *iconpath)
+    \brief To reload a icon contents and append contents to the list-store.
+
+    \param[in] iconpath.
+    \return TRUE or FALSE
+*/
+gboolean CIconChooser::m_ReloadIconList(gchar *iconpath)
+{ 
+  /* First, to clear out the list-store's contents. */
+  GtkTreeModel *model = NULL;
+  ICONPROF_SCOPE(ReloadIconList);
+
+  /* The loading of the previous directory must not append to the new list-store. */
+  m_StopIconList();
+
+  m_bIsChosen = false;
+  m_RemoveOldTreeModel(false);
+
+  /* Second, to load icons' content into the list-store. */
+  if(iconpath)
+    m_SetIconBrowseLocation(iconpath);  /* To set the icon browsing path. */
+
+  /* The "All folders" check button follows the location, without reloading again. */
+  if( m_pWidgets[ICONCHOOSER_GtkCheckButton_AllFolders] )
+  {
+     GtkWidget *checkAllFolders = m_pWidgets[ICONCHOOSER_GtkCheckButton_AllFolders];
+
+     g_signal_handlers_block_by_func(checkAllFolders, (gpointer)cb_all_folders_toggled, this);
+     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(checkAllFolders), g_strcmp0(m_IconBrowseLocation, ICON_LOCATION_UNION) == 0);
+     g_signal_handlers_unblock_by_func(checkAllFolders, (gpointer)cb_all_folders_toggled, this);
+  }
+
+  /* To set the tree model to the icon view, the icons loaded in time slices show up as they are appended. */
+  model = m_CreateAndFillModel();
+  gtk_icon_view_set_model(GTK_ICON_VIEW(m_pWidgets[ICONCHOOSER_GtkIconView]), model);
+  g_object_unref(model);
+
+  /* To call the funciton to build the list-store contents.
+     The path to icons may be changed when it is set current icon full name. */
+  m_LoadIconList();
+
+  /* Set the total number of icons. */
+  m_UpdateIconTotal();
+
+  return true;
+}
+
+/*! \fn	void CIconChooser::m_SetCurrentIcon(gchar *icon)
+    \brief To set the current chosen icon's full name string.
+
+    \param[in] icon. The current chosen icon's full path.
+    \return NONE
+*/
+void CIconChooser::m_SetCurrentIcon(gchar *icon)
+{
+  if( (icon == NULL) || (strlen(icon) == 0) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("\n\n %s(%d)  Error! The passed-in icons full name is NULL! \n\n", __FUNCTION__, __LINE__);
+     #endif
+
+     return;
+  }
+	
+  if(m_CurrentIcon)
+  {
+     g_free(m_CurrentIcon);
+     m_CurrentIcon = NULL;
+  }	
+
+  m_CurrentIcon = g_strdup(icon);
+
+  /* To update the icon browing location. */
+  m_UpdateIconLocation();
+} 
+
+/*! \fn	void CIconChooser::m_SetCurrentIcon(gchar *iconlocation)
+    \brief To set the current chosen icons locating path string.
+
+    \param[in] iconlocation. The current chosen icon's full path name.
+    \return NONE
+*/
+void CIconChooser::m_SetIconBrowseLocation(gchar *iconlocation) 
+{
+  if( (iconlocation == NULL) || (strlen(iconlocation) == 0) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("\n\n %s(%d)  Error! The passed-in icons locating path is NULL! \n\n", __FUNCTION__, __LINE__);
+     #endif
+
+     return;
+  }
+
+  if(m_IconBrowseLocation)
+  {
+     g_free(m_IconBrowseLocation);
+     m_IconBrowseLocation = NULL;
+  }
+
+  m_IconBrowseLocation = g_strdup(iconlocation);
+} 
+
+/*! \fn	void CIconChooser::m_SetDefaultIconPath(gchar *defaultIconPath)
     \brief To set the default icons searching path.
 
     \param[in] defaultIconPath. The default icons path.
@@ -1335,154 +3301,138 @@ void CIconChooser::m_SetDefaultIcon(gchar *defaultIcon)
   m_DefaultIcon = g_strdup(defaultIcon);
 } 
 
-/*! \fn gchar* CIconChooser::m_GetIconFullName(const char* file_name, int size)
-    \brief Try to find it in "pixmaps", "icons/hicolor", "icons/hicolor/scalable/apps" dirs.
+/*! \fn gchar* CIconChooser::m_GetCurrentThemeName(void)
+    \brief To get the name of the icon theme GTK+ uses.
 
-    \param[in]  file_name.
-    \param[in]  size. 
-    \return The string representing the icon's full name.
+    \param[in] NONE
+    \return The theme name, it must be freed.
 */
-gchar* CIconChooser::m_GetIconFullName(const char* file_name, int size)
+gchar* CIconChooser::m_GetCurrentThemeName(void)
 {
-  GdkPixbuf *icon = NULL;
-  char *file_path = NULL;
-  const gchar **dirs = (const gchar**)g_get_system_data_dirs();  /* To read the setting of the environment variable : "XDG_DATA_DIRS"*/
-  const gchar **dir = NULL;
-  gchar *sizeName = NULL;
+  gchar *themeName = NULL;
+
+  g_object_get(gtk_settings_get_default(), "gtk-icon-theme-name", &themeName, NULL);
 
-  for( dir = dirs; *dir; ++dir )
+  if( !themeName || (strlen(themeName) == 0) )
   {
-     /* Searching in "/usr/share/pixmaps" directory. */
-     file_path = g_build_filename( *dir, ICON_SEARCH_PATH_PIXMAPS, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+     g_free(themeName);
+     themeName = g_strdup(ICON_THEME_FALLBACK);
+  }
 
-     if( icon )
-     {
-        /* pixbuf has a referece count of "1" now, as the list store has added its own reference.
-           So to decrease the reference count of pixbuf. */
-        g_object_unref(icon);
-        break;
-     }
-     else
-     {
-        if(file_path)
-          g_free(file_path);
+  return themeName;
+}
 
-        file_path = NULL;
-     }
+/*! \fn gint CIconChooser::m_GetDefaultScale(void)
+    \brief To get the scale factor of the display from the GDK_SCALE environment variable, as GTK+ 3 does.
+    \n GTK+ 2 has no scale of its own, so without the variable the display is taken as scale 1.
 
-     /* Searching in "/usr/share/icons/hicolor/SizexSize/apps",
-        "/usr/local/share/icons/hicolor/SizexSize/apps" directories.
-		These are needed to assign the directory name formed in size. */
-     sizeName = g_strdup_printf( "%s/%dx%d/apps", ICON_SEARCH_PATH_HICOLOR, size, size );
-     file_path = g_build_filename( *dir, sizeName, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+    \param[in] NONE
+    \return The scale factor, 1 to ICONCHOOSER_MAX_SCALE.
+*/
+gint CIconChooser::m_GetDefaultScale(void)
+{
+  const gchar *value = g_getenv("GDK_SCALE");
+  gint scale = value ? atoi(value) : 1;
 
-     if(sizeName)
-       g_free(sizeName);
+  return CLAMP(scale, 1, ICONCHOOSER_MAX_SCALE);
+}
 
-     sizeName = NULL;
+/*! \fn void CIconChooser::m_GetMemoryStats(ICON_BUDGET_STATS *pStats)
+    \brief To get the memory taken by the thumbnails of the rows, the thumbnails held and those of the shared cache.
 
-     if ( icon )
-     {
-        /* pixbuf has a referece count of "1" now, as the list store has added its own reference. 
-           So to decrease the reference count of pixbuf. */
-        g_object_unref(icon);
-        break;
-     }
-     else
-     {
-        if(file_path)
-          g_free( file_path );
+    \param[out] pStats. The statistics.
+    \return NONE
+*/
+void CIconChooser::m_GetMemoryStats(ICON_BUDGET_STATS *pStats)
+{
+  m_pBudget->m_GetStats(pStats);
 
-        file_path = NULL;
-     }
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if(pStats)
+    printf("%s(%d) - %u rows, %u resident, %u thumbnails of %lu/%lu bytes, %u evicted, %u restored, %u cached, "
+           "%u compact of %lu bytes, %u expanded \n",
+           __FUNCTION__, __LINE__, pStats->nRows, pStats->nResidentRows, pStats->nPixbufs, (gulong)pStats->nBytes,
+           (gulong)pStats->nMaxBytes, pStats->nEvicted, pStats->nRestored, pStats->nCachedThumbnails,
+           pStats->nCompactRows, (gulong)pStats->nCompactBytes, pStats->nExpanded);
+  #endif
+}
 
-     /* Searching in "/usr/share/icons/hicolor/scalable/apps",  "/usr/local/share/icons/hicolor/scalable/apps". */
-     file_path = g_build_filename( *dir, ICON_SEARCH_PATH_HICOLOR_SCALABLE, file_name, NULL );
-     icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+/*! \fn void CIconChooser::m_SetScale(gint scale)
+    \brief To set the scale factor thumbnails and the button icon are decoded at.
+    \n The icons loaded are decoded again at the new size, the thumbnails of the old scale stay in the content cache until it is pruned.
 
-    if( icon )
-    {
-       /* pixbuf has a referece count of "1" now, as the list store has added its own reference. 
-          So to decrease the reference count of pixbuf. */
-       g_object_unref(icon);
-       break;
-    }
-    else
-    {
-       if(file_path)
-         g_free( file_path );
+    \param[in] scale. The device pixels per logical pixel, 1 to ICONCHOOSER_MAX_SCALE.
+    \return NONE
+*/
+void CIconChooser::m_SetScale(gint scale)
+{
+  scale = CLAMP(scale, 1, ICONCHOOSER_MAX_SCALE);
 
-       file_path = NULL;			
-    }
+  if(scale == m_nScale)
+    return;
 
-    /* Searching in "/usr/share/icons/gnome/scalable". */
-    file_path = g_build_filename( *dir, ICON_SEARCH_PATH_GNOME_SCALABLE, file_name, NULL );
-    icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+  m_nScale = scale;
+  m_pAnimator->m_SetSize(m_GetThumbnailSize());
+  m_pBudget->m_SetSize(m_GetThumbnailSize());
 
-    if( icon )
-    {
-       /* pixbuf has a referece count of "1" now, as the list store has added its own reference. 
-          So to decrease the reference count of pixbuf. */
-       g_object_unref(icon);
-       break;
-    }
-    else
-    {
-       if(file_path)
-         g_free( file_path );
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - Scale %d, thumbnails of %d pixels \n", __FUNCTION__, __LINE__, m_nScale, m_GetThumbnailSize());
+  #endif
 
-       file_path = NULL;
-    }
+  if( m_pWidgets[ICONCHOOSER_GtkIconView] && m_LoadedLocation )
+    m_ReloadIconList(NULL);
+}
 
-    /* Searching in "/usr/share/icons/gnome/scalable/apps" directory. */
-    file_path = g_build_filename( *dir, ICON_SEARCH_PATH_GNOME_SCALABLE_APPS, file_name, NULL );
-    icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+/*! \fn GdkPixbuf* CIconChooser::m_LoadButtonIcon(void)
+    \brief To load the current icon for the button showing it, decoded at the device pixel size of the icon.
 
-    if( icon )
-    {
-       /* pixbuf has a referece count of "1" now, as the list store has added its own reference. 
-          So to decrease the reference count of pixbuf. */
-       g_object_unref(icon);
-       break;
-    }
-    else
-    {
-       if(file_path)
-         g_free( file_path );
+    \param[in] NONE
+    \return The icon, it must be unreferenced. NULL if there is no current icon.
+*/
+GdkPixbuf* CIconChooser::m_LoadButtonIcon(void)
+{
+  if(!m_CurrentIcon)
+    return NULL;
 
-       file_path = NULL;
-    }
+  return m_LoadIcon(m_CurrentIcon, MIN(m_nIconWidth, m_nIconHeight) * m_nScale, true);
+}
 
-    /* Searching in "/usr/share/icons/gnome/SizexSize/apps".
-       These are needed to assign the directory name formed in size. */
-    sizeName = g_strdup_printf( "%s/%dx%d/apps", ICON_SEARCH_PATH_GNOME, size, size );
-    file_path = g_build_filename( *dir,  sizeName, file_name, NULL );
-    icon = gdk_pixbuf_new_from_file_at_scale( file_path, size, size, TRUE, NULL );
+/*! \fn gchar* CIconChooser::m_LookupThemeFile(const char* file_name, int size)
+    \brief To find an icon file in the tables of the current theme, which are built at the first lookup.
 
-    if(sizeName)
-      g_free(sizeName);
+    \param[in] file_name. The icon name, with or without extension.
+    \param[in] size. The wanted size.
+    \return The full file name, NULL if it is not in the theme. It must be freed.
+*/
+gchar* CIconChooser::m_LookupThemeFile(const char* file_name, int size)
+{
+  CIconScopedString themeName(m_GetCurrentThemeName());
+  gint scale = 1;
 
-    sizeName = NULL;
+  /* A size of device pixels at the current scale is looked up as its logical size, so "@2x" directories match exactly. */
+  if( (m_nScale > 1) && (size % m_nScale == 0) )
+    scale = m_nScale;
 
-    if( icon )
-    {
-       /* pixbuf has a referece count of "1" now, as the list store has added its own reference. 
-          So to decrease the reference count of pixbuf. */
-       g_object_unref(icon);			
-       break;
-    }
-    else
-    {
-       if(file_path)
-         g_free (file_path);
+  return m_pCatalog->m_LookupThemeFile(themeName, file_name, size / scale, scale);
+}
 
-       file_path = NULL;
-    }
-  }
+/*! \fn gchar* CIconChooser::m_GetIconFullName(const char* file_name, int size)
+    \brief Try to find it in the current theme, then in "pixmaps", "icons/hicolor", "icons/hicolor/scalable/apps" dirs.
+
+    \param[in]  file_name.
+    \param[in]  size. 
+    \return The string representing the icon's full name.
+*/
+gchar* CIconChooser::m_GetIconFullName(const char* file_name, int size)
+{
+  CIconScopedString themeName(m_GetCurrentThemeName());
+  gint scale = 1;
+
+  if( (m_nScale > 1) && (size % m_nScale == 0) )
+    scale = m_nScale;
 
-  return  file_path;
+  /* The catalog resolves the name from the theme tables and checks the legacy directories without decoding. */
+  return m_pCatalog->m_Resolve(file_name, size / scale, scale, themeName);
 }
 
 /*! \fn void CIconChooser::m_UpdateIconLocation(void)
@@ -1493,8 +3443,6 @@ gchar* CIconChooser::m_GetIconFullName(const char* file_name, int size)
 */
 void CIconChooser::m_UpdateIconLocation(void)
 {
-  gchar *dirName = NULL;
-
   if( !m_CurrentIcon )
   {
      #ifdef DEBUG_MENU_ICONCHOOSER
@@ -1505,26 +3453,17 @@ void CIconChooser::m_UpdateIconLocation(void)
   }
 
   /* To get the directory name of the current used icon. */
-  dirName = g_path_get_dirname(m_CurrentIcon);
+  CIconScopedString dirName(g_path_get_dirname(m_CurrentIcon));
   if(dirName)
   {
      if( g_str_has_suffix(dirName, "/") == false )
      {
-        gint len = strlen(dirName) + 1 + 1;   // one for a "/" and one for a NULL character.
-        gchar *tmpStr = (gchar*)malloc( sizeof(gchar) * len );
-
-        if(tmpStr)
-        {
-           memset (tmpStr, 0x00, len);
-           tmpStr = g_strdup_printf("%s%s", dirName, "/");
-           m_SetIconBrowseLocation(tmpStr);						
-           g_free(tmpStr);
-        }
-     }	
+        /* The location ends with a "/", the file names are appended to it. */
+        CIconScopedString location(g_strconcat(dirName.m_Get(), "/", NULL));
+        m_SetIconBrowseLocation(location);
+     }
      else
        m_SetIconBrowseLocation(dirName);
-
-     g_free(dirName);
   }
 }
 
@@ -1536,30 +3475,38 @@ void CIconChooser::m_UpdateIconLocation(void)
 */
 void CIconChooser::m_RemoveOldTreeModel(gboolean isDeinit)
 {
+  /* The rows animated are going away, their static thumbnails need not be restored. */
+  if( m_pAnimator )
+    m_pAnimator->m_Reset();
+
+  if( m_pBudget )
+    m_pBudget->m_Reset();
+
+  if( m_pScheduler )
+    m_pScheduler->m_Reset();
+
   if( m_pWidgets[ICONCHOOSER_GtkIconView] )
   {
      if( m_ListStore )
      {
         GtkTreeModel *model = NULL;
-        GtkTreeIter iter;
 
         /* Get the model. */
         model = gtk_icon_view_get_model( GTK_ICON_VIEW(m_pWidgets[ICONCHOOSER_GtkIconView]) );
-        m_ListStore = GTK_LIST_STORE(model);
 
-        /* Make sure the model stays with us after the icon view unrefs it */
-        g_object_ref( (GObject*)m_ListStore ); 	
+        if(model)
+        {
+           /* The view holds the only reference of the store, it is taken over before the view drops it. */
+           CIconScopedObject<GtkListStore> listStore(GTK_LIST_STORE(g_object_ref(model)));
 
-        /* Detach the model from the view */
-        gtk_icon_view_set_model(GTK_ICON_VIEW(m_pWidgets[ICONCHOOSER_GtkIconView]), NULL);
+           /* Detach the model from the view */
+           gtk_icon_view_set_model(GTK_ICON_VIEW(m_pWidgets[ICONCHOOSER_GtkIconView]), NULL);
 
-        /* Initializes iterator with the first iterator in the list(tree) (the one at the path "0") and returns TRUE. */	
-        if( gtk_tree_model_get_iter_first(model, &iter) == TRUE )
-        {
-           /* To clear all tree model data. */
-           gtk_list_store_clear(m_ListStore);			
-           m_ListStore = NULL;
+           /* To clear all tree model data, the store itself is released with the scope. */
+           gtk_list_store_clear(listStore.m_Get());
         }
+
+        m_ListStore = NULL;
      }
 
      /* Reset the counter for the amount of icons. */
@@ -1571,7 +3518,7 @@ void CIconChooser::m_RemoveOldTreeModel(gboolean isDeinit)
            { Pixel-Buffer, String, String }
      */
      if(isDeinit == false)
-       m_ListStore = gtk_list_store_new(NUM_COLS, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_STRING);
+       m_ListStore = gtk_list_store_new(NUM_COLS, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT64, G_TYPE_INT, G_TYPE_UINT64, G_TYPE_STRING);
   }
 }
 
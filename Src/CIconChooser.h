@@ -16,20 +16,20 @@
 #include <gtk/gtk.h>
 #include <gdk/gdk.h>
 
-/* Default icon path. This is used for file chooser, also */
-#define DEFAULT_ICON_PATH  "/usr/share/pixmaps/"
-#define DEFAULT_ICON_PATH_2  "/usr/share/app-install/icons/"
+#include "CIconCatalog.h"
+#include "CIconPerceptualHash.h"
+#include "CIconAnimator.h"
+#include "CIconThumbnailBudget.h"
+#include "CIconDecodeScheduler.h"
 
 #define DEFAULT_ICON    DEFAULT_ICON_PATH"gnome-gimp.png"
 #define DEFAULT_ICON_2  DEFAULT_ICON_PATH_2"gimp.xpm"
 
-/* The alternative icons searching path. */
-#define ICON_SEARCH_PATH_PIXMAPS             "pixmaps"
-#define ICON_SEARCH_PATH_HICOLOR             "icons/hicolor"
-#define ICON_SEARCH_PATH_HICOLOR_SCALABLE    "icons/hicolor/scalable/apps"
-#define ICON_SEARCH_PATH_GNOME               "icons/gnome"
-#define ICON_SEARCH_PATH_GNOME_SCALABLE      "icons/gnome/scalable"
-#define ICON_SEARCH_PATH_GNOME_SCALABLE_APPS "icons/gnome/scalable/apps"
+/* The size of the icon shown in the icon view. The unit is "pixel" */
+#define IMG_SIZE ICON_THUMBNAIL_SIZE
+
+/* The largest scale factor taken from GDK_SCALE or m_SetScale(). */
+#define ICONCHOOSER_MAX_SCALE 4
 
 /* Extension names of images. */
 #define   EXT_NAME_PNG  ".png"
@@ -48,9 +48,112 @@ enum ICONCHOOSER_WIDGET_IDX {
   ICONCHOOSER_GtkButton_BrowseIcon,
   ICONCHOOSER_GtkEntry_IconTotal,
   ICONCHOOSER_GtkEntry_VisibleIconTotal,
+  ICONCHOOSER_GtkProgressBar_Load,
+  ICONCHOOSER_GtkButton_StopLoad,
+  ICONCHOOSER_GtkCheckButton_HideDuplicates,
+  ICONCHOOSER_GtkButton_FindSimilar,
+  ICONCHOOSER_GtkComboBox_Sort,
+  ICONCHOOSER_GtkComboBox_Group,
+  ICONCHOOSER_GtkCheckButton_AllFolders,
+  ICONCHOOSER_GtkCheckButton_Animate,
   N_ICONCHOOSER_WIDGET_IDX
 };
 
+/*! \enum ICONCHOOSER_SORT_MODE
+    \brief The orders the icons could be shown in. The values are the items of the sort combo box.
+*/
+enum ICONCHOOSER_SORT_MODE {
+  ICONCHOOSER_SORT_None = 0,     /*!< The order the directory was read in. */
+  ICONCHOOSER_SORT_Name,         /*!< The file name, numbers in names compare by value. */
+  ICONCHOOSER_SORT_Size,         /*!< The file size. */
+  ICONCHOOSER_SORT_Mtime,        /*!< The modification time, the newest first. */
+  ICONCHOOSER_SORT_Format,       /*!< The extension name. */
+  ICONCHOOSER_SORT_Dimensions,   /*!< The number of pixels of the original image. */
+  N_ICONCHOOSER_SORT_MODE
+};
+
+/*! \enum ICONCHOOSER_GROUP_MODE
+    \brief The groups the icons could be kept together in, before they are sorted. The values are the items of the group combo box.
+*/
+enum ICONCHOOSER_GROUP_MODE {
+  ICONCHOOSER_GROUP_None = 0,
+  ICONCHOOSER_GROUP_Format,      /*!< The extension name. */
+  ICONCHOOSER_GROUP_Directory,   /*!< The directory, e.g. the size directories of a theme. */
+  N_ICONCHOOSER_GROUP_MODE
+};
+
+/*! \struct ICONCHOOSER_ROW_KEYS
+    \brief The sort keys of one row, computed once when the row is loaded.
+*/
+typedef struct _ICONCHOOSER_ROW_KEYS
+{
+  gint     nLoadIndex;   /*!< The position the row was loaded at. */
+  gchar   *nameKey;      /*!< The collation key of the basename, from g_utf8_collate_key_for_filename(). */
+  gchar   *formatKey;    /*!< The lower-case extension name. */
+  gchar   *dirKey;       /*!< The collation key of the directory name. */
+  guint64  fileSize;     /*!< The size of the icon file. */
+  gint64   mtime;        /*!< The modification time of the icon file. */
+  gint64   nPixels;      /*!< The width times height of the original image, 0 if unknown. */
+} ICONCHOOSER_ROW_KEYS;
+
+/*! \struct ICONCHOOSER_LOAD_PROGRESS
+    \brief The progress of loading the icon list.
+*/
+typedef struct _ICONCHOOSER_LOAD_PROGRESS
+{
+  gint     nEnumerated;   /*!< The number of icon files found so far. */
+  gint     nDecoded;      /*!< The number of icons decoded and shown. */
+  gint     nFailed;       /*!< The number of icon files which could not be decoded. */
+  gint     nDuplicates;   /*!< The number of icon files hidden as duplicates of a shown one. */
+  gint     nShadowed;     /*!< The number of icon files of the union view hidden by the same name in an earlier root. */
+  gint     nOversized;    /*!< The number of icon files not decoded because of the pixel or byte limits of CIconStreamDecoder. */
+  gint     nKnownBad;     /*!< The number of icon files of "nFailed" not even read, they had failed before and not changed. */
+  gint     nDeferred;     /*!< The number of rows listed with a placeholder, decoded when they are scrolled near. */
+  guint64  nBytesRead;    /*!< The number of bytes of the icon files read so far. */
+  gdouble  fElapsed;      /*!< The seconds since the loading started. */
+  gdouble  fThroughput;   /*!< The number of icon files processed per second. */
+  gdouble  fEta;          /*!< The estimated seconds left, less than 0 if it is unknown yet. */
+  gboolean bScanDone;     /*!< To indicate if the whole directory had been scanned, "nEnumerated" is final then. */
+  gboolean bFinished;     /*!< To indicate if the loading finished or was cancelled. */
+  gboolean bCancelled;    /*!< To indicate if the loading was cancelled. */
+} ICONCHOOSER_LOAD_PROGRESS;
+
+/*! \struct ICONCHOOSER_STREAM_JOB
+    \brief A file too large to be read into memory, decoded chunk by chunk between the other icons.
+*/
+typedef struct _ICONCHOOSER_STREAM_JOB
+{
+  CIconStreamDecoder *decoder;  /*!< The decoding of the file. */
+  gsize  fileSize;              /*!< The size of the file on disk. */
+  gint64 mtime;                 /*!< The modification time of the file, in second. */
+  gint   nRow;                  /*!< The row waiting for the thumbnail, -1 if a row is appended for it. */
+} ICONCHOOSER_STREAM_JOB;
+
+class CIconChooser;
+
+/* The files sent to the sandboxed decoder workers at most, the loading waits for their thumbnails beyond. */
+#define ICONCHOOSER_MAX_SANDBOX_JOBS  16
+
+/*! \struct ICONCHOOSER_SANDBOX_JOB
+    \brief A file decoded by a sandboxed worker, its row is filled when the thumbnail comes back.
+*/
+typedef struct _ICONCHOOSER_SANDBOX_JOB
+{
+  CIconChooser *pChooser;       /*!< The chooser waiting for the thumbnail. */
+  CIconDecoderPool *pPool;      /*!< The workers decoding the file, referenced until the job is done. */
+  ICON_DECODER_JOB *pJob;       /*!< The job of the workers. */
+  gchar  *fullName;             /*!< The icon file. */
+  guint64 contentHash;          /*!< The content hash of the file, 0 if it is unknown. */
+  gsize  fileSize;              /*!< The size of the file on disk. */
+  gint64 mtime;                 /*!< The modification time of the file, in second. */
+  gint   nRow;                  /*!< The row waiting for the thumbnail, -1 if a row is appended for it. */
+} ICONCHOOSER_SANDBOX_JOB;
+
+/*! \typedef ICONCHOOSER_PROGRESS_FUNC
+    \brief The callback function type to be notified about the loading progress.
+*/
+typedef void (*ICONCHOOSER_PROGRESS_FUNC)(CIconChooser *chooser, const ICONCHOOSER_LOAD_PROGRESS *progress, gpointer userData);
+
 /*! \class CIconChooser
     \brief The Icon Chooser class.
 */
@@ -69,7 +172,11 @@ class CIconChooser
     gint m_nIconHeight;
     gint m_nButtonWidth;
     gint m_nButtonHeight;
+    gint m_nScale;         /*!< The device pixels per logical pixel, thumbnails and the button icon are decoded at their size times it. */
     gboolean m_bIsChosen;  /*!< To indicate if an icon is chosen. */
+    gboolean m_bPersistent;  /*!< To hide the window instead of destroying it when it is closed, so it could be shown again at once. */
+    gboolean m_bInModal;     /*!< To indicate if m_DoModal() is running its nested main loop. */
+    gchar *m_LoadedLocation; /*!< The icon browsing location the list-store was loaded from. */
 
     /* GtkIconView Relevant variables */
     GtkTreeSelection *m_TreeSelection;       /*!< The selection instance gotten from the created icon view. */
@@ -79,6 +186,76 @@ class CIconChooser
     gint m_icon_total;         /*!< Total number of icons in a chosen directory. */
     gint m_icon_visible_total; /*!< Total number of icons could be shown in icon view in a chosen directory. */
 
+    CIconFileReader *m_pFileReader;  /*!< Read icon files in batches before they are decoded. */
+    CIconCatalog *m_pCatalog;        /*!< The shared catalog engine: the thumbnail cache, the search roots and the theme tables. */
+    GHashTable *m_pShownHashes;      /*!< The content hash to the iterator of the row showing it, for hiding duplicates. */
+    gboolean m_bHideDuplicates;      /*!< To show identical icons once, with the number of copies in the name. */
+    GArray *m_pPerceptualHashes;     /*!< The perceptual hash(guint64) of every row, in the order of the rows. */
+    GArray *m_pRowKeys;              /*!< The ICONCHOOSER_ROW_KEYS of every row, in the order of the rows. */
+    gint m_nSortMode;                /*!< One of ICONCHOOSER_SORT_MODE. */
+    gint m_nGroupMode;               /*!< One of ICONCHOOSER_GROUP_MODE. */
+    CIconAnimator *m_pAnimator;        /*!< Play the animated GIF icons being shown, while it is enabled. */
+    CIconThumbnailBudget *m_pBudget;   /*!< Bound the memory of the thumbnails of the rows. */
+    CIconDecodeScheduler *m_pScheduler;  /*!< Order the rows waiting for their thumbnails by what is shown. */
+
+    /* Icon list loading state. The loading could run in time slices on the GTK main loop. */
+    GDir *m_pLoadDir;         /*!< The directory being scanned, NULL when the scanning finished. */
+    GPtrArray *m_pLoadQueue;  /*!< The full names of the union view or the theme left to load, NULL if it is loading a directory. */
+    guint m_nLoadQueueNext;   /*!< The index of the next full name in m_pLoadQueue. */
+    GQueue *m_pStreamJobs;    /*!< The ICONCHOOSER_STREAM_JOB of the large files, the first one is fed between the other icons. */
+    GQueue *m_pSandboxJobs;   /*!< The ICONCHOOSER_SANDBOX_JOB of the files the sandboxed workers are decoding. */
+    gboolean m_bWaitingWorkers;  /*!< The last loading step waits for the thumbnails of m_pSandboxJobs. */
+    gboolean m_bLoadSuspended;   /*!< The loading's idle source is removed while it waits, a thumbnail coming back resumes it. */
+    ICON_FILE_BUFFER m_LoadBuffers[ICON_READ_BATCH];  /*!< The batch of icon files being decoded. */
+    gint m_nLoadBuffers;      /*!< The number of icon files in m_LoadBuffers. */
+    gint m_nLoadNext;         /*!< The index of the next icon file in m_LoadBuffers to be decoded. */
+    guint m_nLoadSource;      /*!< The idle source ID of the loading, 0 if it is not loading in time slices. */
+    gboolean m_bIdleLoad;     /*!< To load icons in time slices on the main loop instead of blocking. */
+    gboolean m_bPrioritize;   /*!< To list the rows first and decode the visible ones before the others. */
+    gboolean m_bPrioritizedRun;  /*!< To indicate if the current or last loading lists the rows first. */
+    gboolean m_bArchiveRun;   /*!< To indicate if the current or last loading browses an archive, its members are not read as files. */
+    gint m_LoadRows[ICON_READ_BATCH];  /*!< The row of every icon file of m_LoadBuffers, when the rows are listed first. */
+    gint m_nFarPriority;      /*!< The lowest ICON_DECODE_PRIORITY decoded, the far rows are left once the loading is cancelled. */
+    guint m_nPendingSource;   /*!< The idle source ID decoding the rows scrolled near after the loading, 0 if none. */
+    GdkPixbuf *m_pPendingIcon;  /*!< The image of the rows waiting for their thumbnails. */
+#ifdef USE_INDEX_DAEMON
+    GPtrArray *m_pDaemonEntries;  /*!< The ICON_INDEX_ENTRY of the index daemon left to append, NULL if it did not answer. */
+    guint m_nDaemonNext;          /*!< The index of the next entry in m_pDaemonEntries. */
+#endif
+
+    ICONCHOOSER_LOAD_PROGRESS m_LoadProgress;  /*!< The progress of the current or last loading. */
+    gint64 m_nLoadStartTime;                   /*!< The monotonic time the loading started at. */
+    ICONCHOOSER_PROGRESS_FUNC m_pfnProgress;   /*!< The embedding application's progress callback function. */
+    gpointer m_pProgressData;                  /*!< The user data passed to m_pfnProgress. */
+
+    void m_AppendIcon(ICON_FILE_BUFFER *pBuffer);
+    void m_QueueLoadFile(gchar *fullName);
+    void m_AppendRow(const gchar *fullName, GdkPixbuf *pixbuf, guint64 contentHash, gsize fileSize, gint64 mtime);
+    gboolean m_StreamIcon(ICON_FILE_BUFFER *pBuffer, gint nRow);
+    GdkPixbuf* m_DecodeLoadBuffer(ICON_FILE_BUFFER *pBuffer, guint64 contentHash);
+    void m_ReadLoadBatch(void);
+    void m_AppendPendingRow(const gchar *fullName);
+    void m_FillPendingRow(ICON_FILE_BUFFER *pBuffer, gint nRow);
+    void m_SetRowThumbnail(gint nRow, GdkPixbuf *pixbuf, guint64 contentHash, gsize fileSize, gint64 mtime);
+    gboolean m_TakePendingRows(gint nMaxPriority);
+    void m_StepStreamJob(void);
+    void m_FreeStreamJobs(void);
+    gboolean m_SandboxIcon(ICON_FILE_BUFFER *pBuffer, guint64 contentHash, gint nRow);
+    void m_FinishSandboxJob(ICONCHOOSER_SANDBOX_JOB *job, GdkPixbuf *pixbuf, gint nStatus);
+    void m_FreeSandboxJobs(void);
+
+    static void cb_sandbox_done(GdkPixbuf *pixbuf, gint nStatus, gpointer data);
+    void m_AddDuplicate(GtkTreeIter *pIter);
+    void m_ReorderRows(gint *newOrder);
+    void m_AppendRowKeys(const gchar *fullName, guint64 fileSize, gint64 mtime, GdkPixbuf *pixbuf);
+    void m_UpdateRowKeys(gint nRow, guint64 fileSize, gint64 mtime, GdkPixbuf *pixbuf);
+    void m_ClearRowKeys(void);
+#ifdef USE_INDEX_DAEMON
+    gboolean m_LoadIconListFromDaemon(void);
+    void m_AppendDaemonEntries(gint nMax);
+    void m_FreeDaemonEntries(void);
+#endif
+
   public:
     CIconChooser(gchar *currentIconFullName, GtkWidget *pwGtkParent);
     ~CIconChooser();
@@ -86,6 +263,8 @@ class CIconChooser
     void m_CreateInitValue(gchar *currentIconFullName);
     gboolean m_InitLayoutUI(GtkWidget *pwGtkParent);
     gboolean m_DoModal(void);  /*!< This function is only for dialog window  */
+    void m_EndModal(void);     /*!< To close the dialog window, it is hidden if the instance is persistent. */
+    void m_OnWindowDestroyed(void);
     void m_DeinitValue(void);
     void m_GetWindowSize(int &nWidth, int &nHeight);
 
@@ -114,17 +293,83 @@ class CIconChooser
     gboolean m_LoadIconList(void);
     gboolean m_ReloadIconList(gchar  *iconpath);
 
+    /* To load icons in time slices, to stop the loading and to show the number of loaded icons. */
+    gboolean m_LoadIconListStep(gint64 nDeadline);
+    void m_FinishIconList(void);
+    void m_StopIconList(void);
+    void m_UpdateIconTotal(void);
+    void m_SetIdleLoad(gboolean idleLoad) { m_bIdleLoad = idleLoad; }
+    gboolean m_GetIdleLoad(void) { return m_bIdleLoad; }
+    gboolean m_IsLoading(void) { return (m_nLoadSource != 0) || m_bLoadSuspended; }
+
+    /* To remove the loading's idle source while the last step waits for the sandboxed workers, TRUE if it was removed. */
+    gboolean m_SuspendLoad(void);
+
+    /* To get/set the flag to list all rows first and decode the selected, visible and scrolled-to rows before the others.
+       It takes effect on the next loading, and only when loading in time slices without hiding duplicates. */
+    void m_SetPrioritizedLoad(gboolean prioritize) { m_bPrioritize = prioritize; }
+    gboolean m_GetPrioritizedLoad(void) { return m_bPrioritize; }
+
+    /* To decode the rows left pending which are scrolled near after the loading, in time slices. */
+    void m_WakePendingRows(void);
+    gboolean m_DecodePendingStep(gint64 nDeadline);
+
+    /* To report the loading progress, and to let the user or the embedding application cancel the loading. */
+    void m_ReportProgress(void);
+    void m_CancelIconList(void);
+    void m_SetProgressCallback(ICONCHOOSER_PROGRESS_FUNC func, gpointer userData) { m_pfnProgress = func; m_pProgressData = userData; }
+    const ICONCHOOSER_LOAD_PROGRESS* m_GetLoadProgress(void) { return &m_LoadProgress; }
+
     /* To get/set the flag indicating if there has any select action had been done. */
     void  m_SetIsChosen(gboolean chosen) { m_bIsChosen = chosen; }
     gboolean m_GetIsChosen(void) { return m_bIsChosen; }
 
+    /* To get/set the flag to show byte-identical icons only once. It takes effect on the next loading. */
+    void m_SetHideDuplicates(gboolean hide) { m_bHideDuplicates = hide; }
+    gboolean m_GetHideDuplicates(void) { return m_bHideDuplicates; }
+
+    /* To get/set the flag to play animated GIF icons in their thumbnails. */
+    void m_SetAnimate(gboolean animate) { m_pAnimator->m_SetEnabled(animate); }
+    gboolean m_GetAnimate(void) { return m_pAnimator->m_GetEnabled(); }
+    CIconAnimator* m_GetAnimator(void) { return m_pAnimator; }
+
+    /* To get/set the memory the thumbnails of the rows could take, the rows far from the visible ones show a placeholder beyond it. */
+    void m_SetMemoryBudget(gsize maxBytes) { m_pBudget->m_SetMaxBytes(maxBytes); }
+    gsize m_GetMemoryBudget(void) { return m_pBudget->m_GetMaxBytes(); }
+
+    /* To get/set if the rows keep their thumbnails compact, expanded only when they are drawn. */
+    void m_SetCompactThumbnails(gboolean bCompact) { m_pBudget->m_SetCompact(bCompact); }
+    gboolean m_GetCompactThumbnails(void) { return m_pBudget->m_GetCompact(); }
+
+    /* To get the memory taken by the thumbnails and the number of them, of the rows and of the shared cache. */
+    void m_GetMemoryStats(ICON_BUDGET_STATS *pStats);
+
+    /* To move the icons looking like the selected one to the top of the icon view. */
+    gboolean m_FindSimilar(void);
+
+    /* To get/set the order and the grouping of the icons. The rows are reordered, not loaded again. */
+    void m_SetSortMode(gint sortMode, gint groupMode);
+    gint m_GetSortMode(void) { return m_nSortMode; }
+    gint m_GetGroupMode(void) { return m_nGroupMode; }
+    gboolean m_SortRows(void);
+
+    /* To get the catalog engine. The union view must be reloaded after its search roots are changed. */
+    CIconCatalog* m_GetCatalog(void) { return m_pCatalog; }
+
+    /* To get/set the flag to keep the window, the loaded icons and caches between uses. */
+    void m_SetPersistent(gboolean persistent) { m_bPersistent = persistent; }
+    gboolean m_GetPersistent(void) { return m_bPersistent; }
+
     /* Icon loading functions. */
     GdkPixbuf* m_LoadIcon( const gchar* name, gint size, gboolean use_fallback );   /*!< To load a icon's image contents. */
     GdkPixbuf* m_LoadIconFile( const char* file_name, int size );
+    static GdkPixbuf* m_LoadIconFromBuffer( const guchar* data, gsize length, gint size ) { return CIconCatalog::m_DecodeBuffer(data, length, size); }
     GdkPixbuf* m_LoadThemeIcon( GtkIconTheme* theme, const char* icon_name, int size );
     gchar* m_GetIconFullName(const char* file_name, int size);
+    gchar* m_LookupThemeFile(const char* file_name, int size);
+    static gchar* m_GetCurrentThemeName(void);
 
-    gboolean  m_IsPhotoFile (gchar *pFile);   /*!< To filt valid format of the icon.*/
+    static gboolean  m_IsPhotoFile (gchar *pFile) { return CIconCatalog::m_IsIconFile(pFile); }   /*!< To filt valid format of the icon.*/
 
     void InitIconChooserDlg(int nPosX, int nPosY);
 
@@ -140,6 +385,15 @@ class CIconChooser
     void m_SetButtonHeight(gint bolderHeight) { if(bolderHeight>0)  m_nButtonHeight = bolderHeight; }
     gint m_GetButtonHeight(void) { return m_nButtonHeight; }
 
+    /* The scale factor for HiDPI displays, 1 to ICONCHOOSER_MAX_SCALE. The icons are reloaded at the new scale. */
+    void m_SetScale(gint scale);
+    gint m_GetScale(void) { return m_nScale; }
+    gint m_GetThumbnailSize(void) { return IMG_SIZE * m_nScale; }
+    static gint m_GetDefaultScale(void);
+
+    /* To load the chosen icon for the button, at the icon size times the scale. The pixbuf must be unreferenced. */
+    GdkPixbuf* m_LoadButtonIcon(void);
+
     void m_UpdateIconLocation(void);	
     void m_RemoveOldTreeModel(gboolean isDeinit);
 
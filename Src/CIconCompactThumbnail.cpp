@@ -0,0 +1,412 @@
+/*! \file    CIconCompactThumbnail.cpp
+    \brief   Keep thumbnails in a few bytes and expand them when they are drawn.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "CIconCompactThumbnail.h"
+
+/* The slots of the hash table collecting the colors of a thumbnail, twice the palette so the probes stay short. */
+#define PALETTE_HASH_BITS   9
+#define PALETTE_HASH_SLOTS  (1 << PALETTE_HASH_BITS)
+
+/*! \fn static inline guint32 pixel_color(const guchar *p, gint nChannels)
+    \brief To get a pixel as 0xAARRGGBB, 0 for every fully transparent pixel.
+*/
+static inline guint32 pixel_color(const guchar *p, gint nChannels)
+{
+  if(nChannels == 3)
+    return 0xff000000 | ((guint32)p[0] << 16) | ((guint32)p[1] << 8) | p[2];
+
+  if(p[3] == 0)
+    return 0;
+
+  return ((guint32)p[3] << 24) | ((guint32)p[0] << 16) | ((guint32)p[1] << 8) | p[2];
+}
+
+/*! \fn static inline void unfilter_row(guchar *row, gint length, gint nChannels)
+    \brief To turn the differences to the left pixel of a row back into the channels.
+*/
+static inline void unfilter_row(guchar *row, gint length, gint nChannels)
+{
+  for(gint i=nChannels; i<length; i++)
+    row[i] = (guchar)(row[i] + row[i - nChannels]);
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconCompactThumbnail::CIconCompactThumbnail()
+    \brief CIconCompactThumbnail constructor
+*/
+CIconCompactThumbnail::CIconCompactThumbnail()
+{
+  m_nWidth = 0;
+  m_nHeight = 0;
+  m_nChannels = 4;
+  m_nLeft = 0;
+  m_nTop = 0;
+  m_nBoxWidth = 0;
+  m_nBoxHeight = 0;
+  m_nFormat = ICON_COMPACT_Empty;
+  m_nBits = 0;
+  m_nPaletteSize = 0;
+  m_pData = NULL;
+  m_nDataLength = 0;
+}
+
+/*! \fn CIconCompactThumbnail::~CIconCompactThumbnail()
+    \brief CIconCompactThumbnail destructor
+*/
+CIconCompactThumbnail::~CIconCompactThumbnail()
+{
+  g_free(m_pData);
+  m_pData = NULL;
+}
+
+/*! \fn gboolean CIconCompactThumbnail::m_FindBox(const guchar *pixels, gint rowstride)
+    \brief To find the box around the pixels which are not fully transparent. An RGB thumbnail is kept whole.
+
+    \param[in] pixels. The pixels of the thumbnail.
+    \param[in] rowstride. The bytes of a row.
+    \return FALSE if every pixel is fully transparent.
+*/
+gboolean CIconCompactThumbnail::m_FindBox(const guchar *pixels, gint rowstride)
+{
+  gint left = m_nWidth, right = -1, top = m_nHeight, bottom = -1;
+
+  if(m_nChannels == 3)
+  {
+     m_nLeft = m_nTop = 0;
+     m_nBoxWidth = m_nWidth;
+     m_nBoxHeight = m_nHeight;
+     return true;
+  }
+
+  for(gint y=0; y<m_nHeight; y++)
+  {
+     const guchar *p = pixels + (gsize)y * rowstride;
+
+     for(gint x=0; x<m_nWidth; x++)
+     {
+        if(p[x * 4 + 3] == 0)
+          continue;
+
+        left = MIN(left, x);
+        right = MAX(right, x);
+        top = MIN(top, y);
+        bottom = y;
+     }
+  }
+
+  if(right < 0)
+    return false;
+
+  m_nLeft = left;
+  m_nTop = top;
+  m_nBoxWidth = right - left + 1;
+  m_nBoxHeight = bottom - top + 1;
+
+  return true;
+}
+
+/*! \fn gboolean CIconCompactThumbnail::m_EncodePalette(const guchar *pixels, gint rowstride)
+    \brief To keep the box as a palette and the indices packed to the fewest bits, the leftmost pixel in the high bits.
+
+    \param[in] pixels. The pixels of the thumbnail.
+    \param[in] rowstride. The bytes of a row.
+    \return FALSE if the box has more than ICON_COMPACT_MAX_PALETTE colors.
+*/
+gboolean CIconCompactThumbnail::m_EncodePalette(const guchar *pixels, gint rowstride)
+{
+  guint32 keys[PALETTE_HASH_SLOTS];
+  gint16 slots[PALETTE_HASH_SLOTS];
+  guint32 palette[ICON_COMPACT_MAX_PALETTE];
+  guint8 *indices = g_new(guint8, (gsize)m_nBoxWidth * m_nBoxHeight);
+  guint nColors = 0;
+  gsize rowBytes = 0;
+  guint8 *pRows = NULL;
+
+  memset(slots, 0xff, sizeof(slots));
+
+  for(gint y=0; y<m_nBoxHeight; y++)
+  {
+     const guchar *p = pixels + (gsize)(m_nTop + y) * rowstride + (gsize)m_nLeft * m_nChannels;
+     guint8 *pIndex = indices + (gsize)y * m_nBoxWidth;
+
+     for(gint x=0; x<m_nBoxWidth; x++, p += m_nChannels)
+     {
+        guint32 color = pixel_color(p, m_nChannels);
+        guint slot = (color * 2654435761u) >> (32 - PALETTE_HASH_BITS);
+
+        while( (slots[slot] >= 0) && (keys[slot] != color) )
+          slot = (slot + 1) & (PALETTE_HASH_SLOTS - 1);
+
+        if(slots[slot] < 0)
+        {
+           if(nColors == ICON_COMPACT_MAX_PALETTE)
+           {
+              g_free(indices);
+              return false;
+           }
+
+           keys[slot] = color;
+           slots[slot] = (gint16)nColors;
+           palette[nColors++] = color;
+        }
+
+        pIndex[x] = (guint8)slots[slot];
+     }
+  }
+
+  m_nBits = (nColors <= 2) ? 1 : (nColors <= 4) ? 2 : (nColors <= 16) ? 4 : 8;
+  m_nPaletteSize = nColors;
+  rowBytes = ((gsize)m_nBoxWidth * m_nBits + 7) / 8;
+  m_nDataLength = nColors * sizeof(guint32) + rowBytes * m_nBoxHeight;
+  m_pData = (guint8*)g_malloc0(m_nDataLength);
+
+  memcpy(m_pData, palette, nColors * sizeof(guint32));
+  pRows = m_pData + nColors * sizeof(guint32);
+
+  for(gint y=0; y<m_nBoxHeight; y++)
+  {
+     const guint8 *pIndex = indices + (gsize)y * m_nBoxWidth;
+     guint8 *pRow = pRows + (gsize)y * rowBytes;
+
+     for(gint x=0; x<m_nBoxWidth; x++)
+     {
+        gint bit = x * m_nBits;
+
+        pRow[bit >> 3] |= (guint8)(pIndex[x] << (8 - m_nBits - (bit & 7)));
+     }
+  }
+
+  g_free(indices);
+
+  m_nFormat = ICON_COMPACT_Palette;
+  return true;
+}
+
+/*! \fn gboolean CIconCompactThumbnail::m_EncodeChannels(const guchar *pixels, gint rowstride)
+    \brief To keep the box as the differences of each channel to the pixel on its left, deflated if that is smaller.
+
+    \param[in] pixels. The pixels of the thumbnail.
+    \param[in] rowstride. The bytes of a row.
+    \return TRUE
+*/
+gboolean CIconCompactThumbnail::m_EncodeChannels(const guchar *pixels, gint rowstride)
+{
+  gsize rowLength = (gsize)m_nBoxWidth * m_nChannels;
+  gsize length = rowLength * m_nBoxHeight;
+  guint8 *filtered = (guint8*)g_malloc(length);
+  uLongf packedLength = compressBound(length);
+  guint8 *packed = (guint8*)g_malloc(packedLength);
+
+  for(gint y=0; y<m_nBoxHeight; y++)
+  {
+     const guchar *p = pixels + (gsize)(m_nTop + y) * rowstride + (gsize)m_nLeft * m_nChannels;
+     guint8 *pOut = filtered + (gsize)y * rowLength;
+     guint32 left = 0;
+
+     for(gint x=0; x<m_nBoxWidth; x++, p += m_nChannels, pOut += m_nChannels)
+     {
+        guint32 color = pixel_color(p, m_nChannels);
+
+        pOut[0] = (guint8)((color >> 16) - (left >> 16));
+        pOut[1] = (guint8)((color >> 8) - (left >> 8));
+        pOut[2] = (guint8)(color - left);
+
+        if(m_nChannels == 4)
+          pOut[3] = (guint8)((color >> 24) - (left >> 24));
+
+        left = color;
+     }
+  }
+
+  if( (compress2(packed, &packedLength, filtered, length, Z_BEST_SPEED) == Z_OK) && (packedLength < length) )
+  {
+     g_free(filtered);
+     m_pData = (guint8*)g_realloc(packed, packedLength);
+     m_nDataLength = packedLength;
+     m_nFormat = ICON_COMPACT_Deflate;
+     return true;
+  }
+
+  g_free(packed);
+  m_pData = filtered;
+  m_nDataLength = length;
+  m_nFormat = ICON_COMPACT_Raw;
+
+  return true;
+}
+
+/*! \fn gboolean CIconCompactThumbnail::m_Compact(GdkPixbuf *pixbuf)
+    \brief To keep the pixels of a thumbnail. The pixels kept before are released.
+
+    \param[in] pixbuf. The thumbnail, RGB or RGBA of 8 bits per channel. It is not referenced.
+    \return FALSE if the pixbuf is of another kind.
+*/
+gboolean CIconCompactThumbnail::m_Compact(GdkPixbuf *pixbuf)
+{
+  const guchar *pixels = NULL;
+  gint rowstride = 0;
+
+  g_free(m_pData);
+  m_pData = NULL;
+  m_nDataLength = 0;
+  m_nPaletteSize = 0;
+  m_nFormat = ICON_COMPACT_Empty;
+
+  if( !pixbuf || (gdk_pixbuf_get_colorspace(pixbuf) != GDK_COLORSPACE_RGB) || (gdk_pixbuf_get_bits_per_sample(pixbuf) != 8) )
+    return false;
+
+  m_nChannels = gdk_pixbuf_get_n_channels(pixbuf);
+  if( m_nChannels != (gdk_pixbuf_get_has_alpha(pixbuf) ? 4 : 3) )
+    return false;
+
+  m_nWidth = gdk_pixbuf_get_width(pixbuf);
+  m_nHeight = gdk_pixbuf_get_height(pixbuf);
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+
+  if( !m_FindBox(pixels, rowstride) )
+    return true;
+
+  if( m_EncodePalette(pixels, rowstride) )
+    return true;
+
+  return m_EncodeChannels(pixels, rowstride);
+}
+
+/*! \fn gboolean CIconCompactThumbnail::m_Fits(GdkPixbuf *pixbuf)
+    \brief To check if the thumbnail could be expanded into a pixbuf.
+
+    \param[in] pixbuf. The pixbuf.
+    \return TRUE if it has the dimensions and the channels of the thumbnail.
+*/
+gboolean CIconCompactThumbnail::m_Fits(GdkPixbuf *pixbuf)
+{
+  return pixbuf && (gdk_pixbuf_get_width(pixbuf) == m_nWidth) && (gdk_pixbuf_get_height(pixbuf) == m_nHeight) &&
+         (gdk_pixbuf_get_n_channels(pixbuf) == m_nChannels) && (gdk_pixbuf_get_bits_per_sample(pixbuf) == 8);
+}
+
+/*! \fn GdkPixbuf* CIconCompactThumbnail::m_NewPixbuf(void)
+    \brief To create a pixbuf the thumbnail could be expanded into.
+
+    \param[in] NONE
+    \return The pixbuf, it must be unreferenced. NULL if it could not be allocated.
+*/
+GdkPixbuf* CIconCompactThumbnail::m_NewPixbuf(void)
+{
+  return gdk_pixbuf_new(GDK_COLORSPACE_RGB, (m_nChannels == 4), 8, MAX(m_nWidth, 1), MAX(m_nHeight, 1));
+}
+
+/*! \fn gboolean CIconCompactThumbnail::m_Expand(GdkPixbuf *pixbuf)
+    \brief To write the thumbnail into a pixbuf, the pixels outside the box kept are cleared.
+
+    \param[in] pixbuf. The pixbuf, m_Fits() must be TRUE.
+    \return FALSE if it does not fit or the deflated pixels are corrupt.
+*/
+gboolean CIconCompactThumbnail::m_Expand(GdkPixbuf *pixbuf)
+{
+  guchar *pixels = NULL;
+  gint rowstride = 0;
+  gsize rowLength = (gsize)m_nBoxWidth * m_nChannels;
+  gboolean bOk = true;
+
+  if( !m_Fits(pixbuf) )
+    return false;
+
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+
+  /* A reused pixbuf still has the previous thumbnail around the box. */
+  if( (m_nFormat == ICON_COMPACT_Empty) || (m_nBoxWidth != m_nWidth) || (m_nBoxHeight != m_nHeight) )
+  {
+     for(gint y=0; y<m_nHeight; y++)
+       memset(pixels + (gsize)y * rowstride, 0x00, (gsize)m_nWidth * m_nChannels);
+  }
+
+  if(m_nFormat == ICON_COMPACT_Palette)
+  {
+     const guint32 *palette = (const guint32*)m_pData;
+     const guint8 *pRows = m_pData + m_nPaletteSize * sizeof(guint32);
+     gsize rowBytes = ((gsize)m_nBoxWidth * m_nBits + 7) / 8;
+     guint mask = (1u << m_nBits) - 1;
+
+     for(gint y=0; y<m_nBoxHeight; y++)
+     {
+        const guint8 *pRow = pRows + (gsize)y * rowBytes;
+        guchar *p = pixels + (gsize)(m_nTop + y) * rowstride + (gsize)m_nLeft * m_nChannels;
+
+        for(gint x=0; x<m_nBoxWidth; x++, p += m_nChannels)
+        {
+           gint bit = x * m_nBits;
+           guint32 color = palette[(pRow[bit >> 3] >> (8 - m_nBits - (bit & 7))) & mask];
+
+           p[0] = (guchar)(color >> 16);
+           p[1] = (guchar)(color >> 8);
+           p[2] = (guchar)color;
+
+           if(m_nChannels == 4)
+             p[3] = (guchar)(color >> 24);
+        }
+     }
+  }
+  else if(m_nFormat == ICON_COMPACT_Deflate)
+  {
+     z_stream stream;
+
+     memset(&stream, 0x00, sizeof(stream));
+     if(inflateInit(&stream) != Z_OK)
+       return false;
+
+     stream.next_in = (Bytef*)m_pData;
+     stream.avail_in = (uInt)m_nDataLength;
+
+     /* Inflated straight into the rows of the pixbuf, nothing else is allocated. */
+     for(gint y=0; bOk && (y<m_nBoxHeight); y++)
+     {
+        guchar *pRow = pixels + (gsize)(m_nTop + y) * rowstride + (gsize)m_nLeft * m_nChannels;
+
+        stream.next_out = pRow;
+        stream.avail_out = (uInt)rowLength;
+
+        while( bOk && (stream.avail_out > 0) )
+        {
+           gint ret = inflate(&stream, Z_NO_FLUSH);
+
+           if( (ret != Z_OK) && !((ret == Z_STREAM_END) && (stream.avail_out == 0)) )
+             bOk = false;
+        }
+
+        if(bOk)
+          unfilter_row(pRow, (gint)rowLength, m_nChannels);
+     }
+
+     inflateEnd(&stream);
+  }
+  else if(m_nFormat == ICON_COMPACT_Raw)
+  {
+     for(gint y=0; y<m_nBoxHeight; y++)
+     {
+        guchar *pRow = pixels + (gsize)(m_nTop + y) * rowstride + (gsize)m_nLeft * m_nChannels;
+
+        memcpy(pRow, m_pData + (gsize)y * rowLength, rowLength);
+        unfilter_row(pRow, (gint)rowLength, m_nChannels);
+     }
+  }
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if(!bOk)
+    printf("%s(%d) - A compact thumbnail of %dx%d is corrupt \n", __FUNCTION__, __LINE__, m_nWidth, m_nHeight);
+  #endif
+
+  return bOk;
+}
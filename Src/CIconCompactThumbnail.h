@@ -0,0 +1,82 @@
+/*! \file    CIconCompactThumbnail.h
+    \brief   Declaration of class CIconCompactThumbnail.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONCOMPACTTHUMBNAIL
+#define __CICONCOMPACTTHUMBNAIL
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* The colors of a thumbnail kept as palette indices at most, one byte per pixel. */
+#define ICON_COMPACT_MAX_PALETTE  256
+
+/*! \enum ICON_COMPACT_FORMAT
+    \brief How the pixels of a compact thumbnail are kept.
+*/
+enum ICON_COMPACT_FORMAT {
+  ICON_COMPACT_Empty = 0,   /* Fully transparent, nothing is kept. */
+  ICON_COMPACT_Palette,     /* A palette and 1, 2, 4 or 8 bits of index per pixel. */
+  ICON_COMPACT_Deflate,     /* The channels as differences to the left pixel, deflated. */
+  ICON_COMPACT_Raw          /* The channels as differences to the left pixel, when deflating them gains nothing. */
+};
+
+/*! \class CIconCompactThumbnail
+    \brief A thumbnail kept in a few bytes, expanded into a pixbuf when it is drawn.
+
+    Only the box around the pixels which are not fully transparent is kept, most icons have wide transparent
+    margins. A thumbnail of ICON_COMPACT_MAX_PALETTE colors or fewer is kept as palette indices packed to the
+    fewest bits, the others are deflated at the fastest level after each channel is taken as the difference to the
+    pixel on its left, which turns the gradients of icons into runs.
+    The fully transparent pixels are expanded as 0x00000000 whatever color they had, they are drawn the same.
+*/
+class CIconCompactThumbnail
+{
+  private:
+    gint m_nWidth;          /*!< The width of the thumbnail. */
+    gint m_nHeight;         /*!< The height of the thumbnail. */
+    gint m_nChannels;       /*!< 3 for RGB, 4 for RGBA. */
+    gint m_nLeft;           /*!< The box of the pixels kept: its left column. */
+    gint m_nTop;            /*!< Its top row. */
+    gint m_nBoxWidth;       /*!< Its width. */
+    gint m_nBoxHeight;      /*!< Its height. */
+    gint m_nFormat;         /*!< The ICON_COMPACT_FORMAT. */
+    gint m_nBits;           /*!< The bits of a palette index. */
+    guint m_nPaletteSize;   /*!< The colors in the palette, at the start of m_pData. */
+    guint8 *m_pData;        /*!< The palette(0xAARRGGBB each) then the index rows, or the encoded channels. */
+    gsize m_nDataLength;    /*!< The bytes of m_pData. */
+
+    gboolean m_FindBox(const guchar *pixels, gint rowstride);
+    gboolean m_EncodePalette(const guchar *pixels, gint rowstride);
+    gboolean m_EncodeChannels(const guchar *pixels, gint rowstride);
+
+  public:
+    CIconCompactThumbnail();
+    ~CIconCompactThumbnail();
+
+    /* To keep the pixels of a thumbnail of 8 bits per channel, FALSE if the pixbuf could not be taken. */
+    gboolean m_Compact(GdkPixbuf *pixbuf);
+
+    /* To expand into a pixbuf of the same dimensions and channels, e.g. one of m_NewPixbuf(). */
+    gboolean m_Expand(GdkPixbuf *pixbuf);
+
+    /* To create a pixbuf the thumbnail could be expanded into. It must be unreferenced. */
+    GdkPixbuf* m_NewPixbuf(void);
+
+    /* To check if a pixbuf could take the thumbnail, so it could be reused for another one. */
+    gboolean m_Fits(GdkPixbuf *pixbuf);
+
+    /* The memory taken, the object included. */
+    gsize m_GetBytes(void) { return sizeof(CIconCompactThumbnail) + m_nDataLength; }
+
+    gint m_GetFormat(void) { return m_nFormat; }
+    gint m_GetWidth(void) { return m_nWidth; }
+    gint m_GetHeight(void) { return m_nHeight; }
+};
+#endif   /* CICONCOMPACTTHUMBNAIL.H	*/
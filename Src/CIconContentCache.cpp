@@ -0,0 +1,371 @@
+/*! \file    CIconContentCache.cpp
+    \brief   Deduplicate byte-identical icon files by content hash, so memory and decoding scale with unique images.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <string.h>
+
+#include "CIconContentCache.h"
+
+/*! \struct ICON_FILE_KEY
+    \brief The identity of an unchanged file.
+*/
+typedef struct _ICON_FILE_KEY
+{
+  guint64 device;
+  guint64 inode;
+  gint64  mtime;
+  guint64 size;
+} ICON_FILE_KEY;
+
+/*! \struct ICON_PIXBUF_KEY
+    \brief The identity of a thumbnail.
+*/
+typedef struct _ICON_PIXBUF_KEY
+{
+  guint64 contentHash;
+  gint64  size;
+} ICON_PIXBUF_KEY;
+
+/*! \struct ICON_PIXBUF_ENTRY
+    \brief A thumbnail of the cache.
+*/
+typedef struct _ICON_PIXBUF_ENTRY
+{
+  ICON_PIXBUF_KEY key;  /*!< Its identity, the key of the table. */
+  GdkPixbuf *pixbuf;    /*!< The thumbnail, referenced. */
+  gsize nBytes;         /*!< The memory of its pixels. */
+  GList *idleLink;      /*!< Its link in the idle list, NULL while others hold the thumbnail. */
+} ICON_PIXBUF_ENTRY;
+
+/* The 64-bit mixing constants of MurmurHash3. */
+#define HASH_C1  0x87c37b91114253d5ULL
+#define HASH_C2  0x4cf5ad432745937fULL
+
+/*! \fn static inline guint64 rotl64(guint64 x, gint r)
+    \brief To rotate a 64-bit word left.
+*/
+static inline guint64 rotl64(guint64 x, gint r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+/*! \fn static inline guint64 fmix64(guint64 k)
+    \brief The finalizer of MurmurHash3, every input bit affects every output bit.
+*/
+static inline guint64 fmix64(guint64 k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+
+  return k;
+}
+
+/*! \fn static guint hash_words(gconstpointer key, gsize nWords)
+    \brief To hash a key made of 64-bit words for GHashTable.
+*/
+static guint hash_words(gconstpointer key, gsize nWords)
+{
+  const guint64 *words = (const guint64*)key;
+  guint64 h = 0;
+
+  for(gsize i=0; i<nWords; i++)
+    h = fmix64(h ^ words[i]);
+
+  return (guint)h;
+}
+
+static guint file_key_hash(gconstpointer key)
+{
+  return hash_words(key, sizeof(ICON_FILE_KEY) / sizeof(guint64));
+}
+
+static gboolean file_key_equal(gconstpointer a, gconstpointer b)
+{
+  return memcmp(a, b, sizeof(ICON_FILE_KEY)) == 0;
+}
+
+static guint pixbuf_key_hash(gconstpointer key)
+{
+  return hash_words(key, sizeof(ICON_PIXBUF_KEY) / sizeof(guint64));
+}
+
+static gboolean pixbuf_key_equal(gconstpointer a, gconstpointer b)
+{
+  return memcmp(a, b, sizeof(ICON_PIXBUF_KEY)) == 0;
+}
+
+/*! \fn static void free_pixbuf_entry(gpointer data)
+    \brief To free an ICON_PIXBUF_ENTRY removed from the table, it must be out of the idle list.
+*/
+static void free_pixbuf_entry(gpointer data)
+{
+  ICON_PIXBUF_ENTRY *entry = (ICON_PIXBUF_ENTRY*)data;
+
+  g_object_unref(entry->pixbuf);
+  g_free(entry);
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconContentCache::CIconContentCache()
+    \brief CIconContentCache constructor
+*/
+CIconContentCache::CIconContentCache()
+{
+  m_pFileHashes = g_hash_table_new_full(file_key_hash, file_key_equal, g_free, g_free);
+  m_pPixbufs = g_hash_table_new_full(pixbuf_key_hash, pixbuf_key_equal, NULL, free_pixbuf_entry);
+  g_queue_init(&m_Idle);
+  m_nIdleBytes = 0;
+  m_nIdleMaxBytes = ICON_CONTENT_IDLE_MAX_BYTES;
+}
+
+/*! \fn CIconContentCache::~CIconContentCache()
+    \brief CIconContentCache destructor
+*/
+CIconContentCache::~CIconContentCache()
+{
+  g_queue_clear(&m_Idle);
+  m_nIdleBytes = 0;
+
+  if(m_pFileHashes)
+    g_hash_table_destroy(m_pFileHashes);
+
+  if(m_pPixbufs)
+    g_hash_table_destroy(m_pPixbufs);
+
+  m_pFileHashes = NULL;
+  m_pPixbufs = NULL;
+}
+
+/*! \fn guint64 CIconContentCache::m_HashBytes(const guchar *data, gsize length)
+    \brief To hash file contents, 8 bytes per step in the manner of MurmurHash3.
+
+    \param[in] data. The file contents.
+    \param[in] length. The number of bytes.
+    \return The 64-bit hash, never 0.
+*/
+guint64 CIconContentCache::m_HashBytes(const guchar *data, gsize length)
+{
+  guint64 h = 0x9e3779b97f4a7c15ULL ^ length;
+  guint64 k = 0;
+  gsize i = 0;
+
+  for(i=0; i+8<=length; i+=8)
+  {
+     memcpy(&k, data + i, sizeof(k));   /* The contents are not aligned. */
+
+     k *= HASH_C1;
+     k = rotl64(k, 31);
+     k *= HASH_C2;
+
+     h ^= k;
+     h = rotl64(h, 27) * 5 + 0x52dce729;
+  }
+
+  /* The last 0 to 7 bytes. */
+  k = 0;
+  for(gsize j=0; i+j<length; j++)
+    k |= (guint64)data[i + j] << (8 * j);
+
+  k *= HASH_C1;
+  k = rotl64(k, 31);
+  k *= HASH_C2;
+  h ^= k;
+
+  h = fmix64(h);
+
+  /* 0 means "no hash". */
+  return h ? h : 1;
+}
+
+/*! \fn guint64 CIconContentCache::m_GetContentHash(const ICON_FILE_BUFFER *pBuffer)
+    \brief To get the content hash of a file read into memory, hashing it only if the file changed since.
+
+    \param[in] pBuffer. The file read by CIconFileReader.
+    \return The content hash, 0 if the file contents had not been read.
+*/
+guint64 CIconContentCache::m_GetContentHash(const ICON_FILE_BUFFER *pBuffer)
+{
+  ICON_FILE_KEY key;
+  guint64 *pHash = NULL;
+  guint64 hash = 0;
+
+  if( !pBuffer || !pBuffer->data || (pBuffer->length != pBuffer->fileSize) )
+    return 0;
+
+  memset(&key, 0x00, sizeof(key));
+  key.device = pBuffer->device;
+  key.inode = pBuffer->inode;
+  key.mtime = pBuffer->mtime;
+  key.size = pBuffer->fileSize;
+
+  /* A file without an inode number(e.g. read from an unusual file system) is always hashed. */
+  if( key.inode && (pHash = (guint64*)g_hash_table_lookup(m_pFileHashes, &key)) != NULL )
+    return *pHash;
+
+  hash = m_HashBytes(pBuffer->data, pBuffer->length);
+
+  if(key.inode)
+  {
+     pHash = g_new(guint64, 1);
+     *pHash = hash;
+     g_hash_table_replace(m_pFileHashes, g_memdup2(&key, sizeof(key)), pHash);
+  }
+
+  return hash;
+}
+
+/*! \fn guint64 CIconContentCache::m_LookupContentHash(const ICON_FILE_BUFFER *pBuffer)
+    \brief To get the content hash of a file by its (device, inode, modification time, size) only.
+    \n The buffer needs only be filled by CIconFileReader::m_StatOne(), so an unchanged file is not read at all.
+
+    \param[in] pBuffer. The file.
+    \return The content hash, 0 if the file was not hashed since it last changed.
+*/
+guint64 CIconContentCache::m_LookupContentHash(const ICON_FILE_BUFFER *pBuffer)
+{
+  ICON_FILE_KEY key;
+  guint64 *pHash = NULL;
+
+  if( !pBuffer || !pBuffer->inode || (pBuffer->error != 0) )
+    return 0;
+
+  memset(&key, 0x00, sizeof(key));
+  key.device = pBuffer->device;
+  key.inode = pBuffer->inode;
+  key.mtime = pBuffer->mtime;
+  key.size = pBuffer->fileSize;
+
+  pHash = (guint64*)g_hash_table_lookup(m_pFileHashes, &key);
+
+  return pHash ? *pHash : 0;
+}
+
+/*! \fn GdkPixbuf* CIconContentCache::m_LookupPixbuf(guint64 contentHash, gint size)
+    \brief To get the thumbnail already decoded from identical contents.
+
+    \param[in] contentHash. The content hash.
+    \param[in] size. The size of the thumbnail.
+    \return A new reference to the thumbnail, NULL if there is none.
+*/
+GdkPixbuf* CIconContentCache::m_LookupPixbuf(guint64 contentHash, gint size)
+{
+  ICON_PIXBUF_KEY key;
+  ICON_PIXBUF_ENTRY *entry = NULL;
+
+  if(contentHash == 0)
+    return NULL;
+
+  memset(&key, 0x00, sizeof(key));
+  key.contentHash = contentHash;
+  key.size = size;
+
+  if( (entry = (ICON_PIXBUF_ENTRY*)g_hash_table_lookup(m_pPixbufs, &key)) == NULL )
+    return NULL;
+
+  /* The caller holds it now, it goes back to the head of the idle list when it is let go. */
+  m_Unidle(entry);
+
+  return (GdkPixbuf*)g_object_ref(entry->pixbuf);
+}
+
+/*! \fn void CIconContentCache::m_InsertPixbuf(guint64 contentHash, gint size, GdkPixbuf *pixbuf)
+    \brief To keep the thumbnail decoded from some contents.
+
+    \param[in] contentHash. The content hash.
+    \param[in] size. The size of the thumbnail.
+    \param[in] pixbuf. The thumbnail, the cache takes its own reference.
+    \return NONE
+*/
+void CIconContentCache::m_InsertPixbuf(guint64 contentHash, gint size, GdkPixbuf *pixbuf)
+{
+  ICON_PIXBUF_ENTRY *entry = NULL;
+
+  if( (contentHash == 0) || !pixbuf )
+    return;
+
+  entry = g_new0(ICON_PIXBUF_ENTRY, 1);
+  entry->key.contentHash = contentHash;
+  entry->key.size = size;
+  entry->pixbuf = (GdkPixbuf*)g_object_ref(pixbuf);
+  entry->nBytes = (gsize)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf);
+
+  /* The entry replaced is freed with the table's function, it must leave the idle list first. */
+  m_Unidle(g_hash_table_lookup(m_pPixbufs, &entry->key));
+
+  g_hash_table_replace(m_pPixbufs, &entry->key, entry);
+}
+
+/*! \fn void CIconContentCache::m_Unidle(gpointer entry)
+    \brief To take an ICON_PIXBUF_ENTRY out of the idle list, if it is in it.
+*/
+void CIconContentCache::m_Unidle(gpointer entry)
+{
+  ICON_PIXBUF_ENTRY *pEntry = (ICON_PIXBUF_ENTRY*)entry;
+
+  if( !pEntry || !pEntry->idleLink )
+    return;
+
+  g_queue_delete_link(&m_Idle, pEntry->idleLink);
+  pEntry->idleLink = NULL;
+  m_nIdleBytes -= MIN(m_nIdleBytes, pEntry->nBytes);
+}
+
+/*! \fn void CIconContentCache::m_Prune(void)
+    \brief To put the thumbnails only the cache holds at the head of the idle list, then to drop the least recently
+           used ones from its tail while it takes more than its bound. The content hashes are kept, they are small.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconContentCache::m_Prune(void)
+{
+  ICON_PIXBUF_ENTRY *entry = NULL;
+  GHashTableIter hashIter;
+  gpointer value = NULL;
+
+  g_hash_table_iter_init(&hashIter, m_pPixbufs);
+  while( g_hash_table_iter_next(&hashIter, NULL, &value) )
+  {
+     entry = (ICON_PIXBUF_ENTRY*)value;
+
+     if( (G_OBJECT(entry->pixbuf)->ref_count == 1) && !entry->idleLink )
+     {
+        g_queue_push_head(&m_Idle, entry);
+        entry->idleLink = m_Idle.head;
+        m_nIdleBytes += entry->nBytes;
+     }
+     else if( (G_OBJECT(entry->pixbuf)->ref_count > 1) && entry->idleLink )
+       m_Unidle(entry);
+  }
+
+  while( (m_nIdleBytes > m_nIdleMaxBytes) && ((entry = (ICON_PIXBUF_ENTRY*)g_queue_pop_tail(&m_Idle)) != NULL) )
+  {
+     entry->idleLink = NULL;
+     m_nIdleBytes -= MIN(m_nIdleBytes, entry->nBytes);
+     g_hash_table_remove(m_pPixbufs, &entry->key);
+  }
+}
+
+/*! \fn void CIconContentCache::m_Clear(void)
+    \brief To drop all cached hashes and thumbnails.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconContentCache::m_Clear(void)
+{
+  g_queue_clear(&m_Idle);
+  m_nIdleBytes = 0;
+
+  g_hash_table_remove_all(m_pFileHashes);
+  g_hash_table_remove_all(m_pPixbufs);
+}
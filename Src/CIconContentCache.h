@@ -0,0 +1,71 @@
+/*! \file    CIconContentCache.h
+    \brief   Declaration of class CIconContentCache.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONCONTENTCACHE
+#define __CICONCONTENTCACHE
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "CIconFileReader.h"
+
+/* The memory of the thumbnails kept after nobody else uses them, the least recently used are dropped beyond it.
+   The unit is "byte". */
+#define ICON_CONTENT_IDLE_MAX_BYTES  (8 * 1024 * 1024)
+
+/*! \class CIconContentCache
+    \brief Share one decoded thumbnail among byte-identical icon files.
+
+    The contents of an icon file are hashed with a fast non-cryptographic 64-bit hash. The hash is
+    remembered by (device, inode, modification time, size), so an unchanged file is hashed only once.
+    Thumbnails are kept by (content hash, size), so identical images are decoded and stored once,
+    no matter how many names they have in how many directories.
+    A thumbnail nobody else holds any more, e.g. evicted from an icon view, is kept in a least recently used list
+    of ICON_CONTENT_IDLE_MAX_BYTES, so a row scrolled back into view gets it without decoding the file again.
+*/
+class CIconContentCache
+{
+  private:
+    GHashTable *m_pFileHashes;  /*!< The file identity to its content hash. */
+    GHashTable *m_pPixbufs;     /*!< The (content hash, size) to the ICON_PIXBUF_ENTRY of the decoded thumbnail. */
+    GQueue m_Idle;              /*!< The entries only the cache holds, the most recently used first. */
+    gsize m_nIdleBytes;         /*!< The memory of the thumbnails of m_Idle. */
+    gsize m_nIdleMaxBytes;      /*!< The memory m_Idle is trimmed to. */
+
+    void m_Unidle(gpointer entry);
+
+  public:
+    CIconContentCache();
+    ~CIconContentCache();
+
+    /* To get the content hash of a file read into memory, 0 if it had not been read. */
+    guint64 m_GetContentHash(const ICON_FILE_BUFFER *pBuffer);
+
+    /* To get the content hash remembered for the identity of a file, without its contents. 0 if it is unknown. */
+    guint64 m_LookupContentHash(const ICON_FILE_BUFFER *pBuffer);
+
+    /* To get/set the thumbnail of a content hash. m_LookupPixbuf returns a new reference. */
+    GdkPixbuf* m_LookupPixbuf(guint64 contentHash, gint size);
+    void m_InsertPixbuf(guint64 contentHash, gint size, GdkPixbuf *pixbuf);
+
+    /* To move the thumbnails nobody else uses any more to the idle list, e.g. after the list-store was cleared,
+       and to drop the least recently used of it beyond its bound. */
+    void m_Prune(void);
+
+    /* To drop all cached hashes and thumbnails. */
+    void m_Clear(void);
+
+    guint m_GetPixbufCount(void) { return g_hash_table_size(m_pPixbufs); }
+    gsize m_GetIdleBytes(void) { return m_nIdleBytes; }
+
+    /* The hash function over file contents. */
+    static guint64 m_HashBytes(const guchar *data, gsize length);
+};
+#endif   /* CICONCONTENTCACHE.H	*/
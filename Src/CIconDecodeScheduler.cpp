@@ -0,0 +1,400 @@
+/*! \file    CIconDecodeScheduler.cpp
+    \brief   Order the rows of an icon view waiting for their thumbnails by what the user looks at.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CIconDecodeScheduler.h"
+
+/*! \enum ICON_ROW_STATE
+    \brief The state of a row in the scheduler.
+*/
+enum ICON_ROW_STATE {
+  ICON_ROW_Done = 0,   /* The row has its thumbnail, or could not be decoded. */
+  ICON_ROW_Pending,    /* The row waits for its thumbnail. */
+  ICON_ROW_InFlight    /* The row was taken and is being decoded. */
+};
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconDecodeScheduler::CIconDecodeScheduler()
+    \brief CIconDecodeScheduler constructor
+*/
+CIconDecodeScheduler::CIconDecodeScheduler()
+{
+  m_pIconView = NULL;
+  m_pAdjustment = NULL;
+  m_pStates = g_byte_array_new();
+  m_nPending = 0;
+  m_pSelected = g_array_new(false, false, sizeof(gint));
+  m_nVisibleFirst = 0;
+  m_nVisibleLast = -1;
+  m_nAheadLast = -1;
+  m_nBehindLast = 0;
+  m_nDirection = 1;
+  m_fVelocity = 0;
+  m_fLastValue = 0;
+  m_nLastTime = 0;
+  m_nRestNext = 0;
+  m_pfnWake = NULL;
+  m_pWakeData = NULL;
+}
+
+/*! \fn CIconDecodeScheduler::~CIconDecodeScheduler()
+    \brief CIconDecodeScheduler destructor
+*/
+CIconDecodeScheduler::~CIconDecodeScheduler()
+{
+  m_Attach(NULL, NULL);
+
+  if(m_pStates)
+    g_byte_array_free(m_pStates, TRUE);
+
+  if(m_pSelected)
+    g_array_free(m_pSelected, TRUE);
+
+  m_pStates = NULL;
+  m_pSelected = NULL;
+}
+
+/*! \fn void CIconDecodeScheduler::m_Attach(GtkIconView *iconView, GtkAdjustment *vAdjustment)
+    \brief To follow the visible rows of an icon view and the scrolling of its vertical adjustment.
+
+    \param[in] iconView. The icon view, NULL to detach.
+    \param[in] vAdjustment. The vertical adjustment of the scrolled window of the view, could be NULL.
+    \return NONE
+*/
+void CIconDecodeScheduler::m_Attach(GtkIconView *iconView, GtkAdjustment *vAdjustment)
+{
+  if(m_pAdjustment)
+    g_signal_handlers_disconnect_by_func(m_pAdjustment, (gpointer)cb_value_changed, this);
+
+  if(m_pIconView)
+    g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_destroy, this);
+
+  m_pIconView = iconView;
+  m_pAdjustment = iconView ? vAdjustment : NULL;
+  m_nDirection = 1;
+  m_fVelocity = 0;
+  m_nLastTime = 0;
+
+  if(m_pIconView)
+    g_signal_connect(m_pIconView, "destroy", G_CALLBACK(cb_destroy), this);
+
+  if(m_pAdjustment)
+  {
+     m_fLastValue = gtk_adjustment_get_value(m_pAdjustment);
+     g_signal_connect(m_pAdjustment, "value-changed", G_CALLBACK(cb_value_changed), this);
+  }
+}
+
+/*! \fn void CIconDecodeScheduler::m_Reset(void)
+    \brief To forget all rows, because the model they were in is replaced.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconDecodeScheduler::m_Reset(void)
+{
+  g_byte_array_set_size(m_pStates, 0);
+  g_array_set_size(m_pSelected, 0);
+  m_nPending = 0;
+  m_nVisibleFirst = 0;
+  m_nVisibleLast = -1;
+  m_nAheadLast = -1;
+  m_nBehindLast = 0;
+  m_nRestNext = 0;
+}
+
+/*! \fn gint CIconDecodeScheduler::m_AddPending(void)
+    \brief To add a row waiting for its thumbnail after the last row.
+
+    \param[in] NONE
+    \return The position of the row.
+*/
+gint CIconDecodeScheduler::m_AddPending(void)
+{
+  guint8 state = ICON_ROW_Pending;
+
+  g_byte_array_append(m_pStates, &state, 1);
+  m_nPending++;
+
+  return (gint)m_pStates->len - 1;
+}
+
+/*! \fn void CIconDecodeScheduler::m_Done(gint nRow)
+    \brief To mark a row as decoded, or as not decodable. It is not taken again.
+
+    \param[in] nRow. The position of the row.
+    \return NONE
+*/
+void CIconDecodeScheduler::m_Done(gint nRow)
+{
+  if( (nRow < 0) || ((guint)nRow >= m_pStates->len) )
+    return;
+
+  if(m_pStates->data[nRow] == ICON_ROW_Pending)
+    m_nPending--;
+
+  m_pStates->data[nRow] = ICON_ROW_Done;
+}
+
+/*! \fn void CIconDecodeScheduler::m_Requeue(gint nRow)
+    \brief To put a row taken back to the pending rows, e.g. the loading was stopped before it was decoded.
+
+    \param[in] nRow. The position of the row.
+    \return NONE
+*/
+void CIconDecodeScheduler::m_Requeue(gint nRow)
+{
+  if( (nRow < 0) || ((guint)nRow >= m_pStates->len) || (m_pStates->data[nRow] != ICON_ROW_InFlight) )
+    return;
+
+  m_pStates->data[nRow] = ICON_ROW_Pending;
+  m_nPending++;
+
+  if((guint)nRow < m_nRestNext)
+    m_nRestNext = nRow;
+}
+
+/*! \fn void CIconDecodeScheduler::m_Reorder(const gint *newOrder, guint nRows)
+    \brief To follow the rows to their new positions after the model was reordered.
+
+    \param[in] newOrder. newOrder[newPosition] is the old position of a row, as gtk_list_store_reorder() takes it.
+    \param[in] nRows. The number of rows.
+    \return NONE
+*/
+void CIconDecodeScheduler::m_Reorder(const gint *newOrder, guint nRows)
+{
+  guint8 *oldStates = NULL;
+
+  if(nRows != m_pStates->len)
+    return;
+
+  oldStates = (guint8*)g_memdup2(m_pStates->data, nRows);
+
+  for(guint i=0; i<nRows; i++)
+    m_pStates->data[i] = oldStates[ newOrder[i] ];
+
+  g_free(oldStates);
+
+  /* The rows left behind the rest cursor could have moved after it. */
+  m_nRestNext = 0;
+}
+
+/*! \fn void CIconDecodeScheduler::m_Plan(void)
+    \brief To read the selected rows, the visible rows and the scrolling, and plan the prefetch windows from them.
+
+    The prefetch ahead is one page, and the rows a fast scroll would pass in ICON_PREFETCH_LOOKAHEAD_MSEC.
+    Half a page behind is prefetched as well, a scroll often goes back a little.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconDecodeScheduler::m_Plan(void)
+{
+  GtkTreePath *start = NULL, *end = NULL;
+  gint nRows = (gint)m_pStates->len;
+  gint nPageRows = ICON_PREFETCH_DEFAULT_PAGE_ROWS;
+  gint nAhead = 0;
+
+  g_array_set_size(m_pSelected, 0);
+  m_nVisibleFirst = 0;
+  m_nVisibleLast = -1;
+
+  if(m_pIconView)
+  {
+     GList *selected = gtk_icon_view_get_selected_items(m_pIconView);
+
+     for(GList *node=selected; node; node=node->next)
+     {
+        gint nRow = gtk_tree_path_get_indices((GtkTreePath*)node->data)[0];
+
+        g_array_append_val(m_pSelected, nRow);
+        gtk_tree_path_free((GtkTreePath*)node->data);
+     }
+
+     g_list_free(selected);
+
+     if( gtk_icon_view_get_visible_range(m_pIconView, &start, &end) )
+     {
+        m_nVisibleFirst = gtk_tree_path_get_indices(start)[0];
+        m_nVisibleLast = gtk_tree_path_get_indices(end)[0];
+        nPageRows = MAX(m_nVisibleLast - m_nVisibleFirst + 1, 1);
+
+        gtk_tree_path_free(start);
+        gtk_tree_path_free(end);
+     }
+  }
+
+  /* A scroll which stopped prefetches one page, in the direction it went last. */
+  if( m_nLastTime && ((g_get_monotonic_time() - m_nLastTime) > ICON_SCROLL_SETTLE_MSEC * 1000) )
+    m_fVelocity = 0;
+
+  nAhead = nPageRows * ICON_PREFETCH_PAGES;
+
+  if( m_pAdjustment && (m_fVelocity > 0) && (gtk_adjustment_get_page_size(m_pAdjustment) > 0) )
+  {
+     gdouble fRowsPerPixel = nPageRows / gtk_adjustment_get_page_size(m_pAdjustment);
+
+     nAhead += (gint)(m_fVelocity * ICON_PREFETCH_LOOKAHEAD_MSEC / 1000 * fRowsPerPixel);
+  }
+
+  nAhead = MIN(nAhead, nPageRows * ICON_PREFETCH_MAX_PAGES);
+
+  if(m_nDirection > 0)
+  {
+     m_nAheadLast = MIN(MAX(m_nVisibleLast, m_nVisibleFirst - 1) + nAhead, nRows - 1);
+     m_nBehindLast = MAX(m_nVisibleFirst - nPageRows / 2, 0);
+  }
+  else
+  {
+     m_nAheadLast = MAX(m_nVisibleFirst - nAhead, 0);
+     m_nBehindLast = MIN(MAX(m_nVisibleLast, m_nVisibleFirst - 1) + nPageRows / 2, nRows - 1);
+  }
+}
+
+/*! \fn gboolean CIconDecodeScheduler::m_TakeRange(gint nFrom, gint nTo, gint *pRow)
+    \brief To take the first pending row from nFrom toward nTo, both included, in either direction.
+*/
+gboolean CIconDecodeScheduler::m_TakeRange(gint nFrom, gint nTo, gint *pRow)
+{
+  gint nStep = (nTo >= nFrom) ? 1 : -1;
+  gint nRows = (gint)m_pStates->len;
+
+  for(gint nRow=nFrom; ; nRow+=nStep)
+  {
+     if( (nRow >= 0) && (nRow < nRows) && (m_pStates->data[nRow] == ICON_ROW_Pending) )
+     {
+        m_pStates->data[nRow] = ICON_ROW_InFlight;
+        m_nPending--;
+        *pRow = nRow;
+        return true;
+     }
+
+     if(nRow == nTo)
+       break;
+  }
+
+  return false;
+}
+
+/*! \fn gboolean CIconDecodeScheduler::m_TakePriority(gint nPriority, gint *pRow)
+    \brief To take the first pending row of one priority, as of the last m_Plan().
+*/
+gboolean CIconDecodeScheduler::m_TakePriority(gint nPriority, gint *pRow)
+{
+  gint nRows = (gint)m_pStates->len;
+
+  switch(nPriority)
+  {
+     case ICON_DECODE_Selected:
+       for(guint i=0; i<m_pSelected->len; i++)
+       {
+          gint nRow = g_array_index(m_pSelected, gint, i);
+
+          if( m_TakeRange(nRow, nRow, pRow) )
+            return true;
+       }
+       return false;
+
+     case ICON_DECODE_Visible:
+       return (m_nVisibleLast >= m_nVisibleFirst) && m_TakeRange(m_nVisibleFirst, m_nVisibleLast, pRow);
+
+     case ICON_DECODE_Prefetch:
+       /* The rows ahead from the nearest, then those behind from the nearest. */
+       if(m_nDirection > 0)
+         return ( (m_nAheadLast > m_nVisibleLast) && m_TakeRange(MAX(m_nVisibleLast + 1, 0), m_nAheadLast, pRow) ) ||
+                ( (m_nVisibleFirst > m_nBehindLast) && m_TakeRange(m_nVisibleFirst - 1, m_nBehindLast, pRow) );
+
+       return ( (m_nVisibleFirst > m_nAheadLast) && m_TakeRange(m_nVisibleFirst - 1, m_nAheadLast, pRow) ) ||
+              ( (m_nBehindLast > m_nVisibleLast) && m_TakeRange(MAX(m_nVisibleLast + 1, 0), m_nBehindLast, pRow) );
+
+     case ICON_DECODE_Rest:
+       if( ((gint)m_nRestNext < nRows) && m_TakeRange(m_nRestNext, nRows - 1, pRow) )
+       {
+          m_nRestNext = *pRow + 1;
+          return true;
+       }
+       return false;
+  }
+
+  return false;
+}
+
+/*! \fn gboolean CIconDecodeScheduler::m_Next(gint nMaxPriority, gint *pRow, gint *pPriority)
+    \brief To take the pending row of the highest priority, as of the last m_Plan(). The row is in flight then.
+
+    \param[in] nMaxPriority. The lowest ICON_DECODE_PRIORITY to take, e.g. ICON_DECODE_Prefetch to leave the far rows.
+    \param[out] pRow. The position of the row.
+    \param[out] pPriority. The priority it was taken at, could be NULL.
+    \return FALSE if there is no pending row up to that priority.
+*/
+gboolean CIconDecodeScheduler::m_Next(gint nMaxPriority, gint *pRow, gint *pPriority)
+{
+  if( (m_nPending == 0) || !pRow )
+    return false;
+
+  for(gint nPriority=ICON_DECODE_Selected; nPriority<=MIN(nMaxPriority, (gint)ICON_DECODE_Rest); nPriority++)
+  {
+     if( m_TakePriority(nPriority, pRow) )
+     {
+        if(pPriority)
+          *pPriority = nPriority;
+
+        return true;
+     }
+  }
+
+  return false;
+}
+
+/*! \fn void CIconDecodeScheduler::cb_value_changed(GtkAdjustment *adjustment, gpointer data)
+    \brief The callback function to measure the direction and speed of the scroll.
+*/
+void CIconDecodeScheduler::cb_value_changed(GtkAdjustment *adjustment, gpointer data)
+{
+  CIconDecodeScheduler *thisObject = (CIconDecodeScheduler*)data;
+  gdouble fValue = gtk_adjustment_get_value(adjustment);
+  gint64 nNow = g_get_monotonic_time();
+
+  if(fValue != thisObject->m_fLastValue)
+    thisObject->m_nDirection = (fValue > thisObject->m_fLastValue) ? 1 : -1;
+
+  /* The speed is smoothed over the changes, a single large jump is not taken as a fast scroll. */
+  if( thisObject->m_nLastTime && (nNow > thisObject->m_nLastTime) &&
+      ((nNow - thisObject->m_nLastTime) <= ICON_SCROLL_SETTLE_MSEC * 1000) )
+  {
+     gdouble fSpeed = ABS(fValue - thisObject->m_fLastValue) * G_USEC_PER_SEC / (nNow - thisObject->m_nLastTime);
+
+     thisObject->m_fVelocity = (thisObject->m_fVelocity + fSpeed) / 2;
+  }
+  else
+    thisObject->m_fVelocity = 0;
+
+  thisObject->m_fLastValue = fValue;
+  thisObject->m_nLastTime = nNow;
+
+  if( thisObject->m_nPending && thisObject->m_pfnWake )
+    thisObject->m_pfnWake(thisObject->m_pWakeData);
+}
+
+/*! \fn void CIconDecodeScheduler::cb_destroy(GtkWidget *widget, gpointer data)
+    \brief The callback function to detach from an icon view being destroyed.
+*/
+void CIconDecodeScheduler::cb_destroy(GtkWidget *widget, gpointer data)
+{
+  CIconDecodeScheduler *thisObject = (CIconDecodeScheduler*)data;
+
+  if(thisObject->m_pAdjustment)
+    g_signal_handlers_disconnect_by_func(thisObject->m_pAdjustment, (gpointer)cb_value_changed, thisObject);
+
+  thisObject->m_pAdjustment = NULL;
+  thisObject->m_pIconView = NULL;
+}
@@ -0,0 +1,108 @@
+/*! \file    CIconDecodeScheduler.h
+    \brief   Declaration of class CIconDecodeScheduler.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONDECODESCHEDULER
+#define __CICONDECODESCHEDULER
+
+#include <gtk/gtk.h>
+
+/* The rows of a page when the view is not shown yet, so the first rows are decoded first. */
+#define ICON_PREFETCH_DEFAULT_PAGE_ROWS  64
+
+/* The rows ahead of the visible ones in the scroll direction which are decoded before the others, in pages.
+   A fast scroll adds the rows it would pass in ICON_PREFETCH_LOOKAHEAD_MSEC, up to ICON_PREFETCH_MAX_PAGES. */
+#define ICON_PREFETCH_PAGES           1
+#define ICON_PREFETCH_MAX_PAGES       8
+#define ICON_PREFETCH_LOOKAHEAD_MSEC  500
+
+/* The scroll is taken as stopped when the adjustment did not move for this long. The unit is "millisecond". */
+#define ICON_SCROLL_SETTLE_MSEC  250
+
+/*! \enum ICON_DECODE_PRIORITY
+    \brief The priorities of the rows waiting for their thumbnails, the lower first.
+*/
+enum ICON_DECODE_PRIORITY {
+  ICON_DECODE_Selected = 0,  /* The selected rows. */
+  ICON_DECODE_Visible,       /* The rows shown. */
+  ICON_DECODE_Prefetch,      /* The rows ahead of the scroll, and half a page behind it. */
+  ICON_DECODE_Rest           /* All others, in the order of the rows. */
+};
+
+/*! \typedef ICON_DECODE_WAKE_FUNC
+    \brief The callback function type to be notified that other rows are shown, e.g. after scrolling.
+*/
+typedef void (*ICON_DECODE_WAKE_FUNC)(gpointer userData);
+
+/*! \class CIconDecodeScheduler
+    \brief Orders the rows of an icon view waiting for their thumbnails: the selected rows, the visible rows, the rows
+           ahead of the scroll direction and velocity of the view's vertical adjustment, then the rest.
+
+    The rows are known by their position. A row is pending until it is taken by m_Next(), in flight until it is
+    m_Done(), or pending again by m_Requeue(). m_Plan() reads the view once, the rows are then taken from the windows
+    it planned, so taking a batch of rows does not look at the view every time.
+*/
+class CIconDecodeScheduler
+{
+  private:
+    GtkIconView *m_pIconView;      /*!< The icon view, NULL if it is not attached. */
+    GtkAdjustment *m_pAdjustment;  /*!< The vertical adjustment of the view's scrolled window, NULL if there is none. */
+    GByteArray *m_pStates;         /*!< The ICON_ROW_STATE of every row. */
+    guint m_nPending;              /*!< The rows in the pending state. */
+    GArray *m_pSelected;           /*!< The selected rows(gint), at the last plan. */
+    gint m_nVisibleFirst;          /*!< The first visible row, at the last plan. */
+    gint m_nVisibleLast;           /*!< The last visible row, less than m_nVisibleFirst if none is visible. */
+    gint m_nAheadLast;             /*!< The last row of the prefetch ahead of the scroll, toward the scroll direction. */
+    gint m_nBehindLast;            /*!< The last row of the prefetch behind the scroll, toward the other direction. */
+    gint m_nDirection;             /*!< 1 when scrolling down or not scrolled yet, -1 when scrolling up. */
+    gdouble m_fVelocity;           /*!< The scroll speed, in pixels per second. */
+    gdouble m_fLastValue;          /*!< The adjustment value at the last change. */
+    gint64 m_nLastTime;            /*!< The monotonic time of the last change, 0 if it never changed. */
+    guint m_nRestNext;             /*!< The row the rest are looked for from. */
+    ICON_DECODE_WAKE_FUNC m_pfnWake;  /*!< The function notified when other rows are shown. */
+    gpointer m_pWakeData;             /*!< The user data passed to m_pfnWake. */
+
+    gboolean m_TakeRange(gint nFrom, gint nTo, gint *pRow);
+    gboolean m_TakePriority(gint nPriority, gint *pRow);
+
+    static void cb_value_changed(GtkAdjustment *adjustment, gpointer data);
+    static void cb_destroy(GtkWidget *widget, gpointer data);
+
+  public:
+    CIconDecodeScheduler();
+    ~CIconDecodeScheduler();
+
+    /* To follow the visible rows and the scrolling of an icon view, NULL to detach from it. */
+    void m_Attach(GtkIconView *iconView, GtkAdjustment *vAdjustment);
+    void m_SetWakeCallback(ICON_DECODE_WAKE_FUNC func, gpointer userData) { m_pfnWake = func; m_pWakeData = userData; }
+
+    /* To forget all rows, when the model is replaced. */
+    void m_Reset(void);
+
+    /* To add a pending row after the last one. The position of the row is returned. */
+    gint m_AddPending(void);
+
+    /* To mark a row taken as decoded, or pending again if it could not be done. */
+    void m_Done(gint nRow);
+    void m_Requeue(gint nRow);
+
+    /* To follow the rows being reordered, newOrder[newPosition] is the old position. */
+    void m_Reorder(const gint *newOrder, guint nRows);
+
+    /* To read the selection, the visible rows and the scroll of the view, before taking a batch. */
+    void m_Plan(void);
+
+    /* To take the pending row of the highest priority, up to nMaxPriority. FALSE if there is none. */
+    gboolean m_Next(gint nMaxPriority, gint *pRow, gint *pPriority);
+
+    guint m_GetPendingCount(void) { return m_nPending; }
+    guint m_GetRowCount(void) { return m_pStates->len; }
+    gdouble m_GetVelocity(void) { return m_fVelocity; }
+};
+#endif   /* CICONDECODESCHEDULER.H	*/
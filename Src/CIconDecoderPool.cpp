@@ -0,0 +1,1180 @@
+/*! \file    CIconDecoderPool.cpp
+    \brief   Decode icon files in sandboxed worker processes with a timeout per file.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "CIconCatalog.h"
+#include "CIconDecoderPool.h"
+
+/* The longest file name requested. */
+#define ICON_DECODER_MAX_NAME  4096
+
+/* The seals of the memfd of a reply, the pixels mapped could not change or vanish under the dialog. */
+#define ICON_DECODER_REPLY_SEALS  (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE)
+
+/*! \fn static gboolean write_all(gint fd, const void *buf, gsize len)
+    \brief To write the whole buffer to a socket.
+
+    \param[in] fd. The socket.
+    \param[in] buf. The data.
+    \param[in] len. The number of bytes.
+    \return TRUE or FALSE
+*/
+static gboolean write_all(gint fd, const void *buf, gsize len)
+{
+  const guchar *p = (const guchar*)buf;
+
+  while(len > 0)
+  {
+     /* MSG_NOSIGNAL: a worker which died must not kill the dialog with SIGPIPE. */
+     ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+       return false;
+
+     p += n;
+     len -= n;
+  }
+
+  return true;
+}
+
+/*! \fn static gboolean read_all(gint fd, void *buf, gsize len)
+    \brief To read exactly "len" bytes from a socket, without a timeout.
+
+    \param[in] fd. The socket.
+    \param[out] buf. The buffer.
+    \param[in] len. The number of bytes.
+    \return TRUE or FALSE
+*/
+static gboolean read_all(gint fd, void *buf, gsize len)
+{
+  guchar *p = (guchar*)buf;
+
+  while(len > 0)
+  {
+     ssize_t n = read(fd, p, len);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+       return false;
+
+     p += n;
+     len -= n;
+  }
+
+  return true;
+}
+
+/*! \fn static gboolean send_with_fd(gint fd, const void *buf, gsize len, gint passFd)
+    \brief To write the whole buffer to a socket, with a file descriptor passed along the first byte.
+
+    \param[in] fd. The socket.
+    \param[in] buf. The data.
+    \param[in] len. The number of bytes, at least 1.
+    \param[in] passFd. The file descriptor to pass, -1 for none.
+    \return TRUE or FALSE
+*/
+static gboolean send_with_fd(gint fd, const void *buf, gsize len, gint passFd)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  union { struct cmsghdr align; gchar data[CMSG_SPACE(sizeof(gint))]; } control;
+  ssize_t n = 0;
+
+  memset(&msg, 0x00, sizeof(msg));
+  iov.iov_base = (void*)buf;
+  iov.iov_len = len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  if(passFd >= 0)
+  {
+     struct cmsghdr *cmsg = NULL;
+
+     memset(&control, 0x00, sizeof(control));
+     msg.msg_control = control.data;
+     msg.msg_controllen = sizeof(control.data);
+
+     cmsg = CMSG_FIRSTHDR(&msg);
+     cmsg->cmsg_level = SOL_SOCKET;
+     cmsg->cmsg_type = SCM_RIGHTS;
+     cmsg->cmsg_len = CMSG_LEN(sizeof(gint));
+     memcpy(CMSG_DATA(cmsg), &passFd, sizeof(gint));
+  }
+
+  do
+  {
+     n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+  } while( (n < 0) && (errno == EINTR) );
+
+  if(n <= 0)
+    return false;
+
+  /* The descriptor went with the first bytes, the rest is plain data. */
+  return write_all(fd, (const guchar*)buf + n, len - n);
+}
+
+/*! \fn static ssize_t recv_once(gint fd, void *buf, gsize len, gint *pPassFd, gint flags)
+    \brief To read what a socket has of "len" bytes, and the file descriptor passed along.
+
+    \param[in] fd. The socket.
+    \param[out] buf. The buffer.
+    \param[in] len. The number of bytes wanted.
+    \param[in,out] pPassFd. The file descriptor passed, left as it is if none was. Another one passed is closed.
+    \param[in] flags. The flags of recvmsg(), e.g. MSG_DONTWAIT.
+    \return The number of bytes read, 0 if the socket was closed, -1 on an error with errno set.
+*/
+static ssize_t recv_once(gint fd, void *buf, gsize len, gint *pPassFd, gint flags)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  union { struct cmsghdr align; gchar data[CMSG_SPACE(sizeof(gint))]; } control;
+  ssize_t n = 0;
+
+  memset(&msg, 0x00, sizeof(msg));
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data;
+  msg.msg_controllen = sizeof(control.data);
+
+  /* MSG_CMSG_CLOEXEC: the workers started later must not inherit the thumbnails of the others. */
+  do
+  {
+     n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | flags);
+  } while( (n < 0) && (errno == EINTR) );
+
+  if(n < 0)
+    return n;
+
+  for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+  {
+     gint passFd = -1;
+
+     if( (cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS) )
+       continue;
+
+     memcpy(&passFd, CMSG_DATA(cmsg), sizeof(gint));
+
+     if(*pPassFd < 0)
+       *pPassFd = passFd;
+     else
+       close(passFd);
+  }
+
+  return n;
+}
+
+/*! \fn static gboolean recv_with_fd(gint fd, void *buf, gsize len, gint *pPassFd, gint64 nDeadline, gboolean *pTimedOut)
+    \brief To read exactly "len" bytes from a socket before a deadline, and the file descriptor passed along.
+
+    \param[in] fd. The socket.
+    \param[out] buf. The buffer.
+    \param[in] len. The number of bytes.
+    \param[out] pPassFd. The file descriptor passed, -1 if none was. It must be closed.
+    \param[in] nDeadline. The monotonic time(in microsecond) to give up at, -1 to wait as long as it takes.
+    \param[out] pTimedOut. TRUE if the deadline passed.
+    \return TRUE or FALSE
+*/
+static gboolean recv_with_fd(gint fd, void *buf, gsize len, gint *pPassFd, gint64 nDeadline, gboolean *pTimedOut)
+{
+  guchar *p = (guchar*)buf;
+
+  *pPassFd = -1;
+  *pTimedOut = false;
+
+  while(len > 0)
+  {
+     struct pollfd pfd = { fd, POLLIN, 0 };
+     gint64 nLeft = (nDeadline < 0) ? -1 : nDeadline - g_get_monotonic_time();
+     gint nReady = 0;
+     ssize_t n = 0;
+
+     if( (nDeadline >= 0) && (nLeft <= 0) )
+     {
+        *pTimedOut = true;
+        return false;
+     }
+
+     nReady = poll(&pfd, 1, (nLeft < 0) ? -1 : (gint)MIN((nLeft + 999) / 1000, G_MAXINT));
+     if( (nReady < 0) && (errno == EINTR) )
+       continue;
+
+     if(nReady == 0)
+     {
+        *pTimedOut = true;
+        return false;
+     }
+
+     if(nReady < 0)
+       return false;
+
+     n = recv_once(fd, p, len, pPassFd, 0);
+     if(n <= 0)
+       return false;
+
+     p += n;
+     len -= n;
+  }
+
+  return true;
+}
+
+/*! \fn static void cb_unmap_pixels(guchar *pixels, gpointer data)
+    \brief The callback function to unmap the pixels of a thumbnail made by a worker, when the pixbuf is finalized.
+
+    \param[in] pixels. The mapped pixels.
+    \param[in] data. The length of the mapping, stored with GSIZE_TO_POINTER().
+    \return NONE
+*/
+static void cb_unmap_pixels(guchar *pixels, gpointer data)
+{
+  munmap(pixels, GPOINTER_TO_SIZE(data));
+}
+
+/*! \fn static gint new_contents_memfd(const guchar *data, gsize length)
+    \brief To put the contents of an icon file the caller read into a memfd, to be passed to a worker.
+
+    \param[in] data. The file contents.
+    \param[in] length. The number of bytes of the contents.
+    \return The memfd to be closed, -1 if it could not be made. The worker reads the file by itself then.
+*/
+static gint new_contents_memfd(const guchar *data, gsize length)
+{
+  gint memfd = -1;
+  gsize nWritten = 0;
+
+  if( !data || (length == 0) || (length > G_MAXUINT32) )
+    return -1;
+
+  memfd = memfd_create("iconchooser-contents", MFD_CLOEXEC);
+  if(memfd < 0)
+    return -1;
+
+  while(nWritten < length)
+  {
+     ssize_t n = write(memfd, data + nWritten, length - nWritten);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+     {
+        close(memfd);
+        return -1;
+     }
+
+     nWritten += n;
+  }
+
+  return memfd;
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconDecoderPool::CIconDecoderPool(const gchar *program, gint nWorkers)
+    \brief CIconDecoderPool constructor. No worker is started before its first file.
+
+    \param[in] program. The program the workers run with ICON_DECODER_WORKER_ARG, NULL for ICON_DECODER_DEFAULT_PROGRAM.
+    \param[in] nWorkers. The number of workers.
+*/
+CIconDecoderPool::CIconDecoderPool(const gchar *program, gint nWorkers)
+{
+  m_Program = g_strdup(program ? program : ICON_DECODER_DEFAULT_PROGRAM);
+  m_nWorkers = MAX(nWorkers, 1);
+  m_pWorkers = g_new0(ICON_DECODER_WORKER, m_nWorkers + 1);
+  m_nNext = 0;
+  g_mutex_init(&m_Lock);
+  g_cond_init(&m_Idle);
+  m_pPending = g_queue_new();
+  m_nTimeout = ICON_DECODER_TIMEOUT_MSEC;
+  m_nTimeouts = 0;
+  m_nCrashes = 0;
+  m_nRestarts = 0;
+  m_nRef = 1;
+
+  for(gint i=0; i<=m_nWorkers; i++)
+  {
+     m_pWorkers[i].pid = 0;
+     m_pWorkers[i].fd = -1;
+     m_pWorkers[i].channel = NULL;
+     m_pWorkers[i].bBusy = false;
+  }
+}
+
+/*! \fn CIconDecoderPool::~CIconDecoderPool()
+    \brief CIconDecoderPool destructor. The workers are killed.
+    \n The jobs of m_DecodeAsync() keep the pool, none is left when it is deleted.
+*/
+CIconDecoderPool::~CIconDecoderPool()
+{
+  for(gint i=0; i<=m_nWorkers; i++)
+    m_Stop(&m_pWorkers[i]);
+
+  g_queue_free(m_pPending);
+  g_cond_clear(&m_Idle);
+  g_mutex_clear(&m_Lock);
+  g_free(m_pWorkers);
+  g_free(m_Program);
+
+  m_pPending = NULL;
+  m_pWorkers = NULL;
+  m_Program = NULL;
+}
+
+/*! \fn void CIconDecoderPool::cb_child_setup(gpointer data)
+    \brief The function run in a worker between fork() and exec(): the socket becomes its standard input,
+           and its memory and privileges are limited.
+
+    \param[in] data. The worker's end of the socket, stored with GINT_TO_POINTER().
+    \return NONE
+*/
+void CIconDecoderPool::cb_child_setup(gpointer data)
+{
+  struct rlimit limit;
+
+  dup2(GPOINTER_TO_INT(data), STDIN_FILENO);
+
+  limit.rlim_cur = limit.rlim_max = ICON_DECODER_WORKER_MEMORY;
+  setrlimit(RLIMIT_AS, &limit);
+
+  /* A crash on a bad image leaves no core file of the size of the limit. */
+  limit.rlim_cur = limit.rlim_max = 0;
+  setrlimit(RLIMIT_CORE, &limit);
+
+#ifdef PR_SET_NO_NEW_PRIVS
+  prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0);
+#endif
+}
+
+/*! \fn gboolean CIconDecoderPool::m_Start(ICON_DECODER_WORKER *pWorker)
+    \brief To start a worker process.
+
+    \param[in] pWorker. The worker, it must be busy and not running.
+    \return TRUE or FALSE
+*/
+gboolean CIconDecoderPool::m_Start(ICON_DECODER_WORKER *pWorker)
+{
+  gchar *argv[3] = { m_Program, (gchar*)ICON_DECODER_WORKER_ARG, NULL };
+  GError *error = NULL;
+  gint sv[2] = { -1, -1 };
+
+  if( socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0 )
+    return false;
+
+  /* The other descriptors of the dialog are closed in the worker, only the socket is left to it. */
+  if( !g_spawn_async(NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD, cb_child_setup, GINT_TO_POINTER(sv[1]),
+                     &pWorker->pid, &error) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("%s(%d) - The decoder worker %s could not be started: %s \n", __FUNCTION__, __LINE__, m_Program,
+            error ? error->message : "");
+     #endif
+
+     if(error)
+       g_error_free(error);
+
+     close(sv[0]);
+     close(sv[1]);
+     pWorker->pid = 0;
+     return false;
+  }
+
+  close(sv[1]);
+  pWorker->fd = sv[0];
+  pWorker->channel = g_io_channel_unix_new(sv[0]);
+
+  return true;
+}
+
+/*! \fn void CIconDecoderPool::m_Stop(ICON_DECODER_WORKER *pWorker)
+    \brief To kill a worker process and reap it. It is started again at its next file.
+
+    \param[in] pWorker. The worker, it must be busy or the pool being deleted. No watch of its socket is left.
+    \return NONE
+*/
+void CIconDecoderPool::m_Stop(ICON_DECODER_WORKER *pWorker)
+{
+  if(pWorker->channel)
+    g_io_channel_unref(pWorker->channel);
+
+  if(pWorker->fd >= 0)
+    close(pWorker->fd);
+
+  /* A worker stuck in a decoder never reads the closed socket, it is killed. */
+  if(pWorker->pid > 0)
+  {
+     kill(pWorker->pid, SIGKILL);
+     waitpid(pWorker->pid, NULL, 0);
+     g_spawn_close_pid(pWorker->pid);
+  }
+
+  pWorker->channel = NULL;
+  pWorker->fd = -1;
+  pWorker->pid = 0;
+}
+
+/*! \fn ICON_DECODER_WORKER* CIconDecoderPool::m_TakeIdle(gint nWorkers)
+    \brief To take a worker which is not decoding a file, the workers are taken in turn. m_Lock must be held.
+
+    \param[in] nWorkers. The workers to take from, m_nWorkers for m_DecodeAsync(), one more for m_Decode().
+    \return The worker, now busy. NULL if all of them are busy.
+*/
+ICON_DECODER_WORKER* CIconDecoderPool::m_TakeIdle(gint nWorkers)
+{
+  for(gint i=0; i<nWorkers; i++)
+  {
+     ICON_DECODER_WORKER *pWorker = &m_pWorkers[(m_nNext + i) % nWorkers];
+
+     if(!pWorker->bBusy)
+     {
+        pWorker->bBusy = true;
+        m_nNext = (m_nNext + i + 1) % nWorkers;
+        return pWorker;
+     }
+  }
+
+  return NULL;
+}
+
+/*! \fn void CIconDecoderPool::m_Release(ICON_DECODER_WORKER *pWorker)
+    \brief To give a worker back when it is done with a file, and send it the next job waiting.
+
+    \param[in] pWorker. The busy worker.
+    \return NONE
+*/
+void CIconDecoderPool::m_Release(ICON_DECODER_WORKER *pWorker)
+{
+  g_mutex_lock(&m_Lock);
+  pWorker->bBusy = false;
+  g_cond_broadcast(&m_Idle);
+  g_mutex_unlock(&m_Lock);
+
+  m_Dispatch();
+}
+
+/*! \fn void CIconDecoderPool::m_Restart(ICON_DECODER_WORKER *pWorker, gint nStatus, const gchar *fullName)
+    \brief To kill a worker which timed out or crashed on a file, it is started again at its next file.
+
+    \param[in] pWorker. The busy worker.
+    \param[in] nStatus. ICON_DECODER_TimedOut or ICON_DECODER_Crashed.
+    \param[in] fullName. The icon file.
+    \return NONE
+*/
+void CIconDecoderPool::m_Restart(ICON_DECODER_WORKER *pWorker, gint nStatus, const gchar *fullName)
+{
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - The decoder worker %s on %s, it is restarted \n", __FUNCTION__, __LINE__,
+         (nStatus == ICON_DECODER_TimedOut) ? "timed out" : "crashed", fullName);
+  #endif
+
+  m_Stop(pWorker);
+  g_atomic_int_inc( (nStatus == ICON_DECODER_TimedOut) ? &m_nTimeouts : &m_nCrashes );
+  g_atomic_int_inc(&m_nRestarts);
+}
+
+/*! \fn gboolean CIconDecoderPool::m_SendRequest(ICON_DECODER_WORKER *pWorker, const gchar *fullName, gint size, gint memfd, gsize length)
+    \brief To send a running worker the request of one file.
+
+    \param[in] pWorker. The busy worker.
+    \param[in] fullName. The icon file.
+    \param[in] size. The thumbnail size in device pixels.
+    \param[in] memfd. The contents of the file, -1 to have the worker read it. It stays open.
+    \param[in] length. The number of bytes of the contents.
+    \return TRUE or FALSE
+*/
+gboolean CIconDecoderPool::m_SendRequest(ICON_DECODER_WORKER *pWorker, const gchar *fullName, gint size, gint memfd, gsize length)
+{
+  guint32 request[4] = { ICON_DECODER_MAGIC, (guint32)size, (guint32)strlen(fullName), (memfd >= 0) ? (guint32)length : 0 };
+
+  return send_with_fd(pWorker->fd, request, sizeof(request), memfd) && write_all(pWorker->fd, fullName, request[2]);
+}
+
+/*! \fn gint CIconDecoderPool::m_ReadReply(ICON_DECODER_WORKER *pWorker, gint64 nDeadline, GdkPixbuf **ppPixbuf)
+    \brief To wait for the reply of a worker, and map the thumbnail it made.
+
+    \param[in] pWorker. The busy worker a request was sent to.
+    \param[in] nDeadline. The monotonic time(in microsecond) the reply is due by.
+    \param[out] ppPixbuf. The thumbnail, it must be unreferenced. NULL if it could not be decoded.
+    \return The ICON_DECODER_STATUS. ICON_DECODER_Unavailable if the thumbnail could not be mapped.
+*/
+gint CIconDecoderPool::m_ReadReply(ICON_DECODER_WORKER *pWorker, gint64 nDeadline, GdkPixbuf **ppPixbuf)
+{
+  guint32 reply[ICON_DECODER_REPLY_WORDS];
+  gboolean bTimedOut = false;
+  gint memfd = -1;
+
+  *ppPixbuf = NULL;
+
+  if( !recv_with_fd(pWorker->fd, reply, sizeof(reply), &memfd, nDeadline, &bTimedOut) )
+  {
+     if(memfd >= 0)
+       close(memfd);
+
+     return bTimedOut ? ICON_DECODER_TimedOut : ICON_DECODER_Crashed;
+  }
+
+  return m_MapReply(reply, memfd, ppPixbuf);
+}
+
+/*! \fn gint CIconDecoderPool::m_MapReply(const guint32 *reply, gint memfd, GdkPixbuf **ppPixbuf)
+    \brief To check a whole reply of a worker, and map the thumbnail it made.
+    \n The memfd must be sealed against writing and resizing, and hold all the pixels, or a worker could change or
+    cut the pixels under the dialog, reading past the end of a memfd raises SIGBUS.
+
+    \param[in] reply. The ICON_DECODER_REPLY_WORDS words of the reply.
+    \param[in] memfd. The memfd passed along the reply, -1 if none was. It is closed.
+    \param[out] ppPixbuf. The thumbnail, it must be unreferenced. NULL if it could not be decoded.
+    \return The ICON_DECODER_STATUS. ICON_DECODER_Unavailable if the thumbnail could not be mapped.
+*/
+gint CIconDecoderPool::m_MapReply(const guint32 *reply, gint memfd, GdkPixbuf **ppPixbuf)
+{
+  guint32 width = 0, height = 0, rowstride = 0, hasAlpha = 0, length = 0;
+  struct stat st;
+  guchar *pixels = NULL;
+  gint nSeals = 0;
+
+  *ppPixbuf = NULL;
+
+  if( (reply[0] != ICON_DECODER_MAGIC) || ((reply[1] == ICON_DECODER_Done) && (memfd < 0)) )
+  {
+     if(memfd >= 0)
+       close(memfd);
+
+     return ICON_DECODER_Crashed;
+  }
+
+  if(reply[1] != ICON_DECODER_Done)
+  {
+     if(memfd >= 0)
+       close(memfd);
+
+     return ICON_DECODER_Failed;
+  }
+
+  width = reply[2];
+  height = reply[3];
+  rowstride = reply[4];
+  hasAlpha = reply[5];
+  length = reply[8];
+  nSeals = fcntl(memfd, F_GET_SEALS);
+
+  if( (width == 0) || (height == 0) || (width > ICON_DECODER_MAX_SIDE) || (height > ICON_DECODER_MAX_SIDE) ||
+      (rowstride < width * (hasAlpha ? 4 : 3)) || (length < (guint64)rowstride * height) ||
+      (nSeals < 0) || ((nSeals & ICON_DECODER_REPLY_SEALS) != ICON_DECODER_REPLY_SEALS) ||
+      (fstat(memfd, &st) != 0) || ((guint64)st.st_size < length) )
+  {
+     close(memfd);
+     return ICON_DECODER_Crashed;
+  }
+
+  /* Private: the dialog may draw on the thumbnail, the worker's pages are copied only then. */
+  pixels = (guchar*)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, memfd, 0);
+  close(memfd);
+
+  if(pixels == MAP_FAILED)
+    return ICON_DECODER_Unavailable;
+
+  *ppPixbuf = gdk_pixbuf_new_from_data(pixels, GDK_COLORSPACE_RGB, hasAlpha != 0, 8, width, height, rowstride,
+                                       cb_unmap_pixels, GSIZE_TO_POINTER(length));
+
+  g_object_set_data(G_OBJECT(*ppPixbuf), ICON_DATA_WIDTH, GINT_TO_POINTER(reply[6]));
+  g_object_set_data(G_OBJECT(*ppPixbuf), ICON_DATA_HEIGHT, GINT_TO_POINTER(reply[7]));
+
+  return ICON_DECODER_Done;
+}
+
+/*! \fn GdkPixbuf* CIconDecoderPool::m_Decode(const gchar *fullName, const guchar *data, gsize length, gint size, gint *pStatus)
+    \brief To decode an icon file by a free worker, or wait for one. A worker which times out or dies is killed.
+
+    \param[in] fullName. The icon file.
+    \param[in] data. The file contents read by the caller, NULL to have the worker read the file.
+    \param[in] length. The number of bytes of the contents.
+    \param[in] size. The thumbnail size in device pixels.
+    \param[out] pStatus. The ICON_DECODER_STATUS, could be NULL.
+    \return The thumbnail, it must be unreferenced. NULL if it could not be decoded.
+*/
+GdkPixbuf* CIconDecoderPool::m_Decode(const gchar *fullName, const guchar *data, gsize length, gint size, gint *pStatus)
+{
+  ICON_DECODER_WORKER *pWorker = NULL;
+  GdkPixbuf *pixbuf = NULL;
+  gint nStatus = ICON_DECODER_Failed;
+  gint memfd = -1;
+
+  if( !fullName || (size <= 0) || (strlen(fullName) >= ICON_DECODER_MAX_NAME) )
+  {
+     if(pStatus)
+       *pStatus = nStatus;
+
+     return NULL;
+  }
+
+  memfd = new_contents_memfd(data, length);
+
+  /* The last worker is only taken here, the jobs of m_DecodeAsync() never hold all of them. */
+  g_mutex_lock(&m_Lock);
+  while( (pWorker = m_TakeIdle(m_nWorkers + 1)) == NULL )
+    g_cond_wait(&m_Idle, &m_Lock);
+  g_mutex_unlock(&m_Lock);
+
+  /* A worker may have died between two files, e.g. killed by the user. The file is not blamed for it, it is sent
+     once more to a new worker. */
+  for(gint nTry=0; nTry<2; nTry++)
+  {
+     if( (pWorker->pid == 0) && !m_Start(pWorker) )
+     {
+        nStatus = ICON_DECODER_Unavailable;
+        break;
+     }
+
+     if( m_SendRequest(pWorker, fullName, size, memfd, length) )
+     {
+        nStatus = m_ReadReply(pWorker, g_get_monotonic_time() + (gint64)m_nTimeout * 1000, &pixbuf);
+        break;
+     }
+
+     nStatus = ICON_DECODER_Unavailable;
+     m_Stop(pWorker);
+  }
+
+  if( (nStatus == ICON_DECODER_TimedOut) || (nStatus == ICON_DECODER_Crashed) )
+    m_Restart(pWorker, nStatus, fullName);
+
+  if(memfd >= 0)
+    close(memfd);
+
+  m_Release(pWorker);
+
+  if(pStatus)
+    *pStatus = nStatus;
+
+  return pixbuf;
+}
+
+/*! \fn ICON_DECODER_JOB* CIconDecoderPool::m_DecodeAsync(const gchar *fullName, const guchar *data, gsize length, gint size, ICON_DECODER_DONE_FUNC pfnDone, gpointer userData)
+    \brief To have an icon file decoded by a free worker, or queue it until one is free, without waiting.
+    \n The workers decode their files in parallel, each reply is read by the main loop when its socket is readable.
+
+    \param[in] fullName. The icon file.
+    \param[in] data. The file contents read by the caller, NULL to have the worker read the file. They are copied.
+    \param[in] length. The number of bytes of the contents.
+    \param[in] size. The thumbnail size in device pixels.
+    \param[in] pfnDone. The callback function, called on the main loop.
+    \param[in] userData. The data of the callback function.
+    \return The job, to be passed to m_Cancel() before pfnDone is called. NULL if no worker could be started.
+*/
+ICON_DECODER_JOB* CIconDecoderPool::m_DecodeAsync(const gchar *fullName, const guchar *data, gsize length, gint size,
+                                                  ICON_DECODER_DONE_FUNC pfnDone, gpointer userData)
+{
+  ICON_DECODER_WORKER *pWorker = NULL;
+  ICON_DECODER_JOB *pJob = NULL;
+
+  if( !fullName || (size <= 0) || (strlen(fullName) >= ICON_DECODER_MAX_NAME) )
+    return NULL;
+
+  pJob = g_new0(ICON_DECODER_JOB, 1);
+  pJob->pPool = this;
+  pJob->fullName = g_strdup(fullName);
+  pJob->size = size;
+  pJob->memfd = new_contents_memfd(data, length);
+  pJob->length = (pJob->memfd >= 0) ? length : 0;
+  pJob->replyFd = -1;
+  pJob->pfnDone = pfnDone;
+  pJob->userData = userData;
+
+  /* The job keeps the pool until it is done, even if the catalog replaced it meanwhile. */
+  m_Ref();
+
+  g_mutex_lock(&m_Lock);
+  pWorker = m_TakeIdle(m_nWorkers);
+  if(pWorker == NULL)
+    g_queue_push_tail(m_pPending, pJob);
+  g_mutex_unlock(&m_Lock);
+
+  if( pWorker && !m_SendJob(pWorker, pJob) )
+  {
+     m_FreeJob(pJob);
+     m_Release(pWorker);
+     m_Unref();
+     return NULL;
+  }
+
+  return pJob;
+}
+
+/*! \fn gboolean CIconDecoderPool::m_SendJob(ICON_DECODER_WORKER *pWorker, ICON_DECODER_JOB *pJob)
+    \brief To send a job to a worker, and watch its socket and the timeout on the main loop.
+    \n The sources are made before they are attached, the main loop could not run one without the other.
+
+    \param[in] pWorker. The busy worker, it is started if it is not running.
+    \param[in] pJob. The job.
+    \return TRUE or FALSE if no worker could be started.
+*/
+gboolean CIconDecoderPool::m_SendJob(ICON_DECODER_WORKER *pWorker, ICON_DECODER_JOB *pJob)
+{
+  for(gint nTry=0; nTry<2; nTry++)
+  {
+     if( (pWorker->pid == 0) && !m_Start(pWorker) )
+       return false;
+
+     if( m_SendRequest(pWorker, pJob->fullName, pJob->size, pJob->memfd, pJob->length) )
+     {
+        pJob->pWorker = pWorker;
+        pJob->nDeadline = g_get_monotonic_time() + (gint64)m_nTimeout * 1000;
+
+        /* The worker holds the contents now. */
+        if(pJob->memfd >= 0)
+          close(pJob->memfd);
+        pJob->memfd = -1;
+
+        pJob->pWatch = g_io_create_watch(pWorker->channel, (GIOCondition)(G_IO_IN | G_IO_HUP | G_IO_ERR));
+        g_source_set_callback(pJob->pWatch, (GSourceFunc)cb_job_reply, pJob, NULL);
+
+        pJob->pTimer = g_timeout_source_new(m_nTimeout);
+        g_source_set_callback(pJob->pTimer, cb_job_timeout, pJob, NULL);
+
+        g_source_attach(pJob->pTimer, NULL);
+        g_source_attach(pJob->pWatch, NULL);
+        return true;
+     }
+
+     m_Stop(pWorker);
+  }
+
+  return false;
+}
+
+/*! \fn void CIconDecoderPool::m_Dispatch(void)
+    \brief To send the jobs waiting to the free workers. A job no worker could be started for ends on the main loop.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconDecoderPool::m_Dispatch(void)
+{
+  while(true)
+  {
+     ICON_DECODER_WORKER *pWorker = NULL;
+     ICON_DECODER_JOB *pJob = NULL;
+
+     g_mutex_lock(&m_Lock);
+     if( !g_queue_is_empty(m_pPending) && ((pWorker = m_TakeIdle(m_nWorkers)) != NULL) )
+       pJob = (ICON_DECODER_JOB*)g_queue_pop_head(m_pPending);
+     g_mutex_unlock(&m_Lock);
+
+     if(pJob == NULL)
+       return;
+
+     if( !m_SendJob(pWorker, pJob) )
+     {
+        g_mutex_lock(&m_Lock);
+        pWorker->bBusy = false;
+        g_cond_broadcast(&m_Idle);
+        g_mutex_unlock(&m_Lock);
+
+        g_idle_add(cb_job_unavailable, pJob);
+     }
+  }
+}
+
+/*! \fn void CIconDecoderPool::m_FinishJob(ICON_DECODER_JOB *pJob, GdkPixbuf *pixbuf, gint nStatus)
+    \brief To end a job on the main loop: its worker takes the next job, then the callback gets the thumbnail.
+
+    \param[in] pJob. The job, it is freed.
+    \param[in] pixbuf. The thumbnail, NULL if it could not be decoded. It is given to the callback.
+    \param[in] nStatus. The ICON_DECODER_STATUS.
+    \return NONE
+*/
+void CIconDecoderPool::m_FinishJob(ICON_DECODER_JOB *pJob, GdkPixbuf *pixbuf, gint nStatus)
+{
+  if(pJob->pWorker)
+    m_Release(pJob->pWorker);
+
+  pJob->pWorker = NULL;
+
+  if( !pJob->bCancelled && pJob->pfnDone )
+    pJob->pfnDone(pixbuf, nStatus, pJob->userData);
+  else if(pixbuf)
+    g_object_unref(pixbuf);
+
+  m_FreeJob(pJob);
+
+  /* The last reference may be the job's, the pool is not used after it. */
+  m_Unref();
+}
+
+/*! \fn gboolean CIconDecoderPool::m_OnReply(ICON_DECODER_JOB *pJob)
+    \brief The socket of a job's worker is readable: a piece of the reply came, or the worker died.
+    \n Only what the socket has is read, the job waits for the rest of the reply on the main loop.
+
+    \param[in] pJob. The job.
+    \return FALSE to remove the watch, TRUE while the reply is not complete.
+*/
+gboolean CIconDecoderPool::m_OnReply(ICON_DECODER_JOB *pJob)
+{
+  GdkPixbuf *pixbuf = NULL;
+  gint nStatus = ICON_DECODER_Crashed;
+  ssize_t n = recv_once(pJob->pWorker->fd, (guchar*)pJob->reply + pJob->nReplyBytes,
+                        sizeof(pJob->reply) - pJob->nReplyBytes, &pJob->replyFd, MSG_DONTWAIT);
+
+  if( (n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)) )
+    return true;
+
+  if(n > 0)
+    pJob->nReplyBytes += n;
+
+  if( (n > 0) && (pJob->nReplyBytes < sizeof(pJob->reply)) )
+    return true;
+
+  /* A closed socket or an error before the whole reply came: the worker died. */
+  if(n > 0)
+  {
+     nStatus = m_MapReply(pJob->reply, pJob->replyFd, &pixbuf);
+     pJob->replyFd = -1;
+  }
+
+  g_source_destroy(pJob->pTimer);
+
+  if( (nStatus == ICON_DECODER_TimedOut) || (nStatus == ICON_DECODER_Crashed) )
+    m_Restart(pJob->pWorker, nStatus, pJob->fullName);
+
+  m_FinishJob(pJob, pixbuf, nStatus);
+
+  return false;
+}
+
+/*! \fn gboolean CIconDecoderPool::m_OnTimeout(ICON_DECODER_JOB *pJob)
+    \brief A job's worker took too long, it is killed.
+
+    \param[in] pJob. The job.
+    \return FALSE to remove the timeout.
+*/
+gboolean CIconDecoderPool::m_OnTimeout(ICON_DECODER_JOB *pJob)
+{
+  g_source_destroy(pJob->pWatch);
+
+  m_Restart(pJob->pWorker, ICON_DECODER_TimedOut, pJob->fullName);
+  m_FinishJob(pJob, NULL, ICON_DECODER_TimedOut);
+
+  return false;
+}
+
+/*! \fn void CIconDecoderPool::m_Cancel(ICON_DECODER_JOB *pJob)
+    \brief To drop a job of m_DecodeAsync(). A job sent to a worker is still waited for, only its reply is dropped.
+
+    \param[in] pJob. The job, its callback was not called yet.
+    \return NONE
+*/
+void CIconDecoderPool::m_Cancel(ICON_DECODER_JOB *pJob)
+{
+  gboolean bPending = false;
+
+  g_mutex_lock(&m_Lock);
+  bPending = g_queue_remove(m_pPending, pJob);
+  g_mutex_unlock(&m_Lock);
+
+  if(!bPending)
+  {
+     pJob->bCancelled = true;
+     return;
+  }
+
+  m_FreeJob(pJob);
+  m_Unref();
+}
+
+/*! \fn void CIconDecoderPool::m_FreeJob(ICON_DECODER_JOB *pJob)
+    \brief To free a job. Its sources are destroyed already, or were never attached.
+
+    \param[in] pJob. The job.
+    \return NONE
+*/
+void CIconDecoderPool::m_FreeJob(ICON_DECODER_JOB *pJob)
+{
+  if(pJob->memfd >= 0)
+    close(pJob->memfd);
+
+  if(pJob->replyFd >= 0)
+    close(pJob->replyFd);
+
+  if(pJob->pWatch)
+    g_source_unref(pJob->pWatch);
+
+  if(pJob->pTimer)
+    g_source_unref(pJob->pTimer);
+
+  g_free(pJob->fullName);
+  g_free(pJob);
+}
+
+/*! \fn gboolean CIconDecoderPool::cb_job_reply(GIOChannel *channel, GIOCondition condition, gpointer data)
+    \brief The callback function of the watch of a worker's socket.
+
+    \param[in] channel. The socket.
+    \param[in] condition. G_IO_IN, or G_IO_HUP/G_IO_ERR if the worker died.
+    \param[in] data. The ICON_DECODER_JOB.
+    \return FALSE to remove the watch.
+*/
+gboolean CIconDecoderPool::cb_job_reply(GIOChannel *channel, GIOCondition condition, gpointer data)
+{
+  ICON_DECODER_JOB *pJob = (ICON_DECODER_JOB*)data;
+
+  return pJob->pPool->m_OnReply(pJob);
+}
+
+/*! \fn gboolean CIconDecoderPool::cb_job_timeout(gpointer data)
+    \brief The callback function of the timeout of a job.
+
+    \param[in] data. The ICON_DECODER_JOB.
+    \return FALSE to remove the timeout.
+*/
+gboolean CIconDecoderPool::cb_job_timeout(gpointer data)
+{
+  ICON_DECODER_JOB *pJob = (ICON_DECODER_JOB*)data;
+
+  return pJob->pPool->m_OnTimeout(pJob);
+}
+
+/*! \fn gboolean CIconDecoderPool::cb_job_unavailable(gpointer data)
+    \brief The idle callback function to end a job no worker could be started for, on the main loop.
+
+    \param[in] data. The ICON_DECODER_JOB.
+    \return FALSE to be called once.
+*/
+gboolean CIconDecoderPool::cb_job_unavailable(gpointer data)
+{
+  ICON_DECODER_JOB *pJob = (ICON_DECODER_JOB*)data;
+
+  pJob->pPool->m_FinishJob(pJob, NULL, ICON_DECODER_Unavailable);
+
+  return false;
+}
+
+/*! \fn static GdkPixbuf* decode_member(CIconArchive **ppArchive, const gchar *fullName, gint size)
+    \brief Worker side: to decode an archive member. The last archive is kept open, its members usually come in a row.
+
+    \param[in,out] ppArchive. The archive kept open by the worker, NULL if none is.
+    \param[in] fullName. The full name of the member, "archive!/member".
+    \param[in] size. The wanted size of the icon.
+    \return GdkPixbuf object for the icon, NULL if it could not be decoded. It must be unreferenced.
+*/
+static GdkPixbuf* decode_member(CIconArchive **ppArchive, const gchar *fullName, gint size)
+{
+  gchar *archiveName = NULL;
+  const gchar *memberName = NULL;
+  const ICON_ARCHIVE_MEMBER *pMember = NULL;
+  GdkPixbuf *pixbuf = NULL;
+
+  if( !CIconArchive::m_SplitMemberName(fullName, &archiveName, &memberName) )
+    return NULL;
+
+  if( *ppArchive && ((strcmp((*ppArchive)->m_GetFileName(), archiveName) != 0) || !(*ppArchive)->m_IsCurrent()) )
+  {
+     (*ppArchive)->m_Unref();
+     *ppArchive = NULL;
+  }
+
+  if(*ppArchive == NULL)
+  {
+     *ppArchive = new CIconArchive(archiveName);
+     if( !(*ppArchive)->m_Open(CIconCatalog::m_IsIconFile) )
+     {
+        (*ppArchive)->m_Unref();
+        *ppArchive = NULL;
+     }
+  }
+
+  if(*ppArchive)
+    pMember = (*ppArchive)->m_Lookup(memberName);
+
+  if(pMember)
+    pixbuf = CIconCatalog::m_DecodeMember(*ppArchive, pMember, size);
+
+  g_free(archiveName);
+
+  return pixbuf;
+}
+
+/*! \fn int CIconDecoderPool::m_RunWorker(gint fd)
+    \brief Worker side: to decode the files requested on a socket into memfds, until the socket is closed.
+    \n The file is decoded from the contents passed along the request if there are, otherwise it is read here.
+
+    \param[in] fd. The socket, the standard input of a worker.
+    \return The exit code of the worker, 0 when the pool closed the socket.
+*/
+int CIconDecoderPool::m_RunWorker(gint fd)
+{
+  CIconArchive *pArchive = NULL;
+  gint nExit = 0;
+
+  while(true)
+  {
+     guint32 request[4] = { 0, 0, 0, 0 };
+     guint32 reply[ICON_DECODER_REPLY_WORDS];
+     ICON_FILE_BUFFER buffer;
+     GdkPixbuf *pixbuf = NULL;
+     gchar *fullName = NULL;
+     gint memfd = -1, contentsFd = -1;
+     gboolean bSent = false, bTimedOut = false;
+
+     /* The contents the dialog read come along the request, the worker waits for the next one as long as it takes. */
+     if( !recv_with_fd(fd, request, sizeof(request), &contentsFd, -1, &bTimedOut) )
+       break;
+
+     if( (request[0] != ICON_DECODER_MAGIC) || (request[2] == 0) || (request[2] >= ICON_DECODER_MAX_NAME) ||
+         ((request[3] > 0) && (contentsFd < 0)) )
+     {
+        if(contentsFd >= 0)
+          close(contentsFd);
+
+        nExit = 1;
+        break;
+     }
+
+     fullName = (gchar*)g_malloc0(request[2] + 1);
+     if( !read_all(fd, fullName, request[2]) )
+     {
+        if(contentsFd >= 0)
+          close(contentsFd);
+
+        g_free(fullName);
+        nExit = 1;
+        break;
+     }
+
+     /* The pool kills a worker which takes too long, this ends it as well if the pool is gone. */
+     alarm(ICON_DECODER_WORKER_ALARM);
+
+     memset(&buffer, 0x00, sizeof(buffer));
+     buffer.fullName = fullName;
+
+     if(request[3] > 0)
+     {
+        struct stat st;
+        guchar *contents = (guchar*)MAP_FAILED;
+
+        /* The contents are only mapped if the memfd holds them, reading past its end raises SIGBUS. */
+        if( (fstat(contentsFd, &st) == 0) && ((guint64)st.st_size >= request[3]) )
+          contents = (guchar*)mmap(NULL, request[3], PROT_READ, MAP_PRIVATE, contentsFd, 0);
+
+        if(contents != MAP_FAILED)
+        {
+           pixbuf = CIconCatalog::m_DecodeBuffer(contents, request[3], request[1]);
+           munmap(contents, request[3]);
+        }
+     }
+     else if( CIconArchive::m_IsMemberName(fullName) )
+       pixbuf = decode_member(&pArchive, fullName, request[1]);
+     else
+     {
+        CIconFileReader::m_ReadOne(&buffer);
+
+        if(buffer.error == 0)
+        {
+           if(buffer.data)
+             pixbuf = CIconCatalog::m_DecodeBuffer(buffer.data, buffer.length, request[1]);
+           else
+             pixbuf = CIconCatalog::m_DecodeFile(fullName, buffer.fileSize, request[1]);
+        }
+
+        CIconFileReader::m_FreeBuffer(&buffer);
+     }
+
+     if(contentsFd >= 0)
+       close(contentsFd);
+
+     memset(reply, 0x00, sizeof(reply));
+     reply[0] = ICON_DECODER_MAGIC;
+     reply[1] = ICON_DECODER_Failed;
+
+     if( pixbuf && (gdk_pixbuf_get_colorspace(pixbuf) == GDK_COLORSPACE_RGB) && (gdk_pixbuf_get_bits_per_sample(pixbuf) == 8) )
+     {
+        gint width = gdk_pixbuf_get_width(pixbuf);
+        gint height = gdk_pixbuf_get_height(pixbuf);
+        gboolean hasAlpha = gdk_pixbuf_get_has_alpha(pixbuf);
+        gint rowstride = (width * (hasAlpha ? 4 : 3) + 3) & ~3;
+        gsize length = (gsize)rowstride * height;
+        guchar *pixels = (guchar*)MAP_FAILED;
+
+        /* The loader made the thumbnail in its own pixbuf, it is copied once into the pages the dialog maps. */
+        memfd = memfd_create("iconchooser-thumbnail", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if( (memfd >= 0) && (ftruncate(memfd, length) == 0) )
+          pixels = (guchar*)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+
+        if(pixels != MAP_FAILED)
+        {
+           GdkPixbuf *shared = gdk_pixbuf_new_from_data(pixels, GDK_COLORSPACE_RGB, hasAlpha, 8, width, height, rowstride, NULL, NULL);
+
+           gdk_pixbuf_copy_area(pixbuf, 0, 0, width, height, shared, 0, 0);
+           g_object_unref(shared);
+           munmap(pixels, length);
+        }
+
+        /* The dialog maps only a sealed memfd, the seal of writing needs the writable mapping gone. */
+        if( (pixels != MAP_FAILED) && (fcntl(memfd, F_ADD_SEALS, ICON_DECODER_REPLY_SEALS) == 0) )
+        {
+           reply[1] = ICON_DECODER_Done;
+           reply[2] = width;
+           reply[3] = height;
+           reply[4] = rowstride;
+           reply[5] = hasAlpha;
+           reply[6] = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pixbuf), ICON_DATA_WIDTH));
+           reply[7] = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(pixbuf), ICON_DATA_HEIGHT));
+           reply[8] = length;
+        }
+        else if(memfd >= 0)
+        {
+           close(memfd);
+           memfd = -1;
+        }
+     }
+
+     alarm(0);
+
+     bSent = send_with_fd(fd, reply, sizeof(reply), memfd);
+
+     if(memfd >= 0)
+       close(memfd);
+
+     if(pixbuf)
+       g_object_unref(pixbuf);
+
+     g_free(fullName);
+
+     if(!bSent)
+     {
+        nExit = 1;
+        break;
+     }
+  }
+
+  if(pArchive)
+    pArchive->m_Unref();
+
+  return nExit;
+}
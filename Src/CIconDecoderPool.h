@@ -0,0 +1,183 @@
+/*! \file    CIconDecoderPool.h
+    \brief   Declaration of class CIconDecoderPool.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONDECODERPOOL
+#define __CICONDECODERPOOL
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* The program the workers run by default, the dedicated worker "iconchooser-decoder". The Makefile sets where it
+   is built or installed. It must handle ICON_DECODER_WORKER_ARG. */
+#ifndef ICON_DECODER_DEFAULT_PROGRAM
+#define ICON_DECODER_DEFAULT_PROGRAM  "/usr/libexec/iconchooser-decoder"
+#endif
+#define ICON_DECODER_WORKER_ARG       "--decode-worker"
+
+/* The worker processes of a pool by default. */
+#define ICON_DECODER_WORKERS  2
+
+/* How long a worker may take for one file before it is killed and restarted. The unit is "millisecond". */
+#define ICON_DECODER_TIMEOUT_MSEC  2000
+
+/* A worker kills itself if one file takes this long, e.g. after the dialog died. The unit is "second". */
+#define ICON_DECODER_WORKER_ALARM  10
+
+/* The address space of a worker, a decoder allocating more fails instead of swapping the machine. */
+#define ICON_DECODER_WORKER_MEMORY  (512 * 1024 * 1024)
+
+/* The magic number of the requests and replies. */
+#define ICON_DECODER_MAGIC  0x44434349   /* "ICCD" */
+
+/* The words of a reply: magic, status, width, height, rowstride, has-alpha, original width, original height, length. */
+#define ICON_DECODER_REPLY_WORDS  9
+
+/* The largest thumbnail taken from a worker, in pixels of a side. */
+#define ICON_DECODER_MAX_SIDE  4096
+
+/*! \enum ICON_DECODER_STATUS
+    \brief The result of a decoding by a worker.
+*/
+enum ICON_DECODER_STATUS {
+  ICON_DECODER_Done = 0,      /* The thumbnail was made. */
+  ICON_DECODER_Failed,        /* The worker could not read or decode the file. */
+  ICON_DECODER_TimedOut,      /* The worker took too long, it was killed. */
+  ICON_DECODER_Crashed,       /* The worker died or answered nonsense. */
+  ICON_DECODER_Unavailable    /* No worker could be started, the file must be decoded in the process. */
+};
+
+/*! \typedef ICON_DECODER_DONE_FUNC
+    \brief The callback function type of CIconDecoderPool::m_DecodeAsync(), called on the main loop.
+    The thumbnail must be unreferenced, NULL if it could not be decoded. nStatus is the ICON_DECODER_STATUS.
+*/
+typedef void (*ICON_DECODER_DONE_FUNC)(GdkPixbuf *pixbuf, gint nStatus, gpointer userData);
+
+/*! \struct ICON_DECODER_WORKER
+    \brief One worker process and the socket it is fed by.
+*/
+typedef struct _ICON_DECODER_WORKER
+{
+  GPid   pid;            /*!< The worker process, 0 if it is not running. */
+  gint   fd;             /*!< The socket to the worker, -1 if it is not running. */
+  GIOChannel *channel;   /*!< The socket watched by the main loop for the replies of m_DecodeAsync(). */
+  gboolean bBusy;        /*!< To indicate if the worker is decoding a file, protected by the pool's lock. */
+} ICON_DECODER_WORKER;
+
+class CIconDecoderPool;
+
+/*! \struct ICON_DECODER_JOB
+    \brief A file decoded by m_DecodeAsync(), waiting for a worker or for its reply.
+*/
+typedef struct _ICON_DECODER_JOB
+{
+  CIconDecoderPool *pPool;         /*!< The pool, referenced until the job is done. */
+  ICON_DECODER_WORKER *pWorker;    /*!< The worker decoding it, NULL while it waits for one. */
+  gchar *fullName;                 /*!< The icon file. */
+  gint size;                       /*!< The thumbnail size in device pixels. */
+  gint memfd;                      /*!< The contents read by the caller, -1 to have the worker read the file. */
+  gsize length;                    /*!< The bytes of the contents. */
+  gint64 nDeadline;                /*!< The monotonic time(in microsecond) the reply is due by. */
+  GSource *pWatch;                 /*!< The watch of the worker's socket, NULL while it waits for a worker. */
+  GSource *pTimer;                 /*!< The timeout of the reply, NULL while it waits for a worker. */
+  gboolean bCancelled;             /*!< The reply is dropped, the callback is not called. */
+  guint32 reply[ICON_DECODER_REPLY_WORDS];  /*!< The reply read so far, it may come in several pieces. */
+  gsize nReplyBytes;               /*!< The bytes of "reply" read. */
+  gint replyFd;                    /*!< The memfd of the pixels passed along the reply, -1 until it came. */
+  ICON_DECODER_DONE_FUNC pfnDone;  /*!< The callback function. */
+  gpointer userData;               /*!< The data of the callback function. */
+} ICON_DECODER_JOB;
+
+/*! \class CIconDecoderPool
+    \brief Decodes icon files in worker processes, so a malicious or pathological image costs one timeout instead
+           of a frozen or dead dialog.
+
+    The workers are started at their first file, as ICON_DECODER_DEFAULT_PROGRAM ICON_DECODER_WORKER_ARG with a UNIX
+    socket as their standard input, and limited to ICON_DECODER_WORKER_MEMORY. The request is the magic number, the
+    thumbnail size, the length of the full file name and of the contents, then the name. The contents the caller
+    already read go along in a memfd, otherwise the worker reads the file itself, chunk by chunk if it is
+    large, and an archive member's "archive!/member" from the archive.
+    The reply is the magic number, the status, the width, height, rowstride, has-alpha, the original width and
+    height and the pixel data length, with a memfd holding the pixels passed along. The worker copies the
+    thumbnail the loader made into the memfd once and seals it against writing and resizing, the caller maps it
+    without another copy only if it is sealed and holds the pixels.
+    A worker which times out or dies is killed and started again at the next file.
+    m_DecodeAsync() keeps one file on each of nWorkers workers at once and queues the others, the replies are read
+    by the main loop as far as they came, without waiting for the rest. m_Decode() blocks, it may be called from any thread; one more worker is left to it, so a
+    caller on the main loop never waits for a worker only the main loop could free.
+*/
+class CIconDecoderPool
+{
+  private:
+    gchar *m_Program;                 /*!< The program the workers run. */
+    ICON_DECODER_WORKER *m_pWorkers;  /*!< The workers, m_nWorkers of them for m_DecodeAsync() and one more for m_Decode(). */
+    gint m_nWorkers;                  /*!< The number of workers of m_DecodeAsync(). */
+    gint m_nNext;                     /*!< The worker tried first by the next file. */
+    GMutex m_Lock;                    /*!< Protect the bBusy of the workers, m_nNext and m_pPending. */
+    GCond m_Idle;                     /*!< Signalled when a worker is done with a file. */
+    GQueue *m_pPending;               /*!< The ICON_DECODER_JOB waiting for a worker. */
+    gint m_nTimeout;                  /*!< The timeout of one file, in millisecond. */
+    gint m_nTimeouts;                 /*!< The files which timed out. */
+    gint m_nCrashes;                  /*!< The files a worker died on. */
+    gint m_nRestarts;                 /*!< The workers started again after a timeout or a crash. */
+    gint m_nRef;                      /*!< The reference count, a decoding in progress keeps the pool. */
+
+    gboolean m_Start(ICON_DECODER_WORKER *pWorker);
+    void m_Stop(ICON_DECODER_WORKER *pWorker);
+    ICON_DECODER_WORKER* m_TakeIdle(gint nWorkers);
+    void m_Release(ICON_DECODER_WORKER *pWorker);
+    void m_Restart(ICON_DECODER_WORKER *pWorker, gint nStatus, const gchar *fullName);
+    gboolean m_SendRequest(ICON_DECODER_WORKER *pWorker, const gchar *fullName, gint size, gint memfd, gsize length);
+    gint m_ReadReply(ICON_DECODER_WORKER *pWorker, gint64 nDeadline, GdkPixbuf **ppPixbuf);
+    static gint m_MapReply(const guint32 *reply, gint memfd, GdkPixbuf **ppPixbuf);
+    gboolean m_SendJob(ICON_DECODER_WORKER *pWorker, ICON_DECODER_JOB *pJob);
+    void m_Dispatch(void);
+    void m_FinishJob(ICON_DECODER_JOB *pJob, GdkPixbuf *pixbuf, gint nStatus);
+    gboolean m_OnReply(ICON_DECODER_JOB *pJob);
+    gboolean m_OnTimeout(ICON_DECODER_JOB *pJob);
+
+    static void m_FreeJob(ICON_DECODER_JOB *pJob);
+    static void cb_child_setup(gpointer data);
+    static gboolean cb_job_reply(GIOChannel *channel, GIOCondition condition, gpointer data);
+    static gboolean cb_job_timeout(gpointer data);
+    static gboolean cb_job_unavailable(gpointer data);
+
+  public:
+    /* The workers run "program ICON_DECODER_WORKER_ARG", NULL for ICON_DECODER_DEFAULT_PROGRAM. */
+    CIconDecoderPool(const gchar *program, gint nWorkers);
+    ~CIconDecoderPool();
+
+    /* A pool created by new is deleted with its last reference. m_DecodeAsync() needs one created by new. */
+    void m_Ref(void) { g_atomic_int_inc(&m_nRef); }
+    void m_Unref(void) { if( g_atomic_int_dec_and_test(&m_nRef) ) delete this; }
+
+    /* To decode an icon file at a size in device pixels, waiting for the reply. It must be unreferenced, NULL if it
+       could not be decoded. data is the contents if the caller read them, NULL to have the worker read the file.
+       pStatus gets the ICON_DECODER_STATUS, could be NULL. */
+    GdkPixbuf* m_Decode(const gchar *fullName, const guchar *data, gsize length, gint size, gint *pStatus);
+
+    /* To decode an icon file without waiting, from the thread of the main loop. pfnDone is called on the main loop
+       with the thumbnail, unless the job is cancelled. NULL if no worker could be started, the file must be
+       decoded in the process then. The job belongs to the pool, it is forgotten once pfnDone is called. */
+    ICON_DECODER_JOB* m_DecodeAsync(const gchar *fullName, const guchar *data, gsize length, gint size,
+                                    ICON_DECODER_DONE_FUNC pfnDone, gpointer userData);
+
+    /* To drop a job of m_DecodeAsync() before its callback is called, from the thread of the main loop. */
+    void m_Cancel(ICON_DECODER_JOB *pJob);
+
+    void m_SetTimeout(gint msec) { if(msec > 0) m_nTimeout = msec; }
+    gint m_GetTimeout(void) { return m_nTimeout; }
+    gint m_GetTimeoutCount(void) { return g_atomic_int_get(&m_nTimeouts); }
+    gint m_GetCrashCount(void) { return g_atomic_int_get(&m_nCrashes); }
+    gint m_GetRestartCount(void) { return g_atomic_int_get(&m_nRestarts); }
+
+    /* Worker side: to decode the files requested on a socket until it is closed. The exit code is returned. */
+    static int m_RunWorker(gint fd);
+};
+#endif   /* CICONDECODERPOOL.H	*/
@@ -0,0 +1,338 @@
+/*! \file    CIconDesktopAudit.cpp
+    \brief   Resolve the Icon= values of all desktop files at once and report the missing, legacy and oversized icons.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include "CIconDesktopAudit.h"
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconDesktopAudit::CIconDesktopAudit(CIconCatalog *pCatalog, const gchar *themeName, gint size)
+    \brief CIconDesktopAudit constructor
+
+    \param[in] pCatalog. The catalog resolving the icons.
+    \param[in] themeName. The theme looked up, NULL for ICON_THEME_FALLBACK.
+    \param[in] size. The icon size asked for.
+*/
+CIconDesktopAudit::CIconDesktopAudit(CIconCatalog *pCatalog, const gchar *themeName, gint size)
+{
+  m_pCatalog = pCatalog;
+  m_ThemeName = g_strdup(themeName ? themeName : ICON_THEME_FALLBACK);
+  m_nSize = (size > 0) ? size : ICON_THUMBNAIL_SIZE;
+  m_pEntries = g_ptr_array_new();
+  m_nNext = 0;
+  m_nCollectUsec = 0;
+  m_nResolveUsec = 0;
+  m_nThreads = 0;
+}
+
+/*! \fn CIconDesktopAudit::~CIconDesktopAudit()
+    \brief CIconDesktopAudit destructor
+*/
+CIconDesktopAudit::~CIconDesktopAudit()
+{
+  m_Clear();
+
+  g_ptr_array_free(m_pEntries, TRUE);
+  g_free(m_ThemeName);
+
+  m_pEntries = NULL;
+  m_ThemeName = NULL;
+}
+
+/*! \fn void CIconDesktopAudit::m_Clear(void)
+    \brief To free the entries of the last audit.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconDesktopAudit::m_Clear(void)
+{
+  for(guint i=0; i<m_pEntries->len; i++)
+  {
+     ICON_AUDIT_ENTRY *entry = (ICON_AUDIT_ENTRY*)g_ptr_array_index(m_pEntries, i);
+
+     g_free(entry->desktopFile);
+     g_free(entry->iconValue);
+     g_free(entry->fullName);
+     g_free(entry);
+  }
+
+  g_ptr_array_set_size(m_pEntries, 0);
+}
+
+/*! \fn void CIconDesktopAudit::m_CollectDirectory(const gchar *dirName, const gchar *prefix, GHashTable *ids)
+    \brief To add the desktop files of a directory and its sub-directories.
+    \n The desktop file ID is the path under the applications directory with '/' replaced by '-', an ID found
+       in an earlier directory shadows the same ID here.
+
+    \param[in] dirName. The directory.
+    \param[in] prefix. The ID prefix of the sub-directory, "" at the top.
+    \param[in,out] ids. The desktop file IDs found so far.
+    \return NONE
+*/
+void CIconDesktopAudit::m_CollectDirectory(const gchar *dirName, const gchar *prefix, GHashTable *ids)
+{
+  GDir *dir = g_dir_open(dirName, 0, NULL);
+  const gchar *baseName = NULL;
+
+  if(!dir)
+    return;
+
+  while( (baseName = g_dir_read_name(dir)) != NULL )
+  {
+     gchar *fullName = g_build_filename(dirName, baseName, NULL);
+     gchar *id = g_strconcat(prefix, baseName, NULL);
+
+     if( g_file_test(fullName, G_FILE_TEST_IS_DIR) )
+     {
+        gchar *subPrefix = g_strconcat(id, "-", NULL);
+
+        m_CollectDirectory(fullName, subPrefix, ids);
+        g_free(subPrefix);
+     }
+     else if( g_str_has_suffix(baseName, ".desktop") && !g_hash_table_lookup(ids, id) )
+     {
+        ICON_AUDIT_ENTRY *entry = g_new0(ICON_AUDIT_ENTRY, 1);
+
+        entry->desktopFile = fullName;
+        fullName = NULL;
+        g_ptr_array_add(m_pEntries, entry);
+
+        g_hash_table_replace(ids, id, GINT_TO_POINTER(1));
+        id = NULL;
+     }
+
+     g_free(fullName);
+     g_free(id);
+  }
+
+  g_dir_close(dir);
+}
+
+/*! \fn void CIconDesktopAudit::m_AuditEntry(ICON_AUDIT_ENTRY *entry)
+    \brief To parse one desktop file and resolve its icon as CIconChooser::m_LoadIcon() does: an absolute file as it is,
+           otherwise the theme, then the legacy icon directories.
+
+    \param[in,out] entry. The entry, its desktop file is set.
+    \return NONE
+*/
+void CIconDesktopAudit::m_AuditEntry(ICON_AUDIT_ENTRY *entry)
+{
+  GKeyFile *keyFile = g_key_file_new();
+  gint64 nStart = g_get_monotonic_time();
+
+  if( !g_key_file_load_from_file(keyFile, entry->desktopFile, G_KEY_FILE_NONE, NULL) )
+    entry->status = ICON_AUDIT_Invalid;
+  /* A hidden entry is a deleted one, it is not shown in the menu. */
+  else if( !g_key_file_get_boolean(keyFile, ICON_AUDIT_DESKTOP_GROUP, "Hidden", NULL) )
+  {
+     entry->iconValue = g_key_file_get_string(keyFile, ICON_AUDIT_DESKTOP_GROUP, "Icon", NULL);
+
+     if(entry->iconValue)
+       g_strstrip(entry->iconValue);
+  }
+
+  if( (entry->status != ICON_AUDIT_Invalid) && (!entry->iconValue || (strlen(entry->iconValue) == 0)) )
+    entry->status = ICON_AUDIT_NoIcon;
+  else if(entry->status != ICON_AUDIT_Invalid)
+  {
+     entry->fullName = m_pCatalog->m_Resolve(entry->iconValue, m_nSize, 1, m_ThemeName);
+
+     if(!entry->fullName)
+       entry->status = ICON_AUDIT_Unresolved;
+     else
+     {
+        GdkPixbufFormat *format = NULL;
+        struct stat st;
+
+        entry->status = ICON_AUDIT_Ok;
+
+        /* An icon name which resolved outside the theme came from the legacy directories, e.g. "pixmaps". */
+        if( !g_path_is_absolute(entry->iconValue) )
+        {
+           gchar *themeFile = m_pCatalog->m_LookupThemeFile(m_ThemeName, entry->iconValue, m_nSize, 1);
+
+           entry->bFallback = (themeFile == NULL);
+           g_free(themeFile);
+        }
+
+        /* Only the header is read for the dimensions. A scalable image is never oversized. */
+        format = gdk_pixbuf_get_file_info(entry->fullName, &entry->width, &entry->height);
+        if( format && !gdk_pixbuf_format_is_scalable(format) )
+          entry->bOversized = (MAX(entry->width, entry->height) > m_nSize * ICON_AUDIT_OVERSIZE_FACTOR);
+
+        if( (stat(entry->fullName, &st) == 0) && (st.st_size > ICON_READ_MAX_BYTES) )
+          entry->bOversized = true;
+     }
+  }
+
+  g_key_file_free(keyFile);
+
+  entry->nUsec = g_get_monotonic_time() - nStart;
+}
+
+/*! \fn gpointer CIconDesktopAudit::m_Worker(gpointer data)
+    \brief The thread function auditing the entries not taken by the other workers.
+*/
+gpointer CIconDesktopAudit::m_Worker(gpointer data)
+{
+  CIconDesktopAudit *thisObject = (CIconDesktopAudit*)data;
+  gint idx = 0;
+
+  while( (idx = g_atomic_int_exchange_and_add(&thisObject->m_nNext, 1)) < (gint)thisObject->m_pEntries->len )
+    thisObject->m_AuditEntry((ICON_AUDIT_ENTRY*)g_ptr_array_index(thisObject->m_pEntries, idx));
+
+  return NULL;
+}
+
+/*! \fn gboolean CIconDesktopAudit::m_Run(const gchar **dirs)
+    \brief To list the desktop files and audit their icons.
+
+    \param[in] dirs. The NULL-terminated list of applications directories in precedence order,
+               NULL for the "applications" directories of the XDG data directories.
+    \return FALSE if no desktop file is found.
+*/
+gboolean CIconDesktopAudit::m_Run(const gchar **dirs)
+{
+  GHashTable *ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  GPtrArray *dirNames = g_ptr_array_new();
+  gint64 nStart = g_get_monotonic_time();
+
+  m_Clear();
+
+  if(dirs)
+  {
+     for(gint i=0; dirs[i]; i++)
+       g_ptr_array_add(dirNames, g_strdup(dirs[i]));
+  }
+  else
+  {
+     const gchar * const *dataDirs = g_get_system_data_dirs();
+
+     g_ptr_array_add(dirNames, g_build_filename(g_get_user_data_dir(), "applications", NULL));
+
+     for(gint i=0; dataDirs[i]; i++)
+       g_ptr_array_add(dirNames, g_build_filename(dataDirs[i], "applications", NULL));
+  }
+
+  for(guint i=0; i<dirNames->len; i++)
+  {
+     m_CollectDirectory((const gchar*)g_ptr_array_index(dirNames, i), "", ids);
+     g_free(g_ptr_array_index(dirNames, i));
+  }
+
+  g_ptr_array_free(dirNames, TRUE);
+  g_hash_table_destroy(ids);
+
+  m_nCollectUsec = g_get_monotonic_time() - nStart;
+
+  if(m_pEntries->len == 0)
+    return false;
+
+  nStart = g_get_monotonic_time();
+  m_nNext = 0;
+  m_nThreads = 1;
+
+#ifdef USE_THREADS
+  {
+     GThread *threads[ICON_AUDIT_THREADS];
+
+     for(gint i=0; i<ICON_AUDIT_THREADS; i++)
+     {
+        threads[i] = g_thread_try_new("icon-audit", m_Worker, this, NULL);
+
+        if( threads[i] )
+          m_nThreads++;
+     }
+
+     /* The entries left by threads which could not be created are audited here. */
+     m_Worker(this);
+
+     for(gint i=0; i<ICON_AUDIT_THREADS; i++)
+     {
+        if( threads[i] )
+          g_thread_join(threads[i]);
+     }
+  }
+#else
+  m_Worker(this);
+#endif
+
+  m_nResolveUsec = g_get_monotonic_time() - nStart;
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - %u desktop files audited in %ld us \n", __FUNCTION__, __LINE__, m_pEntries->len, (glong)(m_nCollectUsec + m_nResolveUsec));
+  #endif
+
+  return true;
+}
+
+/*! \fn void CIconDesktopAudit::m_Print(FILE *fp)
+    \brief To print one line per problem found, then the numbers of each and the timings.
+
+    \param[in] fp. The stream printed to.
+    \return NONE
+*/
+void CIconDesktopAudit::m_Print(FILE *fp)
+{
+  ICON_AUDIT_ENTRY *slowest = NULL;
+  guint nIcons = 0, nInvalid = 0, nUnresolved = 0, nFallback = 0, nOversized = 0;
+
+  for(guint i=0; i<m_pEntries->len; i++)
+  {
+     ICON_AUDIT_ENTRY *entry = (ICON_AUDIT_ENTRY*)g_ptr_array_index(m_pEntries, i);
+
+     if( !slowest || (entry->nUsec > slowest->nUsec) )
+       slowest = entry;
+
+     switch(entry->status)
+     {
+        case ICON_AUDIT_Invalid:
+          nInvalid++;
+          fprintf(fp, "invalid     %s \n", entry->desktopFile);
+          break;
+
+        case ICON_AUDIT_Unresolved:
+          nIcons++;
+          nUnresolved++;
+          fprintf(fp, "unresolved  %s  Icon=%s  (%.2f ms) \n", entry->desktopFile, entry->iconValue, entry->nUsec / 1000.0);
+          break;
+
+        case ICON_AUDIT_Ok:
+          nIcons++;
+
+          if(entry->bFallback)
+          {
+             nFallback++;
+             fprintf(fp, "fallback    %s  Icon=%s -> %s \n", entry->desktopFile, entry->iconValue, entry->fullName);
+          }
+
+          if(entry->bOversized)
+          {
+             nOversized++;
+             fprintf(fp, "oversized   %s  Icon=%s -> %s (%dx%d) \n", entry->desktopFile, entry->iconValue, entry->fullName,
+                     entry->width, entry->height);
+          }
+          break;
+
+        default:
+          break;
+     }
+  }
+
+  fprintf(fp, "%u desktop files, %u with an icon: %u unresolved, %u fallback only, %u oversized, %u invalid \n",
+          m_pEntries->len, nIcons, nUnresolved, nFallback, nOversized, nInvalid);
+  fprintf(fp, "theme %s, size %d: listed in %.1f ms, resolved by %d threads in %.1f ms \n", m_ThemeName, m_nSize,
+          m_nCollectUsec / 1000.0, m_nThreads, m_nResolveUsec / 1000.0);
+
+  if(slowest)
+    fprintf(fp, "slowest %s in %.2f ms \n", slowest->desktopFile, slowest->nUsec / 1000.0);
+}
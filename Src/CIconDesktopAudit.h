@@ -0,0 +1,95 @@
+/*! \file    CIconDesktopAudit.h
+    \brief   Declaration of class CIconDesktopAudit.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONDESKTOPAUDIT
+#define __CICONDESKTOPAUDIT
+
+#include <stdio.h>
+#include <glib.h>
+
+#include "CIconCatalog.h"
+
+/* The threads parsing and resolving the desktop files, besides the calling thread. */
+#define ICON_AUDIT_THREADS  8
+
+/* A raster icon is oversized when its width or height is more than this times the size asked for. */
+#define ICON_AUDIT_OVERSIZE_FACTOR  4
+
+/* The group of the keys of a desktop entry. */
+#define ICON_AUDIT_DESKTOP_GROUP  "Desktop Entry"
+
+/*! \enum ICON_AUDIT_STATUS
+    \brief The result of resolving the Icon= value of one desktop file.
+*/
+enum ICON_AUDIT_STATUS {
+  ICON_AUDIT_Ok = 0,
+  ICON_AUDIT_NoIcon,       /* There is no Icon= key, or the entry is hidden. */
+  ICON_AUDIT_Invalid,      /* The file could not be parsed. */
+  ICON_AUDIT_Unresolved    /* The icon is not found, the dialog would show the default icon instead. */
+};
+
+/*! \struct ICON_AUDIT_ENTRY
+    \brief One desktop file audited.
+*/
+typedef struct _ICON_AUDIT_ENTRY
+{
+  gchar   *desktopFile;  /*!< The full name of the desktop file. */
+  gchar   *iconValue;    /*!< The Icon= value, NULL if there is none. */
+  gchar   *fullName;     /*!< The icon file resolved, NULL if it is not found. */
+  gint     status;       /*!< One of ICON_AUDIT_STATUS. */
+  gboolean bFallback;    /*!< The icon is only found in the legacy icon directories, not in the theme. */
+  gboolean bOversized;   /*!< The icon file is far larger than the size asked for. */
+  gint     width;        /*!< The width of a raster icon file, 0 if it is unknown. */
+  gint     height;       /*!< The height of a raster icon file, 0 if it is unknown. */
+  gint64   nUsec;        /*!< The time taken to parse and resolve it. */
+} ICON_AUDIT_ENTRY;
+
+/*! \class CIconDesktopAudit
+    \brief Resolves the Icon= value of every desktop file of the XDG applications directories at once, as the dialog
+           would, and reports the icons not found, found only as legacy files and oversized.
+
+    The desktop files are listed first, with the desktop file IDs of earlier directories shadowing the later ones
+    as the menu does. Then ICON_AUDIT_THREADS threads parse and resolve them through the shared catalog, whose theme
+    tables and resolved names make a second audit fast.
+*/
+class CIconDesktopAudit
+{
+  private:
+    CIconCatalog *m_pCatalog;  /*!< The catalog resolving the icons. */
+    gchar *m_ThemeName;        /*!< The theme looked up. */
+    gint m_nSize;              /*!< The icon size asked for. */
+    GPtrArray *m_pEntries;     /*!< The ICON_AUDIT_ENTRY of every desktop file, in directory precedence order. */
+    volatile gint m_nNext;     /*!< The next entry taken by a worker. */
+    gint64 m_nCollectUsec;     /*!< The time taken to list the desktop files. */
+    gint64 m_nResolveUsec;     /*!< The time taken to parse and resolve all of them. */
+    gint m_nThreads;           /*!< The threads which audited, the calling thread included. */
+
+    void m_CollectDirectory(const gchar *dirName, const gchar *prefix, GHashTable *ids);
+    void m_AuditEntry(ICON_AUDIT_ENTRY *entry);
+    void m_Clear(void);
+
+    static gpointer m_Worker(gpointer data);
+
+  public:
+    CIconDesktopAudit(CIconCatalog *pCatalog, const gchar *themeName, gint size);
+    ~CIconDesktopAudit();
+
+    /* To list the desktop files of the applications directories, or of the NULL-terminated list given, and audit them. */
+    gboolean m_Run(const gchar **dirs);
+
+    guint m_GetCount(void) { return m_pEntries->len; }
+    ICON_AUDIT_ENTRY* m_GetEntry(guint idx) { return (idx < m_pEntries->len) ? (ICON_AUDIT_ENTRY*)g_ptr_array_index(m_pEntries, idx) : NULL; }
+    gint64 m_GetCollectUsec(void) { return m_nCollectUsec; }
+    gint64 m_GetResolveUsec(void) { return m_nResolveUsec; }
+
+    /* To print the problems found and the summary. */
+    void m_Print(FILE *fp);
+};
+#endif   /* CICONDESKTOPAUDIT.H	*/
@@ -0,0 +1,581 @@
+/*! \file    CIconFileReader.cpp
+    \brief   Read icon files into memory in batches, so the image loaders never wait for the disk one file at a time.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include "CIconFileReader.h"
+
+#ifdef USE_THREADS
+/*! \struct ICON_READ_BATCH_STATE
+    \brief The files of one batch not yet read by the thread pool, each batch waits on its own.
+*/
+typedef struct _ICON_READ_BATCH_STATE
+{
+  GMutex lock;      /*!< Protect nPending. */
+  GCond  done;      /*!< Signaled when nPending drops to zero. */
+  gint   nPending;  /*!< The number of files not yet read. */
+} ICON_READ_BATCH_STATE;
+
+/*! \struct ICON_READ_JOB
+    \brief One file pushed to the thread pool.
+*/
+typedef struct _ICON_READ_JOB
+{
+  ICON_FILE_BUFFER *pBuffer;       /*!< The buffer to fill. */
+  ICON_READ_BATCH_STATE *pBatch;   /*!< The batch it belongs to. */
+} ICON_READ_JOB;
+#endif
+
+/*! \fn CIconFileReader::CIconFileReader()
+    \brief CIconFileReader constructor
+*/
+CIconFileReader::CIconFileReader()
+{
+#ifdef USE_IO_URING
+  g_mutex_init(&m_RingLock);
+
+  /* The kernel may be too old or io_uring may be disabled, then the thread pool is used. */
+  m_bRingReady = (io_uring_queue_init(ICON_READ_BATCH, &m_Ring, 0) == 0);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if( !m_bRingReady )
+    printf("%s(%d) - io_uring is unavailable, fall back to the thread pool. \n", __FUNCTION__, __LINE__);
+  #endif
+#endif
+
+#ifdef USE_THREADS
+  m_pPool = g_thread_pool_new(m_ReadWorker, NULL, ICON_READ_THREADS, FALSE, NULL);
+#endif
+}
+
+/*! \fn CIconFileReader::~CIconFileReader()
+    \brief CIconFileReader destructor
+*/
+CIconFileReader::~CIconFileReader()
+{
+#ifdef USE_IO_URING
+  if(m_bRingReady)
+    io_uring_queue_exit(&m_Ring);
+
+  m_bRingReady = false;
+  g_mutex_clear(&m_RingLock);
+#endif
+
+#ifdef USE_THREADS
+  if(m_pPool)
+    g_thread_pool_free(m_pPool, TRUE, TRUE);
+
+  m_pPool = NULL;
+#endif
+}
+
+/*! \fn gboolean CIconFileReader::m_ReadBatch(ICON_FILE_BUFFER *pBuffers, gint nCount)
+    \brief To read a batch of icon files into memory.
+
+    \param[in,out] pBuffers. The buffers to fill. The "fullName" field of each buffer must be set.
+    \param[in] nCount. The number of buffers.
+    \return TRUE or FALSE
+*/
+gboolean CIconFileReader::m_ReadBatch(ICON_FILE_BUFFER *pBuffers, gint nCount)
+{
+  if( !pBuffers || (nCount <= 0) )
+    return false;
+
+  /* Split a large request into batches the ring could hold. */
+  if(nCount > ICON_READ_BATCH)
+  {
+     for(gint i=0; i<nCount; i+=ICON_READ_BATCH)
+       m_ReadBatch(pBuffers + i, MIN(ICON_READ_BATCH, nCount - i));
+
+     return true;
+  }
+
+  for(gint i=0; i<nCount; i++)
+  {
+     pBuffers[i].data = NULL;
+     pBuffers[i].length = 0;
+     pBuffers[i].fileSize = 0;
+     pBuffers[i].device = 0;
+     pBuffers[i].inode = 0;
+     pBuffers[i].mtime = 0;
+     pBuffers[i].error = 0;
+     pBuffers[i].knownHash = 0;
+  }
+
+#ifdef USE_IO_URING
+  /* The ring is used by one batch at a time, a batch of another thread is read by the thread pool meanwhile. */
+  if( g_mutex_trylock(&m_RingLock) )
+  {
+     gboolean bRead = m_bRingReady && m_ReadBatchUring(pBuffers, nCount);
+
+     g_mutex_unlock(&m_RingLock);
+
+     if(bRead)
+       return true;
+  }
+#endif
+
+#ifdef USE_THREADS
+  if(m_pPool)
+  {
+     m_ReadBatchThreads(pBuffers, nCount);
+     return true;
+  }
+#endif
+
+  for(gint i=0; i<nCount; i++)
+    m_ReadOne(&pBuffers[i]);
+
+  return true;
+}
+
+/*! \fn void CIconFileReader::m_ReadOne(ICON_FILE_BUFFER *pBuffer)
+    \brief To read one icon file synchronously.
+
+    \param[in,out] pBuffer. The buffer to fill.
+    \return NONE
+*/
+void CIconFileReader::m_ReadOne(ICON_FILE_BUFFER *pBuffer)
+{
+  struct stat st;
+  gsize done = 0;
+  gint nError = 0;
+  int fd = -1;
+
+  if( !pBuffer || !pBuffer->fullName )
+    return;
+
+  fd = open(pBuffer->fullName, O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+  {
+     pBuffer->error = errno;
+     return;
+  }
+
+  if( fstat(fd, &st) != 0 )
+  {
+     pBuffer->error = errno;
+     close(fd);
+     return;
+  }
+
+  pBuffer->fileSize = (gsize)st.st_size;
+  pBuffer->device = (guint64)st.st_dev;
+  pBuffer->inode = (guint64)st.st_ino;
+  pBuffer->mtime = (gint64)st.st_mtime;
+
+  /* Huge or empty files are left for the path-based loaders. */
+  if( (st.st_size <= 0) || (st.st_size > ICON_READ_MAX_BYTES) )
+  {
+     close(fd);
+     return;
+  }
+
+  pBuffer->data = (guchar*)g_malloc(pBuffer->fileSize);
+
+  while(done < pBuffer->fileSize)
+  {
+     ssize_t n = read(fd, pBuffer->data + done, pBuffer->fileSize - done);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n < 0)
+       nError = errno;
+
+     if(n <= 0)
+       break;
+
+     done += n;
+  }
+
+  /* A file emptied since the fstat() reads nothing without an error. */
+  if(done == 0)
+  {
+     pBuffer->error = nError ? nError : EIO;
+     g_free(pBuffer->data);
+     pBuffer->data = NULL;
+  }
+
+  pBuffer->length = done;
+
+  close(fd);
+}
+
+/*! \fn void CIconFileReader::m_StatOne(ICON_FILE_BUFFER *pBuffer)
+    \brief To fill the size, device, inode and modification time of one icon file without reading it.
+    \n The contents are left unread, so a file whose content hash is known by its identity is never read.
+
+    \param[in,out] pBuffer. The buffer to fill.
+    \return NONE
+*/
+void CIconFileReader::m_StatOne(ICON_FILE_BUFFER *pBuffer)
+{
+  struct stat st;
+
+  if( !pBuffer || !pBuffer->fullName )
+    return;
+
+  pBuffer->data = NULL;
+  pBuffer->length = 0;
+  pBuffer->error = 0;
+  pBuffer->knownHash = 0;
+
+  if( stat(pBuffer->fullName, &st) != 0 )
+  {
+     pBuffer->error = errno;
+     return;
+  }
+
+  pBuffer->fileSize = (gsize)st.st_size;
+  pBuffer->device = (guint64)st.st_dev;
+  pBuffer->inode = (guint64)st.st_ino;
+  pBuffer->mtime = (gint64)st.st_mtime;
+}
+
+/*! \fn void CIconFileReader::m_FreeBuffer(ICON_FILE_BUFFER *pBuffer)
+    \brief To release the file contents held by a buffer.
+
+    \param[in] pBuffer. The buffer.
+    \return NONE
+*/
+void CIconFileReader::m_FreeBuffer(ICON_FILE_BUFFER *pBuffer)
+{
+  if(!pBuffer)
+    return;
+
+  if(pBuffer->data)
+    g_free(pBuffer->data);
+
+  pBuffer->data = NULL;
+  pBuffer->length = 0;
+}
+
+#ifdef USE_IO_URING
+/*! \fn void CIconFileReader::m_ResetRing(void)
+    \brief To set the ring up again, dropping the requests left in it. The thread pool is used if it could not be.
+*/
+void CIconFileReader::m_ResetRing(void)
+{
+  if(m_bRingReady)
+    io_uring_queue_exit(&m_Ring);
+
+  m_bRingReady = (io_uring_queue_init(ICON_READ_BATCH, &m_Ring, 0) == 0);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - The ring is set up again%s \n", __FUNCTION__, __LINE__, m_bRingReady ? "" : ", it is unavailable now");
+  #endif
+}
+
+/*! \fn gboolean CIconFileReader::m_SubmitAndWait(gint nSubmit, gint *pResults)
+    \brief To submit the prepared requests and collect all completions.
+    \n The kernel may take part of the requests, the rest is submitted again after completions are reaped. If they
+    could not all be submitted or reaped, the ring is set up again, so no request is left for the next batch.
+
+    \param[in] nSubmit. The number of prepared requests.
+    \param[out] pResults. The result(the "res" of the completion) of each request, indexed by its user data.
+    \return FALSE if not every request completed.
+*/
+gboolean CIconFileReader::m_SubmitAndWait(gint nSubmit, gint *pResults)
+{
+  struct io_uring_cqe *cqe = NULL;
+  gint nSubmitted = 0, nReaped = 0;
+  gboolean bRet = true;
+
+  while( bRet && (nSubmitted < nSubmit) )
+  {
+     gint n = io_uring_submit(&m_Ring);
+
+     if(n > 0)
+     {
+        nSubmitted += n;
+        continue;
+     }
+
+     if(n == -EINTR)
+       continue;
+
+     /* The completion queue is full or the kernel is short of memory, room is made by reaping one. */
+     if( ((n == 0) || (n == -EAGAIN) || (n == -EBUSY)) && (nReaped < nSubmitted) &&
+         (io_uring_wait_cqe(&m_Ring, &cqe) == 0) )
+     {
+        pResults[ GPOINTER_TO_INT(io_uring_cqe_get_data(cqe)) ] = cqe->res;
+        io_uring_cqe_seen(&m_Ring, cqe);
+        nReaped++;
+        continue;
+     }
+
+     bRet = false;
+  }
+
+  /* Every submitted request produces exactly one completion, the buffers are written until it arrives. */
+  while(nReaped < nSubmitted)
+  {
+     gint ret = io_uring_wait_cqe(&m_Ring, &cqe);
+
+     if(ret == -EINTR)
+       continue;
+
+     if(ret < 0)
+     {
+        bRet = false;
+        break;
+     }
+
+     pResults[ GPOINTER_TO_INT(io_uring_cqe_get_data(cqe)) ] = cqe->res;
+     io_uring_cqe_seen(&m_Ring, cqe);
+     nReaped++;
+  }
+
+  if( !bRet || (nReaped < nSubmitted) )
+  {
+     m_ResetRing();
+     return false;
+  }
+
+  return true;
+}
+
+/*! \fn gboolean CIconFileReader::m_ReadBatchUring(ICON_FILE_BUFFER *pBuffers, gint nCount)
+    \brief To read a batch of files with four io_uring round trips: open, statx, read and close.
+
+    \param[in,out] pBuffers. The buffers to fill.
+    \param[in] nCount. The number of buffers, at most ICON_READ_BATCH.
+    \return FALSE if the ring could not be used, the caller should fall back then.
+*/
+gboolean CIconFileReader::m_ReadBatchUring(ICON_FILE_BUFFER *pBuffers, gint nCount)
+{
+  gint fds[ICON_READ_BATCH], results[ICON_READ_BATCH];
+  struct statx stx[ICON_READ_BATCH];
+  struct io_uring_sqe *sqe = NULL;
+  gint nSubmit = 0;
+  gboolean bRet = true;
+
+  /* Step 1) Open all files. */
+  for(gint i=0; i<nCount; i++)
+  {
+     fds[i] = -1;
+     results[i] = -EBADF;
+
+     sqe = io_uring_get_sqe(&m_Ring);
+     io_uring_prep_openat(sqe, AT_FDCWD, pBuffers[i].fullName, O_RDONLY | O_CLOEXEC, 0);
+     io_uring_sqe_set_data(sqe, GINT_TO_POINTER(i));
+  }
+
+  if( !m_SubmitAndWait(nCount, results) )
+  {
+     /* Close what had been opened, the caller will read the whole batch again. */
+     for(gint i=0; i<nCount; i++)
+       if(results[i] >= 0)
+         close(results[i]);
+
+     return false;
+  }
+
+  for(gint i=0; i<nCount; i++)
+  {
+     if(results[i] >= 0)
+       fds[i] = results[i];
+     else
+       pBuffers[i].error = -results[i];
+  }
+
+  /* Step 2) Retrieve the size of every opened file. */
+  nSubmit = 0;
+  for(gint i=0; i<nCount; i++)
+  {
+     results[i] = -EBADF;
+
+     if(fds[i] < 0)
+       continue;
+
+     sqe = io_uring_get_sqe(&m_Ring);
+     io_uring_prep_statx(sqe, fds[i], "", AT_EMPTY_PATH, STATX_SIZE | STATX_INO | STATX_MTIME, &stx[i]);
+     io_uring_sqe_set_data(sqe, GINT_TO_POINTER(i));
+     nSubmit++;
+  }
+
+  bRet = m_SubmitAndWait(nSubmit, results);
+
+  /* Step 3) Read every file in one request. */
+  nSubmit = 0;
+  for(gint i=0; (i<nCount) && bRet; i++)
+  {
+     if(fds[i] < 0)
+       continue;
+
+     if(results[i] == 0)
+     {
+        pBuffers[i].fileSize = (gsize)stx[i].stx_size;
+        pBuffers[i].device = (guint64)makedev(stx[i].stx_dev_major, stx[i].stx_dev_minor);
+        pBuffers[i].inode = (guint64)stx[i].stx_ino;
+        pBuffers[i].mtime = (gint64)stx[i].stx_mtime.tv_sec;
+     }
+     else
+     {
+        /* The kernel may not support statx through io_uring. */
+        struct stat st;
+
+        if( fstat(fds[i], &st) == 0 )
+        {
+           pBuffers[i].fileSize = (gsize)st.st_size;
+           pBuffers[i].device = (guint64)st.st_dev;
+           pBuffers[i].inode = (guint64)st.st_ino;
+           pBuffers[i].mtime = (gint64)st.st_mtime;
+        }
+     }
+
+     results[i] = 0;
+
+     /* Huge or empty files are left for the path-based loaders. */
+     if( (pBuffers[i].fileSize == 0) || (pBuffers[i].fileSize > ICON_READ_MAX_BYTES) )
+       continue;
+
+     pBuffers[i].data = (guchar*)g_malloc(pBuffers[i].fileSize);
+
+     sqe = io_uring_get_sqe(&m_Ring);
+     io_uring_prep_read(sqe, fds[i], pBuffers[i].data, (unsigned)pBuffers[i].fileSize, 0);
+     io_uring_sqe_set_data(sqe, GINT_TO_POINTER(i));
+     nSubmit++;
+  }
+
+  if(bRet)
+    bRet = m_SubmitAndWait(nSubmit, results);
+
+  for(gint i=0; (i<nCount) && bRet; i++)
+  {
+     if( (fds[i] < 0) || !pBuffers[i].data )
+       continue;
+
+     /* A file emptied since the statx reads nothing without an error. */
+     if(results[i] <= 0)
+     {
+        pBuffers[i].error = (results[i] < 0) ? -results[i] : EIO;
+        m_FreeBuffer(&pBuffers[i]);
+        continue;
+     }
+
+     pBuffers[i].length = (gsize)results[i];
+
+     /* Finish a short read synchronously, it is rare for regular files. */
+     while(pBuffers[i].length < pBuffers[i].fileSize)
+     {
+        ssize_t n = pread(fds[i], pBuffers[i].data + pBuffers[i].length,
+                          pBuffers[i].fileSize - pBuffers[i].length, pBuffers[i].length);
+
+        if(n <= 0)
+          break;
+
+        pBuffers[i].length += n;
+     }
+  }
+
+  /* Step 4) Close all files. */
+  nSubmit = 0;
+  for(gint i=0; i<nCount; i++)
+  {
+     if(fds[i] < 0)
+       continue;
+
+     if(bRet)
+     {
+        sqe = io_uring_get_sqe(&m_Ring);
+        io_uring_prep_close(sqe, fds[i]);
+        io_uring_sqe_set_data(sqe, GINT_TO_POINTER(i));
+        nSubmit++;
+     }
+     else
+       close(fds[i]);
+  }
+
+  /* The ring was set up again if the closes failed, which closed nothing. */
+  if( bRet && !m_SubmitAndWait(nSubmit, results) )
+  {
+     for(gint i=0; i<nCount; i++)
+       if(fds[i] >= 0)
+         close(fds[i]);
+  }
+  else if(!bRet)
+  {
+     /* The caller will read the whole batch again. */
+     for(gint i=0; i<nCount; i++)
+     {
+        m_FreeBuffer(&pBuffers[i]);
+        pBuffers[i].fileSize = 0;
+        pBuffers[i].error = 0;
+     }
+  }
+
+  return bRet;
+}
+#endif
+
+#ifdef USE_THREADS
+/*! \fn void CIconFileReader::m_ReadBatchThreads(ICON_FILE_BUFFER *pBuffers, gint nCount)
+    \brief To read a batch of files by the worker threads and wait for all of them.
+
+    \param[in,out] pBuffers. The buffers to fill.
+    \param[in] nCount. The number of buffers.
+    \return NONE
+*/
+void CIconFileReader::m_ReadBatchThreads(ICON_FILE_BUFFER *pBuffers, gint nCount)
+{
+  ICON_READ_BATCH_STATE batch;
+  ICON_READ_JOB jobs[ICON_READ_BATCH];
+
+  g_mutex_init(&batch.lock);
+  g_cond_init(&batch.done);
+  batch.nPending = nCount;
+
+  for(gint i=0; i<nCount; i++)
+  {
+     jobs[i].pBuffer = &pBuffers[i];
+     jobs[i].pBatch = &batch;
+     g_thread_pool_push(m_pPool, &jobs[i], NULL);
+  }
+
+  g_mutex_lock(&batch.lock);
+  while(batch.nPending > 0)
+    g_cond_wait(&batch.done, &batch.lock);
+  g_mutex_unlock(&batch.lock);
+
+  g_cond_clear(&batch.done);
+  g_mutex_clear(&batch.lock);
+}
+
+/*! \fn void CIconFileReader::m_ReadWorker(gpointer data, gpointer userData)
+    \brief The thread pool function reading one file.
+
+    \param[in,out] data. The ICON_READ_JOB, its buffer is filled.
+    \param[in] userData. Not used.
+    \return NONE
+*/
+void CIconFileReader::m_ReadWorker(gpointer data, gpointer userData)
+{
+  ICON_READ_JOB *pJob = (ICON_READ_JOB*)data;
+  ICON_READ_BATCH_STATE *pBatch = pJob->pBatch;
+
+  m_ReadOne(pJob->pBuffer);
+
+  /* The batch lives on the stack of the waiting thread, it is not touched after the signal. */
+  g_mutex_lock(&pBatch->lock);
+
+  if( --pBatch->nPending == 0 )
+    g_cond_signal(&pBatch->done);
+
+  g_mutex_unlock(&pBatch->lock);
+}
+#endif
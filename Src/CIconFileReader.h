@@ -0,0 +1,92 @@
+/*! \file    CIconFileReader.h
+    \brief   Declaration of class CIconFileReader.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONFILEREADER
+#define __CICONFILEREADER
+
+#include <glib.h>
+
+#ifdef USE_IO_URING
+#include <liburing.h>
+#endif
+
+/* The number of icon files read in one batch. It is also the depth of the io_uring queue. */
+#define ICON_READ_BATCH  64
+
+/* Files larger than this are not read into memory, they are left for the path-based loaders. The unit is "byte". */
+#define ICON_READ_MAX_BYTES  (4 * 1024 * 1024)
+
+/* The number of worker threads reading icon files when io_uring is unavailable. */
+#define ICON_READ_THREADS  8
+
+/*! \struct ICON_FILE_BUFFER
+    \brief The in-memory contents of one icon file.
+*/
+typedef struct _ICON_FILE_BUFFER
+{
+  gchar  *fullName;   /*!< The icon file's full name. It is owned by the caller. */
+  guchar *data;       /*!< The file contents, NULL if it is not read. Released by CIconFileReader::m_FreeBuffer(). */
+  gsize   length;     /*!< The number of bytes in "data". */
+  gsize   fileSize;   /*!< The size of the file on disk. */
+  guint64 device;     /*!< The device the file resides on. */
+  guint64 inode;      /*!< The inode number of the file. */
+  gint64  mtime;      /*!< The modification time of the file, in second. */
+  gint    error;      /*!< The "errno" value of a failed open/read, 0 on success. */
+  guint64 knownHash;  /*!< The content hash known from the file's identity when "data" is not read, 0 otherwise. */
+} ICON_FILE_BUFFER;
+
+/*! \class CIconFileReader
+    \brief Read a batch of icon files into memory with as few round trips to the kernel as possible.
+
+    With USE_IO_URING all open/statx/read/close requests of a batch are submitted to io_uring at once.
+    Otherwise (or if the kernel refuses io_uring) the files are read by a thread pool with USE_THREADS,
+    or one by one as the last resort.
+    Several threads may read batches at once: the ring serves one batch at a time, a batch finding it busy is
+    read by the thread pool, and each batch of the pool waits on its own state.
+*/
+class CIconFileReader
+{
+  private:
+#ifdef USE_IO_URING
+    struct io_uring m_Ring;  /*!< The submission/completion ring. */
+    gboolean m_bRingReady;   /*!< To indicate if the ring had been set up successfully. Protected by m_RingLock. */
+    GMutex m_RingLock;       /*!< Held by the batch using the ring. */
+#endif
+#ifdef USE_THREADS
+    GThreadPool *m_pPool;    /*!< The worker threads reading files. */
+#endif
+
+#ifdef USE_IO_URING
+    void m_ResetRing(void);
+    gboolean m_SubmitAndWait(gint nSubmit, gint *pResults);
+    gboolean m_ReadBatchUring(ICON_FILE_BUFFER *pBuffers, gint nCount);
+#endif
+#ifdef USE_THREADS
+    void m_ReadBatchThreads(ICON_FILE_BUFFER *pBuffers, gint nCount);
+    static void m_ReadWorker(gpointer data, gpointer userData);
+#endif
+
+  public:
+    CIconFileReader();
+    ~CIconFileReader();
+
+    /* To read at most ICON_READ_BATCH files. The "fullName" of each buffer must be set. */
+    gboolean m_ReadBatch(ICON_FILE_BUFFER *pBuffers, gint nCount);
+
+    /* To read one file synchronously. */
+    static void m_ReadOne(ICON_FILE_BUFFER *pBuffer);
+
+    /* To fill the identity of one file without reading it. */
+    static void m_StatOne(ICON_FILE_BUFFER *pBuffer);
+
+    /* To release the contents of a buffer. */
+    static void m_FreeBuffer(ICON_FILE_BUFFER *pBuffer);
+};
+#endif   /* CICONFILEREADER.H	*/
@@ -0,0 +1,847 @@
+/*! \file    CIconIndexDaemon.cpp
+    \brief   Keep the thumbnails of icon directories warm in a background process, so dialogs open instantly.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "CIconCatalog.h"
+#include "CIconContentCache.h"
+#include "CIconIndexDaemon.h"
+
+/* The longest request line. */
+#define ICON_INDEX_MAX_REQUEST  4096
+
+/*! \fn static gboolean write_all(gint fd, const void *buf, gsize len)
+    \brief To write the whole buffer to a socket.
+
+    \param[in] fd. The socket.
+    \param[in] buf. The data.
+    \param[in] len. The number of bytes.
+    \return TRUE or FALSE
+*/
+static gboolean write_all(gint fd, const void *buf, gsize len)
+{
+  const guchar *p = (const guchar*)buf;
+
+  while(len > 0)
+  {
+     /* MSG_NOSIGNAL: a dialog closing the socket early must not kill the daemon with SIGPIPE. */
+     ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+       return false;
+
+     p += n;
+     len -= n;
+  }
+
+  return true;
+}
+
+/*! \fn static gboolean read_all(gint fd, void *buf, gsize len)
+    \brief To read exactly "len" bytes from a socket.
+
+    \param[in] fd. The socket.
+    \param[out] buf. The buffer.
+    \param[in] len. The number of bytes.
+    \return TRUE or FALSE
+*/
+static gboolean read_all(gint fd, void *buf, gsize len)
+{
+  guchar *p = (guchar*)buf;
+
+  while(len > 0)
+  {
+     ssize_t n = read(fd, p, len);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+       return false;
+
+     p += n;
+     len -= n;
+  }
+
+  return true;
+}
+
+/*! \fn static gboolean write_word(gint fd, guint32 word)
+    \brief To write a 32-bit word to a socket.
+*/
+static gboolean write_word(gint fd, guint32 word)
+{
+  return write_all(fd, &word, sizeof(word));
+}
+
+/*! \fn static gboolean read_word(gint fd, guint32 *pWord)
+    \brief To read a 32-bit word from a socket.
+*/
+static gboolean read_word(gint fd, guint32 *pWord)
+{
+  return read_all(fd, pWord, sizeof(*pWord));
+}
+
+/*! \fn static gboolean write_quad(gint fd, guint64 quad)
+    \brief To write a 64-bit word to a socket.
+*/
+static gboolean write_quad(gint fd, guint64 quad)
+{
+  return write_all(fd, &quad, sizeof(quad));
+}
+
+/*! \fn static gboolean read_quad(gint fd, guint64 *pQuad)
+    \brief To read a 64-bit word from a socket.
+*/
+static gboolean read_quad(gint fd, guint64 *pQuad)
+{
+  return read_all(fd, pQuad, sizeof(*pQuad));
+}
+
+/*! \fn static gboolean set_socket_timeout(gint fd, gint nSeconds)
+    \brief To bound every read and write of a socket, so a stalled peer is dropped.
+
+    \param[in] fd. The socket.
+    \param[in] nSeconds. The timeout.
+    \return TRUE or FALSE
+*/
+static gboolean set_socket_timeout(gint fd, gint nSeconds)
+{
+  struct timeval timeout = { nSeconds, 0 };
+
+  return (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0) &&
+         (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0);
+}
+
+/*! \fn static gchar* normalize_dir_name(const gchar *dirName)
+    \brief To append the trailing "/" the dialog uses for browsing locations.
+
+    \param[in] dirName. The directory name.
+    \return The newly allocated directory name.
+*/
+static gchar* normalize_dir_name(const gchar *dirName)
+{
+  if( g_str_has_suffix(dirName, "/") )
+    return g_strdup(dirName);
+
+  return g_strdup_printf("%s%s", dirName, "/");
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconIndexDaemon::CIconIndexDaemon()
+    \brief CIconIndexDaemon constructor
+*/
+CIconIndexDaemon::CIconIndexDaemon()
+{
+  m_pIndex = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, m_ReleaseDirectory);
+  m_pIndexing = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  m_nRequests = 0;
+  g_mutex_init(&m_IndexLock);
+  m_pReader = new CIconFileReader();
+  m_nListenFd = -1;
+  m_SocketPath = m_GetSocketPath();
+  m_pLoop = NULL;
+
+  /* One indexing thread, so the daemon never decodes more than a dialog would. */
+  m_pIndexPool = g_thread_pool_new(cb_index_thread, this, 1, FALSE, NULL);
+  m_pClientPool = g_thread_pool_new(cb_client_thread, this, ICON_INDEX_CLIENT_THREADS, FALSE, NULL);
+}
+
+/*! \fn CIconIndexDaemon::~CIconIndexDaemon()
+    \brief CIconIndexDaemon destructor
+*/
+CIconIndexDaemon::~CIconIndexDaemon()
+{
+  if(m_nListenFd >= 0)
+  {
+     close(m_nListenFd);
+     unlink(m_SocketPath);
+  }
+
+  /* The queued requests are finished, each is bounded by the client timeout. */
+  if(m_pClientPool)
+    g_thread_pool_free(m_pClientPool, FALSE, TRUE);
+
+  if(m_pIndexPool)
+    g_thread_pool_free(m_pIndexPool, FALSE, TRUE);
+
+  if(m_pLoop)
+    g_main_loop_unref(m_pLoop);
+
+  if(m_pIndex)
+    g_hash_table_destroy(m_pIndex);
+
+  if(m_pIndexing)
+    g_hash_table_destroy(m_pIndexing);
+
+  if(m_pReader)
+    delete m_pReader;
+
+  g_mutex_clear(&m_IndexLock);
+  g_free(m_SocketPath);
+
+  m_nListenFd = -1;
+  m_pClientPool = NULL;
+  m_pIndexPool = NULL;
+  m_pLoop = NULL;
+  m_pIndex = NULL;
+  m_pIndexing = NULL;
+  m_pReader = NULL;
+  m_SocketPath = NULL;
+}
+
+/*! \fn gchar* CIconIndexDaemon::m_GetSocketPath(void)
+    \brief To get the socket file name, under $XDG_RUNTIME_DIR so it is private to the user.
+
+    \param[in] NONE
+    \return The newly allocated socket file name.
+*/
+gchar* CIconIndexDaemon::m_GetSocketPath(void)
+{
+  return g_build_filename(g_get_user_runtime_dir(), ICON_INDEX_SOCKET_DIR, ICON_INDEX_SOCKET_NAME, NULL);
+}
+
+/*! \fn void CIconIndexDaemon::m_FreeEntry(gpointer data)
+    \brief To release an ICON_INDEX_ENTRY.
+
+    \param[in] data. The entry.
+    \return NONE
+*/
+void CIconIndexDaemon::m_FreeEntry(gpointer data)
+{
+  ICON_INDEX_ENTRY *entry = (ICON_INDEX_ENTRY*)data;
+
+  if(!entry)
+    return;
+
+  if(entry->pixbuf)
+    g_object_unref(entry->pixbuf);
+
+  g_free(entry->baseName);
+  g_free(entry);
+}
+
+/*! \fn void CIconIndexDaemon::m_FreeDirectory(gpointer data)
+    \brief To release an ICON_INDEX_DIR.
+
+    \param[in] data. The directory index.
+    \return NONE
+*/
+void CIconIndexDaemon::m_FreeDirectory(gpointer data)
+{
+  ICON_INDEX_DIR *dir = (ICON_INDEX_DIR*)data;
+
+  if(!dir)
+    return;
+
+  g_ptr_array_foreach(dir->entries, (GFunc)m_FreeEntry, NULL);
+  g_ptr_array_free(dir->entries, TRUE);
+  g_free(dir);
+}
+
+/*! \fn void CIconIndexDaemon::m_ReleaseDirectory(gpointer data)
+    \brief To drop a reference to an ICON_INDEX_DIR, it is released with the last one.
+
+    \param[in] data. The directory index.
+    \return NONE
+*/
+void CIconIndexDaemon::m_ReleaseDirectory(gpointer data)
+{
+  ICON_INDEX_DIR *dir = (ICON_INDEX_DIR*)data;
+
+  if( dir && g_atomic_int_dec_and_test(&dir->nRef) )
+    m_FreeDirectory(dir);
+}
+
+/*! \fn ICON_INDEX_DIR* CIconIndexDaemon::m_IndexDirectory(const gchar *dirName)
+    \brief To decode every icon of a directory into a thumbnail and keep them in the index.
+
+    \param[in] dirName. The directory name with a trailing "/".
+    \return The new directory index with one reference, NULL if the directory could not be read.
+*/
+ICON_INDEX_DIR* CIconIndexDaemon::m_IndexDirectory(const gchar *dirName)
+{
+  ICON_FILE_BUFFER buffers[ICON_READ_BATCH];
+  ICON_INDEX_DIR *dir = NULL;
+  const gchar *baseName = NULL;
+  GDir *pDir = NULL;
+  struct stat st;
+  gint nBuffers = 0;
+
+  if( (stat(dirName, &st) != 0) || !S_ISDIR(st.st_mode) )
+    return NULL;
+
+  pDir = g_dir_open(dirName, 0, NULL);
+  if(!pDir)
+    return NULL;
+
+  dir = g_new0(ICON_INDEX_DIR, 1);
+  dir->mtime = st.st_mtime;
+  dir->entries = g_ptr_array_new();
+  dir->nRef = 1;
+
+  do
+  {
+     baseName = g_dir_read_name(pDir);
+
+     if( baseName && CIconCatalog::m_IsIconFile((gchar*)baseName) )
+     {
+        dir->nTotal++;
+        buffers[nBuffers++].fullName = g_strdup_printf("%s%s", dirName, baseName);
+     }
+
+     /* To decode a full batch, or the rest at the end of the directory. */
+     if( (nBuffers == ICON_READ_BATCH) || (!baseName && (nBuffers > 0)) )
+     {
+        m_pReader->m_ReadBatch(buffers, nBuffers);
+
+        for(gint i=0; i<nBuffers; i++)
+        {
+           GdkPixbuf *pixbuf = NULL;
+
+           if(buffers[i].data)
+             pixbuf = CIconCatalog::m_DecodeBuffer(buffers[i].data, buffers[i].length, ICON_THUMBNAIL_SIZE);
+           else if(buffers[i].error == 0)
+             pixbuf = gdk_pixbuf_new_from_file_at_size(buffers[i].fullName, ICON_THUMBNAIL_SIZE, ICON_THUMBNAIL_SIZE, NULL);
+
+           if(pixbuf)
+           {
+              ICON_INDEX_ENTRY *entry = g_new0(ICON_INDEX_ENTRY, 1);
+
+              entry->baseName = g_path_get_basename(buffers[i].fullName);
+              entry->pixbuf = pixbuf;
+              entry->fileSize = buffers[i].fileSize;
+              entry->mtime = buffers[i].mtime;
+
+              /* The dialog hides the duplicates by the same hash it computes for the files it reads. */
+              if( buffers[i].data && (buffers[i].length == buffers[i].fileSize) )
+                entry->contentHash = CIconContentCache::m_HashBytes(buffers[i].data, buffers[i].length);
+              g_ptr_array_add(dir->entries, entry);
+           }
+
+           CIconFileReader::m_FreeBuffer(&buffers[i]);
+           g_free(buffers[i].fullName);
+        }
+
+        nBuffers = 0;
+     }
+  } while(baseName);
+
+  g_dir_close(pDir);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - Indexed %s: %d of %d icons \n", __FUNCTION__, __LINE__, dirName, dir->entries->len, dir->nTotal);
+  #endif
+
+  return dir;
+}
+
+/*! \fn void CIconIndexDaemon::m_StoreDirectory(const gchar *dirName, ICON_INDEX_DIR *dir)
+    \brief To keep the new index of a directory, dropping the least recently requested ones beyond ICON_INDEX_MAX_DIRS.
+
+    \param[in] dirName. The directory name with a trailing "/".
+    \param[in] dir. The directory index, its reference is taken. NULL drops the directory, it could not be read.
+    \return NONE
+*/
+void CIconIndexDaemon::m_StoreDirectory(const gchar *dirName, ICON_INDEX_DIR *dir)
+{
+  g_mutex_lock(&m_IndexLock);
+
+  g_hash_table_remove(m_pIndexing, dirName);
+
+  if(!dir)
+  {
+     g_hash_table_remove(m_pIndex, dirName);
+     g_mutex_unlock(&m_IndexLock);
+     return;
+  }
+
+  dir->nLastUsed = m_nRequests;
+  g_hash_table_replace(m_pIndex, g_strdup(dirName), dir);
+
+  /* The index is small, a scan finds the oldest one. */
+  while( g_hash_table_size(m_pIndex) > ICON_INDEX_MAX_DIRS )
+  {
+     GHashTableIter iter;
+     gpointer key = NULL, value = NULL;
+     gpointer oldestKey = NULL;
+     guint64 nOldest = G_MAXUINT64;
+
+     g_hash_table_iter_init(&iter, m_pIndex);
+     while( g_hash_table_iter_next(&iter, &key, &value) )
+     {
+        if( (((ICON_INDEX_DIR*)value)->nLastUsed < nOldest) && (strcmp((gchar*)key, dirName) != 0) )
+        {
+           nOldest = ((ICON_INDEX_DIR*)value)->nLastUsed;
+           oldestKey = key;
+        }
+     }
+
+     if(!oldestKey)
+       break;
+
+     /* A reply being written keeps its own reference. */
+     g_hash_table_remove(m_pIndex, oldestKey);
+  }
+
+  g_mutex_unlock(&m_IndexLock);
+}
+
+/*! \fn void CIconIndexDaemon::m_QueueIndex(const gchar *dirName)
+    \brief To have a directory indexed by the indexing thread, unless it is queued already.
+
+    \param[in] dirName. The directory name with a trailing "/".
+    \return NONE
+*/
+void CIconIndexDaemon::m_QueueIndex(const gchar *dirName)
+{
+  g_mutex_lock(&m_IndexLock);
+
+  /* The queue is bounded like the index, the directories beyond it are queued again by their next request. */
+  if( !g_hash_table_contains(m_pIndexing, dirName) && (g_hash_table_size(m_pIndexing) < ICON_INDEX_MAX_DIRS) )
+  {
+     g_hash_table_add(m_pIndexing, g_strdup(dirName));
+     g_thread_pool_push(m_pIndexPool, g_strdup(dirName), NULL);
+  }
+
+  g_mutex_unlock(&m_IndexLock);
+}
+
+/*! \fn void CIconIndexDaemon::cb_index_thread(gpointer data, gpointer thisObject)
+    \brief The thread function indexing a directory queued by m_QueueIndex().
+
+    \param[in] data. The directory name, it is freed here.
+    \param[in] thisObject. The instance of class CIconIndexDaemon.
+    \return NONE
+*/
+void CIconIndexDaemon::cb_index_thread(gpointer data, gpointer thisObject)
+{
+  CIconIndexDaemon *daemon = (CIconIndexDaemon*)thisObject;
+  gchar *dirName = (gchar*)data;
+
+  daemon->m_StoreDirectory(dirName, daemon->m_IndexDirectory(dirName));
+
+  g_free(dirName);
+}
+
+/*! \fn ICON_INDEX_DIR* CIconIndexDaemon::m_LookupDirectory(const gchar *dirName)
+    \brief To get the index of a directory. A directory not indexed, or changed since, is queued to be indexed.
+
+    \param[in] dirName. The directory name with a trailing "/".
+    \return The directory index with a reference for the caller, to be dropped by m_ReleaseDirectory().
+             NULL if it is not indexed or out of date, the request is a miss.
+*/
+ICON_INDEX_DIR* CIconIndexDaemon::m_LookupDirectory(const gchar *dirName)
+{
+  ICON_INDEX_DIR *dir = NULL;
+  struct stat st;
+  gboolean bExists = (stat(dirName, &st) == 0) && S_ISDIR(st.st_mode);
+
+  g_mutex_lock(&m_IndexLock);
+
+  m_nRequests++;
+  dir = (ICON_INDEX_DIR*)g_hash_table_lookup(m_pIndex, dirName);
+
+  /* Adding, removing or renaming an icon changes the directory's modification time. */
+  if( dir && bExists && (st.st_mtime == dir->mtime) )
+  {
+     dir->nLastUsed = m_nRequests;
+     g_atomic_int_inc(&dir->nRef);
+     g_mutex_unlock(&m_IndexLock);
+     return dir;
+  }
+
+  g_mutex_unlock(&m_IndexLock);
+
+  /* The out-of-date index is replaced when the indexing is done, a removed directory is dropped then. */
+  if(bExists || dir)
+    m_QueueIndex(dirName);
+
+  return NULL;
+}
+
+/*! \fn void CIconIndexDaemon::m_Prewarm(const gchar *dirName)
+    \brief To index a directory ahead of requests, by the indexing thread.
+
+    \param[in] dirName. The directory name.
+    \return NONE
+*/
+void CIconIndexDaemon::m_Prewarm(const gchar *dirName)
+{
+  gchar *name = NULL;
+
+  if(!dirName)
+    return;
+
+  name = normalize_dir_name(dirName);
+  m_QueueIndex(name);
+  g_free(name);
+}
+
+/*! \fn gboolean CIconIndexDaemon::m_Listen(void)
+    \brief To create the listening socket. A stale socket file of a dead daemon is replaced.
+
+    \param[in] NONE
+    \return FALSE if another daemon is running or the socket could not be created.
+*/
+gboolean CIconIndexDaemon::m_Listen(void)
+{
+  struct sockaddr_un addr;
+  gchar *dirName = NULL;
+  gint fd = -1;
+
+  if( strlen(m_SocketPath) >= sizeof(addr.sun_path) )
+    return false;
+
+  memset(&addr, 0x00, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, m_SocketPath);
+
+  dirName = g_path_get_dirname(m_SocketPath);
+  g_mkdir_with_parents(dirName, 0700);
+  g_free(dirName);
+
+  /* To check if another daemon is serving. */
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd < 0)
+    return false;
+
+  if( connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("%s(%d) - Another index daemon is running on %s \n", __FUNCTION__, __LINE__, m_SocketPath);
+     #endif
+
+     close(fd);
+     return false;
+  }
+
+  unlink(m_SocketPath);
+
+  if( (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) || (listen(fd, 16) != 0) )
+  {
+     close(fd);
+     return false;
+  }
+
+  m_nListenFd = fd;
+
+  return true;
+}
+
+/*! \fn gboolean CIconIndexDaemon::cb_accept(GIOChannel *source, GIOCondition condition, gpointer thisObject)
+    \brief The callback function to accept a dialog's connection and hand it to a serving thread.
+
+    \param[in] source. The listening socket channel.
+    \param[in] condition. The I/O condition.
+    \param[in] thisObject. The instance of class CIconIndexDaemon.
+    \return TRUE to keep on listening.
+*/
+gboolean CIconIndexDaemon::cb_accept(GIOChannel *source, GIOCondition condition, gpointer thisObject)
+{
+  CIconIndexDaemon *daemon = (CIconIndexDaemon*)thisObject;
+  gint fd = accept4(g_io_channel_unix_get_fd(source), NULL, NULL, SOCK_CLOEXEC);
+
+  if(fd < 0)
+    return true;
+
+  /* A dialog which connects and sends nothing, or stops reading, holds a thread for the timeout at most. */
+  if( !set_socket_timeout(fd, ICON_INDEX_CLIENT_TIMEOUT) ||
+      !g_thread_pool_push(daemon->m_pClientPool, GINT_TO_POINTER(fd + 1), NULL) )
+    close(fd);
+
+  return true;
+}
+
+/*! \fn void CIconIndexDaemon::cb_client_thread(gpointer data, gpointer thisObject)
+    \brief The thread function serving a dialog's connection.
+
+    \param[in] data. The connected socket plus one, so socket 0 is not a NULL job. It is closed here.
+    \param[in] thisObject. The instance of class CIconIndexDaemon.
+    \return NONE
+*/
+void CIconIndexDaemon::cb_client_thread(gpointer data, gpointer thisObject)
+{
+  CIconIndexDaemon *daemon = (CIconIndexDaemon*)thisObject;
+  gint fd = GPOINTER_TO_INT(data) - 1;
+
+  daemon->m_ServeClient(fd);
+  close(fd);
+}
+
+/*! \fn void CIconIndexDaemon::m_ServeClient(gint fd)
+    \brief To answer one request of a dialog, from the index in memory only.
+
+    \param[in] fd. The connected socket, with a timeout on reading and writing.
+    \return NONE
+*/
+void CIconIndexDaemon::m_ServeClient(gint fd)
+{
+  gchar request[ICON_INDEX_MAX_REQUEST] = {0};
+  ICON_INDEX_DIR *dir = NULL;
+  gchar *dirName = NULL;
+  gsize len = 0;
+
+  /* To read the request line. A timeout fails the read. */
+  while( (len < sizeof(request) - 1) && !strchr(request, '\n') )
+  {
+     ssize_t n = read(fd, request + len, sizeof(request) - 1 - len);
+
+     if( (n < 0) && (errno == EINTR) )
+       continue;
+
+     if(n <= 0)
+       return;
+
+     len += n;
+  }
+
+  if( !g_str_has_prefix(request, "LIST ") || !strchr(request, '\n') )
+    return;
+
+  *strchr(request, '\n') = '\0';
+  dirName = normalize_dir_name(request + strlen("LIST "));
+  dir = m_LookupDirectory(dirName);
+  g_free(dirName);
+
+  if( !write_word(fd, ICON_INDEX_MAGIC) || !write_word(fd, ICON_INDEX_VERSION) )
+  {
+     m_ReleaseDirectory(dir);
+     return;
+  }
+
+  /* The dialog loads the directory by itself, the next dialog gets it from the index. */
+  if( !dir )
+  {
+     write_word(fd, ICON_INDEX_MISS);
+     write_word(fd, 0);
+     write_word(fd, 0);
+     return;
+  }
+
+  if( write_word(fd, ICON_INDEX_HIT) && write_word(fd, (guint32)dir->nTotal) && write_word(fd, dir->entries->len) )
+  {
+     for(guint i=0; i<dir->entries->len; i++)
+     {
+        ICON_INDEX_ENTRY *entry = (ICON_INDEX_ENTRY*)g_ptr_array_index(dir->entries, i);
+        gint width = gdk_pixbuf_get_width(entry->pixbuf);
+        gint height = gdk_pixbuf_get_height(entry->pixbuf);
+        gint rowstride = gdk_pixbuf_get_rowstride(entry->pixbuf);
+        gint nChannels = gdk_pixbuf_get_n_channels(entry->pixbuf);
+        guint32 nameLen = strlen(entry->baseName);
+        /* The last row is not padded to the rowstride. */
+        guint32 dataLen = (height - 1) * rowstride + width * nChannels;
+
+        if( !write_word(fd, nameLen) || !write_all(fd, entry->baseName, nameLen) ||
+            !write_quad(fd, entry->contentHash) || !write_quad(fd, entry->fileSize) || !write_quad(fd, (guint64)entry->mtime) ||
+            !write_word(fd, width) || !write_word(fd, height) || !write_word(fd, rowstride) || !write_word(fd, nChannels) ||
+            !write_word(fd, gdk_pixbuf_get_has_alpha(entry->pixbuf)) || !write_word(fd, dataLen) ||
+            !write_all(fd, gdk_pixbuf_get_pixels(entry->pixbuf), dataLen) )
+          break;
+     }
+  }
+
+  m_ReleaseDirectory(dir);
+}
+
+/*! \fn gboolean CIconIndexDaemon::m_Run(void)
+    \brief To index the default icon directories and serve the dialogs until the process is killed.
+
+    \param[in] NONE
+    \return FALSE if the daemon could not start.
+*/
+gboolean CIconIndexDaemon::m_Run(void)
+{
+  const gchar * const *dirs = g_get_system_data_dirs();
+  GIOChannel *channel = NULL;
+  gchar *dirName = NULL;
+
+  /* The default icon paths of the dialog. */
+  m_Prewarm(DEFAULT_ICON_PATH);
+  m_Prewarm(DEFAULT_ICON_PATH_2);
+
+  /* The XDG icon directories, the user's one first. */
+  dirName = g_build_filename(g_get_user_data_dir(), "icons/hicolor/48x48/apps", NULL);
+  m_Prewarm(dirName);
+  g_free(dirName);
+
+  for(const gchar * const *dir = dirs; *dir; ++dir)
+  {
+     dirName = g_build_filename(*dir, ICON_SEARCH_PATH_PIXMAPS, NULL);
+     m_Prewarm(dirName);
+     g_free(dirName);
+
+     dirName = g_build_filename(*dir, ICON_SEARCH_PATH_HICOLOR, "48x48/apps", NULL);
+     m_Prewarm(dirName);
+     g_free(dirName);
+
+     dirName = g_build_filename(*dir, ICON_SEARCH_PATH_HICOLOR_SCALABLE, NULL);
+     m_Prewarm(dirName);
+     g_free(dirName);
+  }
+
+  /* The prewarming goes on in the indexing thread. The dialogs get a miss until their directory is indexed,
+     they load by themselves meanwhile. */
+  if( !m_Listen() )
+    return false;
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - Index daemon is listening on %s \n", __FUNCTION__, __LINE__, m_SocketPath);
+  #endif
+
+  channel = g_io_channel_unix_new(m_nListenFd);
+  g_io_add_watch(channel, G_IO_IN, cb_accept, this);
+  g_io_channel_unref(channel);
+
+  m_pLoop = g_main_loop_new(NULL, FALSE);
+  g_main_loop_run(m_pLoop);
+
+  return true;
+}
+
+/*! \fn static gboolean read_entry(gint fd, ICON_INDEX_ENTRY *entry)
+    \brief To read one entry of a reply. The peer is not trusted, the thumbnail is checked before it is allocated.
+
+    \param[in] fd. The connected socket.
+    \param[out] entry. The entry, its name and thumbnail are set on success.
+    \return FALSE if the reply is truncated or malformed.
+*/
+static gboolean read_entry(gint fd, ICON_INDEX_ENTRY *entry)
+{
+  guint32 nameLen = 0, width = 0, height = 0, rowstride = 0, nChannels = 0, hasAlpha = 0, dataLen = 0;
+  guint64 mtime = 0;
+  guchar *pixels = NULL;
+
+  if( !read_word(fd, &nameLen) || (nameLen == 0) || (nameLen >= ICON_INDEX_MAX_REQUEST) )
+    return false;
+
+  entry->baseName = (gchar*)g_malloc0(nameLen + 1);
+
+  if( !read_all(fd, entry->baseName, nameLen) || strchr(entry->baseName, '/') ||
+      !read_quad(fd, &entry->contentHash) || !read_quad(fd, &entry->fileSize) || !read_quad(fd, &mtime) ||
+      !read_word(fd, &width) || !read_word(fd, &height) || !read_word(fd, &rowstride) ||
+      !read_word(fd, &nChannels) || !read_word(fd, &hasAlpha) || !read_word(fd, &dataLen) )
+    return false;
+
+  entry->mtime = (gint64)mtime;
+
+  /* The sizes are checked in 64 bits, so no product wraps around. */
+  if( (width == 0) || (height == 0) || (width > ICON_INDEX_MAX_SIDE) || (height > ICON_INDEX_MAX_SIDE) ||
+      (hasAlpha > 1) || (nChannels != (hasAlpha ? 4u : 3u)) ||
+      ((guint64)rowstride < (guint64)width * nChannels) || ((guint64)rowstride > (guint64)ICON_INDEX_MAX_SIDE * 4) ||
+      ((guint64)dataLen != (guint64)(height - 1) * rowstride + (guint64)width * nChannels) )
+    return false;
+
+  /* The padding of the last row is not sent. */
+  pixels = (guchar*)g_malloc0((gsize)height * rowstride);
+
+  if( !read_all(fd, pixels, dataLen) )
+  {
+     g_free(pixels);
+     return false;
+  }
+
+  entry->pixbuf = gdk_pixbuf_new_from_data(pixels, GDK_COLORSPACE_RGB, hasAlpha, 8, width, height, rowstride,
+                                           (GdkPixbufDestroyNotify)g_free, NULL);
+
+  return true;
+}
+
+/*! \fn GPtrArray* CIconIndexDaemon::m_QueryDirectory(const gchar *dirName, gint *pTotal)
+    \brief To get the thumbnails of a directory from a running daemon.
+
+    \param[in] dirName. The directory name.
+    \param[out] pTotal. The number of icon files with valid names in the directory.
+    \return The array of ICON_INDEX_ENTRY to be freed with m_FreeEntry(), NULL if no daemon answered,
+             the directory is not indexed yet or the reply is malformed.
+*/
+GPtrArray* CIconIndexDaemon::m_QueryDirectory(const gchar *dirName, gint *pTotal)
+{
+  struct sockaddr_un addr;
+  GPtrArray *entries = NULL;
+  gchar *socketPath = m_GetSocketPath();
+  gchar *request = NULL;
+  guint32 magic = 0, version = 0, status = 0, total = 0, count = 0;
+  gint fd = -1;
+
+  memset(&addr, 0x00, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  g_strlcpy(addr.sun_path, socketPath, sizeof(addr.sun_path));
+  g_free(socketPath);
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd < 0)
+    return NULL;
+
+  /* Without a daemon the socket file does not exist and this fails at once. */
+  if( connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 )
+  {
+     close(fd);
+     return NULL;
+  }
+
+  set_socket_timeout(fd, ICON_INDEX_TIMEOUT);
+
+  request = g_strdup_printf("LIST %s\n", dirName);
+
+  /* The count is only trusted as far as the bounds, the entries are read one by one. */
+  if( !write_all(fd, request, strlen(request)) ||
+      !read_word(fd, &magic) || !read_word(fd, &version) || !read_word(fd, &status) ||
+      !read_word(fd, &total) || !read_word(fd, &count) ||
+      (magic != ICON_INDEX_MAGIC) || (version != ICON_INDEX_VERSION) || (status != ICON_INDEX_HIT) ||
+      (count > ICON_INDEX_MAX_ENTRIES) || (total > ICON_INDEX_MAX_ENTRIES) || (count > total) )
+  {
+     g_free(request);
+     close(fd);
+     return NULL;
+  }
+
+  g_free(request);
+
+  entries = g_ptr_array_sized_new(MIN(count, ICON_READ_BATCH));
+
+  for(guint32 i=0; i<count; i++)
+  {
+     ICON_INDEX_ENTRY *entry = g_new0(ICON_INDEX_ENTRY, 1);
+
+     if( !read_entry(fd, entry) )
+     {
+        m_FreeEntry(entry);
+        break;
+     }
+
+     g_ptr_array_add(entries, entry);
+  }
+
+  close(fd);
+
+  /* A truncated reply is not trusted, the dialog loads the directory by itself. */
+  if(entries->len != count)
+  {
+     g_ptr_array_foreach(entries, (GFunc)m_FreeEntry, NULL);
+     g_ptr_array_free(entries, TRUE);
+     return NULL;
+  }
+
+  if(pTotal)
+    *pTotal = (gint)total;
+
+  return entries;
+}
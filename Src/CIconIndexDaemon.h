@@ -0,0 +1,130 @@
+/*! \file    CIconIndexDaemon.h
+    \brief   Declaration of class CIconIndexDaemon.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONINDEXDAEMON
+#define __CICONINDEXDAEMON
+
+#include <time.h>
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "CIconFileReader.h"
+
+/* The name of the socket under the user's runtime directory. */
+#define ICON_INDEX_SOCKET_DIR   "IconChooser"
+#define ICON_INDEX_SOCKET_NAME  "index.sock"
+
+/* The magic number and version of the replies. */
+#define ICON_INDEX_MAGIC    0x58494349   /* "ICIX" */
+#define ICON_INDEX_VERSION  2
+
+/* The status word of a reply. A miss has no entries, the dialog loads the directory by itself meanwhile. */
+#define ICON_INDEX_HIT   0
+#define ICON_INDEX_MISS  1
+
+/* How long a dialog waits for the reply of the daemon. The unit is "second".
+   The daemon never indexes inside a request, it answers from memory or with a miss. */
+#define ICON_INDEX_TIMEOUT  1
+
+/* How long the daemon waits on a silent or stalled dialog before dropping it. The unit is "second". */
+#define ICON_INDEX_CLIENT_TIMEOUT  2
+
+/* The dialogs served at once, each by a thread of the daemon. */
+#define ICON_INDEX_CLIENT_THREADS  4
+
+/* The directories kept by the daemon, the least recently requested ones are dropped beyond it. */
+#define ICON_INDEX_MAX_DIRS  64
+
+/* The bounds a dialog checks the reply against: the entries of a directory and the side of a thumbnail. */
+#define ICON_INDEX_MAX_ENTRIES  65536
+#define ICON_INDEX_MAX_SIDE     1024
+
+/*! \struct ICON_INDEX_ENTRY
+    \brief One thumbnail of an indexed directory.
+*/
+typedef struct _ICON_INDEX_ENTRY
+{
+  gchar     *baseName;     /*!< The icon file's basename, e.g. filename.extension. */
+  GdkPixbuf *pixbuf;       /*!< The thumbnail. */
+  guint64    contentHash;  /*!< The content hash of the file, 0 if it was too large to be read into memory. */
+  guint64    fileSize;     /*!< The size of the file on disk. */
+  gint64     mtime;        /*!< The modification time of the file, in second. */
+} ICON_INDEX_ENTRY;
+
+/*! \struct ICON_INDEX_DIR
+    \brief The index of one directory. It is reference counted, a reply keeps it while the directory is indexed again.
+*/
+typedef struct _ICON_INDEX_DIR
+{
+  time_t     mtime;     /*!< The modification time of the directory when it was indexed. */
+  gint       nTotal;    /*!< The number of icon files with valid names, including the ones failed to decode. */
+  GPtrArray *entries;   /*!< The ICON_INDEX_ENTRY of the decoded icons. */
+  gint       nRef;      /*!< The references, one by m_pIndex and one by every reply being written. */
+  guint64    nLastUsed; /*!< The request counter when it was last requested, for dropping the least recently used. */
+} ICON_INDEX_DIR;
+
+/*! \class CIconIndexDaemon
+    \brief A long-running process keeping thumbnails of icon directories in memory and serving them
+           to Icon Chooser dialogs over a local UNIX socket.
+
+    The request is one line "LIST <directory>\n". The reply is a header of five 32-bit words
+    (magic, version, status, total, count) followed by "count" entries:
+    name length, name, content hash(64-bit), file size(64-bit), modification time(64-bit),
+    width, height, rowstride, channels, has-alpha, pixel data length and pixel data.
+    All words are in host byte order, since both ends run on the same machine.
+
+    The main loop only accepts the connections, the requests are served by a thread pool with a timeout per dialog.
+    A directory not indexed, or changed since, is answered with a miss at once and indexed by a thread of its own.
+*/
+class CIconIndexDaemon
+{
+  private:
+    GHashTable *m_pIndex;         /*!< The directory name(with a trailing "/") to ICON_INDEX_DIR. Protected by m_IndexLock. */
+    GHashTable *m_pIndexing;      /*!< The directory names queued or being indexed. Protected by m_IndexLock. */
+    guint64 m_nRequests;          /*!< The request counter, the LRU clock of m_pIndex. Protected by m_IndexLock. */
+    GMutex m_IndexLock;           /*!< Protect the index between the serving and the indexing threads. */
+    CIconFileReader *m_pReader;   /*!< Read icon files in batches, only by the indexing thread once serving. */
+    GThreadPool *m_pIndexPool;    /*!< The indexing thread, one directory at a time. */
+    GThreadPool *m_pClientPool;   /*!< The threads serving the dialogs. */
+    gint m_nListenFd;             /*!< The listening socket. */
+    gchar *m_SocketPath;          /*!< The socket file name. */
+    GMainLoop *m_pLoop;           /*!< The main loop accepting the connections. */
+
+    ICON_INDEX_DIR* m_IndexDirectory(const gchar *dirName);
+    void m_StoreDirectory(const gchar *dirName, ICON_INDEX_DIR *dir);
+    void m_QueueIndex(const gchar *dirName);
+    ICON_INDEX_DIR* m_LookupDirectory(const gchar *dirName);
+    gboolean m_Listen(void);
+    void m_ServeClient(gint fd);
+
+    static gboolean cb_accept(GIOChannel *source, GIOCondition condition, gpointer thisObject);
+    static void cb_index_thread(gpointer data, gpointer thisObject);
+    static void cb_client_thread(gpointer data, gpointer thisObject);
+    static void m_FreeDirectory(gpointer data);
+    static void m_ReleaseDirectory(gpointer data);
+
+  public:
+    CIconIndexDaemon();
+    ~CIconIndexDaemon();
+
+    /* To index the default icon directories and serve the dialogs until killed. */
+    gboolean m_Run(void);
+
+    /* To index a directory ahead of requests. */
+    void m_Prewarm(const gchar *dirName);
+
+    /* The name of the socket the daemon listens on. The returned string must be freed. */
+    static gchar* m_GetSocketPath(void);
+
+    /* Client side: to get the thumbnails of a directory from a running daemon, NULL if there is no daemon. */
+    static GPtrArray* m_QueryDirectory(const gchar *dirName, gint *pTotal);
+    static void m_FreeEntry(gpointer data);
+};
+#endif   /* CICONINDEXDAEMON.H	*/
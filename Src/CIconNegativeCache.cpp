@@ -0,0 +1,361 @@
+/*! \file    CIconNegativeCache.cpp
+    \brief   Remember the icon files which failed to decode and the names which failed to resolve, across runs.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "CIconNegativeCache.h"
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconNegativeCache::CIconNegativeCache(const gchar *fileName)
+    \brief CIconNegativeCache constructor
+
+    \param[in] fileName. The file the failures are kept in, NULL for "$XDG_CACHE_HOME/IconChooser/negative-cache".
+*/
+CIconNegativeCache::CIconNegativeCache(const gchar *fileName)
+{
+  if(fileName)
+    m_FileName = g_strdup(fileName);
+  else
+    m_FileName = g_build_filename(g_get_user_cache_dir(), ICON_NEGATIVE_CACHE_DIR, ICON_NEGATIVE_CACHE_NAME, NULL);
+
+  g_mutex_init(&m_Lock);
+  m_pFiles = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+  m_pNames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  m_bDirty = false;
+
+  m_Load();
+}
+
+/*! \fn CIconNegativeCache::~CIconNegativeCache()
+    \brief CIconNegativeCache destructor
+*/
+CIconNegativeCache::~CIconNegativeCache()
+{
+  m_Save();
+
+  g_hash_table_destroy(m_pFiles);
+  g_hash_table_destroy(m_pNames);
+  g_mutex_clear(&m_Lock);
+  g_free(m_FileName);
+
+  m_pFiles = NULL;
+  m_pNames = NULL;
+  m_FileName = NULL;
+}
+
+/*! \fn gchar* CIconNegativeCache::m_GetNameKey(const gchar *themeName, const gchar *iconName, gint size)
+    \brief To make the key of an icon name in a theme at a size.
+
+    \return The key, it must be freed.
+*/
+gchar* CIconNegativeCache::m_GetNameKey(const gchar *themeName, const gchar *iconName, gint size)
+{
+  return g_strdup_printf("%s\t%s\t%d", themeName ? themeName : "", iconName, size);
+}
+
+/*! \fn void CIconNegativeCache::m_Load(void)
+    \brief To read the failures kept in the file. One failure per line, the fields are separated by tabs:
+    \n "F <mtime> <size> <full file name>" for a file and "N <generation> <theme> <icon name> <size>" for a name.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconNegativeCache::m_Load(void)
+{
+  gchar *contents = NULL;
+  gchar **lines = NULL;
+
+  if( !g_file_get_contents(m_FileName, &contents, NULL, NULL) )
+    return;
+
+  lines = g_strsplit(contents, "\n", -1);
+  g_free(contents);
+
+  /* A file of another version is ignored, it is written again at the next m_Save(). */
+  if( !lines[0] || (strcmp(lines[0], ICON_NEGATIVE_CACHE_MAGIC) != 0) )
+  {
+     g_strfreev(lines);
+     return;
+  }
+
+  for(gint i=1; lines[i]; i++)
+  {
+     gchar **fields = g_strsplit(lines[i], "\t", 5);
+     guint nFields = g_strv_length(fields);
+
+     if( (nFields == 4) && (strcmp(fields[0], "F") == 0) && g_path_is_absolute(fields[3]) )
+     {
+        ICON_NEGATIVE_FILE *file = g_new0(ICON_NEGATIVE_FILE, 1);
+
+        file->mtime = g_ascii_strtoll(fields[1], NULL, 10);
+        file->size = g_ascii_strtoull(fields[2], NULL, 10);
+        g_hash_table_replace(m_pFiles, g_strdup(fields[3]), file);
+     }
+     else if( (nFields == 5) && (strcmp(fields[0], "N") == 0) )
+     {
+        guint32 generation = (guint32)g_ascii_strtoull(fields[1], NULL, 10);
+
+        g_hash_table_replace(m_pNames, g_strdup_printf("%s\t%s\t%s", fields[2], fields[3], fields[4]), GUINT_TO_POINTER(generation));
+     }
+
+     g_strfreev(fields);
+  }
+
+  g_strfreev(lines);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - %u files and %u names known to fail \n", __FUNCTION__, __LINE__,
+         g_hash_table_size(m_pFiles), g_hash_table_size(m_pNames));
+  #endif
+}
+
+/*! \fn gboolean CIconNegativeCache::m_Save(void)
+    \brief To write the failures to the file if they changed. The file is replaced at once, never left half written.
+
+    \param[in] NONE
+    \return FALSE if the file could not be written.
+*/
+gboolean CIconNegativeCache::m_Save(void)
+{
+  GString *text = NULL;
+  GHashTableIter iter;
+  gpointer key = NULL, value = NULL;
+  gchar *dirName = NULL;
+  gboolean bSaved = false;
+
+  g_mutex_lock(&m_Lock);
+
+  if(!m_bDirty)
+  {
+     g_mutex_unlock(&m_Lock);
+     return true;
+  }
+
+  text = g_string_new(ICON_NEGATIVE_CACHE_MAGIC "\n");
+
+  g_hash_table_iter_init(&iter, m_pFiles);
+  while( g_hash_table_iter_next(&iter, &key, &value) )
+  {
+     ICON_NEGATIVE_FILE *file = (ICON_NEGATIVE_FILE*)value;
+
+     g_string_append_printf(text, "F\t%" G_GINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%s\n", file->mtime, file->size, (const gchar*)key);
+  }
+
+  g_hash_table_iter_init(&iter, m_pNames);
+  while( g_hash_table_iter_next(&iter, &key, &value) )
+    g_string_append_printf(text, "N\t%u\t%s\n", GPOINTER_TO_UINT(value), (const gchar*)key);
+
+  m_bDirty = false;
+
+  g_mutex_unlock(&m_Lock);
+
+  dirName = g_path_get_dirname(m_FileName);
+  g_mkdir_with_parents(dirName, 0700);
+  g_free(dirName);
+
+  bSaved = g_file_set_contents(m_FileName, text->str, text->len, NULL);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if(!bSaved)
+    printf("%s(%d) - %s could not be written \n", __FUNCTION__, __LINE__, m_FileName);
+  #endif
+
+  g_string_free(text, TRUE);
+
+  return bSaved;
+}
+
+/*! \fn gboolean CIconNegativeCache::m_IsBadFile(const gchar *fullName, gint64 mtime, guint64 size)
+    \brief To check if a file failed to decode before, and has not changed since.
+
+    \param[in] fullName. The full file name.
+    \param[in] mtime. The modification time of the file now.
+    \param[in] size. The size of the file now.
+    \return TRUE if it is known to fail.
+*/
+gboolean CIconNegativeCache::m_IsBadFile(const gchar *fullName, gint64 mtime, guint64 size)
+{
+  ICON_NEGATIVE_FILE *file = NULL;
+  gboolean bBad = false;
+
+  if(!fullName)
+    return false;
+
+  g_mutex_lock(&m_Lock);
+
+  file = (ICON_NEGATIVE_FILE*)g_hash_table_lookup(m_pFiles, fullName);
+  if(file)
+  {
+     bBad = (file->mtime == mtime) && (file->size == size);
+
+     /* The file changed, it is decoded again and only remembered if it fails again. */
+     if(!bBad)
+     {
+        g_hash_table_remove(m_pFiles, fullName);
+        m_bDirty = true;
+     }
+  }
+
+  g_mutex_unlock(&m_Lock);
+
+  return bBad;
+}
+
+/*! \fn gboolean CIconNegativeCache::m_IsKnownBadFile(const gchar *fullName)
+    \brief To check if a file failed to decode before, before it is read. Only the files which had failed are stat()ed.
+
+    \param[in] fullName. The full file name.
+    \return TRUE if it is known to fail.
+*/
+gboolean CIconNegativeCache::m_IsKnownBadFile(const gchar *fullName)
+{
+  struct stat st;
+  gboolean bKnown = false;
+
+  if(!fullName)
+    return false;
+
+  g_mutex_lock(&m_Lock);
+  bKnown = (g_hash_table_lookup(m_pFiles, fullName) != NULL);
+  g_mutex_unlock(&m_Lock);
+
+  if( !bKnown || (stat(fullName, &st) != 0) )
+    return false;
+
+  return m_IsBadFile(fullName, (gint64)st.st_mtime, (guint64)st.st_size);
+}
+
+/*! \fn void CIconNegativeCache::m_AddBadFile(const gchar *fullName, gint64 mtime, guint64 size)
+    \brief To remember a file which could not be decoded.
+
+    \param[in] fullName. The full file name.
+    \param[in] mtime. The modification time of the file.
+    \param[in] size. The size of the file.
+    \return NONE
+*/
+void CIconNegativeCache::m_AddBadFile(const gchar *fullName, gint64 mtime, guint64 size)
+{
+  ICON_NEGATIVE_FILE *file = NULL;
+
+  /* A name with a line break could not be written back. */
+  if( !fullName || strpbrk(fullName, "\t\n") )
+    return;
+
+  file = g_new0(ICON_NEGATIVE_FILE, 1);
+  file->mtime = mtime;
+  file->size = size;
+
+  g_mutex_lock(&m_Lock);
+
+  if( g_hash_table_size(m_pFiles) >= ICON_NEGATIVE_MAX_ENTRIES )
+    g_hash_table_remove_all(m_pFiles);
+
+  g_hash_table_replace(m_pFiles, g_strdup(fullName), file);
+  m_bDirty = true;
+
+  g_mutex_unlock(&m_Lock);
+}
+
+/*! \fn gboolean CIconNegativeCache::m_IsUnresolvable(const gchar *themeName, const gchar *iconName, gint size, guint32 generation)
+    \brief To check if an icon name failed to resolve before, in the same generation of the theme.
+
+    \param[in] themeName. The theme looked up.
+    \param[in] iconName. The icon name.
+    \param[in] size. The size in device pixels.
+    \param[in] generation. The generation of the theme now.
+    \return TRUE if it is known to fail.
+*/
+gboolean CIconNegativeCache::m_IsUnresolvable(const gchar *themeName, const gchar *iconName, gint size, guint32 generation)
+{
+  gchar *key = m_GetNameKey(themeName, iconName, size);
+  gpointer value = NULL;
+  gboolean bFound = false;
+
+  g_mutex_lock(&m_Lock);
+  bFound = g_hash_table_lookup_extended(m_pNames, key, NULL, &value);
+  g_mutex_unlock(&m_Lock);
+
+  g_free(key);
+
+  return bFound && (GPOINTER_TO_UINT(value) == generation);
+}
+
+/*! \fn void CIconNegativeCache::m_AddUnresolvable(const gchar *themeName, const gchar *iconName, gint size, guint32 generation)
+    \brief To remember an icon name which could not be resolved.
+
+    \param[in] themeName. The theme looked up.
+    \param[in] iconName. The icon name.
+    \param[in] size. The size in device pixels.
+    \param[in] generation. The generation of the theme.
+    \return NONE
+*/
+void CIconNegativeCache::m_AddUnresolvable(const gchar *themeName, const gchar *iconName, gint size, guint32 generation)
+{
+  if( !iconName || strpbrk(iconName, "\t\n") || (themeName && strpbrk(themeName, "\t\n")) )
+    return;
+
+  g_mutex_lock(&m_Lock);
+
+  if( g_hash_table_size(m_pNames) >= ICON_NEGATIVE_MAX_ENTRIES )
+    g_hash_table_remove_all(m_pNames);
+
+  g_hash_table_replace(m_pNames, m_GetNameKey(themeName, iconName, size), GUINT_TO_POINTER(generation));
+  m_bDirty = true;
+
+  g_mutex_unlock(&m_Lock);
+}
+
+/*! \fn void CIconNegativeCache::m_Clear(void)
+    \brief To forget all failures.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconNegativeCache::m_Clear(void)
+{
+  g_mutex_lock(&m_Lock);
+
+  g_hash_table_remove_all(m_pFiles);
+  g_hash_table_remove_all(m_pNames);
+  m_bDirty = true;
+
+  g_mutex_unlock(&m_Lock);
+}
+
+/*! \fn guint CIconNegativeCache::m_GetFileCount(void)
+    \brief To get the number of files known to fail.
+*/
+guint CIconNegativeCache::m_GetFileCount(void)
+{
+  guint nCount = 0;
+
+  g_mutex_lock(&m_Lock);
+  nCount = g_hash_table_size(m_pFiles);
+  g_mutex_unlock(&m_Lock);
+
+  return nCount;
+}
+
+/*! \fn guint CIconNegativeCache::m_GetNameCount(void)
+    \brief To get the number of icon names known to fail.
+*/
+guint CIconNegativeCache::m_GetNameCount(void)
+{
+  guint nCount = 0;
+
+  g_mutex_lock(&m_Lock);
+  nCount = g_hash_table_size(m_pNames);
+  g_mutex_unlock(&m_Lock);
+
+  return nCount;
+}
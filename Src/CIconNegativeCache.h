@@ -0,0 +1,82 @@
+/*! \file    CIconNegativeCache.h
+    \brief   Declaration of class CIconNegativeCache.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONNEGATIVECACHE
+#define __CICONNEGATIVECACHE
+
+#include <glib.h>
+
+/* The directory under the user's cache directory the negative cache is kept in, and its file name. */
+#define ICON_NEGATIVE_CACHE_DIR   "IconChooser"
+#define ICON_NEGATIVE_CACHE_NAME  "negative-cache"
+
+/* The first line of the file, the file is ignored if it differs. */
+#define ICON_NEGATIVE_CACHE_MAGIC  "# IconChooser negative cache 1"
+
+/* The failures kept of each kind at most, all of that kind are forgotten when there are more. */
+#define ICON_NEGATIVE_MAX_ENTRIES  16384
+
+/*! \struct ICON_NEGATIVE_FILE
+    \brief The identity of a file which could not be decoded.
+*/
+typedef struct _ICON_NEGATIVE_FILE
+{
+  gint64  mtime;   /*!< The modification time of the file when it failed, in second. */
+  guint64 size;    /*!< The size of the file when it failed. */
+} ICON_NEGATIVE_FILE;
+
+/*! \class CIconNegativeCache
+    \brief Remembers the icon files which could not be decoded and the icon names which could not be resolved,
+           across runs, so they are not tried again.
+
+    A file is known bad as long as its modification time and size are those it failed with.
+    A name is known unresolvable as long as the generation of the theme it was looked up in is the same,
+    the generation changes when the theme directories change, e.g. an icon is installed.
+    The failures are kept in a text file under the user's cache directory, written when they changed.
+    All members may be called from several threads at once.
+*/
+class CIconNegativeCache
+{
+  private:
+    GMutex m_Lock;         /*!< Protect the tables and m_bDirty. */
+    GHashTable *m_pFiles;  /*!< The full file name to its ICON_NEGATIVE_FILE. */
+    GHashTable *m_pNames;  /*!< "theme\tname\tsize" to the theme generation it failed in. */
+    gchar *m_FileName;     /*!< The file the failures are kept in. */
+    gboolean m_bDirty;     /*!< To indicate if the tables changed since they were read or written. */
+
+    void m_Load(void);
+    static gchar* m_GetNameKey(const gchar *themeName, const gchar *iconName, gint size);
+
+  public:
+    /* The failures are read from the file, NULL for the file under the user's cache directory. */
+    CIconNegativeCache(const gchar *fileName);
+    ~CIconNegativeCache();
+
+    /* To check or remember a file which could not be decoded. */
+    gboolean m_IsBadFile(const gchar *fullName, gint64 mtime, guint64 size);
+    void m_AddBadFile(const gchar *fullName, gint64 mtime, guint64 size);
+
+    /* To check a file by its name only, it is only stat()ed when it had failed before. */
+    gboolean m_IsKnownBadFile(const gchar *fullName);
+
+    /* To check or remember an icon name which could not be resolved. */
+    gboolean m_IsUnresolvable(const gchar *themeName, const gchar *iconName, gint size, guint32 generation);
+    void m_AddUnresolvable(const gchar *themeName, const gchar *iconName, gint size, guint32 generation);
+
+    /* To write the failures to the file if they changed. */
+    gboolean m_Save(void);
+
+    /* To forget all failures, the file is emptied at the next m_Save(). */
+    void m_Clear(void);
+
+    guint m_GetFileCount(void);
+    guint m_GetNameCount(void);
+};
+#endif   /* CICONNEGATIVECACHE.H	*/
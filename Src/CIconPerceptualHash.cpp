@@ -0,0 +1,205 @@
+/*! \file    CIconPerceptualHash.cpp
+    \brief   Compute and compare the difference hashes of icon thumbnails.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <string.h>
+
+#include "CIconPerceptualHash.h"
+
+/* The size of the shrunk gray image. One column more than the hash width, for the right neighbours. */
+#define DHASH_WIDTH   9
+#define DHASH_HEIGHT  8
+
+/* The POPCNT instruction is taken at run time if the compiler does not target it already, e.g. without -mpopcnt. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__POPCNT__)
+#define DHASH_POPCNT_DISPATCH
+#endif
+
+/*! \fn static inline guint64 popcount64(guint64 x)
+    \brief To count the set bits of a word.
+
+    The POPCNT instruction is used if the compiler targets it(e.g. -mpopcnt or -march=native).
+    Otherwise the bits are added in parallel with shifts and masks only, which the compiler could
+    vectorize over the loop in m_Rank().
+*/
+static inline guint64 popcount64(guint64 x)
+{
+#if defined(__GNUC__) && defined(__POPCNT__)
+  return (guint64)__builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  x = x + (x >> 8);
+  x = x + (x >> 16);
+  x = x + (x >> 32);
+
+  return x & 0x7f;
+#endif
+}
+
+/*! \fn static void get_distances(const guint64 *hashes, guint n, guint64 query, guint8 *distances)
+    \brief To get the distances of hashes to a query. The hot loop: no branches and no data dependencies between the iterations.
+*/
+static void get_distances(const guint64 *hashes, guint n, guint64 query, guint8 *distances)
+{
+  for(guint i=0; i<n; i++)
+    distances[i] = (guint8)popcount64(hashes[i] ^ query);
+}
+
+#ifdef DHASH_POPCNT_DISPATCH
+/*! \fn static void get_distances_popcnt(const guint64 *hashes, guint n, guint64 query, guint8 *distances)
+    \brief get_distances() compiled for the POPCNT instruction, only called if the CPU has it.
+*/
+__attribute__((target("popcnt")))
+static void get_distances_popcnt(const guint64 *hashes, guint n, guint64 query, guint8 *distances)
+{
+  for(guint i=0; i<n; i++)
+    distances[i] = (guint8)__builtin_popcountll(hashes[i] ^ query);
+}
+
+/*! \fn static gint distance_popcnt(guint64 a, guint64 b)
+    \brief The Hamming distance by the POPCNT instruction, only called if the CPU has it.
+*/
+__attribute__((target("popcnt")))
+static gint distance_popcnt(guint64 a, guint64 b)
+{
+  return __builtin_popcountll(a ^ b);
+}
+
+/*! \fn static gboolean has_popcnt(void)
+    \brief To check once if the CPU has the POPCNT instruction.
+*/
+static gboolean has_popcnt(void)
+{
+  static gint nSupported = -1;
+  gint supported = g_atomic_int_get(&nSupported);
+
+  /* Two threads could check at once, they get the same answer. */
+  if(supported < 0)
+  {
+     __builtin_cpu_init();
+     supported = __builtin_cpu_supports("popcnt") ? 1 : 0;
+     g_atomic_int_set(&nSupported, supported);
+  }
+
+  return (supported == 1);
+}
+#endif
+
+//--------------- Class Member Function Implementation.
+/*! \fn guint64 CIconPerceptualHash::m_Compute(GdkPixbuf *pixbuf)
+    \brief To compute the difference hash of a thumbnail.
+
+    \param[in] pixbuf. The thumbnail, e.g. the 48 pixels one shown in the icon view.
+    \return The 64-bit hash, 0 if the thumbnail could not be shrunk.
+*/
+guint64 CIconPerceptualHash::m_Compute(GdkPixbuf *pixbuf)
+{
+  GdkPixbuf *small = NULL;
+  const guchar *pixels = NULL;
+  gint rowstride = 0, nChannels = 0;
+  gboolean hasAlpha = false;
+  guint gray[DHASH_HEIGHT][DHASH_WIDTH];
+  guint64 hash = 0;
+
+  if(!pixbuf)
+    return 0;
+
+  small = gdk_pixbuf_scale_simple(pixbuf, DHASH_WIDTH, DHASH_HEIGHT, GDK_INTERP_BILINEAR);
+  if(!small)
+    return 0;
+
+  pixels = gdk_pixbuf_get_pixels(small);
+  rowstride = gdk_pixbuf_get_rowstride(small);
+  nChannels = gdk_pixbuf_get_n_channels(small);
+  hasAlpha = gdk_pixbuf_get_has_alpha(small);
+
+  for(gint y=0; y<DHASH_HEIGHT; y++)
+  {
+     const guchar *p = pixels + y * rowstride;
+
+     for(gint x=0; x<DHASH_WIDTH; x++, p+=nChannels)
+     {
+        /* ITU-R BT.601 luma, scaled by 1000. */
+        guint luma = p[0] * 299 + p[1] * 587 + p[2] * 114;
+
+        /* Icons are mostly shapes on a transparent background, which is taken as white. */
+        if(hasAlpha)
+          luma = (luma * p[3] + 255000 * (255 - p[3])) / 255;
+
+        gray[y][x] = luma;
+     }
+  }
+
+  g_object_unref(small);
+
+  for(gint y=0; y<DHASH_HEIGHT; y++)
+    for(gint x=0; x<DHASH_WIDTH-1; x++)
+       hash = (hash << 1) | (gray[y][x] < gray[y][x + 1]);
+
+  return hash;
+}
+
+/*! \fn gint CIconPerceptualHash::m_Distance(guint64 a, guint64 b)
+    \brief To get the Hamming distance of two hashes.
+
+    \param[in] a. One hash.
+    \param[in] b. The other hash.
+    \return The number of differing bits, 0 to 64.
+*/
+gint CIconPerceptualHash::m_Distance(guint64 a, guint64 b)
+{
+#ifdef DHASH_POPCNT_DISPATCH
+  if( has_popcnt() )
+    return distance_popcnt(a, b);
+#endif
+
+  return (gint)popcount64(a ^ b);
+}
+
+/*! \fn void CIconPerceptualHash::m_Rank(const guint64 *hashes, guint n, guint64 query, gint *order)
+    \brief To order hashes by their distance to a query, nearest first.
+    \n The distances are only 0 to 64, so a counting sort does it in two linear passes.
+
+    \param[in] hashes. The contiguous array of hashes.
+    \param[in] n. The number of hashes.
+    \param[in] query. The hash to compare with.
+    \param[out] order. "n" indexes of hashes, the nearest first. Equal distances keep their order.
+    \return NONE
+*/
+void CIconPerceptualHash::m_Rank(const guint64 *hashes, guint n, guint64 query, gint *order)
+{
+  guint start[ICON_PHASH_MAX_DISTANCE + 2];
+  guint8 *distances = NULL;
+
+  if( !hashes || !order || (n == 0) )
+    return;
+
+  distances = g_new(guint8, n);
+
+#ifdef DHASH_POPCNT_DISPATCH
+  if( has_popcnt() )
+    get_distances_popcnt(hashes, n, query, distances);
+  else
+#endif
+    get_distances(hashes, n, query, distances);
+
+  memset(start, 0x00, sizeof(start));
+  for(guint i=0; i<n; i++)
+    start[distances[i] + 1]++;
+
+  for(gint d=1; d<=ICON_PHASH_MAX_DISTANCE+1; d++)
+    start[d] += start[d - 1];
+
+  for(guint i=0; i<n; i++)
+    order[ start[distances[i]]++ ] = (gint)i;
+
+  g_free(distances);
+}
@@ -0,0 +1,40 @@
+/*! \file    CIconPerceptualHash.h
+    \brief   Declaration of class CIconPerceptualHash.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONPERCEPTUALHASH
+#define __CICONPERCEPTUALHASH
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* The largest Hamming distance of two 64-bit hashes. */
+#define ICON_PHASH_MAX_DISTANCE  64
+
+/*! \class CIconPerceptualHash
+    \brief The difference hash(dHash) of icons, so similar looking icons could be found.
+
+    The thumbnail is shrunk to 9x8 gray pixels. Each of the 64 bits tells if a pixel is darker
+    than its right neighbour, so the hash survives scaling, small color shifts and re-encoding.
+    Two icons look alike if few bits differ.
+*/
+class CIconPerceptualHash
+{
+  public:
+    /* To compute the hash of a thumbnail. The transparent parts are taken as white. */
+    static guint64 m_Compute(GdkPixbuf *pixbuf);
+
+    /* The number of differing bits. */
+    static gint m_Distance(guint64 a, guint64 b);
+
+    /* To order "n" hashes by their distance to "query", nearest first. Equal distances keep their order.
+       order[rank] is set to the index of the hash, as gtk_list_store_reorder() takes it. */
+    static void m_Rank(const guint64 *hashes, guint n, guint64 query, gint *order);
+};
+#endif   /* CICONPERCEPTUALHASH.H	*/
@@ -0,0 +1,353 @@
+/*! \file    CIconProfiler.cpp
+    \brief   Collect the timing of every icon loading stage and export it as JSON or Chrome trace events.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CIconProfiler.h"
+
+/*! \struct ICONPROF_EVENT
+    \brief One complete("X") trace event.
+*/
+typedef struct _ICONPROF_EVENT
+{
+  gint64 nStart;   /*!< The start time relative to the profiler epoch, in microsecond. */
+  gint64 nDur;     /*!< The duration in microsecond. */
+  guint  nTid;     /*!< The recording thread. */
+  gint16 nStage;   /*!< ICONPROF_STAGE */
+  gint16 nFormat;  /*!< ICONPROF_FORMAT of a decoding event, -1 for the others. */
+} ICONPROF_EVENT;
+
+/* The names used in the exported files. */
+static const gchar *s_StageNames[N_ICONPROF_STAGE] = {
+  "LoadIconList", "ReloadIconList", "Enumerate", "Filter", "Read", "Decode",
+  "LoadIcon", "LoadIconFile", "ThemeLookup", "ModelInsert"
+};
+
+static const gchar *s_FormatNames[N_ICONPROF_FORMAT] = {
+  "png", "xpm", "svg", "jpeg", "gif", "tiff", "bmp", "other"
+};
+
+GMutex CIconProfiler::m_Lock;
+ICONPROF_STAT CIconProfiler::m_Stages[N_ICONPROF_STAGE];
+ICONPROF_STAT CIconProfiler::m_Formats[N_ICONPROF_FORMAT];
+GArray *CIconProfiler::m_pTrace = NULL;
+gint64 CIconProfiler::m_nEpoch = 0;
+gboolean CIconProfiler::m_bInitialized = false;
+
+/*! \fn void CIconProfiler::m_Init(void)
+    \brief To set up the profiler on the first record. It is called from the main thread before any worker records.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconProfiler::m_Init(void)
+{
+  if(m_bInitialized)
+    return;
+
+  m_bInitialized = true;
+  m_nEpoch = g_get_monotonic_time();
+
+  m_Reset();
+
+  /* The trace events are only kept if someone wants them. */
+  if( g_getenv("ICONCHOOSER_TRACE") )
+    m_pTrace = g_array_new(FALSE, FALSE, sizeof(ICONPROF_EVENT));
+
+  atexit(m_DumpAtExit);
+}
+
+/*! \fn void CIconProfiler::m_Reset(void)
+    \brief To clear all statistics and trace events.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconProfiler::m_Reset(void)
+{
+  g_mutex_lock(&m_Lock);
+
+  memset(m_Stages, 0x00, sizeof(m_Stages));
+  memset(m_Formats, 0x00, sizeof(m_Formats));
+
+  if(m_pTrace)
+    g_array_set_size(m_pTrace, 0);
+
+  g_mutex_unlock(&m_Lock);
+}
+
+/*! \fn void CIconProfiler::m_AddSample(ICONPROF_STAT *pStat, gint64 nUsec, gboolean bFailed)
+    \brief To add one duration to the statistics. The lock must be held.
+
+    \param[in,out] pStat. The statistics.
+    \param[in] nUsec. The duration in microsecond.
+    \param[in] bFailed. To indicate if the measured operation failed.
+    \return NONE
+*/
+void CIconProfiler::m_AddSample(ICONPROF_STAT *pStat, gint64 nUsec, gboolean bFailed)
+{
+  guint nBucket = 0;
+
+  if( (pStat->nCount == 0) || (nUsec < pStat->nMinUsec) )
+    pStat->nMinUsec = nUsec;
+
+  if(nUsec > pStat->nMaxUsec)
+    pStat->nMaxUsec = nUsec;
+
+  pStat->nCount++;
+  pStat->nTotalUsec += nUsec;
+
+  if(bFailed)
+    pStat->nFailed++;
+
+  /* The number of significant bits is the log2 bucket. */
+  nBucket = (nUsec > 0) ? g_bit_storage((gulong)nUsec) : 0;
+  pStat->nBuckets[ MIN(nBucket, ICONPROF_BUCKETS - 1) ]++;
+}
+
+/*! \fn void CIconProfiler::m_Record(ICONPROF_STAGE stage, gint64 nStart, gint64 nEnd)
+    \brief To record a duration of a stage.
+
+    \param[in] stage. The stage.
+    \param[in] nStart. The monotonic start time in microsecond.
+    \param[in] nEnd. The monotonic end time in microsecond.
+    \return NONE
+*/
+void CIconProfiler::m_Record(ICONPROF_STAGE stage, gint64 nStart, gint64 nEnd)
+{
+  if(!m_bInitialized)
+    m_Init();
+
+  g_mutex_lock(&m_Lock);
+
+  m_AddSample(&m_Stages[stage], nEnd - nStart, false);
+
+  if( m_pTrace && (m_pTrace->len < ICONPROF_MAX_TRACE_EVENTS) )
+  {
+     ICONPROF_EVENT event;
+
+     event.nStart = nStart - m_nEpoch;
+     event.nDur = nEnd - nStart;
+     event.nTid = GPOINTER_TO_UINT(g_thread_self());
+     event.nStage = (gint16)stage;
+     event.nFormat = -1;
+     g_array_append_val(m_pTrace, event);
+  }
+
+  g_mutex_unlock(&m_Lock);
+}
+
+/*! \fn void CIconProfiler::m_RecordDecode(const gchar *fileName, gint64 nStart, gint64 nEnd, gboolean bSucceeded)
+    \brief To record the decoding cost of an icon file, both to the "Decode" stage and to its format.
+
+    \param[in] fileName. The icon file name, its extension name selects the format.
+    \param[in] nStart. The monotonic start time in microsecond.
+    \param[in] nEnd. The monotonic end time in microsecond.
+    \param[in] bSucceeded. To indicate if an image was decoded.
+    \return NONE
+*/
+void CIconProfiler::m_RecordDecode(const gchar *fileName, gint64 nStart, gint64 nEnd, gboolean bSucceeded)
+{
+  ICONPROF_FORMAT format = m_GetFormat(fileName);
+
+  if(!m_bInitialized)
+    m_Init();
+
+  g_mutex_lock(&m_Lock);
+
+  m_AddSample(&m_Stages[ICONPROF_STAGE_Decode], nEnd - nStart, !bSucceeded);
+  m_AddSample(&m_Formats[format], nEnd - nStart, !bSucceeded);
+
+  if( m_pTrace && (m_pTrace->len < ICONPROF_MAX_TRACE_EVENTS) )
+  {
+     ICONPROF_EVENT event;
+
+     event.nStart = nStart - m_nEpoch;
+     event.nDur = nEnd - nStart;
+     event.nTid = GPOINTER_TO_UINT(g_thread_self());
+     event.nStage = (gint16)ICONPROF_STAGE_Decode;
+     event.nFormat = (gint16)format;
+     g_array_append_val(m_pTrace, event);
+  }
+
+  g_mutex_unlock(&m_Lock);
+}
+
+/*! \fn ICONPROF_FORMAT CIconProfiler::m_GetFormat(const gchar *fileName)
+    \brief To get the format an icon file is accounted to by its extension name.
+
+    \param[in] fileName. The icon file name.
+    \return The format.
+*/
+ICONPROF_FORMAT CIconProfiler::m_GetFormat(const gchar *fileName)
+{
+  const gchar *ext = fileName ? strrchr(fileName, '.') : NULL;
+
+  if(!ext)
+    return ICONPROF_FORMAT_Other;
+
+  if( !g_ascii_strcasecmp(ext, ".png") )
+    return ICONPROF_FORMAT_PNG;
+
+  if( !g_ascii_strcasecmp(ext, ".xpm") )
+    return ICONPROF_FORMAT_XPM;
+
+  if( !g_ascii_strcasecmp(ext, ".svg") )
+    return ICONPROF_FORMAT_SVG;
+
+  if( !g_ascii_strcasecmp(ext, ".jpg") || !g_ascii_strcasecmp(ext, ".jpeg") || !g_ascii_strcasecmp(ext, ".jpe") )
+    return ICONPROF_FORMAT_JPEG;
+
+  if( !g_ascii_strcasecmp(ext, ".gif") )
+    return ICONPROF_FORMAT_GIF;
+
+  if( !g_ascii_strcasecmp(ext, ".tif") || !g_ascii_strcasecmp(ext, ".tiff") )
+    return ICONPROF_FORMAT_TIFF;
+
+  if( !g_ascii_strcasecmp(ext, ".bmp") )
+    return ICONPROF_FORMAT_BMP;
+
+  return ICONPROF_FORMAT_Other;
+}
+
+/*! \fn void CIconProfiler::m_WriteStat(FILE *fp, const gchar *name, const ICONPROF_STAT *pStat)
+    \brief To write one statistics object in JSON.
+
+    \param[in] fp. The output file.
+    \param[in] name. The name of the stage or format.
+    \param[in] pStat. The statistics.
+    \return NONE
+*/
+void CIconProfiler::m_WriteStat(FILE *fp, const gchar *name, const ICONPROF_STAT *pStat)
+{
+  gint nLast = 0;
+
+  fprintf(fp, "    \"%s\": { \"count\": %" G_GUINT64_FORMAT ", \"failed\": %" G_GUINT64_FORMAT
+              ", \"total_us\": %" G_GINT64_FORMAT ", \"min_us\": %" G_GINT64_FORMAT
+              ", \"max_us\": %" G_GINT64_FORMAT ", \"mean_us\": %.1f, \"log2_us_histogram\": [",
+          name, pStat->nCount, pStat->nFailed, pStat->nTotalUsec, pStat->nMinUsec, pStat->nMaxUsec,
+          pStat->nCount ? (gdouble)pStat->nTotalUsec / pStat->nCount : 0.0);
+
+  /* Trailing empty buckets are left out. */
+  for(gint i=0; i<ICONPROF_BUCKETS; i++)
+    if(pStat->nBuckets[i])
+      nLast = i + 1;
+
+  for(gint i=0; i<nLast; i++)
+    fprintf(fp, "%s%" G_GUINT64_FORMAT, i ? ", " : "", pStat->nBuckets[i]);
+
+  fprintf(fp, "] }");
+}
+
+/*! \fn gboolean CIconProfiler::m_DumpJson(const gchar *path)
+    \brief To write the statistics of all stages and formats in JSON.
+
+    \param[in] path. The output file name, "-" for stderr.
+    \return TRUE or FALSE
+*/
+gboolean CIconProfiler::m_DumpJson(const gchar *path)
+{
+  FILE *fp = NULL;
+
+  if(!path)
+    return false;
+
+  fp = strcmp(path, "-") ? fopen(path, "w") : stderr;
+  if(!fp)
+    return false;
+
+  g_mutex_lock(&m_Lock);
+
+  fprintf(fp, "{\n  \"stages\": {\n");
+  for(gint i=0; i<N_ICONPROF_STAGE; i++)
+  {
+     m_WriteStat(fp, s_StageNames[i], &m_Stages[i]);
+     fprintf(fp, "%s\n", (i < N_ICONPROF_STAGE - 1) ? "," : "");
+  }
+
+  fprintf(fp, "  },\n  \"decode_by_format\": {\n");
+  for(gint i=0; i<N_ICONPROF_FORMAT; i++)
+  {
+     m_WriteStat(fp, s_FormatNames[i], &m_Formats[i]);
+     fprintf(fp, "%s\n", (i < N_ICONPROF_FORMAT - 1) ? "," : "");
+  }
+
+  fprintf(fp, "  },\n  \"failed_decodes\": %" G_GUINT64_FORMAT "\n}\n", m_Stages[ICONPROF_STAGE_Decode].nFailed);
+
+  g_mutex_unlock(&m_Lock);
+
+  if(fp != stderr)
+    fclose(fp);
+
+  return true;
+}
+
+/*! \fn gboolean CIconProfiler::m_DumpTrace(const gchar *path)
+    \brief To write the recorded events in Chrome trace-event format.
+
+    \param[in] path. The output file name.
+    \return TRUE or FALSE
+*/
+gboolean CIconProfiler::m_DumpTrace(const gchar *path)
+{
+  FILE *fp = NULL;
+
+  if( !path || !m_pTrace )
+    return false;
+
+  fp = fopen(path, "w");
+  if(!fp)
+    return false;
+
+  g_mutex_lock(&m_Lock);
+
+  fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+  for(guint i=0; i<m_pTrace->len; i++)
+  {
+     ICONPROF_EVENT *event = &g_array_index(m_pTrace, ICONPROF_EVENT, i);
+
+     fprintf(fp, "%s{\"name\": \"%s%s%s\", \"cat\": \"iconchooser\", \"ph\": \"X\", \"ts\": %" G_GINT64_FORMAT
+                 ", \"dur\": %" G_GINT64_FORMAT ", \"pid\": %d, \"tid\": %u}",
+             i ? ",\n" : "",
+             s_StageNames[event->nStage],
+             (event->nFormat >= 0) ? ":" : "",
+             (event->nFormat >= 0) ? s_FormatNames[event->nFormat] : "",
+             event->nStart, event->nDur, (gint)getpid(), event->nTid);
+  }
+
+  fprintf(fp, "\n]}\n");
+
+  g_mutex_unlock(&m_Lock);
+
+  fclose(fp);
+
+  return true;
+}
+
+/*! \fn void CIconProfiler::m_DumpAtExit(void)
+    \brief The "atexit" function writing the files named by the environment variables.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconProfiler::m_DumpAtExit(void)
+{
+  const gchar *path = NULL;
+
+  if( (path = g_getenv("ICONCHOOSER_PROFILE")) != NULL )
+    m_DumpJson(path);
+
+  if( (path = g_getenv("ICONCHOOSER_TRACE")) != NULL )
+    m_DumpTrace(path);
+}
@@ -0,0 +1,135 @@
+/*! \file    CIconProfiler.h
+    \brief   Declaration of class CIconProfiler and the profiling macros.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+
+    The timers are only compiled in with USE_PROFILER, otherwise all ICONPROF_* macros expand to nothing.
+    At exit the statistics are written as JSON to the file named by the environment variable
+    "ICONCHOOSER_PROFILE" ("-" for stderr), and the timeline is written in Chrome trace-event format
+    to the file named by "ICONCHOOSER_TRACE", which could be opened by chrome://tracing or Perfetto.
+*/
+
+#ifndef __CICONPROFILER
+#define __CICONPROFILER
+
+#include <stdio.h>
+#include <glib.h>
+
+/*! \enum ICONPROF_STAGE
+    \brief The stages of loading icons being timed.
+*/
+enum ICONPROF_STAGE {
+  ICONPROF_STAGE_LoadIconList = 0,  /*!< The whole loading of a directory, from m_LoadIconList to the last slice. */
+  ICONPROF_STAGE_ReloadIconList,
+  ICONPROF_STAGE_Enumerate,         /*!< Reading directory entries. */
+  ICONPROF_STAGE_Filter,            /*!< m_IsPhotoFile. */
+  ICONPROF_STAGE_Read,              /*!< Reading a batch of icon files. */
+  ICONPROF_STAGE_Decode,            /*!< Decoding one icon file. */
+  ICONPROF_STAGE_LoadIcon,
+  ICONPROF_STAGE_LoadIconFile,
+  ICONPROF_STAGE_ThemeLookup,       /*!< m_LoadThemeIcon. */
+  ICONPROF_STAGE_ModelInsert,       /*!< Appending one row to the list-store. */
+  N_ICONPROF_STAGE
+};
+
+/*! \enum ICONPROF_FORMAT
+    \brief The image formats the decoding cost is accounted to.
+*/
+enum ICONPROF_FORMAT {
+  ICONPROF_FORMAT_PNG = 0,
+  ICONPROF_FORMAT_XPM,
+  ICONPROF_FORMAT_SVG,
+  ICONPROF_FORMAT_JPEG,
+  ICONPROF_FORMAT_GIF,
+  ICONPROF_FORMAT_TIFF,
+  ICONPROF_FORMAT_BMP,
+  ICONPROF_FORMAT_Other,
+  N_ICONPROF_FORMAT
+};
+
+/* The number of histogram buckets. Bucket "n" counts durations in [2^(n-1), 2^n) microseconds. */
+#define ICONPROF_BUCKETS  32
+
+/* The maximum number of trace events kept in memory. */
+#define ICONPROF_MAX_TRACE_EVENTS  (1024 * 1024)
+
+/*! \struct ICONPROF_STAT
+    \brief The statistics of one stage or format.
+*/
+typedef struct _ICONPROF_STAT
+{
+  guint64 nCount;                      /*!< The number of measurements. */
+  guint64 nFailed;                     /*!< The number of failed operations, only for decoding. */
+  gint64  nTotalUsec;                  /*!< The sum of all durations. */
+  gint64  nMinUsec;                    /*!< The shortest duration. */
+  gint64  nMaxUsec;                    /*!< The longest duration. */
+  guint64 nBuckets[ICONPROF_BUCKETS];  /*!< The log2 histogram of durations. */
+} ICONPROF_STAT;
+
+/*! \class CIconProfiler
+    \brief Collect per-stage timings of the icon loading and export them.
+*/
+class CIconProfiler
+{
+  private:
+    static GMutex m_Lock;                              /*!< Protect all statistics, the file reader threads may record, too. */
+    static ICONPROF_STAT m_Stages[N_ICONPROF_STAGE];   /*!< The statistics per stage. */
+    static ICONPROF_STAT m_Formats[N_ICONPROF_FORMAT]; /*!< The decoding statistics per image format. */
+    static GArray *m_pTrace;                           /*!< The recorded trace events, NULL if tracing is disabled. */
+    static gint64 m_nEpoch;                            /*!< The monotonic time the profiler started at. */
+    static gboolean m_bInitialized;
+
+    static void m_Init(void);
+    static void m_AddSample(ICONPROF_STAT *pStat, gint64 nUsec, gboolean bFailed);
+    static void m_WriteStat(FILE *fp, const gchar *name, const ICONPROF_STAT *pStat);
+    static void m_DumpAtExit(void);
+
+  public:
+    /* To record a duration of a stage. */
+    static void m_Record(ICONPROF_STAGE stage, gint64 nStart, gint64 nEnd);
+
+    /* To record the decoding cost of an icon file. */
+    static void m_RecordDecode(const gchar *fileName, gint64 nStart, gint64 nEnd, gboolean bSucceeded);
+
+    /* To get the format an icon file name is accounted to. */
+    static ICONPROF_FORMAT m_GetFormat(const gchar *fileName);
+
+    /* To write the statistics in JSON, or the timeline in Chrome trace-event format. */
+    static gboolean m_DumpJson(const gchar *path);
+    static gboolean m_DumpTrace(const gchar *path);
+
+    /* To clear all statistics. */
+    static void m_Reset(void);
+};
+
+/*! \class CIconProfScope
+    \brief Record the time spent in a block to a stage.
+*/
+class CIconProfScope
+{
+  private:
+    ICONPROF_STAGE m_Stage;
+    gint64 m_nStart;
+
+  public:
+    CIconProfScope(ICONPROF_STAGE stage) { m_Stage = stage; m_nStart = g_get_monotonic_time(); }
+    ~CIconProfScope() { CIconProfiler::m_Record(m_Stage, m_nStart, g_get_monotonic_time()); }
+};
+
+#ifdef USE_PROFILER
+  #define ICONPROF_SCOPE(stage)                CIconProfScope iconProfScope_##stage(ICONPROF_STAGE_##stage)
+  #define ICONPROF_MARK(var)                   gint64 var = g_get_monotonic_time()
+  #define ICONPROF_RECORD(stage, start)        CIconProfiler::m_Record(ICONPROF_STAGE_##stage, (start), g_get_monotonic_time())
+  #define ICONPROF_DECODE(name, start, ok)     CIconProfiler::m_RecordDecode((name), (start), g_get_monotonic_time(), (ok))
+#else
+  #define ICONPROF_SCOPE(stage)
+  #define ICONPROF_MARK(var)
+  #define ICONPROF_RECORD(stage, start)
+  #define ICONPROF_DECODE(name, start, ok)
+#endif
+
+#endif   /* CICONPROFILER.H	*/
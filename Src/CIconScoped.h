@@ -0,0 +1,122 @@
+/*! \file    CIconScoped.h
+    \brief   Declaration of the scoped owners of GLib and GObject handles.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONSCOPED
+#define __CICONSCOPED
+
+#include <glib.h>
+#include <glib-object.h>
+
+/*! \class CIconScoped
+    \brief Owns one GLib handle and frees it with its destroy function when it goes out of scope.
+
+    It could not be copied, the handle is given away by m_Release(). The handle may be NULL, it is not freed then.
+    e.g. CIconScoped<gchar> name(g_strdup_printf(...), g_free);
+*/
+template <typename T>
+class CIconScoped
+{
+  private:
+    T *m_pData;                /*!< The handle owned, NULL if there is none. */
+    GDestroyNotify m_pfnFree;  /*!< The function freeing the handle. */
+
+    CIconScoped(const CIconScoped&);
+    CIconScoped& operator=(const CIconScoped&);
+
+  public:
+    CIconScoped(T *pData, GDestroyNotify pfnFree) : m_pData(pData), m_pfnFree(pfnFree) {}
+    ~CIconScoped() { m_Reset(NULL); }
+
+    T* m_Get(void) const { return m_pData; }
+    operator T*() const { return m_pData; }
+    T* operator->() const { return m_pData; }
+
+    /* To take an output parameter, e.g. the GError** of a call. The handle owned before is freed. */
+    T** m_Out(void) { m_Reset(NULL); return &m_pData; }
+
+    /* To give the handle away, it is not freed any more. */
+    T* m_Release(void) { T *pData = m_pData; m_pData = NULL; return pData; }
+
+    /* To free the handle owned and own another one. */
+    void m_Reset(T *pData)
+    {
+      if(m_pData && (m_pData != pData))
+        m_pfnFree(m_pData);
+
+      m_pData = pData;
+    }
+};
+
+/*! \class CIconScopedString
+    \brief Owns a string freed by g_free().
+*/
+class CIconScopedString : public CIconScoped<gchar>
+{
+  public:
+    CIconScopedString(gchar *str) : CIconScoped<gchar>(str, g_free) {}
+};
+
+/*! \class CIconScopedObject
+    \brief Owns one reference of a GObject, e.g. a GdkPixbuf.
+*/
+template <typename T>
+class CIconScopedObject : public CIconScoped<T>
+{
+  public:
+    CIconScopedObject(T *pObject) : CIconScoped<T>(pObject, g_object_unref) {}
+};
+
+/*! \class CIconScopedError
+    \brief Owns a GError, to be passed by m_Out() to the call reporting it.
+*/
+class CIconScopedError : public CIconScoped<GError>
+{
+  public:
+    CIconScopedError() : CIconScoped<GError>(NULL, (GDestroyNotify)g_error_free) {}
+};
+
+/*! \class CIconScopedList
+    \brief Owns a GSList or GList and the data of its nodes, each freed by the function given.
+    e.g. the file names of gtk_file_chooser_get_filenames() or the paths of gtk_icon_view_get_selected_items().
+*/
+template <typename L>
+class CIconScopedList
+{
+  private:
+    L *m_pList;                    /*!< The first node, NULL for an empty list. */
+    GDestroyNotify m_pfnFreeData;  /*!< The function freeing the data of a node. */
+
+    CIconScopedList(const CIconScopedList&);
+    CIconScopedList& operator=(const CIconScopedList&);
+
+    static void m_FreeNodes(GSList *list) { g_slist_free(list); }
+    static void m_FreeNodes(GList *list) { g_list_free(list); }
+
+  public:
+    CIconScopedList(L *pList, GDestroyNotify pfnFreeData) : m_pList(pList), m_pfnFreeData(pfnFreeData) {}
+
+    ~CIconScopedList()
+    {
+      for(L *node = m_pList; node; node = node->next)
+      {
+         if(node->data)
+           m_pfnFreeData(node->data);
+      }
+
+      m_FreeNodes(m_pList);
+    }
+
+    L* m_Get(void) const { return m_pList; }
+    operator L*() const { return m_pList; }
+
+    /* The data of the first node, NULL for an empty list. */
+    gpointer m_GetFirst(void) const { return m_pList ? m_pList->data : NULL; }
+};
+#endif   /* CICONSCOPED.H	*/
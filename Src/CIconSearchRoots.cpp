@@ -0,0 +1,289 @@
+/*! \file    CIconSearchRoots.cpp
+    \brief   Scan several icon directories at once into one set, resolving shadowed names by precedence.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CIconSearchRoots.h"
+
+/* The directories of the icon themes searched, the default theme first. */
+static const gchar *g_SearchThemes[] = { "hicolor", "gnome", NULL };
+
+/*! \struct ICON_ROOT_SCAN
+    \brief The work of scanning one root.
+*/
+typedef struct _ICON_ROOT_SCAN
+{
+  const gchar     *root;        /*!< The root directory name with a trailing "/". */
+  ICON_NAME_FILTER filter;      /*!< To check if a file name is an icon. */
+  GPtrArray       *baseNames;   /*!< The icon file names found, NULL if the root could not be read. */
+} ICON_ROOT_SCAN;
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconSearchRoots::CIconSearchRoots()
+    \brief CIconSearchRoots constructor
+*/
+CIconSearchRoots::CIconSearchRoots()
+{
+  m_pRoots = g_ptr_array_new();
+}
+
+/*! \fn CIconSearchRoots::~CIconSearchRoots()
+    \brief CIconSearchRoots destructor
+*/
+CIconSearchRoots::~CIconSearchRoots()
+{
+  if(m_pRoots)
+  {
+     m_SetRoots(NULL);
+     g_ptr_array_free(m_pRoots, TRUE);
+  }
+
+  m_pRoots = NULL;
+}
+
+/*! \fn void CIconSearchRoots::m_AddRoot(const gchar *dirName)
+    \brief To append a root unless it is listed already.
+
+    \param[in] dirName. The directory name, with or without a trailing "/".
+    \return NONE
+*/
+void CIconSearchRoots::m_AddRoot(const gchar *dirName)
+{
+  gchar *root = NULL;
+
+  if( !dirName || (strlen(dirName) == 0) )
+    return;
+
+  root = g_str_has_suffix(dirName, "/") ? g_strdup(dirName) : g_strdup_printf("%s/", dirName);
+
+  for(guint i=0; i<m_pRoots->len; i++)
+  {
+     if( strcmp(root, (const gchar*)g_ptr_array_index(m_pRoots, i)) == 0 )
+     {
+        g_free(root);
+        return;
+     }
+  }
+
+  g_ptr_array_add(m_pRoots, root);
+}
+
+/*! \fn void CIconSearchRoots::m_SetRoots(const gchar **roots)
+    \brief To set the roots.
+
+    \param[in] roots. The NULL-terminated directory names in precedence order, NULL to remove all roots.
+    \return NONE
+*/
+void CIconSearchRoots::m_SetRoots(const gchar **roots)
+{
+  for(guint i=0; i<m_pRoots->len; i++)
+    g_free(g_ptr_array_index(m_pRoots, i));
+
+  g_ptr_array_set_size(m_pRoots, 0);
+
+  for(gint i=0; roots && roots[i]; i++)
+    m_AddRoot(roots[i]);
+}
+
+/*! \fn void CIconSearchRoots::m_SetDefaultRoots(gint size)
+    \brief To set the roots searched by the Icon Theme Specification: the theme directories of the XDG data
+           directories, the user's first, then their "pixmaps" and "app-install/icons" directories.
+
+    \param[in] size. The size directory of the themes, e.g. 48 for "48x48".
+    \return NONE
+*/
+void CIconSearchRoots::m_SetDefaultRoots(gint size)
+{
+  const gchar * const *systemDirs = g_get_system_data_dirs();
+  GPtrArray *dataDirs = g_ptr_array_new();
+  gchar *dirName = NULL;
+
+  m_SetRoots(NULL);
+
+  /* The XDG data directories in precedence order. */
+  g_ptr_array_add(dataDirs, (gpointer)g_get_user_data_dir());
+  for(gint i=0; systemDirs && systemDirs[i]; i++)
+    g_ptr_array_add(dataDirs, (gpointer)systemDirs[i]);
+
+  for(gint t=0; g_SearchThemes[t]; t++)
+  {
+     for(guint i=0; i<dataDirs->len; i++)
+     {
+        gchar *sizeName = g_strdup_printf("%dx%d", size, size);
+
+        dirName = g_build_filename((const gchar*)g_ptr_array_index(dataDirs, i), "icons", g_SearchThemes[t], sizeName, "apps", NULL);
+        m_AddRoot(dirName);
+        g_free(dirName);
+
+        dirName = g_build_filename((const gchar*)g_ptr_array_index(dataDirs, i), "icons", g_SearchThemes[t], "scalable", "apps", NULL);
+        m_AddRoot(dirName);
+        g_free(dirName);
+
+        g_free(sizeName);
+     }
+  }
+
+  for(guint i=0; i<dataDirs->len; i++)
+  {
+     dirName = g_build_filename((const gchar*)g_ptr_array_index(dataDirs, i), "pixmaps", NULL);
+     m_AddRoot(dirName);
+     g_free(dirName);
+  }
+
+  for(guint i=0; i<dataDirs->len; i++)
+  {
+     dirName = g_build_filename((const gchar*)g_ptr_array_index(dataDirs, i), "app-install", "icons", NULL);
+     m_AddRoot(dirName);
+     g_free(dirName);
+  }
+
+  g_ptr_array_free(dataDirs, TRUE);
+}
+
+/*! \fn gchar* CIconSearchRoots::m_GetIconName(const gchar *baseName)
+    \brief To get the icon name of a file name.
+
+    \param[in] baseName. The file name, e.g. "gimp.png".
+    \return The file name without its extension, e.g. "gimp". It must be freed.
+*/
+gchar* CIconSearchRoots::m_GetIconName(const gchar *baseName)
+{
+  const gchar *ext = strrchr(baseName, '.');
+
+  return ext ? g_strndup(baseName, ext - baseName) : g_strdup(baseName);
+}
+
+/*! \fn gpointer CIconSearchRoots::m_ScanWorker(gpointer data)
+    \brief To list the icon files of one root. It runs in a thread of its own if threads are enabled.
+
+    \param[in,out] data. The ICON_ROOT_SCAN.
+    \return NULL
+*/
+gpointer CIconSearchRoots::m_ScanWorker(gpointer data)
+{
+  ICON_ROOT_SCAN *scan = (ICON_ROOT_SCAN*)data;
+  const gchar *baseName = NULL;
+  GDir *dir = NULL;
+
+  dir = g_dir_open(scan->root, 0, NULL);
+  if(!dir)
+    return NULL;
+
+  scan->baseNames = g_ptr_array_new();
+
+  while( (baseName = g_dir_read_name(dir)) != NULL )
+  {
+     if( scan->filter && (scan->filter((gchar*)baseName) == FALSE) )
+       continue;
+
+     g_ptr_array_add(scan->baseNames, g_strdup(baseName));
+  }
+
+  g_dir_close(dir);
+
+  return NULL;
+}
+
+/*! \fn GPtrArray* CIconSearchRoots::m_Scan(ICON_NAME_FILTER filter, gint *pShadowed)
+    \brief To list the icons of all roots as one set.
+    \n The roots are read in parallel, then merged in precedence order on the calling thread.
+
+    \param[in] filter. To check if a file name is an icon, NULL to take all files.
+    \param[out] pShadowed. The number of icon files hidden by the same icon name in an earlier root, could be NULL.
+    \return The full names of the icons, root by root. The array and its strings must be freed.
+*/
+GPtrArray* CIconSearchRoots::m_Scan(ICON_NAME_FILTER filter, gint *pShadowed)
+{
+  ICON_ROOT_SCAN *scans = g_new0(ICON_ROOT_SCAN, m_pRoots->len);
+  GPtrArray *fullNames = g_ptr_array_new();
+  GHashTable *iconNames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+  gint nShadowed = 0;
+
+  for(guint i=0; i<m_pRoots->len; i++)
+  {
+     scans[i].root = (const gchar*)g_ptr_array_index(m_pRoots, i);
+     scans[i].filter = filter;
+  }
+
+#ifdef USE_THREADS
+  {
+     GThread **threads = g_new0(GThread*, m_pRoots->len);
+
+     /* Most roots are on the same disk, but reading them together keeps the disk queue full. */
+     for(guint i=0; i<m_pRoots->len; i++)
+     {
+        threads[i] = g_thread_try_new("icon-scan", m_ScanWorker, &scans[i], NULL);
+
+        if( !threads[i] )
+          m_ScanWorker(&scans[i]);
+     }
+
+     for(guint i=0; i<m_pRoots->len; i++)
+     {
+        if( threads[i] )
+          g_thread_join(threads[i]);
+     }
+
+     g_free(threads);
+  }
+#else
+  for(guint i=0; i<m_pRoots->len; i++)
+    m_ScanWorker(&scans[i]);
+#endif
+
+  for(guint i=0; i<m_pRoots->len; i++)
+  {
+     GPtrArray *rootNames = NULL;
+
+     if( !scans[i].baseNames )
+       continue;
+
+     /* The names of this root only shadow the later roots, not each other. */
+     rootNames = g_ptr_array_new();
+
+     for(guint j=0; j<scans[i].baseNames->len; j++)
+     {
+        gchar *baseName = (gchar*)g_ptr_array_index(scans[i].baseNames, j);
+        gchar *iconName = m_GetIconName(baseName);
+
+        if( g_hash_table_lookup(iconNames, iconName) )
+        {
+           nShadowed++;
+           g_free(iconName);
+        }
+        else
+        {
+           g_ptr_array_add(fullNames, g_strdup_printf("%s%s", scans[i].root, baseName));
+           g_ptr_array_add(rootNames, iconName);
+        }
+
+        g_free(baseName);
+     }
+
+     for(guint j=0; j<rootNames->len; j++)
+       g_hash_table_replace(iconNames, g_ptr_array_index(rootNames, j), GINT_TO_POINTER(1));
+
+     g_ptr_array_free(rootNames, TRUE);
+     g_ptr_array_free(scans[i].baseNames, TRUE);
+  }
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - %u roots, %u icons, %d shadowed \n", __FUNCTION__, __LINE__, m_pRoots->len, fullNames->len, nShadowed);
+  #endif
+
+  g_hash_table_destroy(iconNames);
+  g_free(scans);
+
+  if(pShadowed)
+    *pShadowed = nShadowed;
+
+  return fullNames;
+}
@@ -0,0 +1,58 @@
+/*! \file    CIconSearchRoots.h
+    \brief   Declaration of class CIconSearchRoots.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONSEARCHROOTS
+#define __CICONSEARCHROOTS
+
+#include <glib.h>
+
+/* The icon browsing location of the union view over all search roots. */
+#define ICON_LOCATION_UNION  "union:"
+
+/*! \typedef ICON_NAME_FILTER
+    \brief The function type to check if a file name is an icon, e.g. CIconChooser::m_IsPhotoFile.
+*/
+typedef gboolean (*ICON_NAME_FILTER)(gchar *baseName);
+
+/*! \class CIconSearchRoots
+    \brief The ordered list of directories icons are searched in, and the scanning of all of them as one set.
+
+    The roots are in precedence order. An icon name(the file name without its extension) found in a root
+    shadows the same name in all later roots, as the Icon Theme Specification resolves the XDG data directories.
+*/
+class CIconSearchRoots
+{
+  private:
+    GPtrArray *m_pRoots;  /*!< The root directory names with a trailing "/", in precedence order. */
+
+    void m_AddRoot(const gchar *dirName);
+    static gpointer m_ScanWorker(gpointer data);
+
+  public:
+    CIconSearchRoots();
+    ~CIconSearchRoots();
+
+    /* To set the roots from a NULL-terminated list, in precedence order. NULL sets the default roots. */
+    void m_SetRoots(const gchar **roots);
+
+    /* To set the XDG data directories' theme, pixmaps and app-install directories for icons of "size" pixels. */
+    void m_SetDefaultRoots(gint size);
+
+    guint m_GetRootCount(void) { return m_pRoots->len; }
+    const gchar* m_GetRoot(guint idx) { return (idx < m_pRoots->len) ? (const gchar*)g_ptr_array_index(m_pRoots, idx) : NULL; }
+
+    /* To scan all roots, in parallel if threads are enabled. Returns the full names of the icons not shadowed,
+       root by root in precedence order, the array and its strings must be freed. */
+    GPtrArray* m_Scan(ICON_NAME_FILTER filter, gint *pShadowed);
+
+    /* The icon name of a file name, which is the file name without its extension. The returned string must be freed. */
+    static gchar* m_GetIconName(const gchar *baseName);
+};
+#endif   /* CICONSEARCHROOTS.H	*/
@@ -0,0 +1,279 @@
+/*! \file    CIconStreamDecoder.cpp
+    \brief   Decode large images into thumbnails chunk by chunk, within pixel and byte limits.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "CIconStreamDecoder.h"
+
+guint64 CIconStreamDecoder::m_nMaxPixels = ICON_DECODE_MAX_PIXELS;
+guint64 CIconStreamDecoder::m_nMaxBytes = ICON_DECODE_MAX_BYTES;
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconStreamDecoder::CIconStreamDecoder(const gchar *fullName, gint size)
+    \brief CIconStreamDecoder constructor
+
+    \param[in] fullName. The image file.
+    \param[in] size. The thumbnail size.
+*/
+CIconStreamDecoder::CIconStreamDecoder(const gchar *fullName, gint size)
+{
+  m_FullName = g_strdup(fullName);
+  m_nSize = size;
+  m_nFd = -1;
+  m_pLoader = NULL;
+  m_nWidth = 0;
+  m_nHeight = 0;
+  m_bRejected = false;
+  m_nFed = 0;
+}
+
+/*! \fn CIconStreamDecoder::~CIconStreamDecoder()
+    \brief CIconStreamDecoder destructor
+*/
+CIconStreamDecoder::~CIconStreamDecoder()
+{
+  m_Close();
+
+  if(m_pLoader)
+    g_object_unref(m_pLoader);
+
+  if(m_FullName)
+    g_free(m_FullName);
+
+  m_pLoader = NULL;
+  m_FullName = NULL;
+}
+
+/*! \fn void CIconStreamDecoder::m_SetLimits(guint64 maxPixels, guint64 maxBytes)
+    \brief To set the limits of all decoding.
+
+    \param[in] maxPixels. The pixels of an image decoded at full size at most, 0 keeps the current value.
+    \param[in] maxBytes. The bytes of a file decoded at most, 0 keeps the current value.
+    \return NONE
+*/
+void CIconStreamDecoder::m_SetLimits(guint64 maxPixels, guint64 maxBytes)
+{
+  if(maxPixels > 0)
+    m_nMaxPixels = maxPixels;
+
+  if(maxBytes > 0)
+    m_nMaxBytes = maxBytes;
+}
+
+/*! \fn void CIconStreamDecoder::m_FitSize(gint *pWidth, gint *pHeight, gint size)
+    \brief To fit dimensions into a size, keeping the aspect ratio as gdk_pixbuf_new_from_file_at_size() does.
+
+    \param[in,out] pWidth. The width.
+    \param[in,out] pHeight. The height.
+    \param[in] size. The size to fit into.
+    \return NONE
+*/
+void CIconStreamDecoder::m_FitSize(gint *pWidth, gint *pHeight, gint size)
+{
+  if( (gdouble)*pHeight > (gdouble)*pWidth )
+  {
+     *pWidth = (gint)(0.5 + (gdouble)*pWidth * size / (gdouble)*pHeight);
+     *pHeight = size;
+  }
+  else
+  {
+     *pHeight = (gint)(0.5 + (gdouble)*pHeight * size / (gdouble)*pWidth);
+     *pWidth = size;
+  }
+
+  *pWidth = MAX(*pWidth, 1);
+  *pHeight = MAX(*pHeight, 1);
+}
+
+/*! \fn gboolean CIconStreamDecoder::m_CheckSize(GdkPixbufLoader *loader, gint width, gint height)
+    \brief To check an image being loaded against the pixel limit, in its "size-prepared" signal.
+    \n The JPEG loader scales while decoding, by 1/8 at most, so a JPEG is limited by the image it allocates then.
+       A size of 0x0 tells the loader not to allocate the image, it fails then.
+
+    \param[in] loader. The loader.
+    \param[in] width. The width of the image.
+    \param[in] height. The height of the image.
+    \return FALSE if the image is over the limit.
+*/
+gboolean CIconStreamDecoder::m_CheckSize(GdkPixbufLoader *loader, gint width, gint height)
+{
+  GdkPixbufFormat *format = NULL;
+  gchar *formatName = NULL;
+  guint64 nPixels = (guint64)width * (guint64)height;
+
+  if(nPixels <= m_nMaxPixels)
+    return true;
+
+  format = gdk_pixbuf_loader_get_format(loader);
+  formatName = format ? gdk_pixbuf_format_get_name(format) : NULL;
+
+  if( g_strcmp0(formatName, "jpeg") == 0 )
+    nPixels = (guint64)((width + ICON_JPEG_MAX_SCALE_DENOM - 1) / ICON_JPEG_MAX_SCALE_DENOM) *
+              (guint64)((height + ICON_JPEG_MAX_SCALE_DENOM - 1) / ICON_JPEG_MAX_SCALE_DENOM);
+
+  g_free(formatName);
+
+  if(nPixels <= m_nMaxPixels)
+    return true;
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - %dx%d is over the limit of %lu pixels \n", __FUNCTION__, __LINE__, width, height, (gulong)m_nMaxPixels);
+  #endif
+
+  gdk_pixbuf_loader_set_size(loader, 0, 0);
+
+  return false;
+}
+
+/*! \fn void CIconStreamDecoder::cb_size_prepared(GdkPixbufLoader *loader, gint width, gint height, gpointer data)
+    \brief The callback function to keep the original dimensions, check them, and let the loader decode at the thumbnail size.
+*/
+void CIconStreamDecoder::cb_size_prepared(GdkPixbufLoader *loader, gint width, gint height, gpointer data)
+{
+  CIconStreamDecoder *thisObject = (CIconStreamDecoder*)data;
+
+  if( (width <= 0) || (height <= 0) )
+    return;
+
+  thisObject->m_nWidth = width;
+  thisObject->m_nHeight = height;
+
+  if( !m_CheckSize(loader, width, height) )
+  {
+     thisObject->m_bRejected = true;
+     return;
+  }
+
+  /* Small images are not enlarged, the view centers them. */
+  if( (width > thisObject->m_nSize) || (height > thisObject->m_nSize) )
+  {
+     m_FitSize(&width, &height, thisObject->m_nSize);
+     gdk_pixbuf_loader_set_size(loader, width, height);
+  }
+}
+
+/*! \fn gboolean CIconStreamDecoder::m_Open(guint64 fileSize)
+    \brief To open the file and create the loader.
+
+    \param[in] fileSize. The size of the file.
+    \return FALSE if the file is over the byte limit or could not be opened.
+*/
+gboolean CIconStreamDecoder::m_Open(guint64 fileSize)
+{
+  if(fileSize > m_nMaxBytes)
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("%s(%d) - %s: %lu bytes is over the limit \n", __FUNCTION__, __LINE__, m_FullName, (gulong)fileSize);
+     #endif
+
+     m_bRejected = true;
+     return false;
+  }
+
+  m_nFd = open(m_FullName, O_RDONLY);
+  if(m_nFd < 0)
+    return false;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(m_nFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  m_pLoader = gdk_pixbuf_loader_new();
+  g_signal_connect(m_pLoader, "size-prepared", G_CALLBACK(cb_size_prepared), this);
+
+  return true;
+}
+
+/*! \fn void CIconStreamDecoder::m_Close(void)
+    \brief To close the file.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconStreamDecoder::m_Close(void)
+{
+  if(m_nFd >= 0)
+    close(m_nFd);
+
+  m_nFd = -1;
+}
+
+/*! \fn gint CIconStreamDecoder::m_Feed(guint nChunks)
+    \brief To feed the next chunks of the file to the loader.
+
+    \param[in] nChunks. The number of chunks fed at most.
+    \return One of ICON_STREAM_STATUS.
+*/
+gint CIconStreamDecoder::m_Feed(guint nChunks)
+{
+  guchar *buffer = NULL;
+  gint status = ICON_STREAM_Running;
+
+  if( (m_nFd < 0) || !m_pLoader )
+    return ICON_STREAM_Failed;
+
+  buffer = (guchar*)g_malloc(ICON_STREAM_CHUNK_BYTES);
+
+  for(guint i=0; (i<nChunks) && (status == ICON_STREAM_Running); i++)
+  {
+     ssize_t nRead = read(m_nFd, buffer, ICON_STREAM_CHUNK_BYTES);
+
+     if( (nRead < 0) && (errno == EINTR) )
+       continue;
+
+     if(nRead <= 0)
+     {
+        /* The end of the file, the loader must be closed to finish the image. */
+        m_Close();
+        status = (gdk_pixbuf_loader_close(m_pLoader, NULL) && (nRead == 0) && !m_bRejected) ? ICON_STREAM_Done : ICON_STREAM_Failed;
+        break;
+     }
+
+     m_nFed += nRead;
+
+     if( !gdk_pixbuf_loader_write(m_pLoader, buffer, nRead, NULL) || m_bRejected || (m_nFed > m_nMaxBytes) )
+     {
+        /* The loader must always be closed, even if writing failed. */
+        m_Close();
+        gdk_pixbuf_loader_close(m_pLoader, NULL);
+        status = ICON_STREAM_Failed;
+     }
+  }
+
+  g_free(buffer);
+
+  return status;
+}
+
+/*! \fn GdkPixbuf* CIconStreamDecoder::m_TakePixbuf(void)
+    \brief To take the thumbnail after the decoding is done.
+
+    \param[in] NONE
+    \return The thumbnail, it must be unreferenced. NULL if the decoding failed or is not done.
+*/
+GdkPixbuf* CIconStreamDecoder::m_TakePixbuf(void)
+{
+  GdkPixbuf *pixbuf = NULL;
+
+  if( !m_pLoader || (m_nFd >= 0) || m_bRejected )
+    return NULL;
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf(m_pLoader);
+
+  /* The pixbuf belongs to the loader, take our own reference before the loader is released. */
+  if(pixbuf)
+    g_object_ref(pixbuf);
+
+  return pixbuf;
+}
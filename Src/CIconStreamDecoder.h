@@ -0,0 +1,93 @@
+/*! \file    CIconStreamDecoder.h
+    \brief   Declaration of class CIconStreamDecoder.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONSTREAMDECODER
+#define __CICONSTREAMDECODER
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* The images of more pixels are not decoded. A JPEG is counted at the size its decoder scales it to while decoding. */
+#define ICON_DECODE_MAX_PIXELS  (16 * 1024 * 1024)
+
+/* libjpeg scales a JPEG while decoding by 1/8 at most. */
+#define ICON_JPEG_MAX_SCALE_DENOM  8
+
+/* The files of more bytes are not decoded at all. */
+#define ICON_DECODE_MAX_BYTES   (64 * 1024 * 1024)
+
+/* The bytes fed to the loader at a time. */
+#define ICON_STREAM_CHUNK_BYTES  (64 * 1024)
+
+/*! \enum ICON_STREAM_STATUS
+    \brief The state of a streamed decoding.
+*/
+enum ICON_STREAM_STATUS {
+  ICON_STREAM_Running = 0,
+  ICON_STREAM_Done,
+  ICON_STREAM_Failed
+};
+
+/*! \class CIconStreamDecoder
+    \brief Decode a large image file into a thumbnail by feeding it to a GdkPixbufLoader chunk by chunk.
+
+    The memory used is one chunk plus the loader's state, the file is never read as a whole.
+    The size is set when the loader knows the dimensions, so the JPEG loader decodes with DCT scaling(1/2 to 1/8)
+    straight into a small image. Other formats are decoded at full size first, so an image over the pixel limit is
+    refused there, before its pixels are allocated. A caller could feed a few chunks at a time, between other work.
+*/
+class CIconStreamDecoder
+{
+  private:
+    gchar *m_FullName;           /*!< The image file. */
+    gint m_nSize;                /*!< The thumbnail size. */
+    gint m_nFd;                  /*!< The opened file, -1 if it is not open. */
+    GdkPixbufLoader *m_pLoader;  /*!< The loader fed. */
+    gint m_nWidth;               /*!< The original width, 0 until the loader knows it. */
+    gint m_nHeight;              /*!< The original height, 0 until the loader knows it. */
+    gboolean m_bRejected;        /*!< To indicate if the image was refused by the pixel limit. */
+    guint64 m_nFed;              /*!< The number of bytes fed so far. */
+
+    static guint64 m_nMaxPixels;
+    static guint64 m_nMaxBytes;
+
+    static void cb_size_prepared(GdkPixbufLoader *loader, gint width, gint height, gpointer data);
+    void m_Close(void);
+
+  public:
+    CIconStreamDecoder(const gchar *fullName, gint size);
+    ~CIconStreamDecoder();
+
+    /* To open the file. FALSE if it could not be opened or it is over the byte limit. */
+    gboolean m_Open(guint64 fileSize);
+
+    /* To feed some chunks to the loader. */
+    gint m_Feed(guint nChunks);
+
+    /* To take the thumbnail when the decoding is done, it must be unreferenced. NULL if it failed. */
+    GdkPixbuf* m_TakePixbuf(void);
+
+    const gchar* m_GetFullName(void) { return m_FullName; }
+    gint m_GetWidth(void) { return m_nWidth; }
+    gint m_GetHeight(void) { return m_nHeight; }
+    gboolean m_GetRejected(void) { return m_bRejected; }
+
+    /* The limits of all decoding, 0 keeps the current value. */
+    static void m_SetLimits(guint64 maxPixels, guint64 maxBytes);
+    static guint64 m_GetMaxPixels(void) { return m_nMaxPixels; }
+    static guint64 m_GetMaxBytes(void) { return m_nMaxBytes; }
+
+    /* To check an image being loaded against the pixel limit. If it is over, the loader is told to stop and FALSE is returned. */
+    static gboolean m_CheckSize(GdkPixbufLoader *loader, gint width, gint height);
+
+    /* To fit the dimensions into a size, keeping the aspect ratio. */
+    static void m_FitSize(gint *pWidth, gint *pHeight, gint size);
+};
+#endif   /* CICONSTREAMDECODER.H	*/
@@ -0,0 +1,746 @@
+/*! \file    CIconTheme.cpp
+    \brief   Parse icon themes' index.theme files into tables, and look icons up as the Icon Theme Specification does.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CIconTheme.h"
+
+/* The group of the theme's own keys in index.theme. */
+#define THEME_GROUP  "Icon Theme"
+
+/* The extension names in the order of ICON_THEME_EXT. */
+static const gchar *g_ThemeExtNames[N_ICON_THEME_EXT] = { ".png", ".svg", ".xpm" };
+
+/*! \fn static gint get_ext(const gchar *baseName, gsize *pNameLength)
+    \brief To get the kind of an icon file by its extension name.
+
+    \param[in] baseName. The file name.
+    \param[out] pNameLength. The length of the icon name, which is the file name without the extension.
+    \return One of ICON_THEME_EXT, -1 if it is not an icon file.
+*/
+static gint get_ext(const gchar *baseName, gsize *pNameLength)
+{
+  const gchar *ext = strrchr(baseName, '.');
+
+  if(!ext)
+    return -1;
+
+  for(gint i=0; i<N_ICON_THEME_EXT; i++)
+  {
+     if( strcmp(ext, g_ThemeExtNames[i]) == 0 )
+     {
+        *pNameLength = ext - baseName;
+        return i;
+     }
+  }
+
+  return -1;
+}
+
+/*! \fn static void free_files(gpointer data)
+    \brief To free the GArray of ICON_THEME_FILE of an icon name.
+*/
+static void free_files(gpointer data)
+{
+  g_array_free((GArray*)data, TRUE);
+}
+
+/*! \fn static const ICON_THEME_FILE* find_best_file(GArray *files, GArray *dirs, const gchar *context, gint size, gint scale)
+    \brief To choose the file of an icon as the Icon Theme Specification does.
+    \n The first theme having the icon wins. In that theme the first directory matching the size wins,
+       otherwise the directory with the closest size. In one directory PNG is preferred to SVG to XPM.
+
+    \param[in] files. The ICON_THEME_FILE of the icon name, in lookup order.
+    \param[in] dirs. The directory table.
+    \param[in] context. Only the directories of this context are taken, NULL for all.
+    \param[in] size. The wanted size.
+    \param[in] scale. The wanted scale.
+    \return The chosen file, NULL if the icon is not in any directory taken.
+*/
+static const ICON_THEME_FILE* find_best_file(GArray *files, GArray *dirs, const gchar *context, gint size, gint scale)
+{
+  const ICON_THEME_FILE *best = NULL;
+  gint bestDistance = G_MAXINT;
+  gint bestTheme = -1;
+  gboolean bExact = false;
+
+  for(guint i=0; i<files->len; i++)
+  {
+     const ICON_THEME_FILE *file = &g_array_index(files, ICON_THEME_FILE, i);
+     const ICON_THEME_DIR *dir = &g_array_index(dirs, ICON_THEME_DIR, file->nDir);
+     gint distance = 0;
+
+     if( context && (g_strcmp0(context, dir->context) != 0) )
+       continue;
+
+     /* The files are in the order of the themes, a later theme is only looked at if an earlier one lacks the icon. */
+     if( (bestTheme >= 0) && (dir->nTheme != bestTheme) )
+       break;
+
+     /* After an exact match only the other files of the same directory could be better. */
+     if(bExact)
+     {
+        if(file->nDir != best->nDir)
+          break;
+
+        if(file->ext < best->ext)
+          best = file;
+
+        continue;
+     }
+
+     if( CIconTheme::m_DirectoryMatchesSize(dir, size, scale) )
+     {
+        best = file;
+        bestTheme = dir->nTheme;
+        bExact = true;
+        continue;
+     }
+
+     distance = CIconTheme::m_DirectorySizeDistance(dir, size, scale);
+
+     if( !best || (distance < bestDistance) ||
+         ((distance == bestDistance) && (file->nDir == best->nDir) && (file->ext < best->ext)) )
+     {
+        best = file;
+        bestDistance = distance;
+        bestTheme = dir->nTheme;
+     }
+  }
+
+  return best;
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconTheme::CIconTheme()
+    \brief CIconTheme constructor
+*/
+CIconTheme::CIconTheme()
+{
+  m_ThemeName = NULL;
+  m_pThemes = g_ptr_array_new();
+  m_pDirs = g_array_new(false, false, sizeof(ICON_THEME_DIR));
+  m_pIcons = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, free_files);
+}
+
+/*! \fn CIconTheme::~CIconTheme()
+    \brief CIconTheme destructor
+*/
+CIconTheme::~CIconTheme()
+{
+  m_Clear();
+
+  if(m_pThemes)
+    g_ptr_array_free(m_pThemes, TRUE);
+
+  if(m_pDirs)
+    g_array_free(m_pDirs, TRUE);
+
+  if(m_pIcons)
+    g_hash_table_destroy(m_pIcons);
+
+  m_pThemes = NULL;
+  m_pDirs = NULL;
+  m_pIcons = NULL;
+}
+
+/*! \fn void CIconTheme::m_Clear(void)
+    \brief To free the tables of the theme loaded.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconTheme::m_Clear(void)
+{
+  if(m_ThemeName)
+    g_free(m_ThemeName);
+
+  m_ThemeName = NULL;
+
+  for(guint i=0; i<m_pThemes->len; i++)
+    g_free(g_ptr_array_index(m_pThemes, i));
+
+  g_ptr_array_set_size(m_pThemes, 0);
+
+  for(guint i=0; i<m_pDirs->len; i++)
+  {
+     ICON_THEME_DIR *dir = &g_array_index(m_pDirs, ICON_THEME_DIR, i);
+
+     g_free(dir->path);
+     g_free(dir->context);
+  }
+
+  g_array_set_size(m_pDirs, 0);
+
+  g_hash_table_remove_all(m_pIcons);
+}
+
+/*! \fn GPtrArray* CIconTheme::m_GetBaseDirs(void)
+    \brief To get the directories themes are searched in: "$HOME/.icons", "$XDG_DATA_DIRS/icons" and "/usr/share/pixmaps".
+
+    \param[in] NONE
+    \return The directory names in precedence order. The array and its strings must be freed.
+*/
+GPtrArray* CIconTheme::m_GetBaseDirs(void)
+{
+  const gchar * const *systemDirs = g_get_system_data_dirs();
+  GPtrArray *baseDirs = g_ptr_array_new();
+
+  g_ptr_array_add(baseDirs, g_build_filename(g_get_home_dir(), ".icons", NULL));
+  g_ptr_array_add(baseDirs, g_build_filename(g_get_user_data_dir(), "icons", NULL));
+
+  for(gint i=0; systemDirs && systemDirs[i]; i++)
+    g_ptr_array_add(baseDirs, g_build_filename(systemDirs[i], "icons", NULL));
+
+  g_ptr_array_add(baseDirs, g_strdup("/usr/share/pixmaps"));
+
+  return baseDirs;
+}
+
+/*! \fn gboolean CIconTheme::m_DirectoryMatchesSize(const ICON_THEME_DIR *dir, gint size, gint scale)
+    \brief To check if a theme directory holds icons of a size, as DirectoryMatchesSize of the Icon Theme Specification.
+
+    \param[in] dir. The theme directory.
+    \param[in] size. The wanted size.
+    \param[in] scale. The wanted scale.
+    \return TRUE or FALSE
+*/
+gboolean CIconTheme::m_DirectoryMatchesSize(const ICON_THEME_DIR *dir, gint size, gint scale)
+{
+  if(dir->scale != scale)
+    return false;
+
+  switch(dir->type)
+  {
+    case ICON_THEME_DIR_Fixed:
+      return dir->size == size;
+
+    case ICON_THEME_DIR_Scalable:
+      return (dir->minSize <= size) && (size <= dir->maxSize);
+
+    default:
+      return (dir->size - dir->threshold <= size) && (size <= dir->size + dir->threshold);
+  }
+}
+
+/*! \fn gint CIconTheme::m_DirectorySizeDistance(const ICON_THEME_DIR *dir, gint size, gint scale)
+    \brief To get how far the icons of a theme directory are from a size, as DirectorySizeDistance of the Icon Theme Specification.
+
+    \param[in] dir. The theme directory.
+    \param[in] size. The wanted size.
+    \param[in] scale. The wanted scale.
+    \return The distance in device pixels.
+*/
+gint CIconTheme::m_DirectorySizeDistance(const ICON_THEME_DIR *dir, gint size, gint scale)
+{
+  gint wanted = size * scale;
+  gint minSize = 0, maxSize = 0;
+
+  switch(dir->type)
+  {
+    case ICON_THEME_DIR_Fixed:
+      return abs(dir->size * dir->scale - wanted);
+
+    case ICON_THEME_DIR_Scalable:
+      minSize = dir->minSize;
+      maxSize = dir->maxSize;
+      break;
+
+    default:
+      minSize = dir->size - dir->threshold;
+      maxSize = dir->size + dir->threshold;
+      break;
+  }
+
+  if(wanted < minSize * dir->scale)
+    return minSize * dir->scale - wanted;
+
+  if(wanted > maxSize * dir->scale)
+    return wanted - maxSize * dir->scale;
+
+  return 0;
+}
+
+/*! \fn void CIconTheme::m_ParseTheme(const gchar *themeName, gint nTheme, GPtrArray *inherits)
+    \brief To parse the index.theme of a theme into the directory table.
+
+    \param[in] themeName. The theme name.
+    \param[in] nTheme. The index of the theme in the lookup order.
+    \param[out] inherits. The names of the themes it inherits are appended, they must be freed.
+    \return NONE
+*/
+void CIconTheme::m_ParseTheme(const gchar *themeName, gint nTheme, GPtrArray *inherits)
+{
+  GPtrArray *baseDirs = m_GetBaseDirs();
+  GKeyFile *keyFile = g_key_file_new();
+  gchar **subdirs = NULL, **parents = NULL;
+  gboolean bLoaded = false;
+
+  /* The index.theme of the first base directory having the theme describes it. */
+  for(guint i=0; (i<baseDirs->len) && !bLoaded; i++)
+  {
+     gchar *fileName = g_build_filename((const gchar*)g_ptr_array_index(baseDirs, i), themeName, "index.theme", NULL);
+
+     bLoaded = g_key_file_load_from_file(keyFile, fileName, G_KEY_FILE_NONE, NULL);
+     g_free(fileName);
+  }
+
+  if(bLoaded)
+  {
+     subdirs = g_key_file_get_string_list(keyFile, THEME_GROUP, "Directories", NULL, NULL);
+     parents = g_key_file_get_string_list(keyFile, THEME_GROUP, "Inherits", NULL, NULL);
+  }
+
+  for(gint s=0; subdirs && subdirs[s]; s++)
+  {
+     ICON_THEME_DIR dir;
+     gchar *type = NULL;
+
+     if( !g_key_file_has_group(keyFile, subdirs[s]) )
+       continue;
+
+     memset(&dir, 0x00, sizeof(dir));
+     dir.nTheme = nTheme;
+     dir.size = g_key_file_get_integer(keyFile, subdirs[s], "Size", NULL);
+     dir.minSize = g_key_file_has_key(keyFile, subdirs[s], "MinSize", NULL) ?
+                   g_key_file_get_integer(keyFile, subdirs[s], "MinSize", NULL) : dir.size;
+     dir.maxSize = g_key_file_has_key(keyFile, subdirs[s], "MaxSize", NULL) ?
+                   g_key_file_get_integer(keyFile, subdirs[s], "MaxSize", NULL) : dir.size;
+     dir.threshold = g_key_file_has_key(keyFile, subdirs[s], "Threshold", NULL) ?
+                     g_key_file_get_integer(keyFile, subdirs[s], "Threshold", NULL) : 2;
+     dir.scale = g_key_file_has_key(keyFile, subdirs[s], "Scale", NULL) ?
+                 g_key_file_get_integer(keyFile, subdirs[s], "Scale", NULL) : 1;
+
+     if(dir.scale < 1)
+       dir.scale = 1;
+
+     type = g_key_file_get_string(keyFile, subdirs[s], "Type", NULL);
+     if( g_strcmp0(type, "Fixed") == 0 )
+       dir.type = ICON_THEME_DIR_Fixed;
+     else if( g_strcmp0(type, "Scalable") == 0 )
+       dir.type = ICON_THEME_DIR_Scalable;
+     else
+       dir.type = ICON_THEME_DIR_Threshold;
+
+     g_free(type);
+
+     /* A theme could be spread over several base directories, e.g. the user's additions. */
+     for(guint i=0; i<baseDirs->len; i++)
+     {
+        gchar *path = g_build_filename((const gchar*)g_ptr_array_index(baseDirs, i), themeName, subdirs[s], "/", NULL);
+
+        if( !g_file_test(path, G_FILE_TEST_IS_DIR) )
+        {
+           g_free(path);
+           continue;
+        }
+
+        dir.path = path;
+        dir.context = g_key_file_get_string(keyFile, subdirs[s], "Context", NULL);
+        g_array_append_val(m_pDirs, dir);
+     }
+  }
+
+  for(gint p=0; parents && parents[p]; p++)
+    g_ptr_array_add(inherits, g_strdup(parents[p]));
+
+  g_strfreev(subdirs);
+  g_strfreev(parents);
+  g_key_file_free(keyFile);
+
+  for(guint i=0; i<baseDirs->len; i++)
+    g_free(g_ptr_array_index(baseDirs, i));
+
+  g_ptr_array_free(baseDirs, TRUE);
+}
+
+/*! \fn void CIconTheme::m_AddTheme(const gchar *themeName)
+    \brief To append a theme and, depth first, the themes it inherits to the lookup order.
+
+    \param[in] themeName. The theme name.
+    \return NONE
+*/
+void CIconTheme::m_AddTheme(const gchar *themeName)
+{
+  GPtrArray *inherits = NULL;
+
+  for(guint i=0; i<m_pThemes->len; i++)
+  {
+     if( strcmp(themeName, (const gchar*)g_ptr_array_index(m_pThemes, i)) == 0 )
+       return;
+  }
+
+  g_ptr_array_add(m_pThemes, g_strdup(themeName));
+
+  inherits = g_ptr_array_new();
+  m_ParseTheme(themeName, m_pThemes->len - 1, inherits);
+
+  for(guint i=0; i<inherits->len; i++)
+  {
+     m_AddTheme((const gchar*)g_ptr_array_index(inherits, i));
+     g_free(g_ptr_array_index(inherits, i));
+  }
+
+  g_ptr_array_free(inherits, TRUE);
+}
+
+/*! \fn void CIconTheme::m_AddFile(const gchar *iconName, gsize nameLength, guint nDir, gint ext)
+    \brief To append a file of an icon to the icon name table.
+
+    \param[in] iconName. The icon name, or a file name whose first "nameLength" characters are the icon name.
+    \param[in] nameLength. The length of the icon name.
+    \param[in] nDir. The index of the directory in the directory table.
+    \param[in] ext. One of ICON_THEME_EXT.
+    \return NONE
+*/
+void CIconTheme::m_AddFile(const gchar *iconName, gsize nameLength, guint nDir, gint ext)
+{
+  ICON_THEME_FILE file;
+  GArray *files = NULL;
+  gchar *name = g_strndup(iconName, nameLength);
+
+  file.nDir = nDir;
+  file.ext = ext;
+
+  files = (GArray*)g_hash_table_lookup(m_pIcons, name);
+  if(files)
+    g_free(name);
+  else
+  {
+     files = g_array_new(false, false, sizeof(ICON_THEME_FILE));
+     g_hash_table_insert(m_pIcons, name, files);
+  }
+
+  g_array_append_val(files, file);
+}
+
+/*! \fn void CIconTheme::m_IndexDirectory(guint nDir)
+    \brief To list the icon files of a theme directory into the icon name table.
+
+    \param[in] nDir. The index of the directory in the directory table.
+    \return NONE
+*/
+void CIconTheme::m_IndexDirectory(guint nDir)
+{
+  const ICON_THEME_DIR *dir = &g_array_index(m_pDirs, ICON_THEME_DIR, nDir);
+  const gchar *baseName = NULL;
+  GDir *pDir = g_dir_open(dir->path, 0, NULL);
+
+  if(!pDir)
+    return;
+
+  while( (baseName = g_dir_read_name(pDir)) != NULL )
+  {
+     gsize nameLength = 0;
+     gint ext = get_ext(baseName, &nameLength);
+
+     if(ext >= 0)
+       m_AddFile(baseName, nameLength, nDir, ext);
+  }
+
+  g_dir_close(pDir);
+}
+
+/*! \struct ICON_THEME_CACHE_INDEX
+    \brief The state of indexing one icon-theme.cache.
+*/
+typedef struct _ICON_THEME_CACHE_INDEX
+{
+  CIconTheme *theme;   /*!< The theme indexed. */
+  gint *dirMap;        /*!< The directory table index of every directory of the cache, -1 if it is not in the table. */
+  guint nDirs;         /*!< The number of directories of the cache. */
+} ICON_THEME_CACHE_INDEX;
+
+/*! \fn void CIconTheme::m_IndexCacheImage(const gchar *iconName, const ICON_CACHE_IMAGE *image, gpointer userData)
+    \brief To append the files of an icon in one cached directory to the icon name table.
+
+    \param[in] iconName. The icon name.
+    \param[in] image. The directory and the extension names of the icon.
+    \param[in] userData. The ICON_THEME_CACHE_INDEX.
+    \return NONE
+*/
+void CIconTheme::m_IndexCacheImage(const gchar *iconName, const ICON_CACHE_IMAGE *image, gpointer userData)
+{
+  ICON_THEME_CACHE_INDEX *index = (ICON_THEME_CACHE_INDEX*)userData;
+  gsize nameLength = strlen(iconName);
+  gint nDir = -1;
+
+  if(image->nDir >= index->nDirs)
+    return;
+
+  nDir = index->dirMap[image->nDir];
+  if(nDir < 0)
+    return;
+
+  if(image->flags & ICON_CACHE_FLAG_PNG)
+    index->theme->m_AddFile(iconName, nameLength, nDir, ICON_THEME_EXT_Png);
+
+  if(image->flags & ICON_CACHE_FLAG_SVG)
+    index->theme->m_AddFile(iconName, nameLength, nDir, ICON_THEME_EXT_Svg);
+
+  if(image->flags & ICON_CACHE_FLAG_XPM)
+    index->theme->m_AddFile(iconName, nameLength, nDir, ICON_THEME_EXT_Xpm);
+}
+
+/*! \fn void CIconTheme::m_IndexCaches(gboolean *pIndexed)
+    \brief To index the directories of the theme chain from the icon-theme.cache of every theme directory having an up to date one.
+    \n Reading a cache is one mapping, instead of opening and listing every directory of the theme.
+
+    \param[out] pIndexed. One flag for every directory of the directory table, set if the directory is indexed from a cache.
+    \return NONE
+*/
+void CIconTheme::m_IndexCaches(gboolean *pIndexed)
+{
+  GPtrArray *baseDirs = m_GetBaseDirs();
+  GHashTable *dirPaths = g_hash_table_new(g_str_hash, g_str_equal);
+
+  for(guint i=0; i<m_pDirs->len; i++)
+    g_hash_table_insert(dirPaths, g_array_index(m_pDirs, ICON_THEME_DIR, i).path, GUINT_TO_POINTER(i + 1));
+
+  for(guint t=0; t<m_pThemes->len; t++)
+  {
+     for(guint b=0; b<baseDirs->len; b++)
+     {
+        gchar *themeDir = g_build_filename((const gchar*)g_ptr_array_index(baseDirs, b), (const gchar*)g_ptr_array_index(m_pThemes, t), NULL);
+        CIconThemeCache cache;
+        ICON_THEME_CACHE_INDEX index;
+
+        if( !cache.m_Open(themeDir) )
+        {
+           g_free(themeDir);
+           continue;
+        }
+
+        index.theme = this;
+        index.nDirs = cache.m_GetDirCount();
+        index.dirMap = g_new(gint, index.nDirs + 1);
+
+        for(guint d=0; d<index.nDirs; d++)
+        {
+           const gchar *dirName = cache.m_GetDirName(d);
+           gchar *path = dirName ? g_build_filename(themeDir, dirName, "/", NULL) : NULL;
+           guint nDir = path ? GPOINTER_TO_UINT(g_hash_table_lookup(dirPaths, path)) : 0;
+
+           /* The directories of the cache not described by index.theme are not looked in. */
+           index.dirMap[d] = (gint)nDir - 1;
+
+           g_free(path);
+        }
+
+        /* The directories of a corrupt cache are listed instead. */
+        if( cache.m_ForEachImage(m_IndexCacheImage, &index) )
+        {
+           for(guint d=0; d<index.nDirs; d++)
+           {
+              if(index.dirMap[d] >= 0)
+                pIndexed[ index.dirMap[d] ] = true;
+           }
+
+           #ifdef DEBUG_MENU_ICONCHOOSER
+           printf("%s(%d) - %s indexed from its cache \n", __FUNCTION__, __LINE__, themeDir);
+           #endif
+        }
+
+        g_free(index.dirMap);
+        g_free(themeDir);
+     }
+  }
+
+  g_hash_table_destroy(dirPaths);
+
+  for(guint i=0; i<baseDirs->len; i++)
+    g_free(g_ptr_array_index(baseDirs, i));
+
+  g_ptr_array_free(baseDirs, TRUE);
+}
+
+/*! \fn static gint compare_files(gconstpointer a, gconstpointer b)
+    \brief To sort the ICON_THEME_FILE of an icon name into lookup order for g_array_sort().
+*/
+static gint compare_files(gconstpointer a, gconstpointer b)
+{
+  const ICON_THEME_FILE *fileA = (const ICON_THEME_FILE*)a;
+  const ICON_THEME_FILE *fileB = (const ICON_THEME_FILE*)b;
+
+  if(fileA->nDir != fileB->nDir)
+    return (fileA->nDir < fileB->nDir) ? -1 : 1;
+
+  return fileA->ext - fileB->ext;
+}
+
+/*! \fn static void sort_files(gpointer key, gpointer value, gpointer userData)
+    \brief To sort the files of one icon name, for g_hash_table_foreach().
+*/
+static void sort_files(gpointer key, gpointer value, gpointer userData)
+{
+  GArray *files = (GArray*)value;
+
+  if(files->len > 1)
+    g_array_sort(files, compare_files);
+}
+
+/*! \fn gboolean CIconTheme::m_Load(const gchar *themeName)
+    \brief To load a theme and the themes it inherits into the tables. Nothing is done if the theme is loaded already.
+
+    \param[in] themeName. The theme name, e.g. "gnome".
+    \return FALSE if the theme has no index.theme.
+*/
+gboolean CIconTheme::m_Load(const gchar *themeName)
+{
+  gboolean *pIndexed = NULL;
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  gint64 nStart = g_get_monotonic_time();
+  #endif
+
+  if( !themeName || (strlen(themeName) == 0) )
+    return false;
+
+  if( m_ThemeName && (strcmp(m_ThemeName, themeName) == 0) )
+    return true;
+
+  m_Clear();
+
+  m_AddTheme(themeName);
+
+  /* A theme without directories of its own does not exist. */
+  if( (m_pDirs->len == 0) || (g_array_index(m_pDirs, ICON_THEME_DIR, 0).nTheme != 0) )
+  {
+     m_Clear();
+     return false;
+  }
+
+  /* Every theme finally falls back to hicolor. */
+  m_AddTheme(ICON_THEME_FALLBACK);
+
+  m_ThemeName = g_strdup(themeName);
+
+  /* The caches are read first, then only the directories without an up to date cache are listed. */
+  pIndexed = g_new0(gboolean, m_pDirs->len);
+  m_IndexCaches(pIndexed);
+
+  for(guint i=0; i<m_pDirs->len; i++)
+  {
+     if( !pIndexed[i] )
+       m_IndexDirectory(i);
+  }
+
+  g_free(pIndexed);
+
+  /* The caches and the directories are indexed in different orders, the files of each icon name must be in lookup order. */
+  g_hash_table_foreach(m_pIcons, sort_files, NULL);
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - Theme %s: %u themes, %u directories, %u icon names in %.1f ms \n", __FUNCTION__, __LINE__,
+         themeName, m_pThemes->len, m_pDirs->len, g_hash_table_size(m_pIcons), (g_get_monotonic_time() - nStart) / 1000.0);
+  #endif
+
+  return true;
+}
+
+/*! \fn gchar* CIconTheme::m_LookupIcon(const gchar *iconName, gint size, gint scale)
+    \brief To find the file of an icon name in the theme chain, without touching the file system.
+
+    \param[in] iconName. The icon name, without extension.
+    \param[in] size. The wanted size.
+    \param[in] scale. The wanted scale.
+    \return The full file name, NULL if the icon is not found. It must be freed.
+*/
+gchar* CIconTheme::m_LookupIcon(const gchar *iconName, gint size, gint scale)
+{
+  GArray *files = NULL;
+  const ICON_THEME_FILE *file = NULL;
+
+  if( !iconName || !m_ThemeName )
+    return NULL;
+
+  files = (GArray*)g_hash_table_lookup(m_pIcons, iconName);
+  if(!files)
+    return NULL;
+
+  file = find_best_file(files, m_pDirs, NULL, size, scale);
+  if(!file)
+    return NULL;
+
+  return g_strconcat(g_array_index(m_pDirs, ICON_THEME_DIR, file->nDir).path, iconName, g_ThemeExtNames[file->ext], NULL);
+}
+
+/*! \fn static gint compare_names(gconstpointer a, gconstpointer b)
+    \brief To sort icon names for g_ptr_array_sort().
+*/
+static gint compare_names(gconstpointer a, gconstpointer b)
+{
+  return strcmp(*(const gchar**)a, *(const gchar**)b);
+}
+
+/*! \fn GPtrArray* CIconTheme::m_ListIcons(const gchar *context, gint size, gint scale)
+    \brief To list the best file of every icon of a context.
+
+    \param[in] context. The context, e.g. "Applications", NULL for all contexts.
+    \param[in] size. The wanted size.
+    \param[in] scale. The wanted scale.
+    \return The full file names sorted by icon name. The array and its strings must be freed.
+*/
+GPtrArray* CIconTheme::m_ListIcons(const gchar *context, gint size, gint scale)
+{
+  GPtrArray *iconNames = g_ptr_array_new();
+  GPtrArray *fullNames = g_ptr_array_new();
+  GHashTableIter iter;
+  gpointer key = NULL, value = NULL;
+
+  g_hash_table_iter_init(&iter, m_pIcons);
+  while( g_hash_table_iter_next(&iter, &key, &value) )
+    g_ptr_array_add(iconNames, key);
+
+  g_ptr_array_sort(iconNames, compare_names);
+
+  for(guint i=0; i<iconNames->len; i++)
+  {
+     const gchar *iconName = (const gchar*)g_ptr_array_index(iconNames, i);
+     const ICON_THEME_FILE *file = find_best_file((GArray*)g_hash_table_lookup(m_pIcons, iconName), m_pDirs, context, size, scale);
+
+     if(file)
+       g_ptr_array_add(fullNames, g_strconcat(g_array_index(m_pDirs, ICON_THEME_DIR, file->nDir).path, iconName, g_ThemeExtNames[file->ext], NULL));
+  }
+
+  g_ptr_array_free(iconNames, TRUE);
+
+  return fullNames;
+}
+
+/*! \fn GPtrArray* CIconTheme::m_GetContexts(void)
+    \brief To list the contexts of the theme chain, each once.
+
+    \param[in] NONE
+    \return The context names. The array must be freed, the strings belong to the theme.
+*/
+GPtrArray* CIconTheme::m_GetContexts(void)
+{
+  GPtrArray *contexts = g_ptr_array_new();
+
+  for(guint i=0; i<m_pDirs->len; i++)
+  {
+     const gchar *context = g_array_index(m_pDirs, ICON_THEME_DIR, i).context;
+     gboolean bFound = false;
+
+     if(!context)
+       continue;
+
+     for(guint j=0; (j<contexts->len) && !bFound; j++)
+       bFound = (strcmp(context, (const gchar*)g_ptr_array_index(contexts, j)) == 0);
+
+     if(!bFound)
+       g_ptr_array_add(contexts, (gpointer)context);
+  }
+
+  return contexts;
+}
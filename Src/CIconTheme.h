@@ -0,0 +1,124 @@
+/*! \file    CIconTheme.h
+    \brief   Declaration of class CIconTheme.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONTHEME
+#define __CICONTHEME
+
+#include <glib.h>
+
+#include "CIconThemeCache.h"
+
+/* The icon browsing location of a theme: "theme:<theme name>/<context>".
+   An empty theme name means the current theme, no context means all contexts. */
+#define ICON_LOCATION_THEME  "theme:"
+
+/* The theme every theme finally inherits from. */
+#define ICON_THEME_FALLBACK  "hicolor"
+
+/*! \enum ICON_THEME_DIR_TYPE
+    \brief The "Type" key of a theme directory.
+*/
+enum ICON_THEME_DIR_TYPE {
+  ICON_THEME_DIR_Fixed = 0,
+  ICON_THEME_DIR_Scalable,
+  ICON_THEME_DIR_Threshold
+};
+
+/*! \enum ICON_THEME_EXT
+    \brief The extension names of icon files, in the order they are preferred in.
+*/
+enum ICON_THEME_EXT {
+  ICON_THEME_EXT_Png = 0,
+  ICON_THEME_EXT_Svg,
+  ICON_THEME_EXT_Xpm,
+  N_ICON_THEME_EXT
+};
+
+/*! \struct ICON_THEME_DIR
+    \brief One directory of a theme in one base directory, as described in its index.theme.
+*/
+typedef struct _ICON_THEME_DIR
+{
+  gchar *path;        /*!< The full directory name with a trailing "/". */
+  gchar *context;     /*!< The "Context" key, e.g. "Applications", NULL if it is not given. */
+  gint   nTheme;      /*!< The index of the theme in the lookup order, 0 is the theme itself. */
+  gint   type;        /*!< One of ICON_THEME_DIR_TYPE. */
+  gint   size;        /*!< The "Size" key. */
+  gint   minSize;     /*!< The "MinSize" key, "Size" if it is not given. */
+  gint   maxSize;     /*!< The "MaxSize" key, "Size" if it is not given. */
+  gint   threshold;   /*!< The "Threshold" key, 2 if it is not given. */
+  gint   scale;       /*!< The "Scale" key, 1 if it is not given. */
+} ICON_THEME_DIR;
+
+/*! \struct ICON_THEME_FILE
+    \brief One file of an icon, found in a theme directory.
+*/
+typedef struct _ICON_THEME_FILE
+{
+  guint  nDir;        /*!< The index of the directory in the directory table. */
+  gint   ext;         /*!< One of ICON_THEME_EXT. */
+} ICON_THEME_FILE;
+
+/*! \class CIconTheme
+    \brief An icon theme and the themes it inherits, parsed once into an in-memory table.
+
+    All index.theme files of the theme chain are parsed with GKeyFile into a directory table, and every
+    directory is indexed once into an icon name table, from the theme's icon-theme.cache when it is up to date,
+    otherwise by listing the directory. Then the lookups follow the Icon Theme Specification
+    on the tables only: the themes in inheritance order, the directories matching the size exactly,
+    otherwise the directory with the closest size.
+*/
+class CIconTheme
+{
+  private:
+    gchar *m_ThemeName;     /*!< The name of the theme loaded. */
+    GPtrArray *m_pThemes;   /*!< The names of the theme chain in lookup order, ending with ICON_THEME_FALLBACK. */
+    GArray *m_pDirs;        /*!< The ICON_THEME_DIR table, in lookup order. */
+    GHashTable *m_pIcons;   /*!< The icon name to the GArray of its ICON_THEME_FILE, in lookup order. */
+
+    void m_AddTheme(const gchar *themeName);
+    void m_ParseTheme(const gchar *themeName, gint nTheme, GPtrArray *inherits);
+    void m_AddFile(const gchar *iconName, gsize nameLength, guint nDir, gint ext);
+    void m_IndexDirectory(guint nDir);
+    void m_IndexCaches(gboolean *pIndexed);
+    void m_Clear(void);
+
+    static void m_IndexCacheImage(const gchar *iconName, const ICON_CACHE_IMAGE *image, gpointer userData);
+
+  public:
+    CIconTheme();
+    ~CIconTheme();
+
+    /* To load a theme and the themes it inherits. FALSE if the theme has no index.theme. */
+    gboolean m_Load(const gchar *themeName);
+    const gchar* m_GetThemeName(void) { return m_ThemeName; }
+
+    /* The names of the theme chain in lookup order, the theme, the themes it inherits and ICON_THEME_FALLBACK.
+       The array belongs to the theme. */
+    const GPtrArray* m_GetChain(void) { return m_pThemes; }
+
+    /* To find the file of an icon name for a size and scale. The returned string must be freed, NULL if it is not found. */
+    gchar* m_LookupIcon(const gchar *iconName, gint size, gint scale);
+
+    /* To list the best file of every icon in a context(NULL for all contexts), sorted by icon name.
+       The array and its strings must be freed. */
+    GPtrArray* m_ListIcons(const gchar *context, gint size, gint scale);
+
+    /* To list the contexts of the theme chain. The array must be freed, the strings belong to the theme. */
+    GPtrArray* m_GetContexts(void);
+
+    /* The directories themes are searched in, as the Icon Theme Specification defines. The array and its strings must be freed. */
+    static GPtrArray* m_GetBaseDirs(void);
+
+    /* The size matching functions of the Icon Theme Specification. */
+    static gboolean m_DirectoryMatchesSize(const ICON_THEME_DIR *dir, gint size, gint scale);
+    static gint m_DirectorySizeDistance(const ICON_THEME_DIR *dir, gint size, gint scale);
+};
+#endif   /* CICONTHEME.H	*/
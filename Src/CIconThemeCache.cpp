@@ -0,0 +1,329 @@
+/*! \file    CIconThemeCache.cpp
+    \brief   Read the icon-theme.cache of a theme directory from a memory mapping.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CIconThemeCache.h"
+
+/* The cache format version understood. */
+#define ICON_CACHE_MAJOR_VERSION  1
+
+/* The offset of an empty hash bucket. */
+#define ICON_CACHE_NO_OFFSET  0xFFFFFFFF
+
+/* The header: major(16), minor(16), hash offset(32), directory list offset(32). */
+#define ICON_CACHE_HEADER_SIZE  12
+
+/* An icon entry: chain offset(32), name offset(32), image list offset(32). */
+#define ICON_CACHE_ICON_SIZE  12
+
+/* An image: directory index(16), flags(16), image data offset(32). */
+#define ICON_CACHE_IMAGE_SIZE  8
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconThemeCache::CIconThemeCache()
+    \brief CIconThemeCache constructor
+*/
+CIconThemeCache::CIconThemeCache()
+{
+  m_pData = NULL;
+  m_nSize = 0;
+  m_nHashOffset = 0;
+  m_nDirOffset = 0;
+}
+
+/*! \fn CIconThemeCache::~CIconThemeCache()
+    \brief CIconThemeCache destructor
+*/
+CIconThemeCache::~CIconThemeCache()
+{
+  m_Close();
+}
+
+/*! \fn gboolean CIconThemeCache::m_Read16(gsize offset, guint16 *pValue)
+    \brief To read a big-endian 16-bit number.
+
+    \param[in] offset. The offset in the file.
+    \param[out] pValue. The number.
+    \return TRUE if the number is inside the file.
+*/
+gboolean CIconThemeCache::m_Read16(gsize offset, guint16 *pValue)
+{
+  if( (offset > m_nSize) || (m_nSize - offset < 2) )
+    return FALSE;
+
+  *pValue = (guint16)((m_pData[offset] << 8) | m_pData[offset + 1]);
+  return TRUE;
+}
+
+/*! \fn gboolean CIconThemeCache::m_Read32(gsize offset, guint32 *pValue)
+    \brief To read a big-endian 32-bit number.
+
+    \param[in] offset. The offset in the file.
+    \param[out] pValue. The number.
+    \return TRUE if the number is inside the file.
+*/
+gboolean CIconThemeCache::m_Read32(gsize offset, guint32 *pValue)
+{
+  if( (offset > m_nSize) || (m_nSize - offset < 4) )
+    return FALSE;
+
+  *pValue = ((guint32)m_pData[offset] << 24) | ((guint32)m_pData[offset + 1] << 16) |
+            ((guint32)m_pData[offset + 2] << 8) | (guint32)m_pData[offset + 3];
+  return TRUE;
+}
+
+/*! \fn const gchar* CIconThemeCache::m_GetString(guint32 offset)
+    \brief To get a string of the file.
+
+    \param[in] offset. The offset in the file.
+    \return The string, NULL if it is not terminated inside the file.
+*/
+const gchar* CIconThemeCache::m_GetString(guint32 offset)
+{
+  if( (gsize)offset >= m_nSize )
+    return NULL;
+
+  if( !memchr(m_pData + offset, '\0', m_nSize - offset) )
+    return NULL;
+
+  return (const gchar*)(m_pData + offset);
+}
+
+/*! \fn gboolean CIconThemeCache::m_Open(const gchar *themeDir)
+    \brief To map the cache of a theme directory.
+    \n The cache is stale if the directory was changed after it, e.g. an icon was installed without updating the cache.
+
+    \param[in] themeDir. The theme directory, e.g. "/usr/share/icons/hicolor".
+    \return TRUE if the cache is mapped, FALSE if it is missing, stale or invalid.
+*/
+gboolean CIconThemeCache::m_Open(const gchar *themeDir)
+{
+  gchar *fileName = NULL;
+  struct stat dirStat, cacheStat;
+  gpointer pData = NULL;
+  guint16 major = 0;
+  gint fd = -1;
+
+  m_Close();
+
+  if( !themeDir || (stat(themeDir, &dirStat) != 0) )
+    return FALSE;
+
+  fileName = g_build_filename(themeDir, ICON_THEME_CACHE_NAME, NULL);
+  fd = open(fileName, O_RDONLY);
+  g_free(fileName);
+
+  if(fd < 0)
+    return FALSE;
+
+  if( (fstat(fd, &cacheStat) != 0) || (cacheStat.st_mtime < dirStat.st_mtime) ||
+      (cacheStat.st_size < ICON_CACHE_HEADER_SIZE) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("%s(%d) - the cache of %s is missing or stale \n", __FUNCTION__, __LINE__, themeDir);
+     #endif
+
+     close(fd);
+     return FALSE;
+  }
+
+  pData = mmap(NULL, cacheStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if(pData == MAP_FAILED)
+    return FALSE;
+
+  m_pData = (const guchar*)pData;
+  m_nSize = cacheStat.st_size;
+
+  if( !m_Read16(0, &major) || (major != ICON_CACHE_MAJOR_VERSION) ||
+      !m_Read32(4, &m_nHashOffset) || !m_Read32(8, &m_nDirOffset) )
+  {
+     m_Close();
+     return FALSE;
+  }
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  printf("%s(%d) - %s: %lu bytes, %u directories \n", __FUNCTION__, __LINE__, themeDir, (gulong)m_nSize, m_GetDirCount());
+  #endif
+
+  return TRUE;
+}
+
+/*! \fn void CIconThemeCache::m_Close(void)
+    \brief To unmap the cache.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconThemeCache::m_Close(void)
+{
+  if(m_pData)
+    munmap((void*)m_pData, m_nSize);
+
+  m_pData = NULL;
+  m_nSize = 0;
+  m_nHashOffset = 0;
+  m_nDirOffset = 0;
+}
+
+/*! \fn guint32 CIconThemeCache::m_GetDirCount(void)
+    \brief To get the number of directories in the cache.
+
+    \param[in] NONE
+    \return The number of directories, 0 if no cache is open.
+*/
+guint32 CIconThemeCache::m_GetDirCount(void)
+{
+  guint32 nDirs = 0;
+
+  if( !m_pData || !m_Read32(m_nDirOffset, &nDirs) )
+    return 0;
+
+  return nDirs;
+}
+
+/*! \fn const gchar* CIconThemeCache::m_GetDirName(guint32 idx)
+    \brief To get a directory name of the cache, relative to the theme directory.
+
+    \param[in] idx. The index in the directory list.
+    \return The directory name, e.g. "48x48/apps". It belongs to the mapping, NULL if the index is invalid.
+*/
+const gchar* CIconThemeCache::m_GetDirName(guint32 idx)
+{
+  guint32 offset = 0;
+
+  if( idx >= m_GetDirCount() )
+    return NULL;
+
+  if( !m_Read32((gsize)m_nDirOffset + 4 + (gsize)idx * 4, &offset) )
+    return NULL;
+
+  return m_GetString(offset);
+}
+
+/*! \fn gboolean CIconThemeCache::m_GetImages(guint32 iconOffset, const gchar **pName, guint32 *pImageList)
+    \brief To read an icon entry: chain offset(32), name offset(32), image list offset(32).
+
+    \param[in] iconOffset. The offset of the icon entry.
+    \param[out] pName. The icon name.
+    \param[out] pImageList. The offset of the image list.
+    \return TRUE if the entry is valid.
+*/
+gboolean CIconThemeCache::m_GetImages(guint32 iconOffset, const gchar **pName, guint32 *pImageList)
+{
+  guint32 nameOffset = 0;
+
+  if( !m_Read32((gsize)iconOffset + 4, &nameOffset) || !m_Read32((gsize)iconOffset + 8, pImageList) )
+    return FALSE;
+
+  *pName = m_GetString(nameOffset);
+
+  return (*pName != NULL);
+}
+
+/*! \fn guint32 CIconThemeCache::m_ClampImages(guint32 imageList, guint32 nImages)
+    \brief To bound the image count of an image list by the bytes left in the file, 8 per image.
+
+    \param[in] imageList. The offset of the image list, its count had been read.
+    \param[in] nImages. The count read.
+    \return The count which fits in the file.
+*/
+guint32 CIconThemeCache::m_ClampImages(guint32 imageList, guint32 nImages)
+{
+  gsize nLeft = m_nSize - ((gsize)imageList + 4);
+
+  return (guint32)MIN((gsize)nImages, nLeft / 8);
+}
+
+/*! \fn gboolean CIconThemeCache::m_Walk(ICON_CACHE_FUNC func, gpointer userData)
+    \brief To walk every image of every icon in the cache, bucket by bucket.
+    \n An icon entry takes 12 bytes and an image 8, so a valid cache has no more of them than its size allows.
+    A corrupt cache whose chains loop or share their entries is given up when the walk goes over those counts.
+
+    \param[in] func. The function called, NULL to only check the cache.
+    \param[in] userData. Passed to the function.
+    \return TRUE if the whole cache was walked, FALSE if it is corrupt.
+*/
+gboolean CIconThemeCache::m_Walk(ICON_CACHE_FUNC func, gpointer userData)
+{
+  gsize nMaxIcons = m_nSize / ICON_CACHE_ICON_SIZE, nMaxImages = m_nSize / ICON_CACHE_IMAGE_SIZE;
+  gsize nIcons = 0, nImagesWalked = 0;
+  guint32 nBuckets = 0;
+
+  if( !m_pData || !m_Read32(m_nHashOffset, &nBuckets) )
+    return FALSE;
+
+  for(guint32 b=0; b<nBuckets; b++)
+  {
+     guint32 iconOffset = ICON_CACHE_NO_OFFSET;
+
+     if( !m_Read32((gsize)m_nHashOffset + 4 + (gsize)b * 4, &iconOffset) )
+       return FALSE;
+
+     while(iconOffset != ICON_CACHE_NO_OFFSET)
+     {
+        guint32 imageList = 0, nImages = 0;
+        const gchar *name = NULL;
+
+        if( (++nIcons > nMaxIcons) || !m_GetImages(iconOffset, &name, &imageList) || !m_Read32(imageList, &nImages) )
+          return FALSE;
+
+        nImages = m_ClampImages(imageList, nImages);
+
+        nImagesWalked += nImages;
+        if(nImagesWalked > nMaxImages)
+          return FALSE;
+
+        for(guint32 i=0; (i < nImages) && func; i++)
+        {
+           ICON_CACHE_IMAGE image;
+
+           if( !m_Read16((gsize)imageList + 4 + (gsize)i * 8, &image.nDir) || !m_Read16((gsize)imageList + 6 + (gsize)i * 8, &image.flags) )
+             break;
+
+           func(name, &image, userData);
+        }
+
+        if( !m_Read32(iconOffset, &iconOffset) )
+          return FALSE;
+     }
+  }
+
+  return TRUE;
+}
+
+/*! \fn gboolean CIconThemeCache::m_ForEachImage(ICON_CACHE_FUNC func, gpointer userData)
+    \brief To call a function for every image of every icon in the cache.
+    \n The cache is checked first, nothing is called for a corrupt one, so no half of it is indexed.
+
+    \param[in] func. The function called.
+    \param[in] userData. Passed to the function.
+    \return TRUE if the function was called for the whole cache, FALSE if the cache is corrupt.
+*/
+gboolean CIconThemeCache::m_ForEachImage(ICON_CACHE_FUNC func, gpointer userData)
+{
+  if( !func || !m_Walk(NULL, NULL) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("%s(%d) - the cache is corrupt, it is not used \n", __FUNCTION__, __LINE__);
+     #endif
+
+     return FALSE;
+  }
+
+  return m_Walk(func, userData);
+}
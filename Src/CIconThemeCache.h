@@ -0,0 +1,78 @@
+/*! \file    CIconThemeCache.h
+    \brief   Declaration of class CIconThemeCache.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONTHEMECACHE
+#define __CICONTHEMECACHE
+
+#include <glib.h>
+
+/* The file name of the cache in a theme directory, written by gtk-update-icon-cache. */
+#define ICON_THEME_CACHE_NAME  "icon-theme.cache"
+
+/* The flags of an image in the cache, telling the extension names the icon has in a directory. */
+#define ICON_CACHE_FLAG_XPM   0x01
+#define ICON_CACHE_FLAG_SVG   0x02
+#define ICON_CACHE_FLAG_PNG   0x04
+
+/*! \struct ICON_CACHE_IMAGE
+    \brief One directory containing an icon.
+*/
+typedef struct _ICON_CACHE_IMAGE
+{
+  guint16 nDir;      /*!< The index of the directory in the cache's directory list. */
+  guint16 flags;     /*!< ICON_CACHE_FLAG_* of the files of the icon in that directory. */
+} ICON_CACHE_IMAGE;
+
+/*! \typedef ICON_CACHE_FUNC
+    \brief The function type called for every image of every icon by CIconThemeCache::m_ForEachImage().
+*/
+typedef void (*ICON_CACHE_FUNC)(const gchar *iconName, const ICON_CACHE_IMAGE *image, gpointer userData);
+
+/*! \class CIconThemeCache
+    \brief A read-only view of an icon-theme.cache file, mapped into memory.
+
+    The file is the hashed format of gtk-update-icon-cache, all numbers are big-endian:
+    a header(major and minor version, hash offset, directory list offset), the directory list,
+    the hash buckets with chains of icons, and per icon the list of directories it is in.
+    The whole cache is walked once to index a theme, it is one mapping instead of listing every directory.
+    Every offset is checked against the file size, so a truncated or corrupt cache is rejected, not followed.
+*/
+class CIconThemeCache
+{
+  private:
+    const guchar *m_pData;   /*!< The mapped file, NULL if none is open. */
+    gsize m_nSize;           /*!< The size of the mapped file. */
+    guint32 m_nHashOffset;   /*!< The offset of the hash buckets. */
+    guint32 m_nDirOffset;    /*!< The offset of the directory list. */
+
+    gboolean m_Read16(gsize offset, guint16 *pValue);
+    gboolean m_Read32(gsize offset, guint32 *pValue);
+    const gchar* m_GetString(guint32 offset);
+    gboolean m_GetImages(guint32 iconOffset, const gchar **pName, guint32 *pImageList);
+    guint32 m_ClampImages(guint32 imageList, guint32 nImages);
+    gboolean m_Walk(ICON_CACHE_FUNC func, gpointer userData);
+
+  public:
+    CIconThemeCache();
+    ~CIconThemeCache();
+
+    /* To map the cache of a theme directory. FALSE if it is missing, older than the directory or invalid. */
+    gboolean m_Open(const gchar *themeDir);
+    void m_Close(void);
+    gboolean m_IsOpen(void) { return m_pData != NULL; }
+
+    /* The directory list of the cache, e.g. "48x48/apps". */
+    guint32 m_GetDirCount(void);
+    const gchar* m_GetDirName(guint32 idx);
+
+    /* To call a function for every image of every icon. FALSE if the cache is corrupt, nothing is called then. */
+    gboolean m_ForEachImage(ICON_CACHE_FUNC func, gpointer userData);
+};
+#endif   /* CICONTHEMECACHE.H	*/
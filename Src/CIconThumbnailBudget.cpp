@@ -0,0 +1,1336 @@
+/*! \file    CIconThumbnailBudget.cpp
+    \brief   Bound the memory taken by the thumbnails of an icon view.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CIconThumbnailBudget.h"
+
+/*! \fn static gsize pixbuf_bytes(GdkPixbuf *pixbuf)
+    \brief To get the memory of a thumbnail.
+*/
+static gsize pixbuf_bytes(GdkPixbuf *pixbuf)
+{
+  return (gsize)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf) + ICON_BUDGET_PIXBUF_OVERHEAD;
+}
+
+/*! \fn static gint compare_distance(gconstpointer a, gconstpointer b, gpointer data)
+    \brief To sort the positions of rows, the farthest from the kept window { first, last } first.
+*/
+static gint compare_distance(gconstpointer a, gconstpointer b, gpointer data)
+{
+  const gint *window = (const gint*)data;
+  gint rowA = *(const gint*)a, rowB = *(const gint*)b;
+  gint distA = (rowA < window[0]) ? (window[0] - rowA) : (rowA - window[1]);
+  gint distB = (rowB < window[0]) ? (window[0] - rowB) : (rowB - window[1]);
+
+  return distB - distA;
+}
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconThumbnailBudget::CIconThumbnailBudget(CIconCatalog *pCatalog, gint iconColumn, gint pathColumn, gint hashColumn, gint size)
+    \brief CIconThumbnailBudget constructor
+
+    \param[in] pCatalog. The catalog the thumbnails are restored from.
+    \param[in] iconColumn. The model column of the thumbnail.
+    \param[in] pathColumn. The model column of the icon's full file name.
+    \param[in] hashColumn. The model column of the icon's content hash, 0 if it is unknown.
+    \param[in] size. The thumbnail size.
+*/
+CIconThumbnailBudget::CIconThumbnailBudget(CIconCatalog *pCatalog, gint iconColumn, gint pathColumn, gint hashColumn, gint size)
+{
+  m_pIconView = NULL;
+  m_pCatalog = pCatalog;
+  m_nIconColumn = iconColumn;
+  m_nPathColumn = pathColumn;
+  m_nHashColumn = hashColumn;
+  m_nSize = 0;
+  m_nMaxBytes = ICON_BUDGET_MAX_BYTES;
+  m_nBytes = 0;
+  m_nRows = 0;
+  m_nEvicted = 0;
+  m_nRestored = 0;
+  m_nIdle = 0;
+  m_pPlaceholder = NULL;
+  m_pResident = g_hash_table_new(g_direct_hash, g_direct_equal);
+  m_pPixbufs = g_hash_table_new(g_direct_hash, g_direct_equal);
+  m_pCompacts = g_hash_table_new(g_direct_hash, g_direct_equal);
+  m_pSharedCompacts = g_hash_table_new(g_int64_hash, g_int64_equal);
+#ifdef USE_COMPACT_THUMBNAILS
+  m_bCompact = true;
+#else
+  m_bCompact = false;
+#endif
+  m_nCompactBytes = 0;
+  m_nExpanded = 0;
+  m_pRenderer = NULL;
+  memset(m_Pool, 0x00, sizeof(m_Pool));
+  m_nPoolStamp = 0;
+  m_nFirstVisible = 0;
+  m_nLastVisible = -1;
+  m_nPassFirstVisible = 0;
+  m_nPassLastVisible = -1;
+  m_pRestored = g_async_queue_new();
+  m_pRestoring = g_hash_table_new(g_direct_hash, g_direct_equal);
+  m_nGeneration = 0;
+
+  /* The files are decoded again off the main loop, the rows get their thumbnails when they come back. */
+  m_pRestorePool = g_thread_pool_new(cb_restore_thread, this, ICON_BUDGET_RESTORE_THREADS, FALSE, NULL);
+
+  m_SetSize(size);
+}
+
+/*! \fn CIconThumbnailBudget::~CIconThumbnailBudget()
+    \brief CIconThumbnailBudget destructor
+*/
+CIconThumbnailBudget::~CIconThumbnailBudget()
+{
+  ICON_BUDGET_RESTORE *restore = NULL;
+
+  m_Attach(NULL);
+
+  /* The restores still queued end without decoding, their results and wake-ups are dropped once all threads are done. */
+  m_CancelRestores();
+
+  if(m_pRestorePool)
+    g_thread_pool_free(m_pRestorePool, FALSE, TRUE);
+
+  m_pRestorePool = NULL;
+
+  while( (restore = (ICON_BUDGET_RESTORE*)g_async_queue_try_pop(m_pRestored)) != NULL )
+    m_FreeRestore(restore);
+
+  while( g_source_remove_by_user_data(this) )
+    ;
+
+  if(m_pRestored)
+    g_async_queue_unref(m_pRestored);
+
+  if(m_pRestoring)
+    g_hash_table_destroy(m_pRestoring);
+
+  m_pRestored = NULL;
+  m_pRestoring = NULL;
+
+  if(m_pResident)
+    g_hash_table_destroy(m_pResident);
+
+  if(m_pPixbufs)
+    g_hash_table_destroy(m_pPixbufs);
+
+  if(m_pCompacts)
+    g_hash_table_destroy(m_pCompacts);
+
+  if(m_pSharedCompacts)
+    g_hash_table_destroy(m_pSharedCompacts);
+
+  if(m_pPlaceholder)
+    g_object_unref(m_pPlaceholder);
+
+  for(gint i=0; i<ICON_BUDGET_POOL_SIZE; i++)
+  {
+     if(m_Pool[i].pixbuf)
+       g_object_unref(m_Pool[i].pixbuf);
+  }
+
+  m_pResident = NULL;
+  m_pPixbufs = NULL;
+  m_pCompacts = NULL;
+  m_pSharedCompacts = NULL;
+  m_pPlaceholder = NULL;
+}
+
+/*! \fn void CIconThumbnailBudget::m_Attach(GtkIconView *iconView)
+    \brief To bound the thumbnails of an icon view. The rows of the previous view are forgotten.
+
+    \param[in] iconView. The icon view, NULL to detach.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_Attach(GtkIconView *iconView)
+{
+  GList *cells = NULL;
+
+  if(m_pIconView)
+  {
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_expose, this);
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_expose_start, this);
+     g_signal_handlers_disconnect_by_func(m_pIconView, (gpointer)cb_destroy, this);
+
+     if(m_pRenderer)
+     {
+        gtk_cell_layout_set_cell_data_func(GTK_CELL_LAYOUT(m_pIconView), m_pRenderer, NULL, NULL, NULL);
+        gtk_cell_renderer_set_fixed_size(m_pRenderer, -1, -1);
+     }
+  }
+
+  m_Reset();
+  m_pIconView = iconView;
+  m_pRenderer = NULL;
+
+  if(!m_pIconView)
+    return;
+
+  /* The rows scrolled into view are exposed, that is when their thumbnails are restored. The visible rows are known
+     before they are drawn, only those are expanded. */
+  g_signal_connect(m_pIconView, "expose-event", G_CALLBACK(cb_expose_start), this);
+  g_signal_connect_after(m_pIconView, "expose-event", G_CALLBACK(cb_expose), this);
+  g_signal_connect(m_pIconView, "destroy", G_CALLBACK(cb_destroy), this);
+
+  /* The compact thumbnails are expanded by the pixbuf renderer, after the attributes set the placeholder. */
+  cells = gtk_cell_layout_get_cells(GTK_CELL_LAYOUT(m_pIconView));
+  for(GList *cell=cells; cell && !m_pRenderer; cell=cell->next)
+  {
+     if( GTK_IS_CELL_RENDERER_PIXBUF(cell->data) )
+       m_pRenderer = GTK_CELL_RENDERER(cell->data);
+  }
+  g_list_free(cells);
+
+  if(m_pRenderer)
+    gtk_cell_layout_set_cell_data_func(GTK_CELL_LAYOUT(m_pIconView), m_pRenderer, cb_cell_data, this, NULL);
+
+  m_SetFixedSize();
+}
+
+/*! \fn void CIconThumbnailBudget::m_Reset(void)
+    \brief To forget the rows without touching them, because the model they were in is replaced.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconThumbnailBudget::m_Reset(void)
+{
+  GHashTableIter hashIter;
+  gpointer value = NULL;
+
+  if(m_nIdle)
+    g_source_remove(m_nIdle);
+
+  m_nIdle = 0;
+
+  m_ClearPool();
+  m_CancelRestores();
+
+  g_hash_table_iter_init(&hashIter, m_pCompacts);
+  while( g_hash_table_iter_next(&hashIter, NULL, &value) )
+    m_ReleaseCompact((ICON_BUDGET_COMPACT*)value);
+
+  g_hash_table_remove_all(m_pResident);
+  g_hash_table_remove_all(m_pPixbufs);
+  g_hash_table_remove_all(m_pCompacts);
+  g_hash_table_remove_all(m_pSharedCompacts);
+  m_nBytes = 0;
+  m_nCompactBytes = 0;
+  m_nRows = 0;
+  m_nEvicted = 0;
+  m_nRestored = 0;
+  m_nExpanded = 0;
+  m_nFirstVisible = 0;
+  m_nLastVisible = -1;
+  m_nPassFirstVisible = 0;
+  m_nPassLastVisible = -1;
+}
+
+/*! \fn void CIconThumbnailBudget::m_SetSize(gint size)
+    \brief To set the thumbnail size, the placeholder is made again at it.
+
+    \param[in] size. The thumbnail size.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_SetSize(gint size)
+{
+  if( (size == m_nSize) && m_pPlaceholder )
+    return;
+
+  if(m_pPlaceholder)
+    g_object_unref(m_pPlaceholder);
+
+  /* A transparent image keeps the layout of the view, so the rows do not move when their thumbnails come back. */
+  m_nSize = size;
+  m_pPlaceholder = gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, MAX(size, 1), MAX(size, 1));
+
+  if(m_pPlaceholder)
+    gdk_pixbuf_fill(m_pPlaceholder, 0x00000000);
+
+  m_SetFixedSize();
+}
+
+/*! \fn void CIconThumbnailBudget::m_SetFixedSize(void)
+    \brief To give the pixbuf renderer the thumbnail size in the compact mode, so the view is laid out without the
+           compact rows being expanded. The thumbnails are fitted into that size, they are centered in the cell.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconThumbnailBudget::m_SetFixedSize(void)
+{
+  gint xpad = 0, ypad = 0;
+
+  if(!m_pRenderer)
+    return;
+
+  if(!m_bCompact)
+  {
+     gtk_cell_renderer_set_fixed_size(m_pRenderer, -1, -1);
+     return;
+  }
+
+  gtk_cell_renderer_get_padding(m_pRenderer, &xpad, &ypad);
+  gtk_cell_renderer_set_fixed_size(m_pRenderer, m_nSize + 2 * xpad, m_nSize + 2 * ypad);
+}
+
+/*! \fn void CIconThumbnailBudget::m_UpdateVisibleRange(void)
+    \brief To remember the rows visible in the view, none if the view is not shown yet.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconThumbnailBudget::m_UpdateVisibleRange(void)
+{
+  GtkTreePath *start = NULL, *end = NULL;
+
+  m_nFirstVisible = 0;
+  m_nLastVisible = -1;
+
+  if( !m_pIconView || !gtk_icon_view_get_visible_range(m_pIconView, &start, &end) )
+    return;
+
+  m_nFirstVisible = gtk_tree_path_get_indices(start)[0];
+  m_nLastVisible = gtk_tree_path_get_indices(end)[0];
+
+  gtk_tree_path_free(start);
+  gtk_tree_path_free(end);
+}
+
+/*! \fn void CIconThumbnailBudget::m_SetMaxBytes(gsize maxBytes)
+    \brief To set the memory the thumbnails of the rows could take. The rows are evicted at once if it is exceeded.
+
+    \param[in] maxBytes. The budget in bytes.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_SetMaxBytes(gsize maxBytes)
+{
+  m_nMaxBytes = maxBytes;
+
+  if(m_nBytes > m_nMaxBytes)
+    m_Schedule();
+}
+
+/*! \fn void CIconThumbnailBudget::m_Hold(GdkPixbuf *pixbuf)
+    \brief To count one more resident row holding a thumbnail. Identical icons share their thumbnail, it is counted once.
+*/
+void CIconThumbnailBudget::m_Hold(GdkPixbuf *pixbuf)
+{
+  guint nHolders = 0;
+
+  if(!pixbuf)
+    return;
+
+  nHolders = GPOINTER_TO_UINT(g_hash_table_lookup(m_pPixbufs, pixbuf));
+  if(nHolders == 0)
+    m_nBytes += pixbuf_bytes(pixbuf);
+
+  g_hash_table_insert(m_pPixbufs, pixbuf, GUINT_TO_POINTER(nHolders + 1));
+}
+
+/*! \fn void CIconThumbnailBudget::m_Drop(GdkPixbuf *pixbuf)
+    \brief To count one less resident row holding a thumbnail. It must be called while the row still holds it.
+*/
+void CIconThumbnailBudget::m_Drop(GdkPixbuf *pixbuf)
+{
+  guint nHolders = 0;
+
+  if(!pixbuf)
+    return;
+
+  nHolders = GPOINTER_TO_UINT(g_hash_table_lookup(m_pPixbufs, pixbuf));
+  if(nHolders > 1)
+  {
+     g_hash_table_insert(m_pPixbufs, pixbuf, GUINT_TO_POINTER(nHolders - 1));
+     return;
+  }
+
+  if(nHolders == 1)
+  {
+     g_hash_table_remove(m_pPixbufs, pixbuf);
+     m_nBytes -= MIN(m_nBytes, pixbuf_bytes(pixbuf));
+  }
+}
+
+/*! \fn void CIconThumbnailBudget::m_AddRow(GdkPixbuf *pixbuf)
+    \brief To count the row just appended to the model.
+
+    \param[in] pixbuf. The thumbnail of the row.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_AddRow(GdkPixbuf *pixbuf)
+{
+  g_hash_table_insert(m_pResident, GINT_TO_POINTER(m_nRows), pixbuf);
+  m_nRows++;
+  m_Hold(pixbuf);
+
+  if(m_nBytes > m_nMaxBytes)
+    m_Schedule();
+}
+
+/*! \fn void CIconThumbnailBudget::m_SetRow(gint nRow, GdkPixbuf *pixbuf)
+    \brief To count the thumbnail put into a row after it was appended. It must be called before the row holds it.
+
+    \param[in] nRow. The position of the row.
+    \param[in] pixbuf. The new thumbnail of the row.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_SetRow(gint nRow, GdkPixbuf *pixbuf)
+{
+  gpointer value = NULL;
+
+  if( (nRow < 0) || ((guint)nRow >= m_nRows) )
+    return;
+
+  m_RemoveCompact(nRow);
+
+  if( g_hash_table_lookup_extended(m_pResident, GINT_TO_POINTER(nRow), NULL, &value) )
+    m_Drop((GdkPixbuf*)value);
+
+  g_hash_table_insert(m_pResident, GINT_TO_POINTER(nRow), pixbuf);
+  m_Hold(pixbuf);
+
+  if(m_nBytes > m_nMaxBytes)
+    m_Schedule();
+}
+
+/*! \fn void CIconThumbnailBudget::m_Reorder(const gint *newOrder, guint nRows)
+    \brief To follow the rows to their new positions after the model was reordered.
+
+    \param[in] newOrder. newOrder[newPosition] is the old position of a row, as gtk_list_store_reorder() takes it.
+    \param[in] nRows. The number of rows.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_Reorder(const gint *newOrder, guint nRows)
+{
+  GHashTable *pResident = NULL, *pCompacts = NULL, *pRestoring = NULL;
+  gpointer value = NULL;
+
+  if(nRows != m_nRows)
+    return;
+
+  pResident = g_hash_table_new(g_direct_hash, g_direct_equal);
+  pCompacts = g_hash_table_new(g_direct_hash, g_direct_equal);
+  pRestoring = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  for(guint i=0; i<nRows; i++)
+  {
+     if( g_hash_table_lookup_extended(m_pResident, GINT_TO_POINTER(newOrder[i]), NULL, &value) )
+       g_hash_table_insert(pResident, GINT_TO_POINTER(i), value);
+
+     if( (value = g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(newOrder[i]))) != NULL )
+       g_hash_table_insert(pCompacts, GINT_TO_POINTER(i), value);
+
+     /* The thumbnails being restored follow their rows, they are put at the new positions when they come back. */
+     if( (value = g_hash_table_lookup(m_pRestoring, GINT_TO_POINTER(newOrder[i]))) != NULL )
+     {
+        ((ICON_BUDGET_RESTORE*)value)->nRow = (gint)i;
+        g_hash_table_insert(pRestoring, GINT_TO_POINTER(i), value);
+     }
+  }
+
+  g_hash_table_destroy(m_pResident);
+  m_pResident = pResident;
+
+  g_hash_table_destroy(m_pRestoring);
+  m_pRestoring = pRestoring;
+
+  g_hash_table_destroy(m_pCompacts);
+  m_pCompacts = pCompacts;
+
+  /* Other rows are shown now. */
+  m_Schedule();
+}
+
+/*! \fn gboolean CIconThumbnailBudget::m_Evict(GtkTreeModel *model, gint nRow)
+    \brief To replace the thumbnail of a row by the placeholder.
+
+    \param[in] model. The model of the icon view.
+    \param[in] nRow. The position of the row.
+    \return TRUE if a thumbnail was released.
+*/
+gboolean CIconThumbnailBudget::m_Evict(GtkTreeModel *model, gint nRow)
+{
+  GtkTreeIter iter;
+  gpointer value = NULL;
+
+  /* A compact row shows the placeholder already, only its thumbnail is dropped. */
+  if( g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(nRow)) )
+  {
+     m_RemoveCompact(nRow);
+     m_nEvicted++;
+     return true;
+  }
+
+  if( !g_hash_table_lookup_extended(m_pResident, GINT_TO_POINTER(nRow), NULL, &value) )
+    return false;
+
+  g_hash_table_remove(m_pResident, GINT_TO_POINTER(nRow));
+
+  /* Counted while the row still holds the thumbnail, the row may hold the last reference. */
+  m_Drop((GdkPixbuf*)value);
+
+  if( !value || !gtk_tree_model_iter_nth_child(model, &iter, NULL, nRow) )
+    return false;
+
+  gtk_list_store_set(GTK_LIST_STORE(model), &iter, m_nIconColumn, m_pPlaceholder, -1);
+  m_nEvicted++;
+
+  return true;
+}
+
+/*! \fn gboolean CIconThumbnailBudget::m_Restore(GtkTreeModel *model, GtkTreeIter *pIter, gint nRow)
+    \brief To give an evicted row its thumbnail again. A thumbnail in the content cache is put at once, otherwise the
+           file is decoded off the main loop and m_FinishRestore() puts it when it comes back.
+
+    \param[in] model. The model of the icon view.
+    \param[in] pIter. The row.
+    \param[in] nRow. The position of the row.
+    \return TRUE if the thumbnail was restored or is being decoded. A row which could not be restored keeps the placeholder.
+*/
+gboolean CIconThumbnailBudget::m_Restore(GtkTreeModel *model, GtkTreeIter *pIter, gint nRow)
+{
+  ICON_BUDGET_RESTORE *restore = NULL;
+  GdkPixbuf *pixbuf = NULL;
+  gchar *fullName = NULL;
+  guint64 contentHash = 0;
+
+  gtk_tree_model_get(model, pIter, m_nPathColumn, &fullName, m_nHashColumn, &contentHash, -1);
+
+  if(contentHash)
+    pixbuf = m_pCatalog->m_LookupThumbnail(contentHash, m_nSize);
+
+  if(pixbuf)
+  {
+     g_free(fullName);
+
+     g_hash_table_insert(m_pResident, GINT_TO_POINTER(nRow), pixbuf);
+     m_Hold(pixbuf);
+     gtk_list_store_set(GTK_LIST_STORE(model), pIter, m_nIconColumn, pixbuf, -1);
+     g_object_unref(pixbuf);
+     m_nRestored++;
+
+     return true;
+  }
+
+  /* A file which failed before is not decoded again until it changes, a stat() tells. Not tried again until it is
+     evicted, so a file gone does not cost a restore every time the view is exposed. */
+  if( !fullName || m_pCatalog->m_IsKnownBadFile(fullName) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     printf("%s(%d) - The thumbnail of %s could not be restored \n", __FUNCTION__, __LINE__, fullName);
+     #endif
+
+     g_free(fullName);
+     g_hash_table_insert(m_pResident, GINT_TO_POINTER(nRow), NULL);
+     return false;
+  }
+
+  restore = g_new0(ICON_BUDGET_RESTORE, 1);
+  restore->pBudget = this;
+  restore->fullName = fullName;
+  restore->contentHash = contentHash;
+  restore->nSize = m_nSize;
+  restore->nRow = nRow;
+  restore->nGeneration = m_nGeneration;
+  restore->nStatus = ICON_DECODER_Failed;
+
+  /* The sandboxed workers decode in parallel and reply on the main loop, an archive member is left to the threads. */
+  if( !CIconArchive::m_IsMemberName(fullName) && ((restore->pPool = m_pCatalog->m_GetDecoderPool()) != NULL) )
+  {
+     ICON_FILE_BUFFER buffer;
+
+     memset(&buffer, 0x00, sizeof(buffer));
+     buffer.fullName = fullName;
+     CIconFileReader::m_StatOne(&buffer);
+
+     restore->fileSize = buffer.fileSize;
+     restore->mtime = buffer.mtime;
+
+     if(!restore->contentHash)
+       restore->contentHash = m_pCatalog->m_LookupContentHash(&buffer);
+
+     restore->pJob = restore->pPool->m_DecodeAsync(fullName, NULL, 0, m_nSize, cb_restore_done, restore);
+
+     if(!restore->pJob)
+     {
+        restore->pPool->m_Unref();
+        restore->pPool = NULL;
+     }
+  }
+
+  if(!restore->pJob)
+    g_thread_pool_push(m_pRestorePool, restore, NULL);
+
+  g_hash_table_insert(m_pRestoring, GINT_TO_POINTER(nRow), restore);
+
+  return true;
+}
+
+/*! \fn void CIconThumbnailBudget::cb_restore_thread(gpointer data, gpointer thisObject)
+    \brief The thread function decoding a thumbnail again through the catalog, which stats the file first and reads
+           it only if its thumbnail is not cached.
+
+    \param[in] data. The ICON_BUDGET_RESTORE, it is passed back to the main thread through m_pRestored.
+    \param[in] thisObject. The instance of class CIconThumbnailBudget.
+    \return NONE
+*/
+void CIconThumbnailBudget::cb_restore_thread(gpointer data, gpointer thisObject)
+{
+  CIconThumbnailBudget *budget = (CIconThumbnailBudget*)thisObject;
+  ICON_BUDGET_RESTORE *restore = (ICON_BUDGET_RESTORE*)data;
+
+  /* A cancelled restore is not decoded. */
+  if( g_atomic_int_get(&budget->m_nGeneration) == restore->nGeneration )
+    restore->pixbuf = budget->m_pCatalog->m_Thumbnail(restore->fullName, restore->nSize, NULL);
+
+  g_async_queue_push(budget->m_pRestored, restore);
+  g_idle_add(cb_restored, budget);
+}
+
+/*! \fn gboolean CIconThumbnailBudget::cb_restored(gpointer data)
+    \brief The idle callback function taking the thumbnails the restoring threads decoded.
+*/
+gboolean CIconThumbnailBudget::cb_restored(gpointer data)
+{
+  CIconThumbnailBudget *thisObject = (CIconThumbnailBudget*)data;
+
+  thisObject->m_TakeRestored();
+
+  return false;
+}
+
+/*! \fn void CIconThumbnailBudget::cb_restore_done(GdkPixbuf *pixbuf, gint nStatus, gpointer data)
+    \brief The callback function of the sandboxed workers, called on the main loop when a thumbnail comes back.
+
+    \param[in] pixbuf. The thumbnail, NULL if it could not be decoded. The restore takes it.
+    \param[in] nStatus. The ICON_DECODER_STATUS.
+    \param[in] data. The ICON_BUDGET_RESTORE.
+    \return NONE
+*/
+void CIconThumbnailBudget::cb_restore_done(GdkPixbuf *pixbuf, gint nStatus, gpointer data)
+{
+  ICON_BUDGET_RESTORE *restore = (ICON_BUDGET_RESTORE*)data;
+
+  restore->pJob = NULL;
+  restore->pixbuf = pixbuf;
+  restore->nStatus = nStatus;
+
+  restore->pBudget->m_FinishRestore(restore);
+}
+
+/*! \fn void CIconThumbnailBudget::m_TakeRestored(void)
+    \brief To put the thumbnails the restoring threads decoded into their rows.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconThumbnailBudget::m_TakeRestored(void)
+{
+  ICON_BUDGET_RESTORE *restore = NULL;
+
+  while( (restore = (ICON_BUDGET_RESTORE*)g_async_queue_try_pop(m_pRestored)) != NULL )
+    m_FinishRestore(restore);
+}
+
+/*! \fn void CIconThumbnailBudget::m_FinishRestore(ICON_BUDGET_RESTORE *restore)
+    \brief To put a thumbnail decoded again into its row, if the row still shows the placeholder of the same file.
+
+    \param[in] restore. The restore, it is freed or passed on to the restoring threads.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_FinishRestore(ICON_BUDGET_RESTORE *restore)
+{
+  GtkTreeModel *model = m_pIconView ? gtk_icon_view_get_model(m_pIconView) : NULL;
+  GdkPixbuf *shown = NULL;
+  gchar *fullName = NULL;
+  GtkTreeIter iter;
+
+  /* Queued before the model was replaced. */
+  if( (restore->nGeneration != m_nGeneration) ||
+      (g_hash_table_lookup(m_pRestoring, GINT_TO_POINTER(restore->nRow)) != restore) )
+  {
+     m_FreeRestore(restore);
+     return;
+  }
+
+  /* No worker could be started, the file is decoded by a restoring thread as without the sandbox. */
+  if( restore->pPool && (restore->nStatus == ICON_DECODER_Unavailable) )
+  {
+     restore->pPool->m_Unref();
+     restore->pPool = NULL;
+     g_thread_pool_push(m_pRestorePool, restore, NULL);
+     return;
+  }
+
+  g_hash_table_remove(m_pRestoring, GINT_TO_POINTER(restore->nRow));
+
+  /* The catalog keeps what its own decoding made, the replies of the workers are kept here. Only a file which could
+     not be decoded is remembered, not one a worker timed out or crashed on. */
+  if( restore->pPool && restore->pixbuf )
+    m_pCatalog->m_InsertThumbnail(restore->contentHash, restore->nSize, restore->pixbuf);
+  else if( restore->pPool && (restore->nStatus == ICON_DECODER_Failed) )
+    m_pCatalog->m_AddBadFile(restore->fullName, restore->mtime, restore->fileSize);
+
+  if( model && gtk_tree_model_iter_nth_child(model, &iter, NULL, restore->nRow) )
+    gtk_tree_model_get(model, &iter, m_nIconColumn, &shown, m_nPathColumn, &fullName, -1);
+
+  /* The row could have got its thumbnail meanwhile, e.g. filled by the loading. */
+  if( shown && (shown == m_pPlaceholder) && fullName && (strcmp(fullName, restore->fullName) == 0) &&
+      !g_hash_table_contains(m_pResident, GINT_TO_POINTER(restore->nRow)) &&
+      !g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(restore->nRow)) )
+  {
+     #ifdef DEBUG_MENU_ICONCHOOSER
+     if(!restore->pixbuf)
+       printf("%s(%d) - The thumbnail of %s could not be restored \n", __FUNCTION__, __LINE__, restore->fullName);
+     #endif
+
+     /* Not tried again until it is evicted, so a file gone does not cost a restore every time the view is exposed. */
+     g_hash_table_insert(m_pResident, GINT_TO_POINTER(restore->nRow), restore->pixbuf);
+
+     if(restore->pixbuf)
+     {
+        m_Hold(restore->pixbuf);
+        gtk_list_store_set(GTK_LIST_STORE(model), &iter, m_nIconColumn, restore->pixbuf, -1);
+        m_nRestored++;
+     }
+  }
+
+  if(shown)
+    g_object_unref(shown);
+
+  g_free(fullName);
+  m_FreeRestore(restore);
+
+  /* The budget could be exceeded now, and the rows left by the last pass are restored. */
+  m_Schedule();
+}
+
+/*! \fn void CIconThumbnailBudget::m_CancelRestores(void)
+    \brief To drop the restores in progress. The jobs of the sandboxed workers are cancelled, the restores of the
+           threads are freed when they come back.
+
+    \param[in] NONE
+    \return NONE
+*/
+void CIconThumbnailBudget::m_CancelRestores(void)
+{
+  ICON_BUDGET_RESTORE *restore = NULL;
+  GHashTableIter hashIter;
+  gpointer value = NULL;
+
+  g_atomic_int_inc(&m_nGeneration);
+
+  g_hash_table_iter_init(&hashIter, m_pRestoring);
+  while( g_hash_table_iter_next(&hashIter, NULL, &value) )
+  {
+     restore = (ICON_BUDGET_RESTORE*)value;
+
+     if(restore->pJob)
+     {
+        restore->pPool->m_Cancel(restore->pJob);
+        restore->pJob = NULL;
+        m_FreeRestore(restore);
+     }
+  }
+
+  g_hash_table_remove_all(m_pRestoring);
+
+  while( (restore = (ICON_BUDGET_RESTORE*)g_async_queue_try_pop(m_pRestored)) != NULL )
+    m_FreeRestore(restore);
+}
+
+/*! \fn void CIconThumbnailBudget::m_FreeRestore(ICON_BUDGET_RESTORE *restore)
+    \brief To free an ICON_BUDGET_RESTORE, its job must be done or cancelled.
+*/
+void CIconThumbnailBudget::m_FreeRestore(ICON_BUDGET_RESTORE *restore)
+{
+  if(restore->pixbuf)
+    g_object_unref(restore->pixbuf);
+
+  if(restore->pPool)
+    restore->pPool->m_Unref();
+
+  g_free(restore->fullName);
+  g_free(restore);
+}
+
+/*! \fn gboolean CIconThumbnailBudget::m_CompactRows(GtkTreeModel *model, gint *window)
+    \brief To turn the thumbnails of the resident rows into compact ones, the farthest from the kept window first, until
+           the memory is down to the low water mark. The rows show the placeholder in the model.
+    \n The rows of identical icons share one compact thumbnail, it is made once. A visible row is left as it is, it
+    would be expanded again at every expose. A row showing another image than its thumbnail, e.g. an animation frame,
+    is left until it shows it again.
+
+    \param[in] model. The model of the icon view.
+    \param[in] window. The kept window { first, last }.
+    \return TRUE if there are rows left to compact in another pass.
+*/
+gboolean CIconThumbnailBudget::m_CompactRows(GtkTreeModel *model, gint *window)
+{
+  GArray *rows = g_array_new(false, false, sizeof(gint));
+  GHashTableIter hashIter;
+  gpointer key = NULL, value = NULL;
+  gsize nLowWater = m_nMaxBytes / 100 * ICON_BUDGET_LOW_WATER_PERCENT;
+  guint nCompacted = 0, i = 0;
+  gboolean bMore = false;
+
+  g_hash_table_iter_init(&hashIter, m_pResident);
+  while( g_hash_table_iter_next(&hashIter, &key, &value) )
+  {
+     gint nRow = GPOINTER_TO_INT(key);
+
+     if( value && !m_IsVisible(nRow) )
+       g_array_append_val(rows, nRow);
+  }
+
+  g_array_sort_with_data(rows, compare_distance, window);
+
+  for(i=0; (i < rows->len) && (m_nBytes > nLowWater) && (nCompacted < ICON_BUDGET_COMPACTS_PER_PASS); i++)
+  {
+     gint nRow = g_array_index(rows, gint, i);
+     GdkPixbuf *thumbnail = (GdkPixbuf*)g_hash_table_lookup(m_pResident, GINT_TO_POINTER(nRow));
+     GdkPixbuf *shown = NULL;
+     ICON_BUDGET_COMPACT *entry = NULL;
+     guint64 contentHash = 0;
+     GtkTreeIter iter;
+
+     if( !gtk_tree_model_iter_nth_child(model, &iter, NULL, nRow) )
+       continue;
+
+     gtk_tree_model_get(model, &iter, m_nIconColumn, &shown, m_nHashColumn, &contentHash, -1);
+
+     if(shown)
+       g_object_unref(shown);
+
+     if(shown != thumbnail)
+       continue;
+
+     if(contentHash)
+       entry = (ICON_BUDGET_COMPACT*)g_hash_table_lookup(m_pSharedCompacts, &contentHash);
+
+     if(!entry)
+     {
+        CIconCompactThumbnail *compact = new CIconCompactThumbnail();
+
+        if( !compact->m_Compact(thumbnail) )
+        {
+           delete compact;
+           continue;
+        }
+
+        entry = g_new0(ICON_BUDGET_COMPACT, 1);
+        entry->compact = compact;
+        entry->contentHash = contentHash;
+
+        if(contentHash)
+          g_hash_table_insert(m_pSharedCompacts, &entry->contentHash, entry);
+
+        m_nCompactBytes += compact->m_GetBytes();
+        m_nBytes += compact->m_GetBytes();
+     }
+
+     entry->nRows++;
+
+     /* Counted while the row still holds the thumbnail, the row may hold the last reference. */
+     m_Drop(thumbnail);
+     g_hash_table_remove(m_pResident, GINT_TO_POINTER(nRow));
+     g_hash_table_insert(m_pCompacts, GINT_TO_POINTER(nRow), entry);
+
+     gtk_list_store_set(GTK_LIST_STORE(model), &iter, m_nIconColumn, m_pPlaceholder, -1);
+     nCompacted++;
+  }
+
+  bMore = (i < rows->len) && (m_nBytes > nLowWater);
+  g_array_free(rows, TRUE);
+
+  /* The thumbnails are still held by the content cache, only the tail of its idle list is dropped. */
+  if(nCompacted)
+    m_pCatalog->m_PruneThumbnails();
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if(nCompacted)
+    printf("%s(%d) - %u thumbnails compacted, %u compact rows sharing %u thumbnails of %lu bytes \n", __FUNCTION__, __LINE__,
+           nCompacted, g_hash_table_size(m_pCompacts), g_hash_table_size(m_pSharedCompacts), (gulong)m_nCompactBytes);
+  #endif
+
+  return bMore;
+}
+
+/*! \fn gboolean CIconThumbnailBudget::m_ExpandRow(GtkTreeModel *model, GtkTreeIter *pIter, gint nRow)
+    \brief To turn the compact thumbnail of a row back into a resident one, the row shows it in the model.
+    \n The rows of identical icons share the thumbnail: it is taken from the content cache if it is still there,
+    otherwise it is expanded once and put into the cache for the others.
+
+    \param[in] model. The model of the icon view.
+    \param[in] pIter. The row.
+    \param[in] nRow. The position of the row, it must have a compact thumbnail.
+    \return TRUE if the row shows its thumbnail, otherwise it stays compact.
+*/
+gboolean CIconThumbnailBudget::m_ExpandRow(GtkTreeModel *model, GtkTreeIter *pIter, gint nRow)
+{
+  ICON_BUDGET_COMPACT *entry = (ICON_BUDGET_COMPACT*)g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(nRow));
+  GdkPixbuf *pixbuf = NULL;
+
+  if(!entry)
+    return false;
+
+  if(entry->contentHash)
+    pixbuf = m_pCatalog->m_LookupThumbnail(entry->contentHash, m_nSize);
+
+  if(!pixbuf)
+  {
+     pixbuf = entry->compact->m_NewPixbuf();
+
+     if( !pixbuf || !entry->compact->m_Expand(pixbuf) )
+     {
+        if(pixbuf)
+          g_object_unref(pixbuf);
+
+        return false;
+     }
+
+     m_pCatalog->m_InsertThumbnail(entry->contentHash, m_nSize, pixbuf);
+     m_nExpanded++;
+  }
+
+  m_RemoveCompact(nRow);
+
+  g_hash_table_insert(m_pResident, GINT_TO_POINTER(nRow), pixbuf);
+  m_Hold(pixbuf);
+  gtk_list_store_set(GTK_LIST_STORE(model), pIter, m_nIconColumn, pixbuf, -1);
+  g_object_unref(pixbuf);
+
+  return true;
+}
+
+/*! \fn void CIconThumbnailBudget::m_RemoveCompact(gint nRow)
+    \brief To drop the compact thumbnail of a row, if it has one. The row is not touched.
+*/
+void CIconThumbnailBudget::m_RemoveCompact(gint nRow)
+{
+  ICON_BUDGET_COMPACT *entry = (ICON_BUDGET_COMPACT*)g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(nRow));
+
+  if(!entry)
+    return;
+
+  g_hash_table_remove(m_pCompacts, GINT_TO_POINTER(nRow));
+  m_ReleaseCompact(entry);
+}
+
+/*! \fn void CIconThumbnailBudget::m_ReleaseCompact(ICON_BUDGET_COMPACT *entry)
+    \brief To count one less row keeping a compact thumbnail, it is deleted with the last one.
+*/
+void CIconThumbnailBudget::m_ReleaseCompact(ICON_BUDGET_COMPACT *entry)
+{
+  if( entry->nRows > 1 )
+  {
+     entry->nRows--;
+     return;
+  }
+
+  /* Another thumbnail could be allocated at the same address, the pool must not take it as drawn already. */
+  for(gint i=0; i<ICON_BUDGET_POOL_SIZE; i++)
+  {
+     if(m_Pool[i].compact == entry->compact)
+       m_Pool[i].compact = NULL;
+  }
+
+  if(entry->contentHash)
+    g_hash_table_remove(m_pSharedCompacts, &entry->contentHash);
+
+  m_nCompactBytes -= MIN(m_nCompactBytes, entry->compact->m_GetBytes());
+  m_nBytes -= MIN(m_nBytes, entry->compact->m_GetBytes());
+
+  delete entry->compact;
+  g_free(entry);
+}
+
+/*! \fn void CIconThumbnailBudget::m_ClearPool(void)
+    \brief To forget the thumbnails the pool holds. The pixbufs are kept to be reused.
+*/
+void CIconThumbnailBudget::m_ClearPool(void)
+{
+  for(gint i=0; i<ICON_BUDGET_POOL_SIZE; i++)
+  {
+     m_Pool[i].compact = NULL;
+     m_Pool[i].nStamp = 0;
+  }
+
+  m_nPoolStamp = 0;
+}
+
+/*! \fn GdkPixbuf* CIconThumbnailBudget::m_ExpandCompact(CIconCompactThumbnail *compact)
+    \brief To get the pixbuf of a compact thumbnail from the pool, expanded into the least recently drawn one if it
+            is not there.
+
+    \param[in] compact. The compact thumbnail.
+    \return The pixbuf, owned by the pool. It is valid until ICON_BUDGET_POOL_SIZE other thumbnails are drawn.
+*/
+GdkPixbuf* CIconThumbnailBudget::m_ExpandCompact(CIconCompactThumbnail *compact)
+{
+  ICON_BUDGET_POOL_ENTRY *pEntry = &m_Pool[0];
+
+  m_nPoolStamp++;
+
+  for(gint i=0; i<ICON_BUDGET_POOL_SIZE; i++)
+  {
+     if(m_Pool[i].compact == compact)
+     {
+        m_Pool[i].nStamp = m_nPoolStamp;
+        return m_Pool[i].pixbuf;
+     }
+
+     if(m_Pool[i].nStamp < pEntry->nStamp)
+       pEntry = &m_Pool[i];
+  }
+
+  /* Most thumbnails are square at the thumbnail size, so the pixbuf is mostly reused as it is. */
+  if( !compact->m_Fits(pEntry->pixbuf) )
+  {
+     if(pEntry->pixbuf)
+       g_object_unref(pEntry->pixbuf);
+
+     pEntry->pixbuf = compact->m_NewPixbuf();
+  }
+
+  pEntry->compact = NULL;
+  pEntry->nStamp = m_nPoolStamp;
+
+  if( !pEntry->pixbuf || !compact->m_Expand(pEntry->pixbuf) )
+    return NULL;
+
+  pEntry->compact = compact;
+  m_nExpanded++;
+
+  return pEntry->pixbuf;
+}
+
+/*! \fn void CIconThumbnailBudget::m_SetCompact(gboolean bCompact)
+    \brief To keep the thumbnails of the rows compact, expanded when they are drawn.
+    \n Turned off, the compact rows are evicted, the visible ones are decoded again by the next pass.
+
+    \param[in] bCompact. TRUE for the compact mode.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_SetCompact(gboolean bCompact)
+{
+  GHashTableIter hashIter;
+  gpointer key = NULL;
+  GArray *rows = NULL;
+
+  if( (bCompact ? true : false) == m_bCompact )
+    return;
+
+  m_bCompact = bCompact ? true : false;
+
+  if(!m_bCompact)
+  {
+     rows = g_array_new(false, false, sizeof(gint));
+
+     g_hash_table_iter_init(&hashIter, m_pCompacts);
+     while( g_hash_table_iter_next(&hashIter, &key, NULL) )
+     {
+        gint nRow = GPOINTER_TO_INT(key);
+        g_array_append_val(rows, nRow);
+     }
+
+     for(guint i=0; i<rows->len; i++)
+       m_RemoveCompact(g_array_index(rows, gint, i));
+
+     m_nEvicted += rows->len;
+     g_array_free(rows, TRUE);
+  }
+
+  m_SetFixedSize();
+  m_Schedule();
+}
+
+/*! \fn gboolean CIconThumbnailBudget::m_Pass(void)
+    \brief To restore the rows around the visible ones, then to evict the farthest rows while the budget is exceeded.
+
+    \param[in] NONE
+    \return TRUE if there are rows left to restore in another pass.
+*/
+gboolean CIconThumbnailBudget::m_Pass(void)
+{
+  GtkTreeModel *model = m_pIconView ? gtk_icon_view_get_model(m_pIconView) : NULL;
+  GtkTreeIter iter;
+  gint window[2] = { 0, -1 };
+  guint nRestores = 0, nEvicted = 0;
+  gboolean bMore = false;
+
+  /* The rows are known by position, they must be the rows counted. */
+  if( !model || !GTK_IS_LIST_STORE(model) || (gtk_tree_model_iter_n_children(model, NULL) != (gint)m_nRows) )
+    return false;
+
+  /* Without a visible range, e.g. before the view is shown, the first rows are kept as they are shown first. */
+  m_UpdateVisibleRange();
+  m_nPassFirstVisible = m_nFirstVisible;
+  m_nPassLastVisible = m_nLastVisible;
+
+  if(m_nFirstVisible <= m_nLastVisible)
+  {
+     window[0] = m_nFirstVisible;
+     window[1] = m_nLastVisible;
+  }
+
+  window[0] = MAX(window[0] - ICON_BUDGET_MARGIN_ROWS, 0);
+  window[1] = MIN(window[1] + ICON_BUDGET_MARGIN_ROWS, (gint)m_nRows - 1);
+
+  /* The rows showing the placeholder are read from the model, an animation could have put it back as its static image. */
+  if( (window[0] <= window[1]) && gtk_tree_model_iter_nth_child(model, &iter, NULL, window[0]) )
+  {
+     for(gint nRow=window[0]; nRow<=window[1]; nRow++)
+     {
+        GdkPixbuf *pixbuf = NULL;
+
+        gtk_tree_model_get(model, &iter, m_nIconColumn, &pixbuf, -1);
+
+        /* A visible compact row shows its thumbnail in the model again, it is not expanded at every expose. */
+        if( (pixbuf == m_pPlaceholder) && m_IsVisible(nRow) && g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(nRow)) )
+          m_ExpandRow(model, &iter, nRow);
+        else if( (pixbuf == m_pPlaceholder) && !g_hash_table_lookup(m_pCompacts, GINT_TO_POINTER(nRow)) )
+        {
+           gpointer value = NULL;
+           gboolean bResident = g_hash_table_lookup_extended(m_pResident, GINT_TO_POINTER(nRow), NULL, &value);
+
+           /* A resident row without a thumbnail could not be restored, it is not tried again. A row being restored
+              is left to its restore. */
+           if( (!bResident || value) && !g_hash_table_contains(m_pRestoring, GINT_TO_POINTER(nRow)) )
+           {
+              if(nRestores >= ICON_BUDGET_RESTORES_PER_PASS)
+              {
+                 g_object_unref(pixbuf);
+                 bMore = true;
+                 break;
+              }
+
+              /* The restores coming back schedule the next pass. */
+              if(g_hash_table_size(m_pRestoring) >= ICON_BUDGET_RESTORES_PER_PASS)
+              {
+                 g_object_unref(pixbuf);
+                 break;
+              }
+
+              if(bResident)
+              {
+                 m_Drop((GdkPixbuf*)value);
+                 g_hash_table_remove(m_pResident, GINT_TO_POINTER(nRow));
+              }
+
+              m_Restore(model, &iter, nRow);
+              nRestores++;
+           }
+        }
+
+        if(pixbuf)
+          g_object_unref(pixbuf);
+
+        if( !gtk_tree_model_iter_next(model, &iter) )
+          break;
+     }
+  }
+
+  /* Over the budget, the thumbnails out of sight are compacted first, the rows are evicted only if that is not enough. */
+  if( m_bCompact && (m_nBytes > m_nMaxBytes) && m_CompactRows(model, window) )
+    bMore = true;
+
+  /* The resident rows outside the window are evicted, the farthest first, down to the low water mark. */
+  if(m_nBytes > m_nMaxBytes)
+  {
+     GArray *victims = g_array_new(false, false, sizeof(gint));
+     GHashTableIter hashIter;
+     gpointer key = NULL;
+     gsize nLowWater = m_nMaxBytes / 100 * ICON_BUDGET_LOW_WATER_PERCENT;
+
+     g_hash_table_iter_init(&hashIter, m_pResident);
+     while( g_hash_table_iter_next(&hashIter, &key, NULL) )
+     {
+        gint nRow = GPOINTER_TO_INT(key);
+
+        if( (nRow < window[0]) || (nRow > window[1]) )
+          g_array_append_val(victims, nRow);
+     }
+
+     g_hash_table_iter_init(&hashIter, m_pCompacts);
+     while( g_hash_table_iter_next(&hashIter, &key, NULL) )
+     {
+        gint nRow = GPOINTER_TO_INT(key);
+
+        if( (nRow < window[0]) || (nRow > window[1]) )
+          g_array_append_val(victims, nRow);
+     }
+
+     g_array_sort_with_data(victims, compare_distance, window);
+
+     for(guint i=0; (i < victims->len) && (m_nBytes > nLowWater); i++)
+     {
+        if( m_Evict(model, g_array_index(victims, gint, i)) )
+          nEvicted++;
+     }
+
+     g_array_free(victims, TRUE);
+
+     /* The thumbnails no other row or view holds go to the idle list of the cache, only its least recently used tail
+        is dropped. A row scrolled back soon gets its thumbnail from it without decoding the file again. */
+     if(nEvicted)
+       m_pCatalog->m_PruneThumbnails();
+  }
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if(nRestores || nEvicted)
+    printf("%s(%d) - Rows %d..%d kept, %u restored, %u evicted, %u thumbnails and %u compact of %lu bytes \n", __FUNCTION__, __LINE__,
+           window[0], window[1], nRestores, nEvicted, g_hash_table_size(m_pPixbufs), g_hash_table_size(m_pCompacts), (gulong)m_nBytes);
+  #endif
+
+  return bMore;
+}
+
+/*! \fn void CIconThumbnailBudget::m_Schedule(void)
+    \brief To run a pass on the main loop if none is scheduled.
+*/
+void CIconThumbnailBudget::m_Schedule(void)
+{
+  if( !m_pIconView || m_nIdle )
+    return;
+
+  m_nIdle = g_idle_add(cb_idle, this);
+}
+
+/*! \fn void CIconThumbnailBudget::m_GetStats(ICON_BUDGET_STATS *pStats)
+    \brief To get the memory taken by the thumbnails of the rows and the pixbufs held.
+
+    \param[out] pStats. The statistics.
+    \return NONE
+*/
+void CIconThumbnailBudget::m_GetStats(ICON_BUDGET_STATS *pStats)
+{
+  if(!pStats)
+    return;
+
+  memset(pStats, 0x00, sizeof(ICON_BUDGET_STATS));
+  pStats->nRows = m_nRows;
+  pStats->nResidentRows = g_hash_table_size(m_pResident) + g_hash_table_size(m_pCompacts);
+  pStats->nPixbufs = g_hash_table_size(m_pPixbufs);
+  pStats->nBytes = m_nBytes;
+  pStats->nMaxBytes = m_nMaxBytes;
+  pStats->nEvicted = m_nEvicted;
+  pStats->nRestored = m_nRestored;
+  pStats->nCachedThumbnails = m_pCatalog->m_GetThumbnailCount();
+  pStats->nCompactRows = g_hash_table_size(m_pCompacts);
+  pStats->nCompactBytes = m_nCompactBytes;
+  pStats->nExpanded = m_nExpanded;
+}
+
+/*! \fn gboolean CIconThumbnailBudget::cb_idle(gpointer data)
+    \brief The idle callback function running a pass, again while there are rows left to restore.
+*/
+gboolean CIconThumbnailBudget::cb_idle(gpointer data)
+{
+  CIconThumbnailBudget *thisObject = (CIconThumbnailBudget*)data;
+
+  if( thisObject->m_Pass() )
+    return true;
+
+  thisObject->m_nIdle = 0;
+  return false;
+}
+
+/*! \fn gboolean CIconThumbnailBudget::cb_expose(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    \brief The callback function to restore the rows shown, e.g. after scrolling.
+*/
+gboolean CIconThumbnailBudget::cb_expose(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+{
+  CIconThumbnailBudget *thisObject = (CIconThumbnailBudget*)data;
+
+  /* Nothing could be restored before a row was evicted. The compact rows scrolled into view are expanded by the pass. */
+  if( thisObject->m_nEvicted || (thisObject->m_nBytes > thisObject->m_nMaxBytes) ||
+      (thisObject->m_bCompact && (g_hash_table_size(thisObject->m_pCompacts) > 0) &&
+       ((thisObject->m_nFirstVisible != thisObject->m_nPassFirstVisible) ||
+        (thisObject->m_nLastVisible != thisObject->m_nPassLastVisible))) )
+    thisObject->m_Schedule();
+
+  return false;
+}
+
+/*! \fn gboolean CIconThumbnailBudget::cb_expose_start(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    \brief The callback function to take the visible rows before the view draws them, in the compact mode. The compact
+           rows among them are expanded, the others are compacted by the next pass.
+*/
+gboolean CIconThumbnailBudget::cb_expose_start(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+{
+  CIconThumbnailBudget *thisObject = (CIconThumbnailBudget*)data;
+
+  if(thisObject->m_bCompact)
+    thisObject->m_UpdateVisibleRange();
+
+  return false;
+}
+
+/*! \fn void CIconThumbnailBudget::cb_destroy(GtkWidget *widget, gpointer data)
+    \brief The callback function to detach from an icon view being destroyed.
+*/
+void CIconThumbnailBudget::cb_destroy(GtkWidget *widget, gpointer data)
+{
+  CIconThumbnailBudget *thisObject = (CIconThumbnailBudget*)data;
+
+  thisObject->m_Reset();
+  thisObject->m_pIconView = NULL;
+  thisObject->m_pRenderer = NULL;
+}
+
+/*! \fn void CIconThumbnailBudget::cb_cell_data(GtkCellLayout *layout, GtkCellRenderer *renderer, GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+    \brief The cell data function of the pixbuf renderer, drawing a visible compact row by its thumbnail expanded from
+           the pool. The other rows, e.g. all of them when the view is laid out, keep the placeholder of the same size.
+*/
+void CIconThumbnailBudget::cb_cell_data(GtkCellLayout *layout, GtkCellRenderer *renderer, GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+  CIconThumbnailBudget *thisObject = (CIconThumbnailBudget*)data;
+  ICON_BUDGET_COMPACT *entry = NULL;
+  CIconCompactThumbnail *compact = NULL;
+  GdkPixbuf *pixbuf = NULL;
+  GtkTreePath *path = NULL;
+  gint nRow = -1;
+
+  if( (g_hash_table_size(thisObject->m_pCompacts) == 0) || (thisObject->m_nFirstVisible > thisObject->m_nLastVisible) )
+    return;
+
+  gtk_tree_model_get(model, iter, thisObject->m_nIconColumn, &pixbuf, -1);
+
+  if(pixbuf)
+    g_object_unref(pixbuf);
+
+  /* The rows showing anything else, e.g. an animation frame, are drawn as they are. */
+  if(pixbuf != thisObject->m_pPlaceholder)
+    return;
+
+  path = gtk_tree_model_get_path(model, iter);
+  nRow = gtk_tree_path_get_indices(path)[0];
+  gtk_tree_path_free(path);
+
+  if( !thisObject->m_IsVisible(nRow) )
+    return;
+
+  entry = (ICON_BUDGET_COMPACT*)g_hash_table_lookup(thisObject->m_pCompacts, GINT_TO_POINTER(nRow));
+  if(!entry)
+    return;
+
+  compact = entry->compact;
+
+  pixbuf = thisObject->m_ExpandCompact(compact);
+
+  if(pixbuf)
+    g_object_set(renderer, "pixbuf", pixbuf, NULL);
+}
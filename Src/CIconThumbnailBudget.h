@@ -0,0 +1,219 @@
+/*! \file    CIconThumbnailBudget.h
+    \brief   Declaration of class CIconThumbnailBudget.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONTHUMBNAILBUDGET
+#define __CICONTHUMBNAILBUDGET
+
+#include <gtk/gtk.h>
+
+#include "CIconCatalog.h"
+#include "CIconCompactThumbnail.h"
+
+/* The memory the thumbnails of the rows could take, in bytes. */
+#define ICON_BUDGET_MAX_BYTES  (32 * 1024 * 1024)
+
+/* When the budget is exceeded, the rows are evicted until the memory is down to this percentage of it,
+   so the eviction does not run again at every row appended. */
+#define ICON_BUDGET_LOW_WATER_PERCENT  75
+
+/* The rows before and after the visible ones which keep their thumbnails, so a short scroll shows no placeholders. */
+#define ICON_BUDGET_MARGIN_ROWS  128
+
+/* The thumbnails restored in one pass at most, and the thumbnails being decoded again off the main loop at once. */
+#define ICON_BUDGET_RESTORES_PER_PASS  64
+
+/* The threads decoding the thumbnails of the rows scrolled back into view again, when they are not sandboxed. */
+#define ICON_BUDGET_RESTORE_THREADS  2
+
+/* The memory of a GdkPixbuf besides its pixels, in bytes. */
+#define ICON_BUDGET_PIXBUF_OVERHEAD  128
+
+/* The thumbnails compacted in one pass at most, in the compact mode. */
+#define ICON_BUDGET_COMPACTS_PER_PASS  256
+
+/* The pixbufs the compact thumbnails are expanded into when they are drawn, reused from the least recently drawn. */
+#define ICON_BUDGET_POOL_SIZE  64
+
+/*! \struct ICON_BUDGET_STATS
+    \brief The memory taken by the thumbnails of the rows, for the embedding application to look at.
+*/
+typedef struct _ICON_BUDGET_STATS
+{
+  guint nRows;              /*!< The rows of the model. */
+  guint nResidentRows;      /*!< The rows showing their own thumbnail, the others show the placeholder. */
+  guint nPixbufs;           /*!< The different thumbnails the rows hold, identical icons share one. */
+  gsize nBytes;             /*!< The memory of those thumbnails. */
+  gsize nMaxBytes;          /*!< The budget. */
+  guint nEvicted;           /*!< The thumbnails replaced by the placeholder since the model was filled. */
+  guint nRestored;          /*!< The thumbnails brought back since the model was filled. */
+  guint nCachedThumbnails;  /*!< The thumbnails in the catalog's content cache, of all views in the process. */
+  guint nCompactRows;       /*!< The rows keeping their thumbnail compact, they are counted in nResidentRows too. */
+  gsize nCompactBytes;      /*!< The memory of those compact thumbnails, counted in nBytes too. */
+  guint nExpanded;          /*!< The compact thumbnails expanded to be drawn since the model was filled. */
+} ICON_BUDGET_STATS;
+
+/*! \struct ICON_BUDGET_COMPACT
+    \brief A compact thumbnail, shared by the rows of identical icons.
+*/
+typedef struct _ICON_BUDGET_COMPACT
+{
+  CIconCompactThumbnail *compact;  /*!< The compact thumbnail. */
+  guint64 contentHash;             /*!< The content hash of the icons, 0 if it is unknown, then it is not shared. */
+  guint nRows;                     /*!< The rows keeping it. */
+} ICON_BUDGET_COMPACT;
+
+/*! \struct ICON_BUDGET_POOL_ENTRY
+    \brief A pixbuf a compact thumbnail is expanded into.
+*/
+typedef struct _ICON_BUDGET_POOL_ENTRY
+{
+  CIconCompactThumbnail *compact;  /*!< The thumbnail the pixbuf holds, NULL if none. */
+  GdkPixbuf *pixbuf;               /*!< The pixbuf, NULL until it is needed. */
+  guint nStamp;                    /*!< When it was last drawn. */
+} ICON_BUDGET_POOL_ENTRY;
+
+class CIconThumbnailBudget;
+
+/*! \struct ICON_BUDGET_RESTORE
+    \brief A thumbnail decoded again off the main loop, put into its row when it comes back.
+*/
+typedef struct _ICON_BUDGET_RESTORE
+{
+  CIconThumbnailBudget *pBudget;  /*!< The budget waiting for the thumbnail. */
+  CIconDecoderPool *pPool;        /*!< The sandboxed workers decoding the file, referenced. NULL for a restoring thread. */
+  ICON_DECODER_JOB *pJob;         /*!< The job of the workers, NULL once its callback was called. */
+  gchar  *fullName;               /*!< The icon file. */
+  guint64 contentHash;            /*!< The content hash of the file, 0 if it is unknown. */
+  gsize  fileSize;                /*!< The size of the file on disk. */
+  gint64 mtime;                   /*!< The modification time of the file, in second. */
+  gint   nSize;                   /*!< The thumbnail size. */
+  gint   nRow;                    /*!< The row waiting for the thumbnail. */
+  gint   nGeneration;             /*!< The generation of the budget it was queued in. */
+  GdkPixbuf *pixbuf;              /*!< The thumbnail, NULL if it could not be decoded. */
+  gint   nStatus;                 /*!< The ICON_DECODER_STATUS of the sandboxed workers. */
+} ICON_BUDGET_RESTORE;
+
+/*! \class CIconThumbnailBudget
+    \brief Bounds the memory taken by the thumbnails of an icon view.
+
+    The rows are counted as they are appended. When their thumbnails take more than the budget, the rows farthest from
+    the visible ones get a shared placeholder instead, and the thumbnails nobody else holds go to the bounded
+    idle list of the catalog's content cache.
+    The rows scrolled back into view get their thumbnails again from the catalog's content cache on the main loop.
+    The others are decoded again off it, by the sandboxed workers or ICON_BUDGET_RESTORE_THREADS restoring threads,
+    and put into their rows when they come back. A file known to fail is not decoded again.
+    The rows are known by their position, the positions must be given when the rows are reordered.
+    In the compact mode, when the budget is exceeded, the resident rows out of sight keep their thumbnails as
+    CIconCompactThumbnail and show the placeholder in the model, the farthest first. Only then the rows are evicted.
+    The rows of identical icons share one compact thumbnail by content hash, and one thumbnail when they are expanded. The visible rows are left as
+    they are, a compact row scrolled into view gets its thumbnail back by the next pass. Until then the pixbuf cell
+    renderer of the view expands it when it is drawn, into a pool of ICON_BUDGET_POOL_SIZE pixbufs. The renderer
+    has the fixed thumbnail size, so laying the view out expands nothing.
+*/
+class CIconThumbnailBudget
+{
+  private:
+    GtkIconView *m_pIconView;   /*!< The icon view whose model is bounded, NULL if it is not attached. */
+    CIconCatalog *m_pCatalog;   /*!< The catalog the thumbnails are restored from. */
+    gint m_nIconColumn;         /*!< The model column of the thumbnail. */
+    gint m_nPathColumn;         /*!< The model column of the icon's full file name. */
+    gint m_nHashColumn;         /*!< The model column of the icon's content hash. */
+    gint m_nSize;               /*!< The thumbnail size. */
+    gsize m_nMaxBytes;          /*!< The budget. */
+    gsize m_nBytes;             /*!< The memory of the thumbnails of m_pPixbufs. */
+    guint m_nRows;              /*!< The rows appended since the model was filled. */
+    guint m_nEvicted;           /*!< The thumbnails evicted since the model was filled. */
+    guint m_nRestored;          /*!< The thumbnails restored since the model was filled. */
+    guint m_nIdle;              /*!< The idle source ID of the next pass, 0 if none is scheduled. */
+    GdkPixbuf *m_pPlaceholder;  /*!< The image of the evicted rows, shared by all of them. */
+    GHashTable *m_pResident;    /*!< The position of a row showing its thumbnail to the thumbnail, NULL if it could not be restored. */
+    GHashTable *m_pPixbufs;     /*!< The thumbnail to the number of resident rows holding it. Not referenced. */
+    GHashTable *m_pCompacts;    /*!< The position of a row keeping its thumbnail compact to its ICON_BUDGET_COMPACT. */
+    GHashTable *m_pSharedCompacts;  /*!< The content hash to the ICON_BUDGET_COMPACT of the rows of identical icons. */
+    gboolean m_bCompact;        /*!< To keep the thumbnails of the resident rows compact. */
+    gsize m_nCompactBytes;      /*!< The memory of the compact thumbnails, each counted once, in m_nBytes too. */
+    guint m_nExpanded;          /*!< The compact thumbnails expanded since the model was filled. */
+    GtkCellRenderer *m_pRenderer;  /*!< The pixbuf cell renderer of the view, NULL if it has none. */
+    ICON_BUDGET_POOL_ENTRY m_Pool[ICON_BUDGET_POOL_SIZE];  /*!< The pixbufs the compact thumbnails are drawn from. */
+    guint m_nPoolStamp;         /*!< The stamp of the last pool entry drawn. */
+    gint m_nFirstVisible;       /*!< The first row visible at the last expose or pass. */
+    gint m_nLastVisible;        /*!< The last one, less than m_nFirstVisible if none is visible. */
+    gint m_nPassFirstVisible;   /*!< The first row visible at the last pass, the rows out of it are compacted. */
+    gint m_nPassLastVisible;    /*!< The last one. */
+    GThreadPool *m_pRestorePool;  /*!< The restoring threads. */
+    GAsyncQueue *m_pRestored;     /*!< The ICON_BUDGET_RESTORE finished by the restoring threads. */
+    GHashTable *m_pRestoring;     /*!< The position of a row to its ICON_BUDGET_RESTORE in progress. */
+    gint m_nGeneration;           /*!< Increased when the restores in progress are cancelled, their results are dropped. */
+
+    gboolean m_Pass(void);
+    void m_Schedule(void);
+    void m_Hold(GdkPixbuf *pixbuf);
+    void m_Drop(GdkPixbuf *pixbuf);
+    gboolean m_Evict(GtkTreeModel *model, gint nRow);
+    gboolean m_Restore(GtkTreeModel *model, GtkTreeIter *pIter, gint nRow);
+    void m_FinishRestore(ICON_BUDGET_RESTORE *restore);
+    void m_TakeRestored(void);
+    void m_CancelRestores(void);
+    gboolean m_CompactRows(GtkTreeModel *model, gint *window);
+    gboolean m_ExpandRow(GtkTreeModel *model, GtkTreeIter *pIter, gint nRow);
+    void m_RemoveCompact(gint nRow);
+    void m_ReleaseCompact(ICON_BUDGET_COMPACT *entry);
+    void m_ClearPool(void);
+    GdkPixbuf* m_ExpandCompact(CIconCompactThumbnail *compact);
+    void m_UpdateVisibleRange(void);
+    void m_SetFixedSize(void);
+    gboolean m_IsVisible(gint nRow) { return (nRow >= m_nFirstVisible) && (nRow <= m_nLastVisible); }
+
+    static gboolean cb_idle(gpointer data);
+    static void cb_restore_thread(gpointer data, gpointer thisObject);
+    static gboolean cb_restored(gpointer data);
+    static void cb_restore_done(GdkPixbuf *pixbuf, gint nStatus, gpointer data);
+    static void m_FreeRestore(ICON_BUDGET_RESTORE *restore);
+    static gboolean cb_expose(GtkWidget *widget, GdkEventExpose *event, gpointer data);
+    static gboolean cb_expose_start(GtkWidget *widget, GdkEventExpose *event, gpointer data);
+    static void cb_destroy(GtkWidget *widget, gpointer data);
+    static void cb_cell_data(GtkCellLayout *layout, GtkCellRenderer *renderer, GtkTreeModel *model, GtkTreeIter *iter, gpointer data);
+
+  public:
+    CIconThumbnailBudget(CIconCatalog *pCatalog, gint iconColumn, gint pathColumn, gint hashColumn, gint size);
+    ~CIconThumbnailBudget();
+
+    /* To bound the rows of an icon view, NULL to detach from it. */
+    void m_Attach(GtkIconView *iconView);
+
+    /* To forget the rows without touching them, when the model is replaced. */
+    void m_Reset(void);
+
+    /* To count the row just appended with its thumbnail. */
+    void m_AddRow(GdkPixbuf *pixbuf);
+
+    /* To count the thumbnail a row got after it was appended, e.g. a row listed before it was decoded. */
+    void m_SetRow(gint nRow, GdkPixbuf *pixbuf);
+
+    /* To follow the rows being reordered, newOrder[newPosition] is the old position. */
+    void m_Reorder(const gint *newOrder, guint nRows);
+
+    /* The placeholder is made again at the new size, the model must be filled again. */
+    void m_SetSize(gint size);
+
+    void m_SetMaxBytes(gsize maxBytes);
+    gsize m_GetMaxBytes(void) { return m_nMaxBytes; }
+    gsize m_GetBytes(void) { return m_nBytes; }
+    gboolean m_IsNearFull(void) { return (m_nBytes >= m_nMaxBytes / 100 * ICON_BUDGET_LOW_WATER_PERCENT); }
+
+    /* To keep the thumbnails of the rows compact and expand them when they are drawn. Turned off, the compact rows
+       are evicted and get their thumbnails again as they are scrolled into view. */
+    void m_SetCompact(gboolean bCompact);
+    gboolean m_GetCompact(void) { return m_bCompact; }
+
+    /* To get the memory taken and the pixbufs held. */
+    void m_GetStats(ICON_BUDGET_STATS *pStats);
+};
+#endif   /* CICONTHUMBNAILBUDGET.H	*/
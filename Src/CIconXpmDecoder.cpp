@@ -0,0 +1,583 @@
+/*! \file    CIconXpmDecoder.cpp
+    \brief   Decode XPM icons in one pass over the file contents, without the gdk-pixbuf loader.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1. 2026-10-19 initial version.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "CIconXpmDecoder.h"
+#include "CIconStreamDecoder.h"
+
+/* The first line of an XPM(version 3) file. */
+#define XPM_SIGNATURE  "/* XPM */"
+
+/* The longest color value of a color definition, as the gdk-pixbuf loader reads it. */
+#define XPM_MAX_COLOR_NAME  128
+
+/* The multiplier of the first palette seed, the golden ratio in 64 bits. */
+#define XPM_HASH_MULTIPLIER  0x9e3779b97f4a7c15ULL
+
+/*! \struct XPM_NAMED_COLOR
+    \brief A color name of the X11 color database.
+*/
+typedef struct _XPM_NAMED_COLOR
+{
+  const gchar *name;
+  guint32 rgb;
+} XPM_NAMED_COLOR;
+
+/* The color names found in icon files, with the values of the X11 color database the gdk-pixbuf loader uses.
+   A file with any other name is left to the loader. */
+static const XPM_NAMED_COLOR g_XpmColorNames[] = {
+  { "black",      0x000000 },
+  { "white",      0xffffff },
+  { "red",        0xff0000 },
+  { "green",      0x00ff00 },
+  { "blue",       0x0000ff },
+  { "yellow",     0xffff00 },
+  { "cyan",       0x00ffff },
+  { "magenta",    0xff00ff },
+  { "gray",       0xbebebe },
+  { "grey",       0xbebebe },
+  { "gray25",     0x404040 },
+  { "grey25",     0x404040 },
+  { "gray50",     0x7f7f7f },
+  { "grey50",     0x7f7f7f },
+  { "gray75",     0xbfbfbf },
+  { "grey75",     0xbfbfbf },
+  { NULL,         0x000000 }
+};
+
+gboolean CIconXpmDecoder::m_bEnabled = true;
+
+//--------------- Class Member Function Implementation.
+/*! \fn CIconXpmDecoder::CIconXpmDecoder(const guchar *data, gsize length)
+    \brief CIconXpmDecoder constructor
+
+    \param[in] data. The file contents, they must stay valid until the decoder is deleted.
+    \param[in] length. The number of bytes of the contents.
+*/
+CIconXpmDecoder::CIconXpmDecoder(const guchar *data, gsize length)
+{
+  m_pPos = (const gchar*)data;
+  m_pEnd = (const gchar*)data + (data ? length : 0);
+  m_nWidth = 0;
+  m_nHeight = 0;
+  m_nColors = 0;
+  m_nCpp = 0;
+  m_bHasAlpha = false;
+  m_pKeys = NULL;
+  m_pColors = NULL;
+  m_nHashBits = 0;
+  m_nHashSeed = 0;
+  m_nFallbackColor = 0;
+}
+
+/*! \fn CIconXpmDecoder::~CIconXpmDecoder()
+    \brief CIconXpmDecoder destructor
+*/
+CIconXpmDecoder::~CIconXpmDecoder()
+{
+  g_free(m_pKeys);
+  g_free(m_pColors);
+
+  m_pKeys = NULL;
+  m_pColors = NULL;
+}
+
+/*! \fn gboolean CIconXpmDecoder::m_IsXpm(const guchar *data, gsize length)
+    \brief To check if file contents are an XPM file, by its first line.
+
+    \param[in] data. The file contents.
+    \param[in] length. The number of bytes of the contents.
+    \return TRUE or FALSE
+*/
+gboolean CIconXpmDecoder::m_IsXpm(const guchar *data, gsize length)
+{
+  gsize i = 0;
+
+  if(!data)
+    return false;
+
+  while( (i < length) && g_ascii_isspace(data[i]) )
+    i++;
+
+  return (length - i >= strlen(XPM_SIGNATURE)) && (memcmp(data + i, XPM_SIGNATURE, strlen(XPM_SIGNATURE)) == 0);
+}
+
+/*! \fn gboolean CIconXpmDecoder::m_NextString(const gchar **pString, gsize *pLength)
+    \brief To take the next quoted string of the C source, skipping the comments and the C tokens between.
+    \n The string is not copied, it points into the file contents.
+
+    \param[out] pString. The first character in the quotes.
+    \param[out] pLength. The number of characters in the quotes.
+    \return TRUE or FALSE at the end of the file.
+*/
+gboolean CIconXpmDecoder::m_NextString(const gchar **pString, gsize *pLength)
+{
+  while(m_pPos < m_pEnd)
+  {
+     if(*m_pPos == '"')
+     {
+        const gchar *pStart = ++m_pPos;
+        const gchar *pQuote = (const gchar*)memchr(pStart, '"', m_pEnd - pStart);
+
+        if(pQuote == NULL)
+          return false;
+
+        *pString = pStart;
+        *pLength = pQuote - pStart;
+        m_pPos = pQuote + 1;
+        return true;
+     }
+
+     if( (*m_pPos == '/') && (m_pPos + 1 < m_pEnd) && (m_pPos[1] == '*') )
+     {
+        const gchar *pClose = g_strstr_len(m_pPos + 2, m_pEnd - m_pPos - 2, "*/");
+
+        if(pClose == NULL)
+          return false;
+
+        m_pPos = pClose + 2;
+     }
+     else
+       m_pPos++;
+  }
+
+  return false;
+}
+
+/*! \fn gboolean CIconXpmDecoder::m_ReadHeader(void)
+    \brief To read the values string: the width, the height, the number of colors and the characters per pixel.
+
+    \param[in] NONE
+    \return FALSE if it is missing or out of the limits.
+*/
+gboolean CIconXpmDecoder::m_ReadHeader(void)
+{
+  const gchar *pString = NULL;
+  gsize length = 0;
+  gchar values[64];
+
+  if( !m_NextString(&pString, &length) || (length >= sizeof(values)) )
+    return false;
+
+  memcpy(values, pString, length);
+  values[length] = '\0';
+
+  if( sscanf(values, "%d %d %d %d", &m_nWidth, &m_nHeight, &m_nColors, &m_nCpp) != 4 )
+    return false;
+
+  if( (m_nWidth <= 0) || (m_nHeight <= 0) || (m_nColors <= 0) || (m_nColors > ICON_XPM_MAX_COLORS) ||
+      (m_nCpp <= 0) || (m_nCpp > ICON_XPM_MAX_CPP) )
+    return false;
+
+  /* The loader refuses the image at the same limit. */
+  return (guint64)m_nWidth * (guint64)m_nHeight <= CIconStreamDecoder::m_GetMaxPixels();
+}
+
+/*! \fn gboolean CIconXpmDecoder::m_ReadColors(void)
+    \brief To read the color definitions and build the palette.
+    \n The value is taken as the gdk-pixbuf loader takes it: of the keys "c", "g", "g4" and "m" the first in this
+    order, its words joined by single spaces. A definition without any of them is transparent, as "None".
+
+    \param[in] NONE
+    \return FALSE if a definition is missing or has a color this parser does not know.
+*/
+gboolean CIconXpmDecoder::m_ReadColors(void)
+{
+  guint64 *keys = g_new(guint64, m_nColors);
+  guint32 *colors = g_new(guint32, m_nColors);
+  gboolean bRet = true;
+
+  for(gint i=0; (i < m_nColors) && bRet; i++)
+  {
+     const gchar *pString = NULL;
+     gsize length = 0;
+     const gchar *p = NULL;
+     const gchar *pEnd = NULL;
+     gchar color[XPM_MAX_COLOR_NAME + 1] = "";
+     gchar best[XPM_MAX_COLOR_NAME + 1] = "";
+     gint nKey = 0;
+     gint nBestKey = 1;
+
+     bRet = m_NextString(&pString, &length) && (length >= (gsize)m_nCpp);
+     if(!bRet)
+       break;
+
+     keys[i] = m_PackKey(pString);
+     p = pString + m_nCpp;
+     pEnd = pString + length;
+
+     while(true)
+     {
+        const gchar *pWord = NULL;
+        gsize wordLength = 0;
+        gint nNewKey = 0;
+
+        while( (p < pEnd) && g_ascii_isspace(*p) )
+          p++;
+
+        pWord = p;
+        while( (p < pEnd) && !g_ascii_isspace(*p) )
+          p++;
+
+        wordLength = MIN((gsize)(p - pWord), (gsize)XPM_MAX_COLOR_NAME);
+
+        if(wordLength == 0)
+        {
+           /* The end of the definition, the last value is kept as after a key. A key without a value makes the
+              whole definition incomplete, the loader takes it as transparent. */
+           if(color[0] == '\0')
+           {
+              nBestKey = 1;
+              break;
+           }
+
+           nNewKey = 1;
+        }
+        else if( (nKey > 0) && (color[0] == '\0') )
+          nNewKey = 0;   /* The word after a key is always a value. */
+        else if( (wordLength == 1) && (*pWord == 'c') )
+          nNewKey = 5;
+        else if( (wordLength == 1) && (*pWord == 'g') )
+          nNewKey = 4;
+        else if( (wordLength == 2) && (strncmp(pWord, "g4", 2) == 0) )
+          nNewKey = 3;
+        else if( (wordLength == 1) && (*pWord == 'm') )
+          nNewKey = 2;
+        else if( (wordLength == 1) && (*pWord == 's') )
+          nNewKey = 1;
+
+        if(nNewKey == 0)
+        {
+           gsize used = strlen(color);
+
+           /* A value before any key. */
+           if(nKey == 0)
+             break;
+
+           if( used && (used < XPM_MAX_COLOR_NAME) )
+             color[used++] = ' ';
+
+           wordLength = MIN(wordLength, XPM_MAX_COLOR_NAME - used);
+           memcpy(color + used, pWord, wordLength);
+           color[used + wordLength] = '\0';
+        }
+        else
+        {
+           if(nKey > nBestKey)
+           {
+              nBestKey = nKey;
+              strcpy(best, color);
+           }
+
+           color[0] = '\0';
+           nKey = nNewKey;
+
+           if(p >= pEnd)
+             break;
+        }
+     }
+
+     if( (nBestKey <= 1) || (g_ascii_strcasecmp(best, "None") == 0) )
+     {
+        colors[i] = 0x00000000;
+        m_bHasAlpha = true;
+     }
+     else
+       bRet = m_ParseColor(best, strlen(best), &colors[i]);
+  }
+
+  if(bRet)
+    bRet = m_BuildPalette(keys, colors);
+
+  g_free(keys);
+  g_free(colors);
+
+  return bRet;
+}
+
+/*! \fn gboolean CIconXpmDecoder::m_BuildPalette(const guint64 *keys, const guint32 *colors)
+    \brief To build the perfect hash of the palette: a multiplier under which no two colors share a slot.
+    \n The table has at least twice the slots of the colors, a seed without collisions is usually one of the first.
+    A color defined twice takes the later value, as in the loader.
+
+    \param[in] keys. The packed characters of the colors.
+    \param[in] colors. The colors as 0xAARRGGBB.
+    \return FALSE if no seed was found.
+*/
+gboolean CIconXpmDecoder::m_BuildPalette(const guint64 *keys, const guint32 *colors)
+{
+  gboolean bCollision = true;
+
+  /* A pixel which is not in the palette takes the first color, as in the loader. */
+  m_nFallbackColor = colors[0];
+
+  m_nHashBits = 1;
+  while( (1u << m_nHashBits) < (guint)m_nColors * 2 )
+    m_nHashBits++;
+
+  for(gint nTry=0; (nTry < ICON_XPM_HASH_TRIES) && bCollision; nTry++)
+  {
+     if( (nTry > 0) && ((nTry % ICON_XPM_HASH_GROW_TRIES) == 0) )
+       m_nHashBits++;
+
+     g_free(m_pKeys);
+     g_free(m_pColors);
+     m_pKeys = g_new0(guint64, 1u << m_nHashBits);
+     m_pColors = g_new0(guint32, 1u << m_nHashBits);
+
+     m_nHashSeed = (XPM_HASH_MULTIPLIER * (guint64)(nTry + 1)) | 1;
+     bCollision = false;
+
+     for(gint i=0; (i < m_nColors) && !bCollision; i++)
+     {
+        guint slot = (guint)((keys[i] * m_nHashSeed) >> (64 - m_nHashBits));
+
+        if( m_pKeys[slot] && (m_pKeys[slot] != keys[i]) )
+          bCollision = true;
+
+        m_pKeys[slot] = keys[i];
+        m_pColors[slot] = colors[i];
+     }
+  }
+
+  #ifdef DEBUG_MENU_ICONCHOOSER
+  if(bCollision)
+    printf("%s(%d) - no perfect hash of %d colors \n", __FUNCTION__, __LINE__, m_nColors);
+  #endif
+
+  return !bCollision;
+}
+
+/*! \fn GdkPixbuf* CIconXpmDecoder::m_ReadPixels(void)
+    \brief To read the pixel rows into an image of the full size.
+
+    \param[in] NONE
+    \return The image, NULL if a row is missing or short.
+*/
+GdkPixbuf* CIconXpmDecoder::m_ReadPixels(void)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, m_bHasAlpha, 8, m_nWidth, m_nHeight);
+  guchar *pixels = NULL;
+  gint rowstride = 0;
+  gint nChannels = m_bHasAlpha ? 4 : 3;
+
+  if(!pixbuf)
+    return NULL;
+
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+
+  for(gint y=0; y<m_nHeight; y++)
+  {
+     const gchar *pRow = NULL;
+     gsize length = 0;
+     guchar *pDst = pixels + (gsize)y * rowstride;
+
+     /* The loader fills a short row with garbage, it is left to it. */
+     if( !m_NextString(&pRow, &length) || (length < (gsize)m_nWidth * m_nCpp) )
+     {
+        g_object_unref(pixbuf);
+        return NULL;
+     }
+
+     for(gint x=0; x<m_nWidth; x++, pRow+=m_nCpp, pDst+=nChannels)
+     {
+        guint32 color = m_LookupColor(m_PackKey(pRow));
+
+        pDst[0] = (guchar)(color >> 16);
+        pDst[1] = (guchar)(color >> 8);
+        pDst[2] = (guchar)color;
+
+        if(m_bHasAlpha)
+          pDst[3] = (guchar)(color >> 24);
+     }
+  }
+
+  return pixbuf;
+}
+
+/*! \fn GdkPixbuf* CIconXpmDecoder::m_ReadPixelsScaled(gint width, gint height)
+    \brief To read the pixel rows averaged straight into a smaller image. Every source pixel is added into the
+           output pixel it falls in, weighted by its alpha, and an output row is written when its last source row was read.
+
+    \param[in] width. The output width, not more than the image width.
+    \param[in] height. The output height, not more than the image height.
+    \return The image, NULL if a row is missing or short.
+*/
+GdkPixbuf* CIconXpmDecoder::m_ReadPixelsScaled(gint width, gint height)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, m_bHasAlpha, 8, width, height);
+  gint nChannels = m_bHasAlpha ? 4 : 3;
+  gint *pColumns = NULL;
+  guint64 *pSums = NULL;   /* Per output pixel: red, green and blue weighted by alpha, alpha, the pixel count. */
+  gint nRow = 0;
+  gboolean bRet = true;
+
+  if(!pixbuf)
+    return NULL;
+
+  pColumns = g_new(gint, m_nWidth);
+  pSums = g_new0(guint64, (gsize)width * 5);
+
+  for(gint x=0; x<m_nWidth; x++)
+    pColumns[x] = (gint)((gint64)x * width / m_nWidth);
+
+  for(gint y=0; (y < m_nHeight) && bRet; y++)
+  {
+     const gchar *pRow = NULL;
+     gsize length = 0;
+
+     bRet = m_NextString(&pRow, &length) && (length >= (gsize)m_nWidth * m_nCpp);
+     if(!bRet)
+       break;
+
+     for(gint x=0; x<m_nWidth; x++, pRow+=m_nCpp)
+     {
+        guint32 color = m_LookupColor(m_PackKey(pRow));
+        guint64 alpha = m_bHasAlpha ? (color >> 24) : 0xff;
+        guint64 *pSum = pSums + (gsize)pColumns[x] * 5;
+
+        pSum[0] += ((color >> 16) & 0xff) * alpha;
+        pSum[1] += ((color >> 8) & 0xff) * alpha;
+        pSum[2] += (color & 0xff) * alpha;
+        pSum[3] += alpha;
+        pSum[4]++;
+     }
+
+     /* The output row is complete when the next source row falls into the next one. */
+     nRow = (gint)((gint64)y * height / m_nHeight);
+     if( (y + 1 == m_nHeight) || ((gint)((gint64)(y + 1) * height / m_nHeight) != nRow) )
+     {
+        guchar *pDst = gdk_pixbuf_get_pixels(pixbuf) + (gsize)nRow * gdk_pixbuf_get_rowstride(pixbuf);
+
+        for(gint x=0; x<width; x++, pDst+=nChannels)
+        {
+           guint64 *pSum = pSums + (gsize)x * 5;
+           guint64 alpha = pSum[3];
+
+           pDst[0] = alpha ? (guchar)((pSum[0] + alpha / 2) / alpha) : 0;
+           pDst[1] = alpha ? (guchar)((pSum[1] + alpha / 2) / alpha) : 0;
+           pDst[2] = alpha ? (guchar)((pSum[2] + alpha / 2) / alpha) : 0;
+
+           if(m_bHasAlpha)
+             pDst[3] = pSum[4] ? (guchar)((alpha + pSum[4] / 2) / pSum[4]) : 0;
+        }
+
+        memset(pSums, 0x00, sizeof(guint64) * width * 5);
+     }
+  }
+
+  g_free(pColumns);
+  g_free(pSums);
+
+  if(!bRet)
+  {
+     g_object_unref(pixbuf);
+     return NULL;
+  }
+
+  return pixbuf;
+}
+
+/*! \fn GdkPixbuf* CIconXpmDecoder::m_Decode(gint size)
+    \brief To decode the image fitted into a size, as the loader with the size set at "size-prepared" would.
+    \n An image larger than the size is averaged straight into it. A smaller one is decoded and scaled bilinearly,
+    as the loader scales.
+
+    \param[in] size. The wanted size, 0 for the full size.
+    \return The image, it must be unreferenced. NULL if it is not an XPM this parser handles.
+*/
+GdkPixbuf* CIconXpmDecoder::m_Decode(gint size)
+{
+  GdkPixbuf *pixbuf = NULL;
+  gint width = 0;
+  gint height = 0;
+
+  if( !m_IsXpm((const guchar*)m_pPos, m_pEnd - m_pPos) || !m_ReadHeader() || !m_ReadColors() )
+    return NULL;
+
+  width = m_nWidth;
+  height = m_nHeight;
+
+  if(size > 0)
+    CIconStreamDecoder::m_FitSize(&width, &height, size);
+
+  if( (width < m_nWidth) && (height <= m_nHeight) )
+    return m_ReadPixelsScaled(width, height);
+
+  pixbuf = m_ReadPixels();
+
+  if( pixbuf && ((width != m_nWidth) || (height != m_nHeight)) )
+  {
+     GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pixbuf, width, height, GDK_INTERP_BILINEAR);
+
+     g_object_unref(pixbuf);
+     pixbuf = scaled;
+  }
+
+  return pixbuf;
+}
+
+/*! \fn gboolean CIconXpmDecoder::m_ParseColor(const gchar *spec, gsize length, guint32 *pColor)
+    \brief To parse a color value: "#" with 1 to 4 hexadecimal digits per component, or a name of g_XpmColorNames.
+    \n The components are taken to 16 bits and their high bytes kept, as in the loader.
+
+    \param[in] spec. The color value, not "None".
+    \param[in] length. The number of characters.
+    \param[out] pColor. The color as 0xAARRGGBB.
+    \return FALSE if the value is not handled here, the loader may still know it.
+*/
+gboolean CIconXpmDecoder::m_ParseColor(const gchar *spec, gsize length, guint32 *pColor)
+{
+  static const guint32 maxValues[5] = { 0, 0xf, 0xff, 0xfff, 0xffff };
+
+  if( (length > 1) && (spec[0] == '#') )
+  {
+     gsize digits = (length - 1) / 3;
+     guint32 rgb = 0;
+
+     if( ((length - 1) % 3) || (digits < 1) || (digits > 4) )
+       return false;
+
+     for(gint c=0; c<3; c++)
+     {
+        guint32 value = 0;
+
+        for(gsize i=0; i<digits; i++)
+        {
+           gint digit = g_ascii_xdigit_value(spec[1 + c * digits + i]);
+
+           if(digit < 0)
+             return false;
+
+           value = (value << 4) | digit;
+        }
+
+        value = value * 65535 / maxValues[digits];
+        rgb = (rgb << 8) | (value >> 8);
+     }
+
+     *pColor = 0xff000000 | rgb;
+     return true;
+  }
+
+  for(gint i=0; g_XpmColorNames[i].name; i++)
+  {
+     if( (strlen(g_XpmColorNames[i].name) == length) && (g_ascii_strncasecmp(spec, g_XpmColorNames[i].name, length) == 0) )
+     {
+        *pColor = 0xff000000 | g_XpmColorNames[i].rgb;
+        return true;
+     }
+  }
+
+  return false;
+}
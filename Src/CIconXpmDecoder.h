@@ -0,0 +1,93 @@
+/*! \file    CIconXpmDecoder.h
+    \brief   Declaration of class CIconXpmDecoder.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#ifndef __CICONXPMDECODER
+#define __CICONXPMDECODER
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+/* The colors and the characters per pixel of the XPM files parsed, the others are left to the gdk-pixbuf loader. */
+#define ICON_XPM_MAX_COLORS  65536
+#define ICON_XPM_MAX_CPP     8
+
+/* The seeds tried for a palette without collisions, the table is doubled every ICON_XPM_HASH_GROW_TRIES. */
+#define ICON_XPM_HASH_TRIES       32
+#define ICON_XPM_HASH_GROW_TRIES  8
+
+/*! \class CIconXpmDecoder
+    \brief Decode an XPM icon in memory without the gdk-pixbuf loader, which copies and looks up every pixel as a
+           string.
+
+    The file is tokenized in one pass: the quoted strings are taken in place, nothing is copied. The characters of
+    a pixel are packed into a 64-bit key, and the palette is a perfect hash of those keys: a multiplier is searched
+    until no two colors share a slot, so a pixel is one multiplication, a shift and a compare. An image larger than
+    the thumbnail is averaged straight into the thumbnail row by row, it is never decoded at full size.
+    Anything the parser does not handle, e.g. XPM2 or a color name outside its small table, makes m_Decode()
+    return NULL, and the caller decodes the file by the gdk-pixbuf loader, so the results are the loader's.
+*/
+class CIconXpmDecoder
+{
+  private:
+    const gchar *m_pPos;       /*!< The tokenizer position in the file. */
+    const gchar *m_pEnd;       /*!< The end of the file. */
+    gint m_nWidth;             /*!< The image width, from the header. */
+    gint m_nHeight;            /*!< The image height, from the header. */
+    gint m_nColors;            /*!< The number of colors, from the header. */
+    gint m_nCpp;               /*!< The characters per pixel, from the header. */
+    gboolean m_bHasAlpha;      /*!< To indicate if a color is "None", the image has an alpha channel then. */
+    guint64 *m_pKeys;          /*!< The palette slots: the packed characters of a color, 0 if the slot is empty. */
+    guint32 *m_pColors;        /*!< The palette slots: the color as 0xAARRGGBB. */
+    guint m_nHashBits;         /*!< The palette has 2^m_nHashBits slots. */
+    guint64 m_nHashSeed;       /*!< The multiplier of the palette hash. */
+    guint32 m_nFallbackColor;  /*!< The color of a pixel whose characters are not in the palette, the first color. */
+
+    gboolean m_NextString(const gchar **pString, gsize *pLength);
+    gboolean m_ReadHeader(void);
+    gboolean m_ReadColors(void);
+    gboolean m_BuildPalette(const guint64 *keys, const guint32 *colors);
+    GdkPixbuf* m_ReadPixels(void);
+    GdkPixbuf* m_ReadPixelsScaled(gint width, gint height);
+
+    /* To pack the characters of a pixel into its key. */
+    guint64 m_PackKey(const gchar *p) { guint64 key = 0; for(gint i=0; i<m_nCpp; i++) key = (key << 8) | (guchar)p[i]; return key; }
+
+    /* To look a pixel up in the palette, the fallback color if it is not there. */
+    guint32 m_LookupColor(guint64 key)
+    {
+       guint slot = (guint)((key * m_nHashSeed) >> (64 - m_nHashBits));
+       return (m_pKeys[slot] == key) ? m_pColors[slot] : m_nFallbackColor;
+    }
+
+    static gboolean m_ParseColor(const gchar *spec, gsize length, guint32 *pColor);
+
+    static gboolean m_bEnabled;
+
+  public:
+    /* The file contents must stay valid until the decoder is deleted, e.g. a mapped file. */
+    CIconXpmDecoder(const guchar *data, gsize length);
+    ~CIconXpmDecoder();
+
+    /* To decode the image fitted into a size keeping the aspect ratio, 0 for the full size. It must be unreferenced,
+       NULL if the file is not an XPM this parser handles. */
+    GdkPixbuf* m_Decode(gint size);
+
+    gint m_GetWidth(void) { return m_nWidth; }
+    gint m_GetHeight(void) { return m_nHeight; }
+
+    /* To check if the contents start as an XPM(version 3) file. */
+    static gboolean m_IsXpm(const guchar *data, gsize length);
+
+    /* To use the parser for XPM icons, e.g. off to compare it with the gdk-pixbuf loader. It is on by default.
+       The reader threads and the decoder workers check it while the main thread may switch it. */
+    static void m_SetEnabled(gboolean bEnabled) { g_atomic_int_set(&m_bEnabled, bEnabled ? TRUE : FALSE); }
+    static gboolean m_GetEnabled(void) { return g_atomic_int_get(&m_bEnabled); }
+};
+#endif   /* CICONXPMDECODER.H	*/
@@ -0,0 +1,32 @@
+/*! \file    decoder_worker.cpp
+    \brief   The sandboxed decoder worker "iconchooser-decoder", started by CIconDecoderPool.
+     It needs only the catalog library, so it runs without GTK+ and without a display.
+
+    \date    2026-10-19
+    \version 1.0
+
+    \b Change_History:
+    \n 1) 2026-10-19 initialize.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CIconDecoderPool.h"
+
+int main(int argc, char* argv[])
+{
+  /* "iconchooser-decoder --decode-worker", its standard input is the socket the files are requested on. */
+  if( (argc < 2) || (strcmp(argv[1], ICON_DECODER_WORKER_ARG) != 0) )
+  {
+     fprintf(stderr, "%s is started by the icon chooser's decoder pool, not by hand.\n", argv[0]);
+     return 2;
+  }
+
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+  g_type_init();
+#endif
+
+  return CIconDecoderPool::m_RunWorker(STDIN_FILENO);
+}
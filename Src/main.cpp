@@ -10,9 +10,16 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <glib/gi18n.h>   // For GNU gettext i18n, multi-language
 
 #include "CIconChooser.h"
+#include "CIconDesktopAudit.h"
+#ifdef USE_INDEX_DAEMON
+#include "CIconIndexDaemon.h"
+#endif
 
 //#define TEST
 
@@ -21,12 +28,768 @@
 #define PACKAGE   "IconChooser"
 #define LOCALEDIR "./locale"
 
+/* The threads resolving at once, and the times each of them resolves all names, in the "--resolve" mode. */
+#define RESOLVE_THREADS  4
+#define RESOLVE_ROUNDS   1000
+
+/*! \struct RESOLVE_JOB
+    \brief The names one thread of the "--resolve" mode resolves.
+*/
+typedef struct _RESOLVE_JOB
+{
+  const gchar *themeName;  /*!< The theme looked up. */
+  gchar **names;           /*!< The icon names, NULL-terminated. */
+} RESOLVE_JOB;
+
+/*! \fn static void init_types(void)
+    \brief To initialize the type system for the modes without a display. GLib 2.36 and later do it by themselves.
+*/
+static void init_types(void)
+{
+#if !GLIB_CHECK_VERSION(2, 36, 0)
+  g_type_init();
+#endif
+}
+
+/*! \fn static gpointer resolve_worker(gpointer data)
+    \brief The thread function resolving the names of a RESOLVE_JOB RESOLVE_ROUNDS times.
+*/
+static gpointer resolve_worker(gpointer data)
+{
+  RESOLVE_JOB *job = (RESOLVE_JOB*)data;
+  CIconCatalog *pCatalog = CIconCatalog::m_GetShared();
+
+  for(gint round=0; round<RESOLVE_ROUNDS; round++)
+  {
+     for(gint i=0; job->names[i]; i++)
+     {
+        g_free(pCatalog->m_Resolve(job->names[i], ICON_THUMBNAIL_SIZE, 1, job->themeName));
+     }
+  }
+
+  return NULL;
+}
+
+/*! \fn static int resolve_icons(const gchar *themeName, gchar **names)
+    \brief To resolve icon names with the catalog engine without a display, print the files found
+            and the resolutions per second of RESOLVE_THREADS threads sharing the catalog.
+
+    \param[in] themeName. The theme looked up.
+    \param[in] names. The icon names, NULL-terminated.
+    \return 0 if all names were found, otherwise 1.
+*/
+static int resolve_icons(const gchar *themeName, gchar **names)
+{
+  CIconCatalog *pCatalog = CIconCatalog::m_GetShared();
+  RESOLVE_JOB jobs[RESOLVE_THREADS];
+  GThread *threads[RESOLVE_THREADS];
+  gint nNames = 0, nMissing = 0;
+  gint64 nStart = 0, nElapsed = 0;
+
+  /* The first resolution loads the theme tables, it is not part of the rate. */
+  for(nNames=0; names[nNames]; nNames++)
+  {
+     gchar *fullName = pCatalog->m_Resolve(names[nNames], ICON_THUMBNAIL_SIZE, 1, themeName);
+
+     printf("%s: %s \n", names[nNames], fullName ? fullName : "(not found)");
+
+     if(!fullName)
+       nMissing++;
+
+     g_free(fullName);
+  }
+
+  nStart = g_get_monotonic_time();
+
+  for(gint i=0; i<RESOLVE_THREADS; i++)
+  {
+     jobs[i].themeName = themeName;
+     jobs[i].names = names;
+     threads[i] = g_thread_try_new("icon-resolve", resolve_worker, &jobs[i], NULL);
+  }
+
+  for(gint i=0; i<RESOLVE_THREADS; i++)
+  {
+     if(threads[i])
+       g_thread_join(threads[i]);
+  }
+
+  nElapsed = MAX(g_get_monotonic_time() - nStart, 1);
+
+  printf("%d resolutions by %d threads in %ld ms, %.0f per second \n",
+         nNames * RESOLVE_ROUNDS * RESOLVE_THREADS, RESOLVE_THREADS, (glong)(nElapsed / 1000),
+         (gdouble)nNames * RESOLVE_ROUNDS * RESOLVE_THREADS * 1000000.0 / nElapsed);
+
+  pCatalog->m_SaveNegativeCache();
+
+  return (nMissing == 0) ? 0 : 1;
+}
+
+/*! \fn static int sandbox_decode(gchar **files)
+    \brief To decode icon files by the sandboxed decoder workers, and print how each of them ended.
+     A file hanging or crashing its worker is reported, and the next file is decoded by a new worker.
+
+    \param[in] files. The icon files, NULL-terminated.
+    \return 0 if all files were decoded, otherwise 1.
+*/
+static int sandbox_decode(gchar **files)
+{
+  static const gchar *statusNames[] = { "decoded", "failed", "timed out", "crashed", "no worker" };
+  CIconDecoderPool pool(NULL, ICON_DECODER_WORKERS);
+  gint nDecoded = 0, nFiles = 0;
+
+  for(nFiles=0; files[nFiles]; nFiles++)
+  {
+     gint nStatus = ICON_DECODER_Failed;
+     gint64 nStart = g_get_monotonic_time();
+     GdkPixbuf *pixbuf = pool.m_Decode(files[nFiles], NULL, 0, ICON_THUMBNAIL_SIZE, &nStatus);
+
+     printf("%s: %s", files[nFiles], statusNames[nStatus]);
+
+     if(pixbuf)
+     {
+        printf(" %dx%d", gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+        g_object_unref(pixbuf);
+        nDecoded++;
+     }
+
+     printf(", %ld ms \n", (glong)((g_get_monotonic_time() - nStart) / 1000));
+  }
+
+  printf("%d of %d decoded, %d timed out, %d crashed, %d workers restarted \n", nDecoded, nFiles,
+         pool.m_GetTimeoutCount(), pool.m_GetCrashCount(), pool.m_GetRestartCount());
+
+  return (nDecoded == nFiles) ? 0 : 1;
+}
+
+/* The reload cycles of the "--soak" mode, the first ones only warm the caches up and are not measured. */
+#define SOAK_CYCLES         10000
+#define SOAK_WARMUP_CYCLES  100
+#define SOAK_REPORT_CYCLES  1000
+
+/* The caches are cleared every this many cycles, as after icons were installed. */
+#define SOAK_CLEAR_CYCLES   100
+
+/* The resident memory may grow this much after the warm-up, by heap fragmentation. The unit is "KB".
+   It is below what an empty list-store lost per reload adds up to over SOAK_CYCLES, about 1.5 MB. */
+#define SOAK_RSS_SLACK_KB   256
+
+/*! \fn static glong soak_get_rss(void)
+    \brief To get the resident memory of the process, in KB, -1 if it is unknown.
+*/
+static glong soak_get_rss(void)
+{
+  glong nPages = 0, nResident = -1;
+  FILE *fp = fopen("/proc/self/statm", "r");
+
+  if(!fp)
+    return -1;
+
+  if( fscanf(fp, "%ld %ld", &nPages, &nResident) != 2 )
+    nResident = -1;
+
+  fclose(fp);
+
+  return (nResident < 0) ? -1 : nResident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*! \fn static gint soak_get_fds(void)
+    \brief To get the number of open file descriptors of the process, -1 if it is unknown.
+*/
+static gint soak_get_fds(void)
+{
+  GDir *dir = g_dir_open("/proc/self/fd", 0, NULL);
+  gint nFds = 0;
+
+  if(!dir)
+    return -1;
+
+  while( g_dir_read_name(dir) )
+    nFds++;
+
+  g_dir_close(dir);
+
+  /* The descriptor of the directory itself is not counted. */
+  return nFds - 1;
+}
+
+/*! \fn static void soak_cycle_catalog(CIconCatalog *pCatalog, const gchar *location, gint nCycle)
+    \brief One headless reload: to list the location, make all thumbnails and resolve some names, as a loading does.
+*/
+static void soak_cycle_catalog(CIconCatalog *pCatalog, const gchar *location, gint nCycle)
+{
+  static const gchar *names[] = { "application-x-executable", "folder", "text-x-generic", "iconchooser-soak-missing", NULL };
+  GPtrArray *files = pCatalog->m_Scan(location, 1, NULL);
+
+  if(files)
+  {
+     for(guint i=0; i<files->len; i++)
+     {
+        guint64 contentHash = 0;
+        GdkPixbuf *pixbuf = pCatalog->m_Thumbnail((const gchar*)g_ptr_array_index(files, i), ICON_THUMBNAIL_SIZE, &contentHash);
+
+        if(pixbuf)
+          g_object_unref(pixbuf);
+     }
+
+     g_ptr_array_free(files, TRUE);
+  }
+
+  for(gint i=0; names[i]; i++)
+     g_free(pCatalog->m_Resolve(names[i], ICON_THUMBNAIL_SIZE, 1, NULL));
+
+  pCatalog->m_PruneThumbnails();
+
+  if( (nCycle % SOAK_CLEAR_CYCLES) == 0 )
+    pCatalog->m_ClearCaches();
+}
+
+/*! \fn static int soak_reload(const gchar *location, gint nCycles, gboolean bDisplay)
+    \brief To reload a location many times and check the resident memory and the file descriptors stay flat,
+            as in a long-lived process embedding the chooser.
+
+    The catalog engine is reloaded without a display. If there is a display, a chooser reloading its icon view
+    synchronously is cycled as well, so the dialog's own ownership is covered.
+
+    \param[in] location. The location reloaded, as in the location entry.
+    \param[in] nCycles. The number of reloads.
+    \param[in] bDisplay. To indicate if GTK has a display.
+    \return 0 if the memory and file descriptors did not grow, otherwise 1.
+*/
+static int soak_reload(const gchar *location, gint nCycles, gboolean bDisplay)
+{
+  CIconCatalog *pCatalog = CIconCatalog::m_GetShared();
+  CIconChooser *pChooser = NULL;
+  glong nBaseRss = -1, nRss = -1;
+  gint nBaseFds = -1, nFds = -1;
+  gint64 nStart = g_get_monotonic_time();
+
+  if(bDisplay)
+  {
+     pChooser = new CIconChooser((gchar*)location, NULL);
+     pChooser->m_SetIdleLoad(false);
+  }
+
+  for(gint nCycle=1; nCycle<=nCycles; nCycle++)
+  {
+     soak_cycle_catalog(pCatalog, location, nCycle);
+
+     if(pChooser)
+     {
+        pChooser->m_ReloadIconList((gchar*)location);
+
+        while( gtk_events_pending() )
+          gtk_main_iteration();
+     }
+
+     if(nCycle == MIN(SOAK_WARMUP_CYCLES, nCycles))
+     {
+        nBaseRss = soak_get_rss();
+        nBaseFds = soak_get_fds();
+     }
+
+     if( ((nCycle % SOAK_REPORT_CYCLES) == 0) || (nCycle == nCycles) )
+     {
+        nRss = soak_get_rss();
+        nFds = soak_get_fds();
+
+        printf("cycle %d: RSS %ld KB (%+ld), %d fds (%+d), %ld ms \n", nCycle, nRss, nRss - nBaseRss,
+               nFds, nFds - nBaseFds, (glong)((g_get_monotonic_time() - nStart) / 1000));
+     }
+  }
+
+  if(pChooser)
+    delete pChooser;
+
+  if( (nBaseRss < 0) || (nBaseFds < 0) )
+  {
+     printf("The memory and file descriptors of the process are unknown \n");
+     return 1;
+  }
+
+  if( (nRss - nBaseRss > SOAK_RSS_SLACK_KB) || (nFds != nBaseFds) )
+  {
+     printf("Leak! RSS grew %ld KB and the fds by %d in %d cycles \n", nRss - nBaseRss, nFds - nBaseFds, MAX(nCycles - SOAK_WARMUP_CYCLES, 0));
+     return 1;
+  }
+
+  printf("%d reloads of %s%s: RSS and fds are flat \n", nCycles, location, pChooser ? "" : " (headless)");
+  return 0;
+}
+
+/* The times every compact thumbnail is expanded in the "--compact-stats" mode, to time the drawing. */
+#define COMPACT_EXPAND_ROUNDS  20
+
+/*! \fn static gboolean compact_equal(GdkPixbuf *original, GdkPixbuf *expanded)
+    \brief To compare a thumbnail with its compact copy expanded, the fully transparent pixels are equal whatever color.
+*/
+static gboolean compact_equal(GdkPixbuf *original, GdkPixbuf *expanded)
+{
+  gint nChannels = gdk_pixbuf_get_n_channels(original);
+
+  for(gint y=0; y<gdk_pixbuf_get_height(original); y++)
+  {
+     const guchar *p = gdk_pixbuf_get_pixels(original) + (gsize)y * gdk_pixbuf_get_rowstride(original);
+     const guchar *q = gdk_pixbuf_get_pixels(expanded) + (gsize)y * gdk_pixbuf_get_rowstride(expanded);
+
+     for(gint x=0; x<gdk_pixbuf_get_width(original); x++, p += nChannels, q += nChannels)
+     {
+        if( ((nChannels == 4) && (p[3] == 0)) ? (q[3] != 0) : (memcmp(p, q, nChannels) != 0) )
+          return false;
+     }
+  }
+
+  return true;
+}
+
+/*! \fn static int compact_stats(const gchar *location)
+    \brief To report the memory the thumbnails of a location take as pixbufs and compact, and the time to expand
+            them, as the icon view of the compact mode does when it draws them.
+
+    \param[in] location. The location, as in the location entry.
+    \return 0 if every compact thumbnail expands to its pixbuf, otherwise 1.
+*/
+static int compact_stats(const gchar *location)
+{
+  CIconCatalog *pCatalog = CIconCatalog::m_GetShared();
+  GPtrArray *files = pCatalog->m_Scan(location, 1, NULL);
+  GPtrArray *compacts = g_ptr_array_new();
+  GdkPixbuf *expanded = NULL;
+  guint nFormats[ICON_COMPACT_Raw + 1] = { 0, 0, 0, 0 };
+  guint nMismatches = 0;
+  guint64 nPixbufBytes = 0, nCompactBytes = 0;
+  gint64 nStart = 0, nElapsed = 0;
+
+  if(!files)
+  {
+     printf("%s could not be read \n", location);
+     return 1;
+  }
+
+  for(guint i=0; i<files->len; i++)
+  {
+     const gchar *fullName = (const gchar*)g_ptr_array_index(files, i);
+     GdkPixbuf *pixbuf = pCatalog->m_Thumbnail(fullName, ICON_THUMBNAIL_SIZE, NULL);
+     CIconCompactThumbnail *compact = NULL;
+
+     if(!pixbuf)
+       continue;
+
+     compact = new CIconCompactThumbnail();
+
+     if( compact->m_Compact(pixbuf) )
+     {
+        GdkPixbuf *check = compact->m_NewPixbuf();
+
+        if( !check || !compact->m_Expand(check) || !compact_equal(pixbuf, check) )
+        {
+           nMismatches++;
+           printf("%s: the compact thumbnail differs \n", fullName);
+        }
+
+        if(check)
+          g_object_unref(check);
+
+        nPixbufBytes += (guint64)gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf) + ICON_BUDGET_PIXBUF_OVERHEAD;
+        nCompactBytes += compact->m_GetBytes();
+        nFormats[compact->m_GetFormat()]++;
+        g_ptr_array_add(compacts, compact);
+     }
+     else
+       delete compact;
+
+     g_object_unref(pixbuf);
+  }
+
+  /* The pixbuf is reused as the pool of the icon view reuses its pixbufs. */
+  nStart = g_get_monotonic_time();
+
+  for(gint nRound=0; nRound<COMPACT_EXPAND_ROUNDS; nRound++)
+  {
+     for(guint i=0; i<compacts->len; i++)
+     {
+        CIconCompactThumbnail *compact = (CIconCompactThumbnail*)g_ptr_array_index(compacts, i);
+
+        if( !compact->m_Fits(expanded) )
+        {
+           if(expanded)
+             g_object_unref(expanded);
+
+           expanded = compact->m_NewPixbuf();
+        }
+
+        if(expanded)
+          compact->m_Expand(expanded);
+     }
+  }
+
+  nElapsed = g_get_monotonic_time() - nStart;
+
+  printf("%u thumbnails: %lu KB as pixbufs, %lu KB compact(%.1fx) \n", compacts->len, (gulong)(nPixbufBytes / 1024),
+         (gulong)(nCompactBytes / 1024), nCompactBytes ? (gdouble)nPixbufBytes / nCompactBytes : 0.0);
+  printf("%u empty, %u palette, %u deflated, %u raw, %.2f us per expansion, %u differ \n",
+         nFormats[ICON_COMPACT_Empty], nFormats[ICON_COMPACT_Palette], nFormats[ICON_COMPACT_Deflate], nFormats[ICON_COMPACT_Raw],
+         compacts->len ? (gdouble)nElapsed / ((gdouble)compacts->len * COMPACT_EXPAND_ROUNDS) : 0.0, nMismatches);
+
+  if(expanded)
+    g_object_unref(expanded);
+
+  for(guint i=0; i<compacts->len; i++)
+    delete (CIconCompactThumbnail*)g_ptr_array_index(compacts, i);
+
+  g_ptr_array_free(compacts, TRUE);
+  g_ptr_array_free(files, TRUE);
+
+  return (nMismatches == 0) ? 0 : 1;
+}
+
+#ifdef USE_NATIVE_XPM
+/* The mean difference of a channel between the thumbnails of the XPM parser and of the loader, on 0 to 255.
+   The full size images must be equal. */
+#define XPM_CHECK_MEAN_TOLERANCE  6.0
+
+/* The rounds every file is decoded in the "--xpm-bench" mode. */
+#define XPM_BENCH_ROUNDS  5
+
+/*! \fn static GPtrArray* xpm_list_files(gchar **paths)
+    \brief To list the XPM files of directories and files, the default icon paths if there are none.
+
+    \param[in] paths. The directories or files, NULL-terminated. Could be NULL.
+    \return The full names, the array and its strings must be freed.
+*/
+static GPtrArray* xpm_list_files(gchar **paths)
+{
+  static const gchar *defaultPaths[] = { DEFAULT_ICON_PATH, DEFAULT_ICON_PATH_2, NULL };
+  const gchar **list = (paths && paths[0]) ? (const gchar**)paths : defaultPaths;
+  GPtrArray *files = g_ptr_array_new();
+
+  for(gint i=0; list[i]; i++)
+  {
+     GDir *dir = g_dir_open(list[i], 0, NULL);
+     const gchar *baseName = NULL;
+
+     if(!dir)
+     {
+        g_ptr_array_add(files, g_strdup(list[i]));
+        continue;
+     }
+
+     while( (baseName = g_dir_read_name(dir)) != NULL )
+     {
+        gchar *lower = g_ascii_strdown(baseName, -1);
+
+        if( g_str_has_suffix(lower, EXT_NAME_XPM) )
+          g_ptr_array_add(files, g_build_filename(list[i], baseName, NULL));
+
+        g_free(lower);
+     }
+
+     g_dir_close(dir);
+  }
+
+  return files;
+}
+
+/*! \fn static gboolean xpm_compare(GdkPixbuf *a, GdkPixbuf *b, gdouble *pMean, gint *pMax)
+    \brief To compare two images channel by channel.
+
+    \param[in] a. One image.
+    \param[in] b. The other image.
+    \param[out] pMean. The mean difference of a channel.
+    \param[out] pMax. The largest difference of a channel.
+    \return FALSE if their dimensions or channels differ.
+*/
+static gboolean xpm_compare(GdkPixbuf *a, GdkPixbuf *b, gdouble *pMean, gint *pMax)
+{
+  gint width = gdk_pixbuf_get_width(a);
+  gint height = gdk_pixbuf_get_height(a);
+  gint nChannels = gdk_pixbuf_get_n_channels(a);
+  guint64 nSum = 0;
+
+  *pMean = 0;
+  *pMax = 0;
+
+  if( (width != gdk_pixbuf_get_width(b)) || (height != gdk_pixbuf_get_height(b)) || (nChannels != gdk_pixbuf_get_n_channels(b)) )
+    return false;
+
+  for(gint y=0; y<height; y++)
+  {
+     const guchar *pA = gdk_pixbuf_get_pixels(a) + (gsize)y * gdk_pixbuf_get_rowstride(a);
+     const guchar *pB = gdk_pixbuf_get_pixels(b) + (gsize)y * gdk_pixbuf_get_rowstride(b);
+
+     for(gint i=0; i<width*nChannels; i++)
+     {
+        gint nDiff = ABS((gint)pA[i] - (gint)pB[i]);
+
+        nSum += nDiff;
+        *pMax = MAX(*pMax, nDiff);
+     }
+  }
+
+  *pMean = (gdouble)nSum / ((gdouble)width * height * nChannels);
+  return true;
+}
+
+/*! \fn static int xpm_check(gchar **paths)
+    \brief To check the XPM parser against the gdk-pixbuf loader: the full size images must be equal, and the
+            thumbnails within XPM_CHECK_MEAN_TOLERANCE. The files the parser leaves to the loader are counted.
+
+    \param[in] paths. The directories or files, NULL-terminated. NULL for the default icon paths.
+    \return 0 if no file differs, otherwise 1.
+*/
+static int xpm_check(gchar **paths)
+{
+  GPtrArray *files = xpm_list_files(paths);
+  gint nPassed = 0, nFailed = 0, nLeft = 0;
+
+  for(guint i=0; i<files->len; i++)
+  {
+     const gchar *fullName = (const gchar*)g_ptr_array_index(files, i);
+     GMappedFile *mapped = g_mapped_file_new(fullName, FALSE, NULL);
+     const guchar *data = mapped ? (const guchar*)g_mapped_file_get_contents(mapped) : NULL;
+     gsize length = mapped ? g_mapped_file_get_length(mapped) : 0;
+     GdkPixbuf *native = NULL, *loaded = NULL, *nativeThumb = NULL, *loadedThumb = NULL;
+     gdouble fMean = 0, fThumbMean = 0;
+     gint nMax = 0, nThumbMax = 0;
+     gboolean bSame = false, bThumbSame = false;
+
+     if(data)
+     {
+        CIconXpmDecoder decoder(data, length);
+        CIconXpmDecoder thumbDecoder(data, length);
+
+        native = decoder.m_Decode(0);
+        nativeThumb = thumbDecoder.m_Decode(ICON_THUMBNAIL_SIZE);
+     }
+
+     if(!native)
+     {
+        nLeft++;
+        printf("%s: left to the loader \n", fullName);
+     }
+     else
+     {
+        loaded = gdk_pixbuf_new_from_file(fullName, NULL);
+
+        /* The loader at the thumbnail size, as the catalog decodes without the parser. */
+        CIconXpmDecoder::m_SetEnabled(false);
+        loadedThumb = CIconCatalog::m_DecodeBuffer(data, length, ICON_THUMBNAIL_SIZE);
+        CIconXpmDecoder::m_SetEnabled(true);
+
+        bSame = loaded && xpm_compare(native, loaded, &fMean, &nMax) && (nMax == 0);
+        bThumbSame = nativeThumb && loadedThumb && xpm_compare(nativeThumb, loadedThumb, &fThumbMean, &nThumbMax) &&
+                     (fThumbMean <= XPM_CHECK_MEAN_TOLERANCE);
+
+        if(bSame && bThumbSame)
+          nPassed++;
+        else
+        {
+           nFailed++;
+           printf("%s: DIFFERS, full size %s(max %d), thumbnail mean %.2f max %d \n", fullName,
+                  loaded ? (bSame ? "equal" : "not equal") : "not decoded by the loader", nMax, fThumbMean, nThumbMax);
+        }
+     }
+
+     if(native)
+       g_object_unref(native);
+
+     if(loaded)
+       g_object_unref(loaded);
+
+     if(nativeThumb)
+       g_object_unref(nativeThumb);
+
+     if(loadedThumb)
+       g_object_unref(loadedThumb);
+
+     if(mapped)
+       g_mapped_file_free(mapped);
+  }
+
+  printf("%u XPM files: %d equal to the loader, %d differ, %d left to the loader \n", files->len, nPassed, nFailed, nLeft);
+
+  g_ptr_array_free(files, TRUE);
+
+  return (nFailed == 0) ? 0 : 1;
+}
+
+/*! \fn static int xpm_bench(gchar **paths)
+    \brief To time the thumbnails of the XPM files by the loader and by the parser, the files mapped into memory
+            beforehand so only the decoding is timed.
+
+    \param[in] paths. The directories or files, NULL-terminated. NULL for the default icon paths.
+    \return 0, or 1 if there is no XPM file.
+*/
+static int xpm_bench(gchar **paths)
+{
+  GPtrArray *files = xpm_list_files(paths);
+  GPtrArray *mapped = g_ptr_array_new();
+  gint64 nElapsed[2] = { 0, 0 };
+  gint nDecoded[2] = { 0, 0 };
+  guint64 nBytes = 0;
+
+  for(guint i=0; i<files->len; i++)
+  {
+     GMappedFile *file = g_mapped_file_new((const gchar*)g_ptr_array_index(files, i), FALSE, NULL);
+
+     if(file)
+     {
+        g_ptr_array_add(mapped, file);
+        nBytes += g_mapped_file_get_length(file);
+     }
+  }
+
+  if(mapped->len == 0)
+  {
+     printf("No XPM file found \n");
+     g_ptr_array_free(mapped, TRUE);
+     g_ptr_array_free(files, TRUE);
+     return 1;
+  }
+
+  /* Pass 0 is the loader, pass 1 the parser. */
+  for(gint nPass=0; nPass<2; nPass++)
+  {
+     gint64 nStart = g_get_monotonic_time();
+
+     CIconXpmDecoder::m_SetEnabled(nPass == 1);
+
+     for(gint nRound=0; nRound<XPM_BENCH_ROUNDS; nRound++)
+     {
+        for(guint i=0; i<mapped->len; i++)
+        {
+           GMappedFile *file = (GMappedFile*)g_ptr_array_index(mapped, i);
+           GdkPixbuf *pixbuf = CIconCatalog::m_DecodeBuffer((const guchar*)g_mapped_file_get_contents(file),
+                                                            g_mapped_file_get_length(file), ICON_THUMBNAIL_SIZE);
+
+           if(pixbuf)
+           {
+              nDecoded[nPass]++;
+              g_object_unref(pixbuf);
+           }
+        }
+     }
+
+     nElapsed[nPass] = MAX(g_get_monotonic_time() - nStart, 1);
+  }
+
+  CIconXpmDecoder::m_SetEnabled(true);
+
+  printf("%u XPM files, %lu KB, %d rounds \n", mapped->len, (gulong)(nBytes / 1024), XPM_BENCH_ROUNDS);
+  printf("loader: %ld ms, %.1f us per file, %d decoded \n", (glong)(nElapsed[0] / 1000),
+         (gdouble)nElapsed[0] / (mapped->len * XPM_BENCH_ROUNDS), nDecoded[0]);
+  printf("parser: %ld ms, %.1f us per file, %d decoded, %.1fx \n", (glong)(nElapsed[1] / 1000),
+         (gdouble)nElapsed[1] / (mapped->len * XPM_BENCH_ROUNDS), nDecoded[1], (gdouble)nElapsed[0] / nElapsed[1]);
+
+  for(guint i=0; i<mapped->len; i++)
+    g_mapped_file_free((GMappedFile*)g_ptr_array_index(mapped, i));
+
+  g_ptr_array_free(mapped, TRUE);
+  g_ptr_array_free(files, TRUE);
+
+  return 0;
+}
+#endif
+
 int main(int argc, char* argv[])
 {
   /* For GNU gettext i18n, multi-language */
   bindtextdomain(PACKAGE, LOCALEDIR);
   textdomain(PACKAGE);
 
+  /* "IconChooser --sandbox-decode <file>..." decodes files by the decoder workers, e.g. to try a suspicious image. */
+  if( (argc > 2) && (strcmp(argv[1], "--sandbox-decode") == 0) )
+  {
+     init_types();
+
+     return sandbox_decode(argv + 2);
+  }
+
+#ifdef USE_NATIVE_XPM
+  /* "IconChooser --xpm-check [dir or file]..." compares the XPM parser with the gdk-pixbuf loader, and
+     "IconChooser --xpm-bench [dir or file]..." times both, over the default icon paths if none is given. */
+  if( (argc > 1) && ((strcmp(argv[1], "--xpm-check") == 0) || (strcmp(argv[1], "--xpm-bench") == 0)) )
+  {
+     init_types();
+
+     if( strcmp(argv[1], "--xpm-check") == 0 )
+       return xpm_check(argv + 2);
+
+     return xpm_bench(argv + 2);
+  }
+#endif
+
+#ifdef USE_INDEX_DAEMON
+  /* "IconChooser --daemon" keeps the thumbnails of the default icon paths warm for the dialogs.
+     It needs no display, so GTK is not initialized. */
+  if( (argc > 1) && (strcmp(argv[1], "--daemon") == 0) )
+  {
+     init_types();
+
+     CIconIndexDaemon indexDaemon;
+
+     return indexDaemon.m_Run() ? 0 : 1;
+  }
+#endif
+
+  /* "IconChooser --resolve <theme> <icon name>..." resolves icon names with the catalog engine, without a display. */
+  if( (argc > 3) && (strcmp(argv[1], "--resolve") == 0) )
+  {
+     init_types();
+
+     return resolve_icons(argv[2], argv + 3);
+  }
+
+  /* "IconChooser --audit [theme] [size]" resolves the Icon= of every desktop file of the applications directories,
+     and reports the icons not found, found only in the legacy directories and oversized. */
+  if( (argc > 1) && (strcmp(argv[1], "--audit") == 0) )
+  {
+     init_types();
+
+     CIconDesktopAudit audit(CIconCatalog::m_GetShared(), (argc > 2) ? argv[2] : NULL, (argc > 3) ? atoi(argv[3]) : ICON_THUMBNAIL_SIZE);
+
+     if( !audit.m_Run(NULL) )
+     {
+        printf("No desktop file is found \n");
+        return 1;
+     }
+
+     audit.m_Print(stdout);
+
+     /* The names not found are not looked up again by the next audit, until the themes change. */
+     CIconCatalog::m_GetShared()->m_SaveNegativeCache();
+
+     return 0;
+  }
+
+  /* "IconChooser --compact-stats [location]" reports the memory of the thumbnails kept compact by the icon view, and
+     the time to expand them when they are drawn. */
+  if( (argc > 1) && (strcmp(argv[1], "--compact-stats") == 0) )
+  {
+     init_types();
+
+     return compact_stats((argc > 2) ? argv[2] : DEFAULT_ICON_PATH);
+  }
+
+  /* "IconChooser --soak [cycles] [location]" reloads a location many times, and fails if the memory
+     or the file descriptors of the process grow. The dialog is only cycled if there is a display. */
+  if( (argc > 1) && (strcmp(argv[1], "--soak") == 0) )
+  {
+     gint nCycles = (argc > 2) ? atoi(argv[2]) : SOAK_CYCLES;
+     const gchar *location = (argc > 3) ? argv[3] : DEFAULT_ICON_PATH;
+     gboolean bDisplay = gtk_init_check(NULL, NULL);
+
+     if(!bDisplay)
+       init_types();
+
+#ifdef USE_DECODER_SANDBOX
+     /* The workers are started and killed in the cycles as well, they must not leak descriptors either. */
+     CIconCatalog::m_GetShared()->m_SetSandboxed(true, NULL, ICON_DECODER_WORKERS);
+#endif
+
+     return soak_reload(location, MAX(nCycles, 1), bDisplay);
+  }
+
   /* First of all, call gtk_init() to initialize GTK type system.
 
      If you do not call this first of all GTK codes,
@@ -35,6 +798,12 @@ int main(int argc, char* argv[])
   */
   gtk_init (&argc, &argv);
 
+#ifdef USE_DECODER_SANDBOX
+  /* The icons of the browsed folders are decoded by worker processes of this program, a bad image could not hang
+     or crash the dialog. */
+  CIconCatalog::m_GetShared()->m_SetSandboxed(true, NULL, ICON_DECODER_WORKERS);
+#endif
+
   CIconChooser iconChooser((gchar*)DEFAULT_ICON_PATH, NULL);
 
   printf("Start to show dialog \n");
@@ -48,7 +817,16 @@ int main(int argc, char* argv[])
   if (iconChooser.m_GetIsChosen())
   {
     if (iconChooser.m_GetCurrentIcon())
-       printf("The Selected Icon Name : %s \n", (char*)iconChooser.m_GetCurrentIcon());		
+       printf("The Selected Icon Name : %s \n", (char*)iconChooser.m_GetCurrentIcon());
+
+    /* The application's button shows the chosen icon, decoded at the device pixel size so it is sharp on HiDPI. */
+    GdkPixbuf *buttonIcon = iconChooser.m_LoadButtonIcon();
+    if (buttonIcon)
+    {
+       printf("The Button Icon : %dx%d pixels at scale %d \n", gdk_pixbuf_get_width(buttonIcon),
+              gdk_pixbuf_get_height(buttonIcon), iconChooser.m_GetScale());
+       g_object_unref(buttonIcon);
+    }
   }
 
   printf("Going to shutdown \n\n");